@@ -102,15 +102,62 @@ extern "C" {
 
 typedef struct discord* discord_handle_t;
 
+struct discord_presence; // discord_presence_t, see discord/presence.h
+
+/**
+ * @brief What happens to the received payload when the bot does not handle events as fast as they arrive
+ */
+typedef enum {
+    DISCORD_QUEUE_POLICY_DROP_OLDEST,      /*<! Oldest waiting payload is dropped to make room for the new one */
+    DISCORD_QUEUE_POLICY_DROP_NEWEST,      /*<! New payload is dropped */
+    DISCORD_QUEUE_POLICY_BLOCK,            /*<! Receiving is paused until there is room (up to 5 seconds, then new payload is dropped). Heartbeat ACKs are delayed meanwhile */
+    DISCORD_QUEUE_POLICY_COALESCE,         /*<! Update of a message replaces waiting update of the same message. Otherwise like DROP_OLDEST */
+} discord_queue_policy_t;
+
+typedef enum {
+    DISCORD_GATEWAY_ENCODING_JSON,         /*<! Default */
+    DISCORD_GATEWAY_ENCODING_ETF,          /*<! Erlang External Term Format. Smaller and cheaper to decode, payloads are pruned while receiving the same way as JSON */
+} discord_gateway_encoding_t;
+
+// when the standby gateway connection is opened (discord_config_t.gateway_standby)
+
+#define DISCORD_GATEWAY_STANDBY_ON_RECONNECT  (1 << 0)  /*!< Discord requested reconnection (op 7) */
+#define DISCORD_GATEWAY_STANDBY_ON_LATENCY    (1 << 1)  /*!< Average heartbeat RTT went above gateway_latency_threshold_ms, session is moved to a new connection */
+
+#define DISCORD_GATEWAY_SHARD_COUNT_AUTO      (0xFFFF)  /*!< discord_config_t.gateway_shard_count recommended by Discord (GET /gateway/bot) at login */
+
 typedef struct {
     char* token;
-    int intents;
+    int intents;                           /*<! Gateway intents. If 0, intents are calculated at login from registered events */
     size_t gateway_buffer_size;
     size_t api_buffer_size;
     size_t api_timeout_ms;
-    uint8_t queue_size;
+    uint8_t queue_size;                    /*<! Maximum number of received payloads waiting to be handled */
+    discord_queue_policy_t queue_policy;
     size_t task_stack_size;
     uint8_t task_priority;
+    bool gateway_compress;                 /*<! Receive gateway payloads compressed with zlib-stream. Inflate context takes about 43 KB (32 KB window) */
+    uint32_t gateway_latency_threshold_ms; /*<! DISCORD_EVENT_GATEWAY_LATENCY is fired when average heartbeat RTT crosses this value. 0 disables the event */
+    discord_gateway_encoding_t gateway_encoding;
+    char* gateway_url;                     /*<! Gateway to connect to instead of Discord, for example local mock "ws://127.0.0.1:8080". NULL for Discord */
+    char* api_url;                         /*<! REST API base instead of Discord, for example "http://127.0.0.1:8080/api/v10". NULL for Discord */
+    char* gateway_record_path;             /*<! Debug. Every raw frame received from the gateway is appended to this file (see discord_replay). NULL disables recording */
+    size_t guild_cache_size;               /*<! Bytes for roles and channels of the guilds, kept current by gateway events (GUILDS intent is added to calculated intents). Role and channel lookups are answered from the cache without REST requests. 0 disables the cache */
+    const char** member_cache_guild_ids;   /*<! NULL terminated list of guilds whose members are requested (Request Guild Members) after READY and kept current by gateway events (privileged GUILD_MEMBERS intent is added to calculated intents). discord_member_get is answered from the cache without REST request. NULL disables the cache */
+    size_t member_cache_size;              /*<! Bytes for the cached members, least recently used members are evicted. 0 disables the cache */
+    uint8_t gateway_standby;               /*<! DISCORD_GATEWAY_STANDBY_* flags. Second connection is opened ahead of the reconnection and takes the session over with RESUME, so DNS, TCP and TLS handshake are not in the gap. Until the switch it holds another websocket task and TLS session (see standby_memory in discord_gateway_stats_t). 0 disables the standby */
+    size_t gateway_standby_min_free_heap;  /*<! Standby connection is opened only if this many bytes of heap are free, otherwise the usual reconnection follows. Default 64 KB */
+    uint32_t gateway_ack_timeout_ms;       /*<! Connection is considered dead if heartbeat ACK does not arrive within this time. 0 (or more than heartbeat interval) waits until the next heartbeat, about 41 s */
+    uint16_t gateway_ping_interval_s;      /*<! Websocket ping is sent this often, so the silent connection still receives pongs. 0 keeps esp_websocket_client default (10 s) */
+    uint32_t gateway_silence_timeout_ms;   /*<! Connection is considered dead if nothing (payload or pong) is received for this long. Should be a few ping intervals. 0 disables the check */
+    bool gateway_tcp_keepalive;            /*<! Enable TCP keepalive on the gateway socket, so the network stack detects unreachable peer while nothing is being sent */
+    bool gateway_payload_compress;         /*<! Ask Discord (identify compress) to compress large payloads, READY and GUILD_CREATE in particular, one by one. Uses the same inflate window as gateway_compress, which takes precedence */
+    uint8_t gateway_large_threshold;       /*<! Guilds with more members (50 - 250) are sent without offline members in GUILD_CREATE. 0 keeps Discord default (50) */
+    const struct discord_presence* gateway_presence; /*<! Initial presence, sent in IDENTIFY so the session starts with it. Same as calling discord_presence_update before login. NULL for none */
+    uint16_t gateway_shard_id;             /*<! First shard run by this client, 0 ... gateway_shard_count - 1 */
+    uint16_t gateway_shard_count;          /*<! Total number of shards, or DISCORD_GATEWAY_SHARD_COUNT_AUTO. 0 if the bot is not sharded */
+    uint16_t gateway_shard_run_count;      /*<! Number of shards run by this client, from gateway_shard_id on. Every shard has its own connection, heartbeat and session, while REST API, event handlers and identify rate limit are shared. Handlers receive the shard in event data client. 0 runs all shards from gateway_shard_id to the last one */
+    bool gateway_payload_arena;            /*<! Data of message, reaction and voice state events is decoded into one region per payload instead of a heap block per field, and the region is freed at once after the handlers. Regions of common sizes are reused, which keeps the heap from fragmenting. Applies to JSON and ETF encoding. Data is valid only while the handler runs, handler which needs it later must copy it with discord_event_data_keep */
 } discord_config_t;
 
 typedef enum {
@@ -158,6 +205,9 @@ typedef enum {
     DISCORD_EVENT_MESSAGE_REACTION_ADDED,      /*<! Reaction added to message */
     DISCORD_EVENT_MESSAGE_REACTION_REMOVED,    /*<! Reaction removed from message */
     DISCORD_EVENT_VOICE_STATE_UPDATED,         /*<! Voice state updated */
+    DISCORD_EVENT_RESUMED,                     /*<! Bot is reconnected and previous session is resumed. Events missed while disconnected are replayed */
+    DISCORD_EVENT_GATEWAY_LATENCY,             /*<! Average heartbeat RTT went above or back below gateway_latency_threshold_ms. Event data is discord_gateway_latency_t* */
+    DISCORD_EVENT_CONNECTION_LOST,             /*<! Connection was closed or found dead, reconnection follows. Event data is discord_connection_lost_t* */
 } discord_event_t;
 
 typedef void* discord_event_data_ptr_t;
@@ -176,15 +226,113 @@ typedef struct {
 
 typedef esp_err_t(*discord_download_handler_t)(discord_download_info_t* info, void* arg);
 
+typedef enum {
+    DISCORD_EVENT_FILTER_AUTHOR_ANY,           /*<! Author is not checked */
+    DISCORD_EVENT_FILTER_AUTHOR_BOT,           /*<! Only messages sent by bots */
+    DISCORD_EVENT_FILTER_AUTHOR_NOT_BOT        /*<! Only messages sent by users */
+} discord_event_filter_author_t;
+
+/**
+ * @brief Filter of the events which are delivered to the handler.
+ *        It is applied only to the events related to a channel (messages, reactions and voice states), other events are always delivered.
+ *        Filter is also used to calculate intents if they are not set in configuration.
+ */
+typedef struct {
+    const char** channel_ids;                  /*<! NULL terminated list of channel ids. NULL for any channel. Channels are assumed to be guild channels when intents are calculated, see direct_messages */
+    const char** guild_ids;                    /*<! NULL terminated list of guild ids. NULL for any guild (including direct messages) */
+    discord_event_filter_author_t author;      /*<! Filter by message author */
+    bool direct_messages;                      /*<! Calculated intents include direct messages even if channel_ids are set, so DM channels can be listed. Has no effect with guild_ids */
+} discord_event_filter_t;
+
+typedef struct {
+    uint32_t payloads_received;                /*<! Number of complete payloads received from gateway */
+    uint32_t payloads_ignored;                 /*<! Payloads rejected before decoding (unknown events, own messages, ...) */
+    uint32_t payloads_decoded;                 /*<! Payloads decoded into models */
+    uint32_t heartbeat_acks;                   /*<! Heartbeat ACKs handled without decoding */
+    uint32_t reconnect_attempts;               /*<! Number of connection attempts after the connection was lost */
+    uint32_t reconnects;                       /*<! Number of successful reconnections (session resumed or identified again) */
+    uint32_t last_reconnect_ms;                /*<! Time from the loss of connection to the last successful reconnection */
+    uint32_t queue_drops;                      /*<! Payloads dropped because the queue was full */
+    uint32_t queue_coalesced;                  /*<! Payloads which replaced a waiting update of the same message */
+    uint32_t queue_max_depth;                  /*<! Maximum number of payloads which were waiting at the same time */
+    uint32_t guild_cache_hits;                 /*<! Role and channel lookups answered from the guild cache */
+    uint32_t guild_cache_misses;               /*<! Role and channel lookups which needed REST request */
+    uint32_t guild_cache_evictions;            /*<! Guilds evicted from the cache to stay within guild_cache_size */
+    uint32_t member_cache_hits;                /*<! Member lookups answered from the member cache */
+    uint32_t member_cache_misses;              /*<! Member lookups which needed REST request */
+    uint32_t member_cache_evictions;           /*<! Members evicted from the cache to stay within member_cache_size */
+    uint32_t standby_opened;                   /*<! Standby connections opened ahead of the reconnection */
+    uint32_t standby_switches;                 /*<! Sessions moved to the standby connection */
+    uint32_t standby_failures;                 /*<! Standby connections which failed or timed out, the usual reconnection followed */
+    uint32_t standby_memory;                   /*<! Heap taken by the last standby connection (websocket task, buffers and TLS session), measured when it received HELLO */
+    uint32_t connect_bytes;                    /*<! Bytes received on the last connection until the session was ready (READY or RESUMED), compressed size if compression is enabled */
+} discord_gateway_stats_t;
+
+typedef enum {
+    DISCORD_CONNECTION_LOST_CLOSED,            /*<! Gateway closed the connection with close_code */
+    DISCORD_CONNECTION_LOST_REQUESTED,         /*<! Gateway requested reconnection or invalidated the session */
+    DISCORD_CONNECTION_LOST_ACK_TIMEOUT,       /*<! Heartbeat ACK did not arrive within gateway_ack_timeout_ms (or before the next heartbeat) */
+    DISCORD_CONNECTION_LOST_SILENCE,           /*<! Nothing was received for gateway_silence_timeout_ms */
+    DISCORD_CONNECTION_LOST_TRANSPORT,         /*<! Websocket or TCP failed without close code (including TCP keepalive) */
+} discord_connection_lost_reason_t;
+
+typedef struct {
+    discord_connection_lost_reason_t reason;
+    discord_close_code_t close_code;           /*<! DISCORD_CLOSEOP_NO_CODE unless reason is DISCORD_CONNECTION_LOST_CLOSED */
+    uint32_t silence_ms;                       /*<! Time since anything was received, how long the connection had been dead at most */
+} discord_connection_lost_t;
+
+/**
+ * @brief Round trip times between heartbeats and their ACKs, over the last few heartbeats
+ */
+typedef struct {
+    uint32_t last_ms;                          /*<! RTT of the last acknowledged heartbeat */
+    uint32_t min_ms;
+    uint32_t avg_ms;
+    uint32_t p95_ms;
+    uint8_t samples;                           /*<! Number of RTTs in the window, 0 if no heartbeat has been acknowledged yet */
+    bool above_threshold;                      /*<! Average is above gateway_latency_threshold_ms */
+} discord_gateway_latency_t;
+
 discord_handle_t discord_create(const discord_config_t* config);
 /**
  * @brief Cannot be called from event handler
  */
 esp_err_t discord_login(discord_handle_t client);
 esp_err_t discord_register_events(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler, void* event_handler_arg);
+/**
+ * @brief Same as discord_register_events, but handler receives only events which pass the filter (copied, can be NULL).
+ *        Events filtered out by all handlers are dropped before decoding
+ */
+esp_err_t discord_register_events_filtered(discord_handle_t client, discord_event_t event, const discord_event_filter_t* filter, esp_event_handler_t event_handler, void* event_handler_arg);
 esp_err_t discord_unregister_events(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler);
 esp_err_t discord_get_state(discord_handle_t client, discord_gateway_state_t* out_state);
 esp_err_t discord_get_close_code(discord_handle_t client, discord_close_code_t* out_code);
+/**
+ * @brief Get gateway counters. Counters are kept for the whole lifetime of the client
+ */
+esp_err_t discord_get_gateway_stats(discord_handle_t client, discord_gateway_stats_t* out_stats);
+/**
+ * @brief Get heartbeat round trip times. Window is kept across reconnections
+ */
+esp_err_t discord_get_gateway_latency(discord_handle_t client, discord_gateway_latency_t* out_latency);
+/**
+ * @brief Debug. Push frames recorded with gateway_record_path through the gateway as if they were received, without network.
+ *        Frames are replayed back to back, events are fired from the calling task and nothing is sent.
+ *        Client must be created with the same encoding and compression as the recording, and must not be logged in
+ */
+esp_err_t discord_replay(discord_handle_t client, const char* path);
+/**
+ * @brief Get the shard which receives events of the guild. Shard can be used as any client, except for login, logout and destroy
+ * @return ESP_ERR_NOT_FOUND if the shard is not run by this client. Client itself is returned if the connection is not sharded
+ */
+esp_err_t discord_get_shard(discord_handle_t client, const char* guild_id, discord_handle_t* out_shard);
+/**
+ * @brief Copy event data, so it can be kept after the handler returns (event data is freed then).
+ *        Copy is owned by the caller and freed by the model free function (discord_message_free, ...)
+ * @return ESP_ERR_NOT_SUPPORTED if data of the event cannot be copied (only message, reaction and voice state events can)
+ */
+esp_err_t discord_event_data_keep(int32_t event, const discord_event_data_t* data, discord_event_data_ptr_t* out_data);
 /**
  * @brief Cannot be called from event handler
  */
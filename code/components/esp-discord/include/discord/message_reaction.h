@@ -11,6 +11,7 @@ typedef struct {
     char* user_id;
     char* message_id;
     char* channel_id;
+    char* guild_id;
     discord_emoji_t* emoji;
 } discord_message_reaction_t;
 
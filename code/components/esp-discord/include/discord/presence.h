@@ -0,0 +1,55 @@
+#ifndef _DISCORD_PRESENCE_H_
+#define _DISCORD_PRESENCE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "discord.h"
+
+typedef enum {
+    DISCORD_ACTIVITY_PLAYING,               /*!< Playing {name} */
+    DISCORD_ACTIVITY_STREAMING,             /*!< Streaming {name} */
+    DISCORD_ACTIVITY_LISTENING,             /*!< Listening to {name} */
+    DISCORD_ACTIVITY_WATCHING,              /*!< Watching {name} */
+    DISCORD_ACTIVITY_CUSTOM,                /*!< {state} (custom status) */
+    DISCORD_ACTIVITY_COMPETING,             /*!< Competing in {name} */
+} discord_activity_type_t;
+
+typedef struct {
+    char* name;                             /*!< Activity name */
+    discord_activity_type_t type;           /*!< Activity type */
+    char* state;                            /*!< Text of the custom status, can be NULL */
+} discord_activity_t;
+
+typedef enum {
+    DISCORD_PRESENCE_ONLINE,
+    DISCORD_PRESENCE_DND,                   /*!< Do Not Disturb */
+    DISCORD_PRESENCE_IDLE,
+    DISCORD_PRESENCE_INVISIBLE,             /*!< Shown as offline */
+    DISCORD_PRESENCE_OFFLINE,
+} discord_presence_status_t;
+
+typedef struct discord_presence {
+    discord_presence_status_t status;       /*!< Status */
+    discord_activity_t* activity;           /*!< Activity, can be NULL */
+    bool afk;                               /*!< Whether the client is afk */
+} discord_presence_t;
+
+/**
+ * @brief Update presence of the bot. Presence is sent over the gateway connection, no HTTP request is made.
+ *        Update identical to the last one is ignored. Updates are sent at most once per DISCORD_GW_PRESENCE_INTERVAL_MS,
+ *        more frequent updates replace the waiting one, so only the latest presence is sent.
+ *        Presence can be set before login, it is sent (again) whenever a new session starts
+ * @param presence Presence to send. It is copied, so it can be freed after the call
+ * @return ESP_OK if presence is sent, waits to be sent or is the same as the last one
+ */
+esp_err_t discord_presence_update(discord_handle_t client, const discord_presence_t* presence);
+void discord_activity_free(discord_activity_t* activity);
+void discord_presence_free(discord_presence_t* presence);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
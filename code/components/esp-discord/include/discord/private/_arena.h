@@ -0,0 +1,80 @@
+#ifndef _DISCORD_PRIVATE_ARENA_H_
+#define _DISCORD_PRIVATE_ARENA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISCORD_ARENA_ALIGN             (8)
+#define DISCORD_ARENA_CLASS_MIN_SIZE    (512)   /*<! Size classes are 512 B, 1 KB, 2 KB and 4 KB */
+#define DISCORD_ARENA_CLASS_COUNT       (4)
+#define DISCORD_ARENA_POOL_DEPTH        (2)     /*<! Free regions of each class kept for reuse */
+
+typedef struct discord_arena_pool discord_arena_pool_t;
+
+/**
+ * @brief Region which holds all allocations of one decoded payload. Allocation only bumps the offset,
+ *        allocations are never freed one by one and the whole region is released at once.
+ *        Region which gets full is followed by another one, so allocation fails only if heap does
+ */
+typedef struct discord_arena {
+    struct discord_arena* next;                    /*<! Region added when this one got full */
+    struct discord_arena* current;                 /*<! Region which is allocated from (first region only) */
+    discord_arena_pool_t* pool;                    /*<! Pool the region is taken from and returned to. NULL for plain heap region */
+    int size_class;                                /*<! -1 if region does not have a size class */
+    size_t size;
+    size_t used;
+} discord_arena_t;
+
+/**
+ * @brief Free regions of the size classes. Regions of common payloads are reused instead of being allocated,
+ *        so the heap does not get fragmented by a block per model field. Decoding (ws task) takes regions,
+ *        discord task returns them
+ */
+struct discord_arena_pool {
+    portMUX_TYPE lock;
+    discord_arena_t* free[DISCORD_ARENA_CLASS_COUNT];
+    uint8_t free_len[DISCORD_ARENA_CLASS_COUNT];
+};
+
+void discord_arena_pool_init(discord_arena_pool_t* pool);
+
+/**
+ * @brief Free the regions kept in the pool. Regions in use are freed by discord_arena_free as usual
+ */
+void discord_arena_pool_destroy(discord_arena_pool_t* pool);
+
+/**
+ * @brief Create arena for about size bytes of allocations
+ * @param pool Pool to take the region from, NULL to allocate it from heap
+ * @return Arena or NULL if there is no memory
+ */
+discord_arena_t* discord_arena_create(discord_arena_pool_t* pool, size_t size);
+
+/**
+ * @brief Allocate zeroed memory, aligned to DISCORD_ARENA_ALIGN
+ * @param arena Arena or NULL to allocate from heap (calloc)
+ */
+void* discord_arena_calloc(discord_arena_t* arena, size_t size);
+
+/**
+ * @brief Copy len bytes of str and terminate the copy
+ * @param arena Arena or NULL to allocate from heap
+ */
+char* discord_arena_strndup(discord_arena_t* arena, const char* str, size_t len);
+
+/**
+ * @brief Release all allocations of the arena at once. Regions of a size class go back to their pool
+ */
+void discord_arena_free(discord_arena_t* arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
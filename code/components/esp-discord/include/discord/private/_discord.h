@@ -15,18 +15,38 @@ extern "C" {
 #include "esp_websocket_client.h"
 #include "esp_http_client.h"
 #include "_models.h"
+#include "_json_stream.h"
+#include "_zlib_stream.h"
+#include "_timer.h"
+#include "_payload_ring.h"
+#include "_outbox.h"
+#include "_recorder.h"
+#include "_guild_cache.h"
+#include "_member_cache.h"
+#include "_shards.h"
 #include "discord.h"
 #include "discord_ota.h"
 
 #include "discord/session.h"
+#include "discord/presence.h"
 
 #ifndef CONFIG_IDF_TARGET
 #define CONFIG_IDF_TARGET "esp32"
 #endif
 
-#define DISCORD_GW_URL                   "wss://gateway.discord.gg/?v=10&encoding=json"
+#define DISCORD_GW_BASE_URL              "wss://gateway.discord.gg"
+#define DISCORD_GW_QUERY                 "/?v=10"
+#define DISCORD_GW_QUERY_JSON            "&encoding=json"
+#define DISCORD_GW_QUERY_ETF             "&encoding=etf"
+#define DISCORD_GW_QUERY_COMPRESS        "&compress=zlib-stream"
+#define DISCORD_GW_URL                   DISCORD_GW_BASE_URL DISCORD_GW_QUERY DISCORD_GW_QUERY_JSON
 #define DISCORD_API_URL                  "https://discord.com/api/v10"
 
+// certificates are embedded by the component only for the ESP targets. Linux target is meant for the local mock
+#if !defined(CONFIG_ESP_TLS_SKIP_SERVER_CERT_VERIFY) && !defined(CONFIG_IDF_TARGET_LINUX)
+#define DISCORD_CERTS_EMBEDDED
+#endif
+
 // this should go into menuconfig configuration
 #define DISCORD_DEFAULT_GW_BUFFER_SIZE   (3 * 1024)
 #define DISCORD_DEFAULT_TASK_STACK_SIZE  (6 * 1024)
@@ -34,6 +54,25 @@ extern "C" {
 #define DISCORD_DEFAULT_API_BUFFER_SIZE  (3 * 1024)
 #define DISCORD_DEFAULT_API_TIMEOUT_MS   (8000)
 #define DISCORD_DEFAULT_QUEUE_SIZE       (3)
+#define DISCORD_DEFAULT_GW_STANDBY_MIN_FREE_HEAP (64 * 1024)
+#define DISCORD_QUEUE_BLOCK_TIMEOUT_MS   (5000)
+#define DISCORD_RECONNECT_BASE_MS        (1000)
+#define DISCORD_RECONNECT_MAX_MS         (60000)
+#define DISCORD_HEARTBEAT_RTT_WINDOW     (16)
+#define DISCORD_GW_RATE_LIMIT            (120)   /*<! Gateway closes connection (4008) if more payloads are sent per period */
+#define DISCORD_GW_RATE_PERIOD_MS        (60000)
+#define DISCORD_GW_RATE_RESERVE          (5)     /*<! Tokens which only heartbeats, identify and resume can use */
+#define DISCORD_GW_OUTBOX_SIZE           (8)
+#define DISCORD_GW_SEND_BUFFER_SIZE      (512)   /*<! Outbound frames are written here */
+#define DISCORD_GW_PRESENCE_INTERVAL_MS  (12000) /*<! Minimum interval between presence updates (Discord allows 5 per minute) */
+#define DISCORD_GW_CLOSE_CODE_RESUMABLE  (4000)  /*<! Closing with 1000 or 1001 would invalidate the session */
+#define DISCORD_GW_STANDBY_BUFFER_SIZE   (512)   /*<! Frames received by the standby connection before the switch (HELLO only) */
+#define DISCORD_GW_STANDBY_FRAMES        (4)
+#define DISCORD_GW_STANDBY_TIMEOUT_MS    (10000) /*<! Standby has to receive HELLO in time, old connection has to be closed in time after the switch */
+#define DISCORD_GW_STANDBY_CLOSE_MS      (1000)
+#define DISCORD_GW_KEEPALIVE_IDLE_S      (10)    /*<! TCP keepalive probes start after this much silence */
+#define DISCORD_GW_KEEPALIVE_INTERVAL_S  (5)
+#define DISCORD_GW_KEEPALIVE_COUNT       (3)     /*<! Unanswered probes before the socket is closed */
 
 #define DISCORD_LOG_TAG "DISCORD"
 
@@ -50,17 +89,39 @@ extern "C" {
 #define DISCORD_LOG_FOO() DISCORD_LOGD("...")
 
 #define DISCORD_EVENT_FIRE(event, data) client->event_handler(client, event, data)
+#define DISCORD_TASK_NOTIFY_BITS(client, bits) do { TaskHandle_t _th = (client)->task_handle; if(_th) { xTaskNotify(_th, bits, eSetBits); } } while(0)
+#define DISCORD_TASK_NOTIFY(client) DISCORD_TASK_NOTIFY_BITS(client, DISCORD_TASK_BIT_WAKE)
+#define DISCORD_OWNER(client) ((client)->shard_owner ? (client)->shard_owner : (client))  /*<! Client which owns REST API and event handlers */
+
+// discord task notification bits
+#define DISCORD_TASK_BIT_WAKE             (1 << 0)  /*<! State changed, payload queued, timer expired or logout */
+#define DISCORD_TASK_BIT_HELLO            (1 << 1)  /*<! HELLO received, heartbeat interval is in gw_hello_interval */
+#define DISCORD_TASK_BIT_RECONNECT        (1 << 2)  /*<! RECONNECT received */
+#define DISCORD_TASK_BIT_INVALID_SESSION  (1 << 3)  /*<! INVALID_SESSION received, resumability is in gw_session_resumable */
+#define DISCORD_TASK_BIT_MEMBERS          (1 << 4)  /*<! Last chunk of members of the loading guild received, next guild can be requested */
 
 #define STRDUP(str) (str ? strdup(str) : NULL)
 
 typedef enum {
     DISCORD_CLOSE_REASON_NOT_REQUESTED,
     DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED,
+    DISCORD_CLOSE_REASON_SILENCE,
+    DISCORD_CLOSE_REASON_RECONNECT,
+    DISCORD_CLOSE_REASON_INVALID_SESSION,
     DISCORD_CLOSE_REASON_LOGOUT,
     DISCORD_CLOSE_REASON_DESTROY,
     DISCORD_CLOSE_REASON_ERROR
 } discord_gateway_close_reason_t;
 
+/**
+ * @brief Order in which outbound payloads get the send tokens
+ */
+typedef enum {
+    DISCORD_GW_PRIORITY_HEARTBEAT,
+    DISCORD_GW_PRIORITY_SESSION,            /*<! IDENTIFY and RESUME */
+    DISCORD_GW_PRIORITY_REQUEST,            /*<! Presence, voice state and guild members requests */
+} discord_gateway_priority_t;
+
 enum {
     DISCORD_OP_DISPATCH,                    /*!< [Receive] An event was dispatched */
     DISCORD_OP_HEARTBEAT,                   /*!< [Send/Receive] An event was dispatched */
@@ -81,10 +142,43 @@ enum {
 typedef struct {
     bool running;
     int interval;
-    uint64_t tick_ms;
+    uint64_t tick_ms;                   /*<! Time when the last heartbeat was sent */
     bool received_ack;
+    uint32_t rtts[DISCORD_HEARTBEAT_RTT_WINDOW]; /*<! Ring of the last round trip times */
+    uint8_t rtt_count;
+    uint8_t rtt_next;
+    bool latency_high;                  /*<! Average RTT is above the configured threshold */
+    bool latency_crossed;               /*<! Threshold has been crossed, event is going to be fired from the task */
 } discord_heartbeater_t;
 
+typedef struct {
+    uint32_t attempts;                  /*<! Consecutive reconnection attempts since the connection was lost */
+    uint64_t lost_tick_ms;              /*<! Time when the connection was lost, 0 if connected */
+} discord_reconnector_t;
+
+typedef enum {
+    DISCORD_GW_STANDBY_IDLE,            /*<! There is no standby connection */
+    DISCORD_GW_STANDBY_WARMING,         /*<! Connecting, HELLO has not been received yet */
+    DISCORD_GW_STANDBY_READY,           /*<! HELLO received, connection can take the session over */
+    DISCORD_GW_STANDBY_FAILED,
+    DISCORD_GW_STANDBY_RETIRING,        /*<! Connection which was replaced, it is closed once the session is resumed */
+} discord_gateway_standby_state_t;
+
+/**
+ * @brief Second websocket which is connected ahead of the reconnection. Its frames are only buffered
+ *        until the task switches to it, then they go through the usual path as if they were just received
+ */
+typedef struct {
+    esp_websocket_client_handle_t ws;   /*<! NULL if there is no standby connection */
+    volatile discord_gateway_standby_state_t state;
+    discord_gateway_close_reason_t fallback; /*<! Current connection is closed with this reason if standby fails, NOT_REQUESTED keeps it */
+    discord_recorder_frame_t frames[DISCORD_GW_STANDBY_FRAMES];
+    uint8_t frames_len;
+    char* buffer;                       /*<! Data of the frames */
+    size_t buffer_len;
+    uint32_t free_heap;                 /*<! Free heap before the connection was opened */
+} discord_gateway_standby_t;
+
 typedef esp_err_t(*discord_event_handler_t)(discord_handle_t client, discord_event_t event, discord_event_data_ptr_t data_ptr);
 
 struct discord {
@@ -92,10 +186,15 @@ struct discord {
     EventGroupHandle_t bits;
     discord_gateway_state_t state;
     TaskHandle_t task_handle;
-    QueueHandle_t queue;
+    discord_timers_t timers;
+    discord_payload_ring_t queue;
     esp_event_loop_handle_t event_handle;
     discord_event_handler_t event_handler;
+    SemaphoreHandle_t events_lock;
+    struct discord_event_registration* event_registrations;
+    uint8_t events_dispatching;
     discord_config_t* config;
+    int intents;
     SemaphoreHandle_t gw_lock;
     esp_websocket_client_handle_t ws;
     SemaphoreHandle_t api_lock;
@@ -110,13 +209,44 @@ struct discord {
     size_t api_download_total;
     size_t api_download_offset;
     discord_heartbeater_t heartbeater;
+    discord_reconnector_t reconnector;
     discord_session_t* session;
     int last_sequence_number;
+    volatile uint32_t gw_rx_tick_ms;              /*<! Time (low bits) when the last frame was received, written by ws task */
+    bool gw_resuming;
+    int gw_hello_interval;
+    bool gw_session_resumable;
     char* gw_buffer;
     int gw_buffer_len;
+    char* gw_send_buffer;
+    discord_json_stream_t gw_stream;
+    discord_arena_pool_t gw_arenas;               /*<! Regions of decoded payloads, used if gateway_payload_arena is set */
+    discord_zlib_stream_t gw_zlib;
+    discord_outbox_t gw_outbox;
+    discord_presence_t* gw_presence;              /*<! Last presence sent in the current session */
+    discord_presence_t* gw_presence_pending;      /*<! Presence waiting for the interval or connection */
+    uint64_t gw_presence_tick_ms;                 /*<! Time when the last presence was sent */
+    bool gw_presence_identified;                  /*<! Presence was sent in IDENTIFY, so it does not have to be restored after READY */
+    bool gw_inflating;                            /*<! Current binary payload is compressed (per message compression) */
+    volatile uint32_t gw_connect_bytes;           /*<! Bytes received since the websocket connected, until the session is ready */
+    volatile bool gw_connect_counting;
+    discord_gateway_stats_t gw_stats;
+    discord_recorder_t gw_recorder;               /*<! Received frames are recorded if gateway_record_path is set */
+    bool gw_replaying;                            /*<! Frames come from the recording, nothing is sent */
+    uint32_t gw_replay_bits;                      /*<! DISCORD_TASK_BIT_* signaled while replaying, there is no task to notify */
+    SemaphoreHandle_t gw_guilds_lock;             /*<! NULL if guild cache is disabled */
+    discord_guild_cache_t gw_guilds;              /*<! Updated from websocket task, read by the model lookups */
+    SemaphoreHandle_t gw_members_lock;            /*<! NULL if member cache is disabled */
+    discord_member_cache_t gw_members;            /*<! Updated from websocket task, read by discord_member_get */
+    int gw_members_loading;                       /*<! Index of the guild in member_cache_guild_ids whose members are requested, written only by discord task */
+    discord_gateway_standby_t gw_standby;         /*<! Used only if gateway_standby is set */
     discord_gateway_close_reason_t close_reason;
     discord_close_code_t close_code;
     discord_ota_handle_t ota;
+    discord_handle_t shard_owner;                 /*<! Client which runs this shard, NULL for the client itself */
+    discord_shards_t* shards;                     /*<! Other shards run by this client, NULL if it runs only its own connection */
+    uint16_t shard_id;
+    uint16_t shard_count;                         /*<! Resolved at login, 0 if the connection is not sharded */
 };
 
 #ifdef __cplusplus
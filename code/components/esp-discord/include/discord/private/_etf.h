@@ -0,0 +1,120 @@
+#ifndef _DISCORD_PRIVATE_ETF_H_
+#define _DISCORD_PRIVATE_ETF_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cJSON.h"
+#include "discord/presence.h"
+#include "discord/private/_models.h"
+#include "discord/private/_json_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISCORD_ETF_VERSION          (131)
+
+enum {
+    DISCORD_ETF_NEW_FLOAT = 70,
+    DISCORD_ETF_SMALL_INTEGER = 97,
+    DISCORD_ETF_INTEGER = 98,
+    DISCORD_ETF_FLOAT = 99,
+    DISCORD_ETF_ATOM = 100,
+    DISCORD_ETF_SMALL_TUPLE = 104,
+    DISCORD_ETF_LARGE_TUPLE = 105,
+    DISCORD_ETF_NIL = 106,
+    DISCORD_ETF_STRING = 107,
+    DISCORD_ETF_LIST = 108,
+    DISCORD_ETF_BINARY = 109,
+    DISCORD_ETF_SMALL_BIG = 110,
+    DISCORD_ETF_LARGE_BIG = 111,
+    DISCORD_ETF_SMALL_ATOM = 115,
+    DISCORD_ETF_MAP = 116,
+    DISCORD_ETF_ATOM_UTF8 = 118,
+    DISCORD_ETF_SMALL_ATOM_UTF8 = 119,
+};
+
+/**
+ * @brief Writer of Erlang External Term Format into a fixed buffer. Nothing is allocated.
+ *        Writing past the end of the buffer only counts the bytes, so the overflow is checked once at the end
+ */
+typedef struct {
+    uint8_t* buffer;
+    size_t size;
+    size_t len;                                    /*<! Number of written bytes, can be bigger than size on overflow */
+} discord_etf_writer_t;
+
+void discord_etf_writer_init(discord_etf_writer_t* writer, uint8_t* buffer, size_t size);
+void discord_etf_write_map(discord_etf_writer_t* writer, uint32_t arity);
+/**
+ * @brief Write list header. Elements and discord_etf_write_list_end must follow. Empty list is only discord_etf_write_list_end
+ */
+void discord_etf_write_list(discord_etf_writer_t* writer, uint32_t length);
+void discord_etf_write_list_end(discord_etf_writer_t* writer);
+void discord_etf_write_atom(discord_etf_writer_t* writer, const char* atom);
+void discord_etf_write_binary(discord_etf_writer_t* writer, const char* str);
+void discord_etf_write_int(discord_etf_writer_t* writer, int64_t value);
+void discord_etf_write_bool(discord_etf_writer_t* writer, bool value);
+void discord_etf_write_nil(discord_etf_writer_t* writer);
+/**
+ * @return Length of the term or -1 if it does not fit into the buffer
+ */
+int discord_etf_writer_result(discord_etf_writer_t* writer);
+
+/**
+ * @brief Write outbound gateway payloads. Same frames as discord_json_write_*, PRESENCE_UPDATE and REQUEST_GUILD_MEMBERS
+ * @return Length of the frame or -1 if it does not fit into the buffer
+ */
+int discord_etf_write_heartbeat(uint8_t* buffer, size_t size, int seq);
+int discord_etf_write_identify(uint8_t* buffer, size_t size, const discord_identify_t* identify);
+int discord_etf_write_resume(uint8_t* buffer, size_t size, const char* token, const char* session_id, int seq);
+int discord_etf_write_presence(uint8_t* buffer, size_t size, discord_presence_t* presence);
+int discord_etf_write_request_guild_members(uint8_t* buffer, size_t size, const char* guild_id);
+
+/**
+ * @brief Prepare the pull reader (see discord_json_reader_t) for ETF term. Term must be writable,
+ *        strings are terminated in place by moving them over their length
+ */
+void discord_etf_reader_init(discord_json_reader_t* reader, uint8_t* data, size_t len);
+
+/**
+ * @brief Decode gateway payload straight into the models, same decoders as for JSON are used (see discord_json_read_payload)
+ * @return Payload or NULL if payload is not valid term
+ */
+discord_payload_t* discord_etf_read_payload(uint8_t* data, size_t len, discord_arena_pool_t* pool);
+
+/**
+ * @brief ETF implementation of the pull reader, discord_json_reader_* functions call these for ETF reader
+ */
+discord_json_type_t discord_etf_reader_peek(discord_json_reader_t* reader);
+bool discord_etf_reader_enter(discord_json_reader_t* reader, bool object);
+bool discord_etf_reader_next_key(discord_json_reader_t* reader, const char** out_key);
+bool discord_etf_reader_next_item(discord_json_reader_t* reader);
+int discord_etf_reader_count(discord_json_reader_t* reader);
+void discord_etf_reader_skip(discord_json_reader_t* reader);
+char* discord_etf_reader_string(discord_json_reader_t* reader, size_t* out_len);
+char* discord_etf_reader_strdup(discord_json_reader_t* reader);
+int64_t discord_etf_reader_int(discord_json_reader_t* reader, int64_t default_value);
+bool discord_etf_reader_bool(discord_json_reader_t* reader);
+
+/**
+ * @brief Decode the next value of the reader into cJSON tree, see discord_etf_to_cjson. Guild state events are decoded this way
+ * @return cJSON tree or NULL if value is not valid term (reader reports error then)
+ */
+cJSON* discord_etf_reader_cjson(discord_json_reader_t* reader);
+
+/**
+ * @brief Decode payload into the same cJSON tree which JSON encoding produces, so it can be passed to the same model decoders.
+ *        Map keys and binaries become strings, atoms nil, true and false become null and booleans,
+ *        big integers (snowflakes) become decimal strings.
+ *        Data is modified while decoding (strings are terminated in place and restored), so there must be one writable byte after the data
+ * @return cJSON tree or NULL if payload is not valid term
+ */
+cJSON* discord_etf_to_cjson(uint8_t* data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
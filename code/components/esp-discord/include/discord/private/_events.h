@@ -0,0 +1,58 @@
+#ifndef _DISCORD_PRIVATE_EVENTS_H_
+#define _DISCORD_PRIVATE_EVENTS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "discord.h"
+
+typedef struct discord_event_registration {
+    discord_event_t event;
+    discord_event_filter_t* filter;                /*<! Deep copy of the filter or NULL */
+    esp_event_handler_t handler;
+    void* handler_arg;
+    bool removed;                                  /*<! Unregistered while events were dispatched, will be freed afterwards */
+    struct discord_event_registration* next;
+} discord_event_registration_t;
+
+/**
+ * @brief Event properties which filters are applied to
+ */
+typedef struct {
+    bool scoped;                                   /*<! Event is related to a channel, so filters apply */
+    const char* channel_id;
+    const char* guild_id;                          /*<! NULL for direct messages */
+    int author_bot;                                /*<! 1 if author is a bot, 0 if not, -1 if event does not have an author */
+} discord_event_attrs_t;
+
+/**
+ * @brief Init registrations and register dispatcher in client event loop
+ */
+esp_err_t dcev_init(discord_handle_t client);
+esp_err_t dcev_register(discord_handle_t client, discord_event_t event, const discord_event_filter_t* filter, esp_event_handler_t handler, void* handler_arg);
+esp_err_t dcev_unregister(discord_handle_t client, discord_event_t event, esp_event_handler_t handler);
+void dcev_destroy(discord_handle_t client);
+/**
+ * @brief Get properties of decoded event data
+ */
+void dcev_attrs_from_data(discord_event_t event, discord_event_data_ptr_t data, discord_event_attrs_t* out_attrs);
+/**
+ * @brief Check if at least one registered handler is going to receive the event
+ */
+bool dcev_is_wanted(discord_handle_t client, discord_event_t event, const discord_event_attrs_t* attrs);
+/**
+ * @brief Calculate the minimal gateway intents for receiving all registered events
+ */
+int dcev_required_intents(discord_handle_t client);
+/**
+ * @brief Deep copy of NULL terminated list of ids (filters and config use the same lists)
+ */
+char** dcev_ids_copy(const char** ids);
+void dcev_ids_free(const char** ids);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
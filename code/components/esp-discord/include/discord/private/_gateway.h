@@ -11,9 +11,43 @@ extern "C" {
 
 esp_err_t dcgw_init(discord_handle_t client);
 /**
- * @brief Send payload (serialized to json) to gateway. Payload will be automatically freed
+ * @brief Send payload (serialized to json) to gateway. Payload will be automatically freed.
+ *        Sends are limited to DISCORD_GW_RATE_LIMIT per period. Payload which cannot be sent immediately
+ *        waits in the outbox (ordered by priority) and newer presence update replaces the waiting one
+ * @return ESP_OK if payload is sent or waits in the outbox
  */
 esp_err_t dcgw_send(discord_handle_t client, discord_payload_t* payload);
+/**
+ * @brief Send outbound payloads which have their token already. Must be called from the discord task
+ */
+void dcgw_outbox_flush(discord_handle_t client);
+/**
+ * @brief Remember the presence and schedule its sending. Update identical to the last one is ignored,
+ *        updates within DISCORD_GW_PRESENCE_INTERVAL_MS replace the waiting one
+ */
+esp_err_t dcgw_presence_update(discord_handle_t client, const discord_presence_t* presence);
+/**
+ * @brief Take over the waiting (or the last) presence of the other client, so a new shard starts with the presence of the bot
+ */
+esp_err_t dcgw_presence_inherit(discord_handle_t client, discord_handle_t from);
+/**
+ * @brief Send the waiting presence when presence timer expires. Must be called from the discord task
+ */
+void dcgw_presence_flush(discord_handle_t client);
+/**
+ * @brief Check if there is a session (and sequence number) which can be resumed after reconnection
+ */
+bool dcgw_can_resume(discord_handle_t client);
+/**
+ * @brief Decide using only the fields captured while streaming whether payload is worth decoding.
+ *        Same rules as in dcgw_whether_payload_should_go_into_queue, but applied before any allocation.
+ *        Payload is decoded if there is not enough information to decide. Heartbeat ACK never gets here
+ */
+bool dcgw_whether_payload_should_be_decoded(discord_handle_t client, discord_json_stream_t* stream);
+/**
+ * @brief Forget the session so the next connection will start a new one using IDENTIFY
+ */
+void dcgw_session_invalidate(discord_handle_t client);
 bool dcgw_is_open(discord_handle_t client);
 esp_err_t dcgw_open(discord_handle_t client);
 esp_err_t dcgw_start(discord_handle_t client);
@@ -21,8 +55,81 @@ esp_err_t dcgw_close(discord_handle_t client, discord_gateway_close_reason_t rea
 esp_err_t dcgw_get_close_desc(discord_handle_t client, char** out_description);
 esp_err_t dcgw_destroy(discord_handle_t client);
 esp_err_t dcgw_queue_flush(discord_handle_t client);
-esp_err_t dcgw_heartbeat_send_if_expired(discord_handle_t client);
+/**
+ * @brief Send IDENTIFY when identify timer (identify rate limit of the shards) expires
+ */
+esp_err_t dcgw_identify(discord_handle_t client);
+/**
+ * @brief Send heartbeat when heartbeat timer expires. Connection is closed if previous heartbeat is not acknowledged
+ */
+esp_err_t dcgw_heartbeat_send(discord_handle_t client);
+/**
+ * @brief Close the connection if ACK of the last heartbeat has not arrived by the deadline (gateway_ack_timeout_ms)
+ */
+void dcgw_heartbeat_check_ack(discord_handle_t client);
+/**
+ * @brief Close the connection if nothing has been received for gateway_silence_timeout_ms, otherwise move the deadline
+ */
+void dcgw_check_silence(discord_handle_t client);
+/**
+ * @brief Calculate latency statistics from the heartbeat RTT window
+ */
+void dcgw_get_latency(discord_handle_t client, discord_gateway_latency_t* out_latency);
+/**
+ * @brief Fire DISCORD_EVENT_GATEWAY_LATENCY if RTT crossed the threshold since the last call. Must be called from the discord task
+ */
+void dcgw_latency_fire_if_crossed(discord_handle_t client);
+/**
+ * @brief Count reconnection attempt and calculate how long to wait before it, depending on close reason.
+ *        Reconnection requested by Discord is immediate, other reconnections are delayed using
+ *        exponential backoff with jitter, so the clients which lost connection at the same time do not reconnect together
+ */
+uint32_t dcgw_reconnect_schedule(discord_handle_t client);
+/**
+ * @brief Switch to the standby connection once it has received HELLO, or drop it if it failed. Must be called from the discord task
+ */
+void dcgw_standby_step(discord_handle_t client);
+/**
+ * @brief Standby connection is opening, so the lost connection is going to be replaced by it instead of reconnecting
+ */
+bool dcgw_standby_is_warming(discord_handle_t client);
+/**
+ * @brief Handle control opcodes signaled by DISCORD_TASK_BIT_* notification bits
+ */
+void dcgw_handle_control(discord_handle_t client, uint32_t bits);
 esp_err_t dcgw_handle_payload(discord_handle_t client, discord_payload_t* payload);
+/**
+ * @brief Copy roles/channels of the guild from the guild cache
+ * @return ESP_OK or ESP_ERR_NOT_FOUND if the cache is disabled or the guild is not cached
+ */
+esp_err_t dcgw_guild_cache_get_roles(discord_handle_t client, const char* guild_id, discord_role_t*** out_roles, discord_role_len_t* out_length);
+esp_err_t dcgw_guild_cache_get_channels(discord_handle_t client, const char* guild_id, discord_channel_t*** out_channels, int* out_length);
+/**
+ * @brief Put roles/channels fetched over REST API into the guild cache.
+ *        Nothing is done if GUILDS intent is not requested, since the cache would not be kept current
+ */
+void dcgw_guild_cache_set_roles(discord_handle_t client, const char* guild_id, discord_role_t** roles, discord_role_len_t len);
+void dcgw_guild_cache_set_channels(discord_handle_t client, const char* guild_id, discord_channel_t** channels, int len);
+void dcgw_guild_cache_get_stats(discord_handle_t client, discord_gateway_stats_t* out_stats);
+/**
+ * @brief Check if the member cache is configured (member_cache_size and at least one guild)
+ */
+bool dcgw_member_cache_enabled(discord_handle_t client);
+/**
+ * @brief Copy the member from the member cache
+ * @return ESP_OK or ESP_ERR_NOT_FOUND if the cache is disabled, guild is not configured or the member is not cached
+ */
+esp_err_t dcgw_member_cache_get(discord_handle_t client, const char* guild_id, const char* user_id, discord_member_t** out_member);
+/**
+ * @brief Put the member fetched over REST API into the member cache.
+ *        Nothing is done if the guild is not configured or GUILD_MEMBERS intent is not requested
+ */
+void dcgw_member_cache_put(discord_handle_t client, const char* guild_id, const char* user_id, const discord_member_t* member);
+void dcgw_member_cache_get_stats(discord_handle_t client, discord_gateway_stats_t* out_stats);
+/**
+ * @brief Push recorded frames through the same path as the received ones, without network. Gateway must not be open
+ */
+esp_err_t dcgw_replay(discord_handle_t client, const char* path);
 
 #ifdef __cplusplus
 }
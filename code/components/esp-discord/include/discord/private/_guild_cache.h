@@ -0,0 +1,103 @@
+#ifndef _DISCORD_PRIVATE_GUILD_CACHE_H_
+#define _DISCORD_PRIVATE_GUILD_CACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "discord/role.h"
+#include "discord/channel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint64_t id;
+    uint64_t permissions;
+    discord_role_len_t position;
+    char* name;
+} discord_guild_cache_role_t;
+
+typedef struct {
+    uint64_t id;
+    discord_channel_type_t type;
+    char* name;
+} discord_guild_cache_channel_t;
+
+typedef struct discord_guild_cache_guild {
+    uint64_t id;
+    bool roles_cached;
+    bool channels_cached;
+    discord_guild_cache_role_t* roles;
+    uint16_t roles_len;
+    discord_guild_cache_channel_t* channels;
+    uint16_t channels_len;
+    size_t size;                                   /*<! Bytes accounted to this guild */
+    struct discord_guild_cache_guild* next;        /*<! Less recently used guild */
+} discord_guild_cache_guild_t;
+
+/**
+ * @brief Roles and channels of the guilds, kept current by the gateway events so the lookups do not need REST requests.
+ *        Snowflakes are stored as integers and every guild is accounted with the bytes it takes. When the cache grows
+ *        over its limit, least recently used guilds are evicted. Cache is not thread safe
+ */
+typedef struct {
+    discord_guild_cache_guild_t* guilds;           /*<! Most recently used first */
+    size_t size;                                   /*<! Bytes taken by all guilds */
+    size_t limit;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+} discord_guild_cache_t;
+
+void discord_guild_cache_init(discord_guild_cache_t* cache, size_t limit);
+
+/**
+ * @brief Replace all roles of the guild. Guild is added if it is not in the cache
+ * @return ESP_OK or ESP_ERR_INVALID_SIZE if the guild alone does not fit into the limit (guild is removed then)
+ */
+esp_err_t discord_guild_cache_set_roles(discord_guild_cache_t* cache, const char* guild_id, discord_role_t** roles, int len);
+
+/**
+ * @brief Replace all channels of the guild. Guild is added if it is not in the cache
+ * @return ESP_OK or ESP_ERR_INVALID_SIZE if the guild alone does not fit into the limit (guild is removed then)
+ */
+esp_err_t discord_guild_cache_set_channels(discord_guild_cache_t* cache, const char* guild_id, discord_channel_t** channels, int len);
+
+/**
+ * @brief Add or update the role. Nothing is done if roles of the guild are not cached
+ */
+esp_err_t discord_guild_cache_put_role(discord_guild_cache_t* cache, const char* guild_id, const discord_role_t* role);
+esp_err_t discord_guild_cache_remove_role(discord_guild_cache_t* cache, const char* guild_id, const char* role_id);
+
+/**
+ * @brief Add or update the channel. Nothing is done if channels of the guild are not cached
+ */
+esp_err_t discord_guild_cache_put_channel(discord_guild_cache_t* cache, const char* guild_id, const discord_channel_t* channel);
+esp_err_t discord_guild_cache_remove_channel(discord_guild_cache_t* cache, const char* guild_id, const char* channel_id);
+
+void discord_guild_cache_remove_guild(discord_guild_cache_t* cache, const char* guild_id);
+
+/**
+ * @brief Copy cached roles of the guild. Roles need to be freed like the ones received from discord_role_get_all
+ * @return ESP_OK or ESP_ERR_NOT_FOUND if roles of the guild are not cached
+ */
+esp_err_t discord_guild_cache_get_roles(discord_guild_cache_t* cache, const char* guild_id, discord_role_t*** out_roles, discord_role_len_t* out_length);
+
+/**
+ * @brief Copy cached channels of the guild. Channels need to be freed like the ones received from discord_guild_get_channels
+ * @return ESP_OK or ESP_ERR_NOT_FOUND if channels of the guild are not cached
+ */
+esp_err_t discord_guild_cache_get_channels(discord_guild_cache_t* cache, const char* guild_id, discord_channel_t*** out_channels, int* out_length);
+
+/**
+ * @brief Remove all guilds. Cache can be used afterwards
+ */
+void discord_guild_cache_clear(discord_guild_cache_t* cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
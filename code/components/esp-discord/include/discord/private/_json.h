@@ -13,6 +13,7 @@
 #include "discord/role.h"
 #include "discord/attachment.h"
 #include "discord/voice_state.h"
+#include "discord/presence.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -53,29 +54,96 @@ extern "C" {
 #define discord_json_list_deserialize_(obj_name, json, length, out_length) \
     discord_json_list_deserialize(discord_ ##obj_name ##_t, discord_ ##obj_name ##_from_cjson, json, length, out_length)
 
-cJSON* discord_payload_to_cjson(discord_payload_t* payload);
+/**
+ * @brief Map dispatch event name (payload "t" field) to event
+ * @return Event or DISCORD_EVENT_UNKNOWN if event is not supported
+ */
+discord_event_t discord_model_event_by_name(const char* name);
+
 discord_payload_t* discord_payload_from_cjson(cJSON* cjson);
 
 discord_payload_data_t discord_dispatch_event_data_from_cjson(discord_event_t e, cJSON* cjson);
 
-cJSON* discord_heartbeat_to_cjson(discord_heartbeat_t* heartbeat);
-
-cJSON* discord_identify_properties_to_cjson(discord_identify_properties_t* properties);
+/**
+ * @brief Writer of JSON text, counterpart of discord_etf_writer_t. Values are written in document order straight from the models,
+ *        so no tree is built. Writing past the end of the buffer only counts bytes, which lets the exact length be measured first
+ *        (with NULL buffer) and the text be written into a single allocation afterwards. Commas are written by the writer
+ */
+typedef struct {
+    char* buffer;
+    size_t size;
+    size_t len;                                    /*<! Number of written bytes, can be bigger than size on overflow */
+    bool after_value;                              /*<! Value of the current container has been written, separator comes next */
+} discord_json_writer_t;
+
+void discord_json_writer_init(discord_json_writer_t* writer, char* buffer, size_t size);
+void discord_json_write_object(discord_json_writer_t* writer);
+void discord_json_write_object_end(discord_json_writer_t* writer);
+void discord_json_write_array(discord_json_writer_t* writer);
+void discord_json_write_array_end(discord_json_writer_t* writer);
+/**
+ * @brief Write member key. Keys are literals of this library, so they are not escaped
+ */
+void discord_json_write_key(discord_json_writer_t* writer, const char* key);
+/**
+ * @brief Write quoted and escaped string, null if str is NULL
+ */
+void discord_json_write_string(discord_json_writer_t* writer, const char* str);
+void discord_json_write_int(discord_json_writer_t* writer, int64_t value);
+void discord_json_write_bool(discord_json_writer_t* writer, bool value);
+void discord_json_write_null(discord_json_writer_t* writer);
+/**
+ * @brief Terminate the text
+ * @return Length of the text or -1 if it (with the terminator) does not fit into the buffer
+ */
+int discord_json_writer_result(discord_json_writer_t* writer);
+
+/**
+ * @brief Measure the text written by write_fnc(writer, obj), then write it into an allocation of the exact size
+ * @return Text owned by the caller or NULL if allocation fails
+ */
+#define discord_json_write_alloc(write_fnc, obj) ({ \
+        discord_json_writer_t _writer; \
+        discord_json_writer_init(&_writer, NULL, 0); \
+        write_fnc(&_writer, obj); \
+        size_t _size = _writer.len + 1; \
+        char* _json = malloc(_size); \
+        if(_json) { \
+            discord_json_writer_init(&_writer, _json, _size); \
+            write_fnc(&_writer, obj); \
+            if(discord_json_writer_result(&_writer) < 0) { free(_json); _json = NULL; } \
+        } \
+        _json; \
+    })
 
-cJSON* discord_identify_to_cjson(discord_identify_t* identify);
+/**
+ * @brief Write outbound gateway payloads directly into the buffer, without any heap allocation
+ * @return Length of the frame or -1 if it does not fit into the buffer
+ */
+int discord_json_write_heartbeat(char* buffer, size_t size, int seq);
+int discord_json_write_identify(char* buffer, size_t size, const discord_identify_t* identify);
+int discord_json_write_resume(char* buffer, size_t size, const char* token, const char* session_id, int seq);
+int discord_json_write_presence(char* buffer, size_t size, const discord_presence_t* presence);
+int discord_json_write_request_guild_members(char* buffer, size_t size, const char* guild_id);
+
+/**
+ * @brief Status name used by Discord ("online", "dnd", ...)
+ */
+const char* discord_presence_status_name(discord_presence_status_t status);
+
+/**
+ * @brief Write message (REST API request body) and embed. Use discord_json_write_alloc to get the text
+ */
+void discord_json_write_message(discord_json_writer_t* writer, const discord_message_t* message);
+void discord_json_write_embed(discord_json_writer_t* writer, const discord_embed_t* embed);
 
 discord_session_t* discord_session_from_cjson(cJSON* root);
 
 discord_user_t* discord_user_from_cjson(cJSON* root);
-cJSON* discord_user_to_cjson(discord_user_t* user);
 
 discord_member_t* discord_member_from_cjson(cJSON* root);
-cJSON* discord_member_to_cjson(discord_member_t* member);
 
 discord_attachment_t* discord_attachment_from_cjson(cJSON* root);
-cJSON* discord_attachment_to_cjson(discord_attachment_t* attachment);
-
-cJSON* discord_embed_to_cjson(discord_embed_t* embed);
 
 discord_guild_t* discord_guild_from_cjson(cJSON* root);
 cJSON* discord_guild_to_cjson(discord_guild_t* guild);
@@ -87,7 +155,6 @@ discord_role_t* discord_role_from_cjson(cJSON* root);
 cJSON* discord_role_to_cjson(discord_role_t* role);
 
 discord_message_t* discord_message_from_cjson(cJSON* root);
-cJSON* discord_message_to_cjson(discord_message_t* msg);
 
 discord_emoji_t* discord_emoji_from_cjson(cJSON* root);
 
@@ -95,6 +162,11 @@ discord_message_reaction_t* discord_message_reaction_from_cjson(cJSON* root);
 
 discord_voice_state_t* discord_voice_state_from_cjson(cJSON* root);
 
+/**
+ * @brief Decode data of GUILD_*, GUILD_ROLE_* and CHANNEL_* events which keep the guild cache current
+ */
+discord_guild_state_t* discord_guild_state_from_cjson(discord_event_t e, cJSON* root);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,131 @@
+#ifndef _DISCORD_PRIVATE_JSON_READER_H_
+#define _DISCORD_PRIVATE_JSON_READER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "discord/private/_models.h"
+#include "discord/private/_arena.h"
+#include "discord/message.h"
+#include "discord/member.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISCORD_ETF_MAX_DEPTH        (24)   /*<! Deeper terms are rejected, decoder is recursive */
+
+typedef enum {
+    DISCORD_JSON_NONE,                             /*<! End of the container, end of the input or syntax error */
+    DISCORD_JSON_NULL,
+    DISCORD_JSON_BOOL,
+    DISCORD_JSON_NUMBER,
+    DISCORD_JSON_STRING,
+    DISCORD_JSON_OBJECT,
+    DISCORD_JSON_ARRAY
+} discord_json_type_t;
+
+/**
+ * @brief Pull tokenizer over a complete JSON document. Values are read in document order straight into the models,
+ *        so no tree is built. Strings are unescaped and terminated in place, that is why the input must be writable.
+ *        Skipped values are not modified and nothing is allocated by the reader.
+ *        Once syntax error is found, reader reports end of every container, so decoding loops simply finish.
+ *        Same reader walks ETF terms (see discord_etf_reader_init), so both encodings share the model decoders
+ */
+typedef struct {
+    char* pos;
+    char* end;
+    bool after_value;                              /*<! Value of the current container has been read, separator comes next */
+    bool error;
+    discord_arena_t* arena;                        /*<! Models and strings are allocated here, NULL for heap */
+    bool etf;                                      /*<! Input is ETF term instead of JSON */
+    uint8_t depth;                                 /*<! Number of entered ETF containers */
+    uint32_t tails;                                /*<! Bit per depth, set if ETF container is a list which ends with a tail */
+    uint32_t left[DISCORD_ETF_MAX_DEPTH];          /*<! Items (or map members) which are still expected in each ETF container */
+} discord_json_reader_t;
+
+void discord_json_reader_init(discord_json_reader_t* reader, char* json, size_t len);
+
+/**
+ * @brief Type of the next value, nothing is consumed
+ */
+discord_json_type_t discord_json_reader_peek(discord_json_reader_t* reader);
+
+/**
+ * @brief Enter the object (or the array). Value of any other type is skipped
+ * @return false if the next value is not an object (array)
+ */
+bool discord_json_reader_object(discord_json_reader_t* reader);
+bool discord_json_reader_array(discord_json_reader_t* reader);
+
+/**
+ * @brief Move to the next member of the object. Value of the member must be read or skipped before the next call
+ * @param out_key Key of the member, valid until the input is released
+ * @return false at the end of the object
+ */
+bool discord_json_reader_next_key(discord_json_reader_t* reader, const char** out_key);
+
+/**
+ * @brief Move to the next item of the array. Item must be read or skipped before the next call
+ * @return false at the end of the array
+ */
+bool discord_json_reader_next_item(discord_json_reader_t* reader);
+
+/**
+ * @brief Count items of the array which is the next value, nothing is consumed. Lets lists be allocated at once
+ */
+int discord_json_reader_count(discord_json_reader_t* reader);
+
+/**
+ * @brief Skip the next value with all nested values
+ */
+void discord_json_reader_skip(discord_json_reader_t* reader);
+
+/**
+ * @brief Read string value in place
+ * @return String inside of the input or NULL if value is null or not a string (value is skipped then)
+ */
+char* discord_json_reader_string(discord_json_reader_t* reader, size_t* out_len);
+
+/**
+ * @brief Read string value into the new allocation, which is owned by the caller (or the arena of the reader)
+ */
+char* discord_json_reader_strdup(discord_json_reader_t* reader);
+
+/**
+ * @brief Read integer part of the number
+ * @return Value or default_value if value is not a number
+ */
+int64_t discord_json_reader_int(discord_json_reader_t* reader, int64_t default_value);
+
+/**
+ * @return true if value is true, false for any other value
+ */
+bool discord_json_reader_bool(discord_json_reader_t* reader);
+
+/**
+ * @brief Decode gateway payload in one pass. Unknown members (and fields which models do not have) are skipped without allocating.
+ *        Data of guild state events is decoded by cJSON decoders, only the "d" member is parsed to the tree then.
+ *        Input is modified, see discord_json_reader_t
+ * @param pool Data of the events delivered to the handlers is allocated in one arena taken from this pool,
+ *        and it is freed at once with the payload. NULL allocates data field by field
+ * @return Payload or NULL on syntax error
+ */
+discord_payload_t* discord_json_read_payload(char* json, size_t len, discord_arena_pool_t* pool);
+
+/**
+ * @brief Decode gateway payload from the initialized reader of either encoding, see discord_json_read_payload
+ */
+discord_payload_t* discord_json_read_payload_from(discord_json_reader_t* reader, discord_arena_pool_t* pool);
+
+/**
+ * @brief Decode REST API responses. Same rules as for discord_json_read_payload apply
+ */
+discord_message_t* discord_json_read_message(char* json, size_t len);
+discord_member_t* discord_json_read_member(char* json, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,158 @@
+#ifndef _DISCORD_PRIVATE_JSON_STREAM_H_
+#define _DISCORD_PRIVATE_JSON_STREAM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "discord/private/_member_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISCORD_JSON_STREAM_MAX_DEPTH  (32)
+#define DISCORD_JSON_STREAM_KEY_MAX    (32)
+#define DISCORD_JSON_STREAM_FIELD_MAX  (40)
+
+typedef enum {
+    DISCORD_JSON_STREAM_VALUE,
+    DISCORD_JSON_STREAM_VALUE_OR_END,
+    DISCORD_JSON_STREAM_KEY,
+    DISCORD_JSON_STREAM_KEY_OR_END,
+    DISCORD_JSON_STREAM_KEY_STRING,
+    DISCORD_JSON_STREAM_KEY_STRING_ESC,
+    DISCORD_JSON_STREAM_COLON,
+    DISCORD_JSON_STREAM_STRING,
+    DISCORD_JSON_STREAM_STRING_ESC,
+    DISCORD_JSON_STREAM_LITERAL,
+    DISCORD_JSON_STREAM_AFTER_VALUE,
+    DISCORD_JSON_STREAM_ETF_VERSION,
+    DISCORD_JSON_STREAM_ETF_TAG,
+    DISCORD_JSON_STREAM_ETF_HEADER,
+    DISCORD_JSON_STREAM_ETF_BODY,
+    DISCORD_JSON_STREAM_DONE,
+    DISCORD_JSON_STREAM_ERROR
+} discord_json_stream_state_t;
+
+/**
+ * @brief Scalar values which are captured while payload is scanned,
+ *        so the payload can be routed (or ignored) without being decoded
+ */
+typedef enum {
+    DISCORD_JSON_STREAM_FIELD_NONE = -1,
+    DISCORD_JSON_STREAM_FIELD_OP,                  /*<! op */
+    DISCORD_JSON_STREAM_FIELD_S,                   /*<! s */
+    DISCORD_JSON_STREAM_FIELD_T,                   /*<! t */
+    DISCORD_JSON_STREAM_FIELD_TYPE,                /*<! d.type */
+    DISCORD_JSON_STREAM_FIELD_CHANNEL_ID,          /*<! d.channel_id */
+    DISCORD_JSON_STREAM_FIELD_GUILD_ID,            /*<! d.guild_id */
+    DISCORD_JSON_STREAM_FIELD_USER_ID,             /*<! d.user_id */
+    DISCORD_JSON_STREAM_FIELD_AUTHOR_ID,           /*<! d.author.id */
+    DISCORD_JSON_STREAM_FIELD_AUTHOR_BOT,          /*<! d.author.bot */
+    _DISCORD_JSON_STREAM_FIELD_COUNT
+} discord_json_stream_field_t;
+
+/**
+ * @brief Called for every member of GUILD_MEMBERS_CHUNK. Members are scanned while they are skipped, so the chunk is never retained.
+ *        If "t" follows "d", members of d.members are scanned before the event is known. Handler has to keep them
+ *        until the payload is done and check the event then
+ */
+typedef void (*discord_json_stream_member_handler_t)(void* arg, const discord_member_record_t* member);
+
+/**
+ * @brief Resumable JSON scanner which consumes gateway payload fragments as they arrive
+ *        and copies only the data that is going to be decoded into the output buffer.
+ *        Whitespace is dropped and members of the "d" object whose keys are in the prune list
+ *        are skipped without being stored, so the output buffer needs to be only as large as the retained data.
+ *        ETF payloads are scanned term by term and pruned the same way, arity of the "d" map is fixed once it ends
+ */
+typedef struct {
+    char* buffer;                                  /*<! Output buffer. Must be able to hold size + 1 bytes (null terminator) */
+    size_t size;                                   /*<! Maximum number of retained bytes */
+    size_t len;                                    /*<! Number of retained bytes */
+    const char* const* prune_keys;                 /*<! NULL terminated list of "d" member keys that will be skipped */
+    discord_json_stream_state_t state;
+    uint8_t depth;
+    uint8_t skip_depth;                            /*<! Depth of the object whose member is being skipped (0 if nothing is skipped) */
+    uint32_t arrays;                               /*<! Bit per depth, set if container on that depth is array */
+    uint32_t members;                              /*<! Bit per depth, set if container on that depth already has retained members */
+    bool in_data;                                  /*<! Currently inside of the top-level "d" member */
+    char key[DISCORD_JSON_STREAM_KEY_MAX + 1];
+    uint8_t key_len;
+    bool key_matchable;                            /*<! False if key is too long or contains escapes */
+    bool key_pending;                              /*<! Key is held back in key buffer and not written yet */
+    bool in_author;                                /*<! Currently inside of the "d.author" member */
+    discord_json_stream_field_t field;             /*<! Field which is captured from the current value */
+    uint8_t field_len;
+    char fields[_DISCORD_JSON_STREAM_FIELD_COUNT][DISCORD_JSON_STREAM_FIELD_MAX + 1];
+    discord_json_stream_member_handler_t member_handler; /*<! NULL if members of GUILD_MEMBERS_CHUNK are just pruned */
+    void* member_handler_arg;
+    uint8_t member_scan;                           /*<! Flags of the member which is being scanned (0 if members are not scanned) */
+    uint8_t member_value;                          /*<! Member value which is being scanned */
+    uint8_t member_len;                            /*<! Length of the scanned nick */
+    discord_member_record_t member;
+    bool etf;                                      /*<! Payload is ETF term instead of JSON */
+    uint8_t etf_tag;                               /*<! Tag of the current term */
+    bool etf_key;                                  /*<! Current term is a map key */
+    bool etf_negative;
+    uint8_t etf_header_len;                        /*<! Header bytes (length or arity) of the current term which are still expected */
+    uint32_t etf_n;                                /*<! Length or arity from the header of the current term */
+    uint32_t etf_body_len;                         /*<! Body bytes of the current term which are still expected */
+    uint64_t etf_value;                            /*<! Integer value of the current term */
+    size_t etf_key_start;                          /*<! Output length before the current key. Key is written right away and removed if its member is pruned */
+    size_t etf_arity_at;                           /*<! Output offset of the "d" map arity (0 if "d" is not a map) */
+    uint32_t etf_arity;                            /*<! Original arity of the "d" map */
+    uint32_t etf_pruned;                           /*<! Pruned members of the "d" map */
+    uint32_t etf_left[DISCORD_JSON_STREAM_MAX_DEPTH]; /*<! Terms which are still expected in the container on each depth */
+} discord_json_stream_t;
+
+/**
+ * @brief List of "d" member keys which are never decoded by the library
+ */
+extern const char* const discord_json_stream_default_prune_keys[];
+
+/**
+ * @brief Default list without "roles", which GUILD_MEMBER_ADD and GUILD_MEMBER_UPDATE carry for the member cache
+ */
+#define discord_json_stream_member_cache_prune_keys (discord_json_stream_default_prune_keys + 1)
+
+/**
+ * @brief Default list without "roles" and "channels", which GUILD_CREATE carries for the guild cache
+ */
+#define discord_json_stream_guild_cache_prune_keys (discord_json_stream_default_prune_keys + 2)
+
+/**
+ * @brief Prepare the stream for the new payload. Output buffer and encoding are reused
+ */
+void discord_json_stream_reset(discord_json_stream_t* stream);
+
+/**
+ * @brief Feed the next fragment of the payload
+ * @return ESP_OK if fragment is consumed, ESP_ERR_INVALID_SIZE if retained data cannot fit into the buffer,
+ *         ESP_FAIL on syntax error. Once error is returned, stream ignores the rest of payload until reset
+ */
+esp_err_t discord_json_stream_feed(discord_json_stream_t* stream, const char* data, size_t len);
+
+/**
+ * @brief Check if the whole top-level value has been received
+ */
+bool discord_json_stream_is_done(discord_json_stream_t* stream);
+
+/**
+ * @brief Get captured field. Strings are returned without quotes and escapes are not decoded
+ * @return Raw value or NULL if field is not present in payload (or it is null, or too long)
+ */
+const char* discord_json_stream_get_field(discord_json_stream_t* stream, discord_json_stream_field_t field);
+
+/**
+ * @brief Get captured numeric field
+ * @return Value of the field or default_value if field is not present
+ */
+int discord_json_stream_get_int_field(discord_json_stream_t* stream, discord_json_stream_field_t field, int default_value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef _DISCORD_PRIVATE_MEMBER_CACHE_H_
+#define _DISCORD_PRIVATE_MEMBER_CACHE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "discord/member.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISCORD_MEMBER_CACHE_ROLES_MAX  (16)       /*<! Members with more roles are not cached */
+#define DISCORD_MEMBER_CACHE_NICK_MAX   (128)      /*<! Nick has up to 32 characters (up to 4 bytes each) */
+
+/**
+ * @brief Member as it is scanned from the payload, before it is put into the cache
+ */
+typedef struct {
+    uint64_t user_id;
+    uint64_t roles[DISCORD_MEMBER_CACHE_ROLES_MAX];
+    uint8_t roles_len;
+    bool has_nick;
+    char nick[DISCORD_MEMBER_CACHE_NICK_MAX + 1];
+} discord_member_record_t;
+
+typedef struct discord_member_cache_entry {
+    struct discord_member_cache_entry* next;       /*<! Less recently used member */
+    uint64_t guild_id;
+    uint64_t user_id;
+    uint8_t roles_len;
+    bool has_nick;
+    uint64_t roles[];                              /*<! Followed by null terminated nick */
+} discord_member_cache_entry_t;
+
+/**
+ * @brief Members of the guilds, each stored in a single allocation. When the cache grows over its limit,
+ *        least recently used members are evicted. Cache is not thread safe
+ */
+typedef struct {
+    discord_member_cache_entry_t* members;         /*<! Most recently used first */
+    size_t size;                                   /*<! Bytes taken by all members */
+    size_t limit;
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    discord_member_cache_entry_t* staged;          /*<! Members waiting for discord_member_cache_commit, oldest first */
+    discord_member_cache_entry_t* staged_last;
+    size_t staged_size;
+} discord_member_cache_t;
+
+void discord_member_cache_init(discord_member_cache_t* cache, size_t limit);
+
+/**
+ * @brief Add or replace the member
+ * @return ESP_OK or ESP_ERR_INVALID_SIZE if the member alone does not fit into the limit
+ */
+esp_err_t discord_member_cache_put(discord_member_cache_t* cache, const char* guild_id, const discord_member_record_t* record);
+
+/**
+ * @brief Keep the member until it is known which guild it belongs to, or whether it should be cached at all.
+ *        Staged members are bounded by the limit as well, the oldest ones are dropped (commit would evict them)
+ * @return ESP_OK or ESP_ERR_INVALID_SIZE if the member alone does not fit into the limit
+ */
+esp_err_t discord_member_cache_stage(discord_member_cache_t* cache, const discord_member_record_t* record);
+
+/**
+ * @brief Add or replace all staged members as members of the guild
+ */
+void discord_member_cache_commit(discord_member_cache_t* cache, const char* guild_id);
+
+/**
+ * @brief Drop staged members without caching them
+ */
+void discord_member_cache_drop_staged(discord_member_cache_t* cache);
+
+void discord_member_cache_remove(discord_member_cache_t* cache, const char* guild_id, const char* user_id);
+
+/**
+ * @brief Copy the cached member. Member needs to be freed like the one received from discord_member_get
+ * @return ESP_OK or ESP_ERR_NOT_FOUND if the member is not cached
+ */
+esp_err_t discord_member_cache_get(discord_member_cache_t* cache, const char* guild_id, const char* user_id, discord_member_t** out_member);
+
+/**
+ * @brief Remove all members, staged ones too. Cache can be used afterwards
+ */
+void discord_member_cache_clear(discord_member_cache_t* cache);
+
+/**
+ * @brief Convert the member received over REST API
+ * @return ESP_OK or ESP_ERR_INVALID_SIZE if member has too many roles or too long nick to be cached
+ */
+esp_err_t discord_member_record_from_member(const char* user_id, const discord_member_t* member, discord_member_record_t* out_record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
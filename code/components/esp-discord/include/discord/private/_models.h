@@ -3,6 +3,13 @@
 
 #include "cJSON.h"
 #include "discord.h"
+#include "discord/role.h"
+#include "discord/channel.h"
+#include "discord/presence.h"
+#include "discord/message.h"
+#include "discord/voice_state.h"
+#include "discord/private/_member_cache.h"
+#include "discord/private/_arena.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,6 +17,28 @@ extern "C" {
 
 #define DISCORD_NULL_SEQUENCE_NUMBER 0
 
+/**
+ * @brief Events which are never fired. They only keep the guild and member caches current
+ */
+enum {
+    DISCORD_EVENT_GUILD_CREATED = 0x100,
+    DISCORD_EVENT_GUILD_UPDATED,
+    DISCORD_EVENT_GUILD_DELETED,
+    DISCORD_EVENT_GUILD_ROLE_CREATED,
+    DISCORD_EVENT_GUILD_ROLE_UPDATED,
+    DISCORD_EVENT_GUILD_ROLE_DELETED,
+    DISCORD_EVENT_CHANNEL_CREATED,
+    DISCORD_EVENT_CHANNEL_UPDATED,
+    DISCORD_EVENT_CHANNEL_DELETED,
+    DISCORD_EVENT_GUILD_MEMBERS_CHUNK,
+    DISCORD_EVENT_GUILD_MEMBER_ADDED,
+    DISCORD_EVENT_GUILD_MEMBER_UPDATED,
+    DISCORD_EVENT_GUILD_MEMBER_REMOVED,
+};
+
+#define DISCORD_EVENT_IS_GUILD_STATE(event) ((int) (event) >= DISCORD_EVENT_GUILD_CREATED && (int) (event) <= DISCORD_EVENT_GUILD_MEMBER_REMOVED)
+#define DISCORD_EVENT_IS_MEMBER_STATE(event) ((int) (event) >= DISCORD_EVENT_GUILD_MEMBERS_CHUNK && (int) (event) <= DISCORD_EVENT_GUILD_MEMBER_REMOVED)
+
 typedef void* discord_payload_data_t;
 
 typedef struct {
@@ -17,35 +46,67 @@ typedef struct {
     discord_payload_data_t d;
     int s;
     discord_event_t t;
+    discord_arena_t* arena;                        /*<! Data is allocated in the arena and freed with it at once. NULL if data is allocated field by field */
 } discord_payload_t;
 
 typedef struct {
     int heartbeat_interval;
 } discord_hello_t;
 
-typedef int discord_heartbeat_t;
-
 typedef struct {
-    char* os;
-    char* browser;
-    char* device;
-} discord_identify_properties_t;
+    bool resumable;
+} discord_invalid_session_t;
 
+/**
+ * @brief Fields of IDENTIFY. Optional fields which are zero (or NULL) are not sent, so Discord defaults apply
+ */
 typedef struct {
-    char* token;
+    const char* token;
     int intents;
-    discord_identify_properties_t* properties;
+    uint8_t large_threshold;               /*<! 50 - 250 */
+    bool compress;                         /*<! Payload compression */
+    const discord_presence_t* presence;    /*<! Initial presence of the session */
+    uint16_t shard_id;
+    uint16_t shard_count;                  /*<! 0 if the connection is not sharded */
 } discord_identify_t;
 
+/**
+ * @brief Data of the guild state events
+ */
+typedef struct {
+    char* guild_id;
+    char* id;                              /*<! Deleted role, channel or member */
+    discord_role_t** roles;                /*<! NULL if the event does not carry roles */
+    int roles_len;
+    discord_channel_t** channels;          /*<! NULL if the event does not carry channels */
+    int channels_len;
+    discord_member_record_t* members;      /*<! NULL if the event does not carry members (members of JSON chunks are scanned while streaming) */
+    int members_len;
+    int chunk_index;
+    int chunk_count;
+} discord_guild_state_t;
+
 void discord_payload_free(discord_payload_t* payload);
 
 void discord_dispatch_event_data_free(discord_payload_t* payload);
 
 void discord_hello_free(discord_hello_t* hello);
 
-void discord_identify_properties_free(discord_identify_properties_t* properties);
-
-void discord_identify_free(discord_identify_t* identify);
+void discord_invalid_session_free(discord_invalid_session_t* invalid_session);
+
+void discord_guild_state_free(discord_guild_state_t* state);
+
+/**
+ * @brief Deep copy of the event data allocated field by field, so it can be freed by its own free function.
+ *        Embeds and attachment data are not copied, received messages do not carry them
+ * @return Copy or NULL if there is no memory
+ */
+discord_user_t* discord_user_clone(const discord_user_t* user);
+discord_member_t* discord_member_clone(const discord_member_t* member);
+discord_attachment_t* discord_attachment_clone(const discord_attachment_t* attachment);
+discord_message_t* discord_message_clone(const discord_message_t* message);
+discord_message_reaction_t* discord_message_reaction_clone(const discord_message_reaction_t* reaction);
+discord_voice_state_t* discord_voice_state_clone(const discord_voice_state_t* state);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,78 @@
+#ifndef _DISCORD_PRIVATE_OUTBOX_H_
+#define _DISCORD_PRIVATE_OUTBOX_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void(*discord_outbox_free_t)(void* item);
+
+typedef struct discord_outbox_item {
+    void* item;
+    uint8_t priority;
+    int key;                                       /*<! Coalescing key, 0 if item cannot be replaced by a newer one */
+    struct discord_outbox_item* next;
+} discord_outbox_item_t;
+
+/**
+ * @brief Token bucket which limits outbound gateway payloads, and the list of payloads waiting for a token.
+ *        Priority 0 is the highest. Last `reserve` tokens can be used only by priorities below `reserved_from`,
+ *        so the low priority traffic can never delay heartbeats. Time is passed in, so the outbox does not depend on a clock.
+ */
+typedef struct {
+    discord_outbox_item_t* items;                  /*<! Sorted by priority, FIFO within the same priority */
+    uint8_t count;
+    uint8_t limit;                                 /*<! Maximum number of waiting items */
+    uint32_t capacity;                             /*<! Maximum number of tokens (sends per period) */
+    uint32_t refill_ms;                            /*<! Time in which one token is refilled */
+    uint32_t reserve;
+    uint8_t reserved_from;
+    uint32_t tokens;
+    uint64_t refill_tick_ms;                       /*<! Time of the last refill */
+    discord_outbox_free_t free_item;
+    uint32_t deferred;                             /*<! Number of items which had to wait for a token */
+    uint32_t coalesced;                            /*<! Number of waiting items replaced by a newer one */
+} discord_outbox_t;
+
+esp_err_t discord_outbox_init(discord_outbox_t* outbox, uint32_t capacity, uint32_t period_ms, uint32_t reserve, uint8_t reserved_from, uint8_t limit, discord_outbox_free_t free_item);
+
+/**
+ * @brief Drop waiting items and fill the bucket (new connection has its own limit)
+ */
+void discord_outbox_reset(discord_outbox_t* outbox, uint64_t now_ms);
+
+/**
+ * @brief Consume a token if item of given priority can be sent right now.
+ *        Fails if waiting items of the same or higher priority have to go first
+ */
+bool discord_outbox_take_token(discord_outbox_t* outbox, uint8_t priority, uint64_t now_ms);
+
+/**
+ * @brief Let the item wait for a token. Waiting item with the same non-zero key is replaced (and freed)
+ * @return ESP_OK if item waits, ESP_ERR_NO_MEM if outbox is full (item is freed)
+ */
+esp_err_t discord_outbox_defer(discord_outbox_t* outbox, void* item, uint8_t priority, int key);
+
+/**
+ * @brief Take the next waiting item if there is a token for it
+ * @return Item (owned by caller) or NULL
+ */
+void* discord_outbox_next(discord_outbox_t* outbox, uint64_t now_ms);
+
+/**
+ * @brief Time until the next waiting item can be sent
+ * @return Milliseconds or UINT32_MAX if nothing is waiting
+ */
+uint32_t discord_outbox_wait_ms(discord_outbox_t* outbox, uint64_t now_ms);
+
+void discord_outbox_destroy(discord_outbox_t* outbox);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
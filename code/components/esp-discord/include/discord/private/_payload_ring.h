@@ -0,0 +1,72 @@
+#ifndef _DISCORD_PRIVATE_PAYLOAD_RING_H_
+#define _DISCORD_PRIVATE_PAYLOAD_RING_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "discord.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void(*discord_payload_ring_free_t)(void* item);
+
+typedef struct {
+    _Atomic(void*) item;                           /*<! NULL once the item is taken by consumer */
+    uint64_t key;                                  /*<! Coalescing key, 0 if item cannot be coalesced. Used only by producer */
+} discord_payload_ring_slot_t;
+
+/**
+ * @brief Lock-free handoff of received payloads from one producer (ws task) to one consumer (discord task).
+ *        Only producer moves head and only consumer moves tail. Ring has twice as many slots as the limit,
+ *        so when the oldest item has to be dropped, producer only asks the consumer to drop it and never waits.
+ */
+typedef struct {
+    discord_payload_ring_slot_t* slots;
+    uint32_t capacity;
+    uint32_t limit;                                /*<! Maximum number of items waiting for consumer */
+    discord_queue_policy_t policy;
+    uint32_t block_timeout_ms;                     /*<! How long producer waits for room with DISCORD_QUEUE_POLICY_BLOCK */
+    discord_payload_ring_free_t free_item;
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_uint pending_drops;                     /*<! Number of the oldest items which consumer drops instead of returning */
+    atomic_uint drops;
+    atomic_uint coalesced;
+    atomic_uint max_depth;
+} discord_payload_ring_t;
+
+esp_err_t discord_payload_ring_init(discord_payload_ring_t* ring, uint32_t limit, discord_queue_policy_t policy, uint32_t block_timeout_ms, discord_payload_ring_free_t free_item);
+
+/**
+ * @brief Put item into the ring (producer only). Item is owned by the ring afterwards, even if it is dropped
+ * @param key Non-zero key makes the item replace a waiting item with the same key (DISCORD_QUEUE_POLICY_COALESCE only)
+ * @return ESP_OK if item is queued or replaced a waiting item, ESP_ERR_NO_MEM if item has been dropped
+ */
+esp_err_t discord_payload_ring_push(discord_payload_ring_t* ring, void* item, uint64_t key);
+
+/**
+ * @brief Take the oldest item (consumer only)
+ * @return Item or NULL if ring is empty
+ */
+void* discord_payload_ring_pop(discord_payload_ring_t* ring);
+
+/**
+ * @brief Number of items waiting for consumer
+ */
+uint32_t discord_payload_ring_depth(discord_payload_ring_t* ring);
+
+/**
+ * @brief Free all waiting items (consumer only)
+ */
+void discord_payload_ring_flush(discord_payload_ring_t* ring);
+
+void discord_payload_ring_destroy(discord_payload_ring_t* ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
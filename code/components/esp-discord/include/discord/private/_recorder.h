@@ -0,0 +1,84 @@
+#ifndef _DISCORD_PRIVATE_RECORDER_H_
+#define _DISCORD_PRIVATE_RECORDER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "discord.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISCORD_RECORDER_MAGIC     "DCGW"
+#define DISCORD_RECORDER_VERSION   (1)
+
+/**
+ * @brief Log of raw websocket frames received from the gateway.
+ *
+ *        Log starts with magic, version, encoding and flags (4 + 1 + 1 + 1 + 1 bytes).
+ *        Every record is: time since the previous record in us, event id, op code, payload length, payload offset
+ *        and data length (all varints except op code which is one byte), followed by the data.
+ *        Numbers are little-endian base 128 varints, so usual record has 7-10 bytes of overhead
+ */
+typedef struct {
+    FILE* file;
+    int64_t start_us;                              /*<! Time when the recording started (writer only) */
+    uint64_t time_us;                              /*<! Time of the last record since the recording started */
+    uint32_t data_left;                            /*<! Data of the last read record which has not been read yet (reader only) */
+} discord_recorder_t;
+
+typedef struct {
+    discord_gateway_encoding_t encoding;
+    bool compress;                                 /*<! Frames are zlib-stream compressed */
+    bool payload_compress;                         /*<! Large payloads are compressed one by one (identify compress) */
+} discord_recorder_header_t;
+
+typedef struct {
+    uint64_t time_us;                              /*<! Time since the recording started. Ignored when writing, current time is used */
+    int32_t event_id;                              /*<! esp_websocket_event_id_t */
+    uint8_t op_code;
+    uint32_t payload_len;
+    uint32_t payload_offset;
+    uint32_t data_len;
+} discord_recorder_frame_t;
+
+/**
+ * @brief Start the log in the file opened for writing. File is owned by the recorder afterwards
+ */
+esp_err_t discord_recorder_init_writer(discord_recorder_t* recorder, FILE* file, const discord_recorder_header_t* header);
+
+/**
+ * @brief Append the frame. File is flushed, so the log survives a crash of the program
+ */
+esp_err_t discord_recorder_write(discord_recorder_t* recorder, const discord_recorder_frame_t* frame, const char* data);
+
+/**
+ * @brief Start reading the log from the file opened for reading. File is owned by the recorder afterwards
+ * @return ESP_OK or ESP_ERR_INVALID_VERSION if file is not a log of this version
+ */
+esp_err_t discord_recorder_init_reader(discord_recorder_t* recorder, FILE* file, discord_recorder_header_t* out_header);
+
+/**
+ * @brief Read the next record. Data of the previous record is skipped if it has not been read
+ * @return ESP_OK, ESP_ERR_NOT_FOUND at the end of the log or ESP_ERR_INVALID_SIZE if the log is truncated
+ */
+esp_err_t discord_recorder_read_frame(discord_recorder_t* recorder, discord_recorder_frame_t* out_frame);
+
+/**
+ * @brief Read data of the last record
+ * @param buffer Buffer of at least out_frame->data_len bytes
+ */
+esp_err_t discord_recorder_read_data(discord_recorder_t* recorder, char* buffer);
+
+/**
+ * @brief Close the file
+ */
+void discord_recorder_close(discord_recorder_t* recorder);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef _DISCORD_PRIVATE_SHARDS_H_
+#define _DISCORD_PRIVATE_SHARDS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "discord.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISCORD_SHARD_IDENTIFY_INTERVAL_MS  (5000)  /*<! Every identify rate limit bucket can start one session per 5 s */
+
+/**
+ * @brief Identify rate limit shared by the shards. Shard identifies in bucket shard_id % max_concurrency,
+ *        each bucket can start one session per DISCORD_SHARD_IDENTIFY_INTERVAL_MS.
+ *        Time is passed in, so the limiter does not depend on a clock
+ */
+typedef struct {
+    uint16_t max_concurrency;                      /*<! Number of buckets */
+    uint64_t* bucket_tick_ms;                      /*<! Time when the bucket can start the next session */
+} discord_identify_limiter_t;
+
+esp_err_t discord_identify_limiter_init(discord_identify_limiter_t* limiter, uint16_t max_concurrency);
+
+/**
+ * @brief Take the next identify slot of the shard's bucket
+ * @return Time to wait before the identify is sent, 0 if it can be sent right away
+ */
+uint32_t discord_identify_limiter_take(discord_identify_limiter_t* limiter, uint16_t shard_id, uint64_t now_ms);
+
+void discord_identify_limiter_destroy(discord_identify_limiter_t* limiter);
+
+/**
+ * @brief Shard which receives events of the guild, (guild_id >> 22) % shard_count
+ */
+uint16_t discord_shard_of_guild(const char* guild_id, uint16_t shard_count);
+
+/**
+ * @brief Shards run by one client. Every other shard is a client of its own (connection, heartbeater, session and task),
+ *        which shares REST API, event handlers and identify rate limit with the client running it (shard_owner)
+ */
+typedef struct {
+    discord_handle_t* clients;                     /*<! Shards besides the first one, which is run by the owner itself */
+    uint16_t clients_len;
+    portMUX_TYPE lock;                             /*<! Guards the limiter, shards identify from their own tasks */
+    discord_identify_limiter_t limiter;
+} discord_shards_t;
+
+/**
+ * @brief Recommended number of shards and identify concurrency (GET /gateway/bot)
+ */
+esp_err_t dcsh_get_gateway_bot(discord_handle_t client, uint16_t* out_shards, uint16_t* out_max_concurrency);
+
+/**
+ * @brief Time to wait before the shard can identify. Slot is taken, so the shard has to identify after the delay
+ */
+uint32_t dcsh_identify_delay(discord_handle_t client);
+
+/**
+ * @brief Check if guild events are received by this client's connection. Always true if connection is not sharded
+ */
+bool dcsh_has_guild(discord_handle_t client, const char* guild_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef _DISCORD_PRIVATE_TIMER_H_
+#define _DISCORD_PRIVATE_TIMER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "discord.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    DISCORD_TIMER_HEARTBEAT,                       /*<! Next heartbeat (and ACK check of the previous one) */
+    DISCORD_TIMER_ACK,                             /*<! Deadline for ACK of the last heartbeat, if it is shorter than the interval */
+    DISCORD_TIMER_SILENCE,                         /*<! Something has to be received by then */
+    DISCORD_TIMER_RECONNECT,                       /*<! End of the reconnection backoff */
+    DISCORD_TIMER_OUTBOX,                          /*<! Token for the next waiting outbound payload */
+    DISCORD_TIMER_PRESENCE,                        /*<! End of the minimum interval between presence updates */
+    DISCORD_TIMER_STANDBY,                         /*<! Standby connection has to be ready, or replaced connection closed, by then */
+    DISCORD_TIMER_IDENTIFY,                        /*<! Identify slot of the shard (identify rate limit shared by the shards) */
+    _DISCORD_TIMER_COUNT
+} discord_timer_t;
+
+/**
+ * @brief All deadlines of the client are served by one esp_timer which is always armed for the nearest deadline.
+ *        Expired timer only wakes up the discord task, the work itself is done in the task
+ */
+typedef struct {
+    esp_timer_handle_t handle;
+    portMUX_TYPE lock;
+    uint64_t deadlines[_DISCORD_TIMER_COUNT];      /*<! Tick (ms) when timer expires, 0 if timer is not set */
+    uint64_t armed_deadline;                       /*<! Deadline for which esp_timer is currently armed, 0 if stopped */
+} discord_timers_t;
+
+esp_err_t dctm_init(discord_handle_t client);
+/**
+ * @brief Set (or move) the timer to expire after delay_ms
+ */
+void dctm_set(discord_handle_t client, discord_timer_t timer, uint32_t delay_ms);
+void dctm_cancel(discord_handle_t client, discord_timer_t timer);
+bool dctm_is_set(discord_handle_t client, discord_timer_t timer);
+/**
+ * @brief Check if timer is expired and clear it in that case, so it is handled only once
+ */
+bool dctm_take_expired(discord_handle_t client, discord_timer_t timer);
+/**
+ * @brief Arm esp_timer for the nearest deadline. Must be called only from the discord task
+ */
+void dctm_arm(discord_handle_t client);
+void dctm_destroy(discord_handle_t client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
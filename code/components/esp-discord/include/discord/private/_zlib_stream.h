@@ -0,0 +1,80 @@
+#ifndef _DISCORD_PRIVATE_ZLIB_STREAM_H_
+#define _DISCORD_PRIVATE_ZLIB_STREAM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+#include <zlib.h>
+#else
+#include "rom/miniz.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DISCORD_ZLIB_STREAM_SUFFIX  (0x0000FFFF)  /*<! Z_SYNC_FLUSH marker which ends every gateway message */
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+#define DISCORD_ZLIB_STREAM_WINDOW_SIZE (32768)   /*<! Output buffer only, zlib keeps the window on its own */
+typedef z_stream discord_zlib_stream_decompressor_t;
+#else
+#define DISCORD_ZLIB_STREAM_WINDOW_SIZE TINFL_LZ_DICT_SIZE
+typedef tinfl_decompressor discord_zlib_stream_decompressor_t;
+#endif
+
+/**
+ * @brief Function which receives inflated data. It is called as many times as needed for a single message
+ */
+typedef void(*discord_zlib_stream_sink_t)(void* arg, const char* data, size_t len);
+
+/**
+ * @brief Inflate context shared by all messages of one gateway connection (compress=zlib-stream).
+ *        Inflated data is written into the window, which is at the same time used as the dictionary,
+ *        so the memory usage is bounded by the window size regardless of the message length.
+ *        Window is TINFL_LZ_DICT_SIZE (32 KB), the biggest window zlib declares and the one Discord compresses with.
+ *        In per message mode (identify compress) every message is a complete zlib stream of its own instead.
+ *        Linux target has no ROM inflater, so zlib of the host is used there with the same 32 KB window.
+ */
+typedef struct {
+    discord_zlib_stream_decompressor_t* decomp;
+    uint8_t* window;
+    size_t window_offset;
+    uint32_t tail;                                 /*<! Last four bytes of the input */
+    bool flushed;                                  /*<! Input ends with the Z_SYNC_FLUSH marker (or the end of the stream in per message mode), so message is complete */
+    bool per_message;                              /*<! Every message is a separate zlib stream. Set after init */
+} discord_zlib_stream_t;
+
+/**
+ * @brief Allocate inflate context and the window
+ * @return ESP_ERR_NO_MEM if allocation fails
+ */
+esp_err_t discord_zlib_stream_init(discord_zlib_stream_t* stream);
+
+/**
+ * @brief Prepare the context for the new connection
+ */
+void discord_zlib_stream_reset(discord_zlib_stream_t* stream);
+
+/**
+ * @brief Inflate the next part of the compressed stream and pass the output to the sink
+ * @return ESP_OK on success, ESP_FAIL if stream is corrupted. Context cannot be used after the failure until it is reset
+ */
+esp_err_t discord_zlib_stream_feed(discord_zlib_stream_t* stream, const void* data, size_t len, discord_zlib_stream_sink_t sink, void* arg);
+
+/**
+ * @brief Check if all data fed so far forms complete messages
+ */
+bool discord_zlib_stream_is_flushed(discord_zlib_stream_t* stream);
+
+void discord_zlib_stream_destroy(discord_zlib_stream_t* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
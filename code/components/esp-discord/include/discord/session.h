@@ -9,6 +9,7 @@ extern "C" {
 
 typedef struct {
     char* session_id;
+    char* resume_gateway_url;
     discord_user_t* user;
 } discord_session_t;
 
@@ -23,7 +23,7 @@ typedef struct {
 } discord_ota_config_t;
 
 /**
- * @brief Initialize discord OTA ability
+ * @brief Initialize discord OTA ability. OTA is not built for the linux target
  * @param client Discord bot handle
  * @param config OTA config. Provide NULL for default configuration
  * @return ESP_OK on success
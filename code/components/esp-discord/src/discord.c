@@ -1,6 +1,8 @@
 #include "discord.h"
 #include "discord/private/_gateway.h"
 #include "discord/private/_api.h"
+#include "discord/private/_events.h"
+#include "discord/private/_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -25,8 +27,26 @@ static discord_config_t* dc_config_copy(const discord_config_t* config) {
         .api_buffer_size = _dc_default(config->api_buffer_size, DISCORD_DEFAULT_API_BUFFER_SIZE),
         .api_timeout_ms = _dc_default(config->api_timeout_ms, DISCORD_DEFAULT_API_TIMEOUT_MS),
         .queue_size = _dc_default(config->queue_size, DISCORD_DEFAULT_QUEUE_SIZE),
+        .queue_policy = config->queue_policy,
         .task_stack_size = _dc_default(config->task_stack_size, DISCORD_DEFAULT_TASK_STACK_SIZE),
-        .task_priority = _dc_default(config->task_priority, DISCORD_DEFAULT_TASK_PRIORITY)
+        .task_priority = _dc_default(config->task_priority, DISCORD_DEFAULT_TASK_PRIORITY),
+        .gateway_compress = config->gateway_compress,
+        .gateway_latency_threshold_ms = config->gateway_latency_threshold_ms,
+        .gateway_encoding = config->gateway_encoding,
+        .guild_cache_size = config->guild_cache_size,
+        .member_cache_size = config->member_cache_size,
+        .gateway_standby = config->gateway_standby,
+        .gateway_standby_min_free_heap = _dc_default(config->gateway_standby_min_free_heap, DISCORD_DEFAULT_GW_STANDBY_MIN_FREE_HEAP),
+        .gateway_ack_timeout_ms = config->gateway_ack_timeout_ms,
+        .gateway_ping_interval_s = config->gateway_ping_interval_s,
+        .gateway_silence_timeout_ms = config->gateway_silence_timeout_ms,
+        .gateway_tcp_keepalive = config->gateway_tcp_keepalive,
+        .gateway_payload_compress = config->gateway_payload_compress,
+        .gateway_large_threshold = config->gateway_large_threshold,
+        .gateway_shard_id = config->gateway_shard_id,
+        .gateway_shard_count = config->gateway_shard_count,
+        .gateway_shard_run_count = config->gateway_shard_run_count,
+        .gateway_payload_arena = config->gateway_payload_arena
     );
 
     // todo: memcheck
@@ -41,6 +61,11 @@ static discord_config_t* dc_config_copy(const discord_config_t* config) {
 #endif
     }
 
+    clone->gateway_url = STRDUP(config->gateway_url);
+    clone->api_url = STRDUP(config->api_url);
+    clone->gateway_record_path = STRDUP(config->gateway_record_path);
+    clone->member_cache_guild_ids = (const char**) dcev_ids_copy(config->member_cache_guild_ids);
+
     return clone;
 }
 
@@ -49,23 +74,50 @@ static void dc_config_free(discord_config_t* config) {
         return;
 
     free(config->token);
+    free(config->gateway_url);
+    free(config->api_url);
+    free(config->gateway_record_path);
+    dcev_ids_free(config->member_cache_guild_ids);
     free(config);
 }
 
+/**
+ * @brief Intents from the config, or calculated from registered events.
+ *        Guild cache needs GUILDS intent to stay current, member cache needs GUILD_MEMBERS intent
+ */
+static int dc_intents(discord_handle_t client) {
+    if(client->config->intents > 0) {
+        return client->config->intents;
+    }
+
+    return dcev_required_intents(client) |
+        (client->config->guild_cache_size > 0 ? DISCORD_INTENT_GUILDS : 0) |
+        (dcgw_member_cache_enabled(client) ? DISCORD_INTENT_GUILD_MEMBERS : 0);
+}
+
+/**
+ * @brief Shards post events to the loop of the client which runs them, event data client is the shard itself.
+ *        Events lock keeps shard tasks from running each other's events
+ */
 static esp_err_t dc_dispatch_event(discord_handle_t client, discord_event_t event, discord_event_data_ptr_t data_ptr) {
     DISCORD_LOG_FOO();
 
     esp_err_t err;
+    discord_handle_t owner = DISCORD_OWNER(client);
 
     discord_event_data_t event_data;
     event_data.client = client;
     event_data.ptr = data_ptr;
 
-    if ((err = esp_event_post_to(client->event_handle, DISCORD_EVENTS, event, &event_data, sizeof(discord_event_data_t), portMAX_DELAY)) != ESP_OK) {
-        return err;
+    xSemaphoreTakeRecursive(owner->events_lock, portMAX_DELAY);
+
+    if ((err = esp_event_post_to(owner->event_handle, DISCORD_EVENTS, event, &event_data, sizeof(discord_event_data_t), portMAX_DELAY)) == ESP_OK) {
+        err = esp_event_loop_run(owner->event_handle, 0);
     }
 
-    return esp_event_loop_run(client->event_handle, 0);
+    xSemaphoreGiveRecursive(owner->events_lock);
+
+    return err;
 }
 
 static esp_err_t dc_shutdown(discord_handle_t client) {
@@ -77,86 +129,180 @@ static esp_err_t dc_shutdown(discord_handle_t client) {
     client->running = false;
     dcgw_destroy(client);
     dcapi_destroy(client);
-    discord_session_free(client->session);
-    client->session = NULL;
+    dcgw_session_invalidate(client);
+    client->reconnector = (discord_reconnector_t) { 0 };
+    dctm_cancel(client, DISCORD_TIMER_RECONNECT);
+    dctm_arm(client);
 
     return ESP_OK;
 }
 
+static discord_connection_lost_reason_t dc_connection_lost_reason(discord_handle_t client, discord_close_code_t close_code) {
+    switch(client->close_reason) {
+        case DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED:
+            return DISCORD_CONNECTION_LOST_ACK_TIMEOUT;
+
+        case DISCORD_CLOSE_REASON_SILENCE:
+            return DISCORD_CONNECTION_LOST_SILENCE;
+
+        case DISCORD_CLOSE_REASON_RECONNECT:
+        case DISCORD_CLOSE_REASON_INVALID_SESSION:
+            return DISCORD_CONNECTION_LOST_REQUESTED;
+
+        default:
+            return client->state != DISCORD_STATE_ERROR && close_code != DISCORD_CLOSEOP_NO_CODE ?
+                DISCORD_CONNECTION_LOST_CLOSED : DISCORD_CONNECTION_LOST_TRANSPORT;
+    }
+}
+
+/**
+ * @brief Decide what to do after the connection is lost and schedule the reconnection
+ * @return false if client has been shut down
+ */
+static bool dc_handle_connection_lost(discord_handle_t client) {
+    if(client->state > DISCORD_STATE_DISCONNECTED || dctm_is_set(client, DISCORD_TIMER_RECONNECT) || dcgw_standby_is_warming(client)) {
+        return true; // connected, reconnection is already scheduled or standby connection is going to take over
+    }
+
+    bool restart = client->state == DISCORD_STATE_ERROR;
+    discord_connection_lost_t lost = {
+        .reason = dc_connection_lost_reason(client, client->close_code),
+        .silence_ms = (uint32_t) discord_tick_ms() - client->gw_rx_tick_ms
+    };
+
+    if(lost.reason == DISCORD_CONNECTION_LOST_CLOSED) {
+        lost.close_code = client->close_code;
+    }
+
+    if(client->state == DISCORD_STATE_DISCONNECTED) {
+        if(DISCORD_CLOSE_REASON_NOT_REQUESTED == client->close_reason) {
+            char* close_desc = NULL;
+
+            if(client->close_code != DISCORD_CLOSEOP_NO_CODE) {
+                dcgw_get_close_desc(client, &close_desc);
+            }
+
+            DISCORD_LOGE(
+                "Connection closed (code=%d, desc=%s)",
+                client->close_code,
+                client->close_code == DISCORD_CLOSEOP_NO_CODE ? "NULL" : (close_desc ? close_desc : "NULL")
+            );
+
+            if(client->close_code == DISCORD_CLOSEOP_AUTHENTICATION_FAILED) {
+                dc_shutdown(client);     // shutdown only on invalid token
+                return false;
+            }
+
+            if(client->close_code == DISCORD_CLOSEOP_SHARDING_REQUIRED ||
+               client->close_code == DISCORD_CLOSEOP_INVALID_SHARD) {
+                DISCORD_LOGE("Set gateway_shard_count (or DISCORD_GATEWAY_SHARD_COUNT_AUTO) to shard the connection");
+                dc_shutdown(client);     // reconnecting with the same shard config would fail again
+                return false;
+            }
+
+            if(client->close_code == DISCORD_CLOSEOP_INVALID_SEQ ||
+               client->close_code == DISCORD_CLOSEOP_SESSION_TIMED_OUT) {
+                dcgw_session_invalidate(client); // session cannot be resumed
+            }
+
+            restart = true;              // restart in any other case
+            client->close_code = DISCORD_CLOSEOP_NO_CODE;
+        } else if(DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED == client->close_reason ||
+                  DISCORD_CLOSE_REASON_SILENCE == client->close_reason ||
+                  DISCORD_CLOSE_REASON_RECONNECT == client->close_reason ||
+                  DISCORD_CLOSE_REASON_INVALID_SESSION == client->close_reason) {
+            restart = true;
+        } else {
+            DISCORD_LOGW("Disconnection requested but not handled");
+            dc_shutdown(client);
+            return false;
+        }
+    }
+
+    dcapi_destroy(client);
+    dcgw_close(client, client->state == DISCORD_STATE_ERROR ? DISCORD_CLOSE_REASON_ERROR : client->close_reason); // do not modify reason if no error
+
+    if(restart) {
+        DISCORD_EVENT_FIRE(DISCORD_EVENT_CONNECTION_LOST, &lost);
+
+        uint32_t delay_ms = dcgw_reconnect_schedule(client);
+        DISCORD_LOGI("Restarting discord in %d ms...", delay_ms);
+        dctm_set(client, DISCORD_TIMER_RECONNECT, delay_ms);
+    }
+
+    return true;
+}
+
 static void dc_task(void* arg) {
     DISCORD_LOG_FOO();
 
     discord_handle_t client = (discord_handle_t) arg;
-    bool restart = false;
     bool is_shutted_down = false;
 
     xEventGroupClearBits(client->bits, DISCORD_STOPPED_BIT);
 
     while(client->running) {
-        switch(client->state) {
-            case DISCORD_STATE_CONNECTED:
-                dcgw_heartbeat_send_if_expired(client);
-                break;
-
-            case DISCORD_STATE_DISCONNECTED:
-                if(DISCORD_CLOSE_REASON_NOT_REQUESTED == client->close_reason) {
-                    char* close_desc = NULL;
-
-                    if(client->close_code != DISCORD_CLOSEOP_NO_CODE) {
-                        dcgw_get_close_desc(client, &close_desc);
-                    }
-
-                    DISCORD_LOGE(
-                        "Connection closed (code=%d, desc=%s)",
-                        client->close_code,
-                        client->close_code == DISCORD_CLOSEOP_NO_CODE ? "NULL" : (close_desc ? close_desc : "NULL")
-                    );
-
-                    if(client->close_code == DISCORD_CLOSEOP_AUTHENTICATION_FAILED) {
-                        dc_shutdown(client);     // shutdown only on invalid token
-                        is_shutted_down = true;
-                    } else {
-                        restart = true;          // restart in any other case
-                        client->close_code = DISCORD_CLOSEOP_NO_CODE;
-                    }
-                } else if(DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED == client->close_reason) {
-                    restart = true;
-                } else {
-                    DISCORD_LOGW("Disconnection requested but not handled");
-                    dc_shutdown(client);
-                    is_shutted_down = true;
-                }
-
-                break;
-
-            default: // ignore other states
-                break;
+        uint32_t bits = 0;
+
+        // sleep until ws handler, timer or logout wakes the task up
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+
+        if(!client->running) {
+            break;
         }
 
-        if(is_shutted_down) {
+        dcgw_standby_step(client);
+
+        if(!dc_handle_connection_lost(client)) {
+            is_shutted_down = true;
             break;
         }
 
         if(client->state >= DISCORD_STATE_CONNECTING) {
             discord_payload_t* payload = NULL;
 
-            if(xQueueReceive(client->queue, &payload, 1000 / portTICK_PERIOD_MS) == pdPASS) { // poll every 1 sec
+            dcgw_handle_control(client, bits & (DISCORD_TASK_BIT_HELLO | DISCORD_TASK_BIT_MEMBERS));
+
+            // payloads received before RECONNECT or INVALID_SESSION are handled first
+            while((payload = discord_payload_ring_pop(&client->queue))) {
                 dcgw_handle_payload(client, payload);
             }
-        } else if(client->state <= DISCORD_STATE_DISCONNECTED) {
-            dcapi_destroy(client);
-            dcgw_close(client, client->state == DISCORD_STATE_ERROR ? DISCORD_CLOSE_REASON_ERROR : client->close_reason); // do not modify reason if no error
-
-            if(restart || client->state == DISCORD_STATE_ERROR) {
-                restart = false;
-                DISCORD_LOGI("Restarting discord in 10 sec...");
-                vTaskDelay(10000 / portTICK_PERIOD_MS);
-                DISCORD_EVENT_FIRE(DISCORD_EVENT_RECONNECTING, NULL);
-                dcgw_start(client);
-            }
-        } else {
-            vTaskDelay(125 / portTICK_PERIOD_MS);
+
+            dcgw_handle_control(client, bits & (DISCORD_TASK_BIT_RECONNECT | DISCORD_TASK_BIT_INVALID_SESSION));
+        }
+
+        if(dctm_take_expired(client, DISCORD_TIMER_IDENTIFY)) {
+            dcgw_identify(client);
+        }
+
+        if(dctm_take_expired(client, DISCORD_TIMER_HEARTBEAT)) {
+            dcgw_heartbeat_send(client);
+        }
+
+        if(dctm_take_expired(client, DISCORD_TIMER_ACK)) {
+            dcgw_heartbeat_check_ack(client);
         }
+
+        if(dctm_take_expired(client, DISCORD_TIMER_SILENCE)) {
+            dcgw_check_silence(client);
+        }
+
+        if(dctm_take_expired(client, DISCORD_TIMER_OUTBOX)) {
+            dcgw_outbox_flush(client);
+        }
+
+        if(dctm_take_expired(client, DISCORD_TIMER_PRESENCE)) {
+            dcgw_presence_flush(client);
+        }
+
+        dcgw_latency_fire_if_crossed(client);
+
+        if(dctm_take_expired(client, DISCORD_TIMER_RECONNECT)) {
+            DISCORD_EVENT_FIRE(DISCORD_EVENT_RECONNECTING, NULL);
+            dcgw_start(client);
+        }
+
+        dctm_arm(client);
     }
 
     if(!is_shutted_down) {
@@ -164,16 +310,19 @@ static void dc_task(void* arg) {
     }
     
     DISCORD_EVENT_FIRE(DISCORD_EVENT_DISCONNECTED, NULL);
+    client->task_handle = NULL; // nothing is allowed to notify the task anymore
     xEventGroupSetBits(client->bits, DISCORD_STOPPED_BIT);
     DISCORD_LOGD("Task exit.");
     vTaskDelete(NULL);
 }
 
-discord_handle_t discord_create(const discord_config_t* config) {
-    DISCORD_LOG_FOO();
-
+/**
+ * @param owner Client which runs the shard, NULL for a client on its own
+ */
+static discord_handle_t dc_create(const discord_config_t* config, discord_handle_t owner) {
     discord_handle_t client = cu_tctor(discord_handle_t, struct discord,
-        .config = dc_config_copy(config)
+        .config = dc_config_copy(config),
+        .shard_owner = owner
     );
 
     // todo: memcheck
@@ -208,23 +357,150 @@ discord_handle_t discord_create(const discord_config_t* config) {
 
     xEventGroupSetBits(client->bits, DISCORD_STOPPED_BIT);
 
-    if (esp_event_loop_create(&event_args, &client->event_handle) != ESP_OK) {
+    client->event_handler = &dc_dispatch_event;
+
+    if(owner) {
+        // shard fires events to the loop and handlers of the owner
+    } else if (esp_event_loop_create(&event_args, &client->event_handle) != ESP_OK) {
         DISCORD_LOGE("Fail to create event handler");
         discord_destroy(client);
         return NULL;
+    } else if(dcev_init(client) != ESP_OK) {
+        DISCORD_LOGE("Fail to init events");
+        discord_destroy(client);
+        return NULL;
     }
 
-    client->event_handler = &dc_dispatch_event;
+    if(dctm_init(client) != ESP_OK) {
+        DISCORD_LOGE("Fail to init timer");
+        discord_destroy(client);
+        return NULL;
+    }
 
     if(dcgw_init(client) != ESP_OK) {
         DISCORD_LOGE("Fail to init gateway");
         discord_destroy(client);
         return NULL;
     }
+
+    if(config->gateway_presence && dcgw_presence_update(client, config->gateway_presence) != ESP_OK) {
+        DISCORD_LOGE("Fail to set initial presence");
+        discord_destroy(client);
+        return NULL;
+    }
     
     return client;
 }
 
+discord_handle_t discord_create(const discord_config_t* config) {
+    DISCORD_LOG_FOO();
+
+    return dc_create(config, NULL);
+}
+
+static void dc_shards_stop(discord_handle_t client) {
+    discord_shards_t* shards = client->shards;
+
+    if(!shards)
+        return;
+
+    for(uint16_t i = 0; i < shards->clients_len; i++) {
+        discord_destroy(shards->clients[i]);
+    }
+
+    client->shards = NULL;
+    discord_identify_limiter_destroy(&shards->limiter);
+    free(shards->clients);
+    free(shards);
+}
+
+/**
+ * @brief Resolve the shard count and login the other shards run by this client.
+ *        Shard count and identify concurrency are fetched only when they are needed
+ */
+static esp_err_t dc_shards_start(discord_handle_t client) {
+    const discord_config_t* config = client->config;
+    uint16_t count = config->gateway_shard_count;
+    uint16_t first = config->gateway_shard_id;
+    uint16_t run = config->gateway_shard_run_count;
+    uint16_t max_concurrency = 1;
+
+    client->shard_id = client->shard_count = 0;
+
+    if(count == 0) {
+        return ESP_OK; // connection is not sharded
+    }
+
+    if(count == DISCORD_GATEWAY_SHARD_COUNT_AUTO || run != 1) {
+        uint16_t recommended = 0;
+
+        if(dcsh_get_gateway_bot(client, &recommended, &max_concurrency) == ESP_OK) {
+            count = count == DISCORD_GATEWAY_SHARD_COUNT_AUTO ? recommended : count;
+        } else if(count == DISCORD_GATEWAY_SHARD_COUNT_AUTO) {
+            DISCORD_LOGE("Fail to resolve shard count");
+            return ESP_FAIL;
+        } else {
+            DISCORD_LOGW("Identify concurrency is unknown, shards will identify one by one");
+        }
+    }
+
+    run = run > 0 ? run : (first < count ? count - first : 0);
+
+    if(first >= count || run == 0 || first + run > count) {
+        DISCORD_LOGE("Invalid shards (id=%d, count=%d, run=%d)", first, count, run);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    client->shard_id = first;
+    client->shard_count = count;
+
+    DISCORD_LOGI("Running shards %d - %d of %d (max_concurrency=%d)", first, first + run - 1, count, max_concurrency);
+
+    if(run == 1) {
+        return ESP_OK;
+    }
+
+    discord_shards_t* shards = cu_ctor(discord_shards_t,
+        .clients = calloc(run - 1, sizeof(discord_handle_t))
+    );
+
+    if(!shards || !shards->clients || discord_identify_limiter_init(&shards->limiter, max_concurrency) != ESP_OK) {
+        DISCORD_LOGE("Fail to allocate shards");
+        if(shards) free(shards->clients);
+        free(shards);
+        return ESP_ERR_NO_MEM;
+    }
+
+    portMUX_INITIALIZE(&shards->lock);
+    client->shards = shards; // identify of the owner goes through the limiter as well
+
+    discord_config_t shard_config = *config;
+    shard_config.gateway_shard_count = count;
+    shard_config.gateway_shard_run_count = 1;
+    shard_config.gateway_record_path = NULL; // recording holds a single connection
+
+    for(uint16_t i = 1; i < run; i++) {
+        shard_config.gateway_shard_id = first + i;
+        discord_handle_t shard = dc_create(&shard_config, client);
+
+        if(!shard) {
+            DISCORD_LOGE("Fail to create shard %d", first + i);
+            return ESP_ERR_NO_MEM;
+        }
+
+        shards->clients[shards->clients_len++] = shard;
+        dcgw_presence_inherit(shard, client);
+
+        esp_err_t err = discord_login(shard);
+
+        if(err != ESP_OK) {
+            return err;
+        }
+    }
+
+    return ESP_OK;
+}
+
 esp_err_t discord_login(discord_handle_t client) {
     if(!client)
         return ESP_ERR_INVALID_ARG;
@@ -250,6 +526,16 @@ esp_err_t discord_login(discord_handle_t client) {
     // in case if discord_login is called from different task, and DISCORD_STOPPED_BIT is just raised
     vTaskDelay(50 / portTICK_PERIOD_MS);
 
+    esp_err_t err;
+
+    if(!client->shard_owner && (err = dc_shards_start(client)) != ESP_OK) {
+        dc_shards_stop(client);
+        return err;
+    }
+
+    client->intents = dc_intents(client);
+    DISCORD_LOGD("Intents: %d", client->intents);
+
     client->running = true;
 
     if (xTaskCreate(dc_task, "discord_task", client->config->task_stack_size, client, client->config->task_priority, &client->task_handle) != pdTRUE) {
@@ -270,6 +556,57 @@ esp_err_t discord_get_state(discord_handle_t client, discord_gateway_state_t* ou
     return ESP_OK;
 }
 
+esp_err_t discord_get_shard(discord_handle_t client, const char* guild_id, discord_handle_t* out_shard) {
+    if(!client || !guild_id || !out_shard) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    client = DISCORD_OWNER(client);
+    discord_shards_t* shards = client->shards;
+
+    if(dcsh_has_guild(client, guild_id)) {
+        *out_shard = client;
+        return ESP_OK;
+    }
+
+    for(uint16_t i = 0; shards && i < shards->clients_len; i++) {
+        if(dcsh_has_guild(shards->clients[i], guild_id)) {
+            *out_shard = shards->clients[i];
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t discord_event_data_keep(int32_t event, const discord_event_data_t* data, discord_event_data_ptr_t* out_data) {
+    if(!data || !out_data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    switch(event) {
+        case DISCORD_EVENT_MESSAGE_RECEIVED:
+        case DISCORD_EVENT_MESSAGE_UPDATED:
+        case DISCORD_EVENT_MESSAGE_DELETED:
+            *out_data = discord_message_clone((discord_message_t*) data->ptr);
+            break;
+
+        case DISCORD_EVENT_MESSAGE_REACTION_ADDED:
+        case DISCORD_EVENT_MESSAGE_REACTION_REMOVED:
+            *out_data = discord_message_reaction_clone((discord_message_reaction_t*) data->ptr);
+            break;
+
+        case DISCORD_EVENT_VOICE_STATE_UPDATED:
+            *out_data = discord_voice_state_clone((discord_voice_state_t*) data->ptr);
+            break;
+
+        default:
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    return *out_data || !data->ptr ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
 esp_err_t discord_get_close_code(discord_handle_t client, discord_close_code_t* out_code) {
     if(!client || !out_code) {
         return ESP_ERR_INVALID_ARG;
@@ -279,13 +616,40 @@ esp_err_t discord_get_close_code(discord_handle_t client, discord_close_code_t*
     return ESP_OK;
 }
 
+esp_err_t discord_get_gateway_stats(discord_handle_t client, discord_gateway_stats_t* out_stats) {
+    if(!client || !out_stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *out_stats = client->gw_stats;
+    out_stats->queue_drops = client->queue.drops;
+    out_stats->queue_coalesced = client->queue.coalesced;
+    out_stats->queue_max_depth = client->queue.max_depth;
+    dcgw_guild_cache_get_stats(client, out_stats);
+    dcgw_member_cache_get_stats(client, out_stats);
+    return ESP_OK;
+}
+
+esp_err_t discord_get_gateway_latency(discord_handle_t client, discord_gateway_latency_t* out_latency) {
+    if(!client || !out_latency) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    dcgw_get_latency(client, out_latency);
+    return ESP_OK;
+}
+
 esp_err_t discord_register_events(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler, void* event_handler_arg) {
+    return discord_register_events_filtered(client, event, NULL, event_handler, event_handler_arg);
+}
+
+esp_err_t discord_register_events_filtered(discord_handle_t client, discord_event_t event, const discord_event_filter_t* filter, esp_event_handler_t event_handler, void* event_handler_arg) {
     if(!client)
         return ESP_ERR_INVALID_ARG;
     
     DISCORD_LOG_FOO();
     
-    return esp_event_handler_register_with(client->event_handle, DISCORD_EVENTS, event, event_handler, event_handler_arg);
+    return dcev_register(DISCORD_OWNER(client), event, filter, event_handler, event_handler_arg);
 }
 
 esp_err_t discord_unregister_events(discord_handle_t client, discord_event_t event, esp_event_handler_t event_handler) {
@@ -293,11 +657,23 @@ esp_err_t discord_unregister_events(discord_handle_t client, discord_event_t eve
         return ESP_ERR_INVALID_ARG;
     }
 
-    if(!client->event_handle) {
-        return ESP_OK;
+    return dcev_unregister(DISCORD_OWNER(client), event, event_handler);
+}
+
+esp_err_t discord_replay(discord_handle_t client, const char* path) {
+    if(!client || !path)
+        return ESP_ERR_INVALID_ARG;
+
+    DISCORD_LOG_FOO();
+
+    if(client->running || dcgw_is_open(client)) {
+        DISCORD_LOGE("Cannot replay while logged in");
+        return ESP_ERR_INVALID_STATE;
     }
 
-    return esp_event_handler_unregister_with(client->event_handle, DISCORD_EVENTS, event, event_handler);
+    client->intents = dc_intents(client);
+
+    return dcgw_replay(client, path);
 }
 
 esp_err_t discord_logout(discord_handle_t client) {
@@ -311,12 +687,15 @@ esp_err_t discord_logout(discord_handle_t client) {
         return ESP_FAIL;
     }
 
+    dc_shards_stop(client);
+
     if(!client->running) {
         DISCORD_LOGW("Not logged in");
         return ESP_OK;
     }
 
     client->running = false;
+    DISCORD_TASK_NOTIFY(client);
     xEventGroupWaitBits(client->bits, DISCORD_STOPPED_BIT, pdFALSE, pdTRUE, portMAX_DELAY); // wait for the discord task to be stopped
 
     return ESP_OK;
@@ -342,12 +721,17 @@ esp_err_t discord_destroy(discord_handle_t client) {
         client->event_handle = NULL;
     }
 
+    dcev_destroy(client);
+    dctm_destroy(client);
+
     if(client->bits) {
         vEventGroupDelete(client->bits);
         client->bits = NULL;
     }
 
+#ifndef CONFIG_IDF_TARGET_LINUX
     discord_ota_destroy(client);
+#endif
 
     dc_config_free(client->config);
     client->config = NULL;
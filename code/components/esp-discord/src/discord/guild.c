@@ -1,5 +1,6 @@
 #include "discord/private/_discord.h"
 #include "discord/private/_api.h"
+#include "discord/private/_gateway.h"
 #include "discord/private/_json.h"
 #include "estr.h"
 
@@ -13,6 +14,10 @@ esp_err_t discord_guild_get_channels(discord_handle_t client, discord_guild_t* g
         return ESP_ERR_INVALID_ARG;
     }
 
+    if(dcgw_guild_cache_get_channels(client, guild->id, out_channels, out_length) == ESP_OK) {
+        return ESP_OK;
+    }
+
     esp_err_t err = ESP_OK;
     discord_api_response_t* res = NULL;
     
@@ -23,6 +28,10 @@ esp_err_t discord_guild_get_channels(discord_handle_t client, discord_guild_t* g
     
     if(dcapi_response_is_success(res) && res->data_len > 0) {
         *out_channels = discord_json_list_deserialize_(channel, res->data, res->data_len, out_length);
+
+        if(*out_channels) {
+            dcgw_guild_cache_set_channels(client, guild->id, *out_channels, *out_length);
+        }
     }
     
     dcapi_response_free(client, res);
@@ -1,7 +1,9 @@
 #include "discord/member.h"
 #include "discord/private/_discord.h"
 #include "discord/private/_api.h"
+#include "discord/private/_gateway.h"
 #include "discord/private/_json.h"
+#include "discord/private/_json_reader.h"
 #include "cutils.h"
 #include "estr.h"
 
@@ -13,6 +15,10 @@ esp_err_t discord_member_get(discord_handle_t client, char* guild_id, char* user
         return ESP_ERR_INVALID_ARG;
     }
 
+    if(dcgw_member_cache_get(client, guild_id, user_id, out_member) == ESP_OK) {
+        return ESP_OK;
+    }
+
     esp_err_t err = ESP_OK;
     discord_member_t* member = NULL;
     discord_api_response_t* res = NULL;
@@ -27,11 +33,15 @@ esp_err_t discord_member_get(discord_handle_t client, char* guild_id, char* user
     }
 
     if(dcapi_response_is_success(res) && res->data_len > 0) {
-        member = discord_json_deserialize_(member, res->data, res->data_len);
+        member = discord_json_read_member(res->data, res->data_len);
     }
 
     dcapi_response_free(client, res);
 
+    if(member) {
+        dcgw_member_cache_put(client, guild_id, user_id, member);
+    }
+
     *out_member = member;
     return err;
 }
@@ -125,6 +135,7 @@ esp_err_t discord_member_has_role_name(discord_handle_t client, discord_member_t
         }
     }
 
+    cu_list_tfreex(roles, discord_role_len_t, len, discord_role_free);
     *out_result = result;
     return ESP_OK;
 }
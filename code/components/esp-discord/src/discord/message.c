@@ -2,6 +2,7 @@
 #include "discord/private/_discord.h"
 #include "discord/private/_api.h"
 #include "discord/private/_json.h"
+#include "discord/private/_json_reader.h"
 #include "cutils.h"
 #include "estr.h"
 
@@ -27,7 +28,7 @@ esp_err_t discord_message_send(discord_handle_t client, discord_message_t* messa
 
     discord_api_request_t* req = dcapi_create_request(
         estr_cat("/channels/", message->channel_id, "/messages"),
-        discord_json_serialize(message)
+        discord_json_write_alloc(discord_json_write_message, message)
     );
 
     for(uint8_t i = 0; i < message->_attachments_len; i++) {
@@ -51,7 +52,7 @@ esp_err_t discord_message_send(discord_handle_t client, discord_message_t* messa
         if(res->data_len <= 0) {
             DISCORD_LOGW("Message sent but cannot return");
         } else {
-            *out_result = discord_json_deserialize_(message, res->data, res->data_len);
+            *out_result = discord_json_read_message(res->data, res->data_len);
         }
     }
     
@@ -8,6 +8,7 @@ void discord_message_reaction_free(discord_message_reaction_t* reaction) {
     free(reaction->user_id);
     free(reaction->message_id);
     free(reaction->channel_id);
+    free(reaction->guild_id);
     discord_emoji_free(reaction->emoji);
     free(reaction);
 }
\ No newline at end of file
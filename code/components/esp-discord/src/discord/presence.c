@@ -0,0 +1,38 @@
+#include "discord/presence.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_gateway.h"
+
+DISCORD_LOG_DEFINE_BASE();
+
+esp_err_t discord_presence_update(discord_handle_t client, const discord_presence_t* presence) {
+    if(! client || ! presence || (presence->activity && ! presence->activity->name)) {
+        DISCORD_LOGE("Invalid args");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    client = DISCORD_OWNER(client);
+    esp_err_t err = dcgw_presence_update(client, presence);
+
+    for(uint16_t i = 0; err == ESP_OK && client->shards && i < client->shards->clients_len; i++) {
+        err = dcgw_presence_update(client->shards->clients[i], presence); // bot presence is set per shard
+    }
+
+    return err;
+}
+
+void discord_activity_free(discord_activity_t* activity) {
+    if(!activity)
+        return;
+
+    free(activity->name);
+    free(activity->state);
+    free(activity);
+}
+
+void discord_presence_free(discord_presence_t* presence) {
+    if(!presence)
+        return;
+
+    discord_activity_free(presence->activity);
+    free(presence);
+}
\ No newline at end of file
@@ -21,6 +21,8 @@ esp_err_t dcapi_response_free(discord_handle_t client, discord_api_response_t* r
     if(! client || ! res)
         return ESP_ERR_INVALID_ARG;
 
+    client = DISCORD_OWNER(client);
+
     if(res->data || res->data_len > 0) {
         client->api_buffer_size = 0;
         res->data = NULL; // do not free() res->data because it holds addr of internal api buffer
@@ -32,6 +34,10 @@ esp_err_t dcapi_response_free(discord_handle_t client, discord_api_response_t* r
     return ESP_OK;
 }
 
+static const char* dcapi_base_url(discord_handle_t client) {
+    return client->config->api_url ? client->config->api_url : DISCORD_API_URL;
+}
+
 static esp_err_t dcapi_flush_http(discord_handle_t client, bool record) {
     DISCORD_LOG_FOO();
 
@@ -138,18 +144,18 @@ static esp_err_t dcapi_init_lazy(discord_handle_t client, bool download, const c
 
     client->api_download_mode = download;
 
-#ifndef CONFIG_ESP_TLS_SKIP_SERVER_CERT_VERIFY
+#ifdef DISCORD_CERTS_EMBEDDED
     extern const uint8_t api_crt[] asm("_binary_api_pem_start");
 #endif
 
     esp_http_client_config_t config = {
-        .url = download ? url : DISCORD_API_URL,
+        .url = download ? url : dcapi_base_url(client),
         .is_async = false,
         .keep_alive_enable = !download,
         .event_handler = download ? dcapi_on_download : dcapi_on_http_event,
         .user_data = client,
         .timeout_ms = client->config->api_timeout_ms,
-#ifndef CONFIG_ESP_TLS_SKIP_SERVER_CERT_VERIFY
+#ifdef DISCORD_CERTS_EMBEDDED
         .cert_pem = (const char*) api_crt
 #endif
     };
@@ -223,6 +229,8 @@ static int dcapi_calculate_request_length(discord_api_request_t* request)
 esp_err_t dcapi_request(discord_handle_t client, esp_http_client_method_t method, discord_api_request_t* request, discord_api_response_t** out_response) {
     DISCORD_LOG_FOO();
 
+    client = DISCORD_OWNER(client); // shards share REST API of the client which runs them
+
     bool stream_response = out_response != NULL;
 
     esp_err_t err;
@@ -242,7 +250,7 @@ esp_err_t dcapi_request(discord_handle_t client, esp_http_client_method_t method
     client->api_buffer_record = true; // always record first chunk which comes with headers because maybe will need to record error
     client->api_buffer_record_status = ESP_OK;
 
-    char* url = estr_cat(DISCORD_API_URL, request->uri);
+    char* url = estr_cat(dcapi_base_url(client), request->uri);
     // todo: memcheck
     if(! request->disable_auto_uri_free) {
         free(request->uri);
@@ -387,6 +395,8 @@ esp_err_t dcapi_download(discord_handle_t client, const char* url, discord_downl
     if(! client || ! url ||  ! download_handler || ! out_response) {
         return ESP_ERR_INVALID_ARG;
     }
+
+    client = DISCORD_OWNER(client);
     
     if(client->api_download_mode && xSemaphoreTake(client->api_lock, client->config->api_timeout_ms / portTICK_PERIOD_MS) != pdTRUE) {
         DISCORD_LOGW("Api is locked");
@@ -0,0 +1,148 @@
+#include "discord/private/_arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DISCORD_ARENA_HEADER_SIZE ((sizeof(discord_arena_t) + DISCORD_ARENA_ALIGN - 1) & ~(size_t) (DISCORD_ARENA_ALIGN - 1))
+#define DISCORD_ARENA_DATA(arena) ((uint8_t*) (arena) + DISCORD_ARENA_HEADER_SIZE)
+
+static size_t discord_arena_class_size(int size_class) {
+    return (size_t) DISCORD_ARENA_CLASS_MIN_SIZE << size_class;
+}
+
+/**
+ * @return Smallest class which fits the size or -1 if size is bigger than the biggest class
+ */
+static int discord_arena_class_of(size_t size) {
+    for(int i = 0; i < DISCORD_ARENA_CLASS_COUNT; i++) {
+        if(size <= discord_arena_class_size(i)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void discord_arena_pool_init(discord_arena_pool_t* pool) {
+    *pool = (discord_arena_pool_t) { 0 };
+    portMUX_INITIALIZE(&pool->lock);
+}
+
+void discord_arena_pool_destroy(discord_arena_pool_t* pool) {
+    if(!pool)
+        return;
+
+    for(int i = 0; i < DISCORD_ARENA_CLASS_COUNT; i++) {
+        while(pool->free[i]) {
+            discord_arena_t* region = pool->free[i];
+            pool->free[i] = region->next;
+            free(region);
+        }
+
+        pool->free_len[i] = 0;
+    }
+}
+
+static discord_arena_t* discord_arena_region_create(discord_arena_pool_t* pool, size_t size) {
+    int size_class = pool ? discord_arena_class_of(size) : -1;
+    discord_arena_t* region = NULL;
+
+    if(size_class >= 0) {
+        size = discord_arena_class_size(size_class);
+
+        portENTER_CRITICAL(&pool->lock);
+
+        if((region = pool->free[size_class])) {
+            pool->free[size_class] = region->next;
+            pool->free_len[size_class]--;
+        }
+
+        portEXIT_CRITICAL(&pool->lock);
+    }
+
+    if(!region && !(region = malloc(DISCORD_ARENA_HEADER_SIZE + size))) {
+        return NULL;
+    }
+
+    *region = (discord_arena_t) {
+        .pool = size_class >= 0 ? pool : NULL,
+        .size_class = size_class,
+        .size = size
+    };
+
+    return region;
+}
+
+discord_arena_t* discord_arena_create(discord_arena_pool_t* pool, size_t size) {
+    discord_arena_t* arena = discord_arena_region_create(pool, size);
+
+    if(arena) {
+        arena->current = arena;
+    }
+
+    return arena;
+}
+
+void* discord_arena_calloc(discord_arena_t* arena, size_t size) {
+    if(!arena) {
+        return calloc(1, size);
+    }
+
+    size = (size + DISCORD_ARENA_ALIGN - 1) & ~(size_t) (DISCORD_ARENA_ALIGN - 1);
+    discord_arena_t* region = arena->current;
+
+    if(region->size - region->used < size) {
+        // next region is at least as big as the first one, so a bad estimate costs only a few regions
+        discord_arena_t* next = discord_arena_region_create(arena->pool, size > arena->size ? size : arena->size);
+
+        if(!next) {
+            return NULL;
+        }
+
+        region->next = next;
+        region = arena->current = next;
+    }
+
+    void* ptr = DISCORD_ARENA_DATA(region) + region->used;
+    region->used += size;
+    memset(ptr, 0, size);
+
+    return ptr;
+}
+
+char* discord_arena_strndup(discord_arena_t* arena, const char* str, size_t len) {
+    char* copy = arena ? discord_arena_calloc(arena, len + 1) : malloc(len + 1);
+
+    if(copy) {
+        memcpy(copy, str, len);
+        copy[len] = '\0';
+    }
+
+    return copy;
+}
+
+void discord_arena_free(discord_arena_t* arena) {
+    while(arena) {
+        discord_arena_t* next = arena->next;
+        discord_arena_pool_t* pool = arena->pool;
+        bool pooled = false;
+
+        if(pool) {
+            portENTER_CRITICAL(&pool->lock);
+
+            if(pool->free_len[arena->size_class] < DISCORD_ARENA_POOL_DEPTH) {
+                arena->next = pool->free[arena->size_class];
+                pool->free[arena->size_class] = arena;
+                pool->free_len[arena->size_class]++;
+                pooled = true;
+            }
+
+            portEXIT_CRITICAL(&pool->lock);
+        }
+
+        if(!pooled) {
+            free(arena);
+        }
+
+        arena = next;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,966 @@
+#include "discord/private/_etf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_system.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_json.h"
+
+// writer
+
+static void discord_etf_put(discord_etf_writer_t* writer, const void* data, size_t len) {
+    if(writer->len + len <= writer->size) {
+        memcpy(writer->buffer + writer->len, data, len);
+    }
+
+    writer->len += len;
+}
+
+static void discord_etf_put_u8(discord_etf_writer_t* writer, uint8_t value) {
+    discord_etf_put(writer, &value, 1);
+}
+
+static void discord_etf_put_u32(discord_etf_writer_t* writer, uint32_t value) {
+    uint8_t be[4] = { value >> 24, value >> 16, value >> 8, value };
+    discord_etf_put(writer, be, sizeof(be));
+}
+
+void discord_etf_writer_init(discord_etf_writer_t* writer, uint8_t* buffer, size_t size) {
+    *writer = (discord_etf_writer_t) {
+        .buffer = buffer,
+        .size = size
+    };
+
+    discord_etf_put_u8(writer, DISCORD_ETF_VERSION);
+}
+
+void discord_etf_write_map(discord_etf_writer_t* writer, uint32_t arity) {
+    discord_etf_put_u8(writer, DISCORD_ETF_MAP);
+    discord_etf_put_u32(writer, arity);
+}
+
+void discord_etf_write_list(discord_etf_writer_t* writer, uint32_t length) {
+    discord_etf_put_u8(writer, DISCORD_ETF_LIST);
+    discord_etf_put_u32(writer, length);
+}
+
+void discord_etf_write_list_end(discord_etf_writer_t* writer) {
+    discord_etf_put_u8(writer, DISCORD_ETF_NIL);
+}
+
+void discord_etf_write_atom(discord_etf_writer_t* writer, const char* atom) {
+    size_t len = strlen(atom);
+
+    if(len > UINT8_MAX) {
+        writer->len = SIZE_MAX / 2; // atom cannot be longer, make the result fail
+        return;
+    }
+
+    discord_etf_put_u8(writer, DISCORD_ETF_SMALL_ATOM_UTF8);
+    discord_etf_put_u8(writer, len);
+    discord_etf_put(writer, atom, len);
+}
+
+void discord_etf_write_binary(discord_etf_writer_t* writer, const char* str) {
+    size_t len = strlen(str);
+
+    discord_etf_put_u8(writer, DISCORD_ETF_BINARY);
+    discord_etf_put_u32(writer, len);
+    discord_etf_put(writer, str, len);
+}
+
+void discord_etf_write_int(discord_etf_writer_t* writer, int64_t value) {
+    if(value >= 0 && value <= UINT8_MAX) {
+        discord_etf_put_u8(writer, DISCORD_ETF_SMALL_INTEGER);
+        discord_etf_put_u8(writer, value);
+    } else if(value >= INT32_MIN && value <= INT32_MAX) {
+        discord_etf_put_u8(writer, DISCORD_ETF_INTEGER);
+        discord_etf_put_u32(writer, (uint32_t) (int32_t) value);
+    } else {
+        uint64_t magnitude = value < 0 ? -(uint64_t) value : (uint64_t) value;
+        uint8_t digits[8];
+        uint8_t n = 0;
+
+        for(; magnitude > 0; magnitude >>= 8) {
+            digits[n++] = magnitude & 0xFF; // little endian
+        }
+
+        discord_etf_put_u8(writer, DISCORD_ETF_SMALL_BIG);
+        discord_etf_put_u8(writer, n);
+        discord_etf_put_u8(writer, value < 0);
+        discord_etf_put(writer, digits, n);
+    }
+}
+
+void discord_etf_write_bool(discord_etf_writer_t* writer, bool value) {
+    discord_etf_write_atom(writer, value ? "true" : "false");
+}
+
+void discord_etf_write_nil(discord_etf_writer_t* writer) {
+    discord_etf_write_atom(writer, "nil");
+}
+
+int discord_etf_writer_result(discord_etf_writer_t* writer) {
+    return writer->len <= writer->size && writer->len <= INT32_MAX ? (int) writer->len : -1;
+}
+
+// map keys are written as binaries, same as Discord's own clients do
+
+int discord_etf_write_heartbeat(uint8_t* buffer, size_t size, int seq) {
+    discord_etf_writer_t w;
+    discord_etf_writer_init(&w, buffer, size);
+
+    discord_etf_write_map(&w, 2);
+    discord_etf_write_binary(&w, "op");
+    discord_etf_write_int(&w, DISCORD_OP_HEARTBEAT);
+    discord_etf_write_binary(&w, "d");
+
+    if(seq == DISCORD_NULL_SEQUENCE_NUMBER) {
+        discord_etf_write_nil(&w);
+    } else {
+        discord_etf_write_int(&w, seq);
+    }
+
+    return discord_etf_writer_result(&w);
+}
+
+static void discord_etf_write_presence_data(discord_etf_writer_t* w, const discord_presence_t* presence) {
+    discord_etf_write_map(w, 4);
+    discord_etf_write_binary(w, "since");
+    discord_etf_write_nil(w);
+    discord_etf_write_binary(w, "activities");
+
+    discord_activity_t* activity = presence->activity;
+
+    if(activity) {
+        discord_etf_write_list(w, 1);
+        discord_etf_write_map(w, activity->state ? 3 : 2);
+        discord_etf_write_binary(w, "name");
+        discord_etf_write_binary(w, activity->name);
+        discord_etf_write_binary(w, "type");
+        discord_etf_write_int(w, activity->type);
+
+        if(activity->state) {
+            discord_etf_write_binary(w, "state");
+            discord_etf_write_binary(w, activity->state);
+        }
+    }
+
+    discord_etf_write_list_end(w);
+    discord_etf_write_binary(w, "status");
+    discord_etf_write_binary(w, discord_presence_status_name(presence->status));
+    discord_etf_write_binary(w, "afk");
+    discord_etf_write_bool(w, presence->afk);
+}
+
+int discord_etf_write_identify(uint8_t* buffer, size_t size, const discord_identify_t* identify) {
+    char os[48];
+    snprintf(os, sizeof(os), "esp-idf (%s)", esp_get_idf_version());
+
+    discord_etf_writer_t w;
+    discord_etf_writer_init(&w, buffer, size);
+
+    discord_etf_write_map(&w, 2);
+    discord_etf_write_binary(&w, "op");
+    discord_etf_write_int(&w, DISCORD_OP_IDENTIFY);
+    discord_etf_write_binary(&w, "d");
+    discord_etf_write_map(&w, 3
+        + (identify->large_threshold > 0)
+        + identify->compress
+        + (identify->shard_count > 0)
+        + (identify->presence != NULL)
+    );
+    discord_etf_write_binary(&w, "token");
+    discord_etf_write_binary(&w, identify->token);
+    discord_etf_write_binary(&w, "intents");
+    discord_etf_write_int(&w, identify->intents);
+    discord_etf_write_binary(&w, "properties");
+    discord_etf_write_map(&w, 3);
+    discord_etf_write_binary(&w, "os");
+    discord_etf_write_binary(&w, os);
+    discord_etf_write_binary(&w, "browser");
+    discord_etf_write_binary(&w, "esp-discord (" DISCORD_VER_STRING ")");
+    discord_etf_write_binary(&w, "device");
+    discord_etf_write_binary(&w, CONFIG_IDF_TARGET);
+
+    if(identify->large_threshold > 0) {
+        discord_etf_write_binary(&w, "large_threshold");
+        discord_etf_write_int(&w, identify->large_threshold);
+    }
+
+    if(identify->compress) {
+        discord_etf_write_binary(&w, "compress");
+        discord_etf_write_bool(&w, true);
+    }
+
+    if(identify->shard_count > 0) {
+        discord_etf_write_binary(&w, "shard");
+        discord_etf_write_list(&w, 2);
+        discord_etf_write_int(&w, identify->shard_id);
+        discord_etf_write_int(&w, identify->shard_count);
+        discord_etf_write_list_end(&w);
+    }
+
+    if(identify->presence) {
+        discord_etf_write_binary(&w, "presence");
+        discord_etf_write_presence_data(&w, identify->presence);
+    }
+
+    return discord_etf_writer_result(&w);
+}
+
+int discord_etf_write_resume(uint8_t* buffer, size_t size, const char* token, const char* session_id, int seq) {
+    discord_etf_writer_t w;
+    discord_etf_writer_init(&w, buffer, size);
+
+    discord_etf_write_map(&w, 2);
+    discord_etf_write_binary(&w, "op");
+    discord_etf_write_int(&w, DISCORD_OP_RESUME);
+    discord_etf_write_binary(&w, "d");
+    discord_etf_write_map(&w, 3);
+    discord_etf_write_binary(&w, "token");
+    discord_etf_write_binary(&w, token);
+    discord_etf_write_binary(&w, "session_id");
+    discord_etf_write_binary(&w, session_id);
+    discord_etf_write_binary(&w, "seq");
+    discord_etf_write_int(&w, seq);
+
+    return discord_etf_writer_result(&w);
+}
+
+int discord_etf_write_presence(uint8_t* buffer, size_t size, discord_presence_t* presence) {
+    discord_etf_writer_t w;
+    discord_etf_writer_init(&w, buffer, size);
+
+    discord_etf_write_map(&w, 2);
+    discord_etf_write_binary(&w, "op");
+    discord_etf_write_int(&w, DISCORD_OP_PRESENCE_UPDATE);
+    discord_etf_write_binary(&w, "d");
+    discord_etf_write_presence_data(&w, presence);
+
+    return discord_etf_writer_result(&w);
+}
+
+int discord_etf_write_request_guild_members(uint8_t* buffer, size_t size, const char* guild_id) {
+    discord_etf_writer_t w;
+    discord_etf_writer_init(&w, buffer, size);
+
+    discord_etf_write_map(&w, 2);
+    discord_etf_write_binary(&w, "op");
+    discord_etf_write_int(&w, DISCORD_OP_REQUEST_GUILD_MEMBERS);
+    discord_etf_write_binary(&w, "d");
+    discord_etf_write_map(&w, 3);
+    discord_etf_write_binary(&w, "guild_id");
+    discord_etf_write_binary(&w, guild_id);
+    discord_etf_write_binary(&w, "query");
+    discord_etf_write_binary(&w, ""); // all members
+    discord_etf_write_binary(&w, "limit");
+    discord_etf_write_int(&w, 0);
+
+    return discord_etf_writer_result(&w);
+}
+
+// reader
+
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t pos;
+} discord_etf_cursor_t;
+
+static bool discord_etf_take(discord_etf_cursor_t* cur, size_t n, uint8_t** out) {
+    if(n > cur->len - cur->pos) {
+        return false;
+    }
+
+    *out = cur->data + cur->pos;
+    cur->pos += n;
+
+    return true;
+}
+
+static bool discord_etf_read_u8(discord_etf_cursor_t* cur, uint8_t* out) {
+    uint8_t* p;
+
+    if(!discord_etf_take(cur, 1, &p)) {
+        return false;
+    }
+
+    *out = p[0];
+    return true;
+}
+
+static bool discord_etf_read_u16(discord_etf_cursor_t* cur, uint32_t* out) {
+    uint8_t* p;
+
+    if(!discord_etf_take(cur, 2, &p)) {
+        return false;
+    }
+
+    *out = (p[0] << 8) | p[1];
+    return true;
+}
+
+static bool discord_etf_read_u32(discord_etf_cursor_t* cur, uint32_t* out) {
+    uint8_t* p;
+
+    if(!discord_etf_take(cur, 4, &p)) {
+        return false;
+    }
+
+    *out = ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+    return true;
+}
+
+static bool discord_etf_read_version(discord_etf_cursor_t* cur) {
+    uint8_t version;
+    return discord_etf_read_u8(cur, &version) && version == DISCORD_ETF_VERSION;
+}
+
+/**
+ * @brief Read term which holds text (binary, string or atom) without copying it
+ */
+static bool discord_etf_read_text(discord_etf_cursor_t* cur, uint8_t tag, uint8_t** out, uint32_t* out_len) {
+    uint8_t len8;
+
+    switch(tag) {
+        case DISCORD_ETF_BINARY:
+            return discord_etf_read_u32(cur, out_len) && discord_etf_take(cur, *out_len, out);
+
+        case DISCORD_ETF_STRING:
+        case DISCORD_ETF_ATOM:
+        case DISCORD_ETF_ATOM_UTF8:
+            return discord_etf_read_u16(cur, out_len) && discord_etf_take(cur, *out_len, out);
+
+        case DISCORD_ETF_SMALL_ATOM:
+        case DISCORD_ETF_SMALL_ATOM_UTF8:
+            if(!discord_etf_read_u8(cur, &len8)) {
+                return false;
+            }
+
+            *out_len = len8;
+            return discord_etf_take(cur, len8, out);
+
+        default:
+            return false;
+    }
+}
+
+static bool discord_etf_is_atom(uint8_t tag) {
+    return tag == DISCORD_ETF_ATOM || tag == DISCORD_ETF_ATOM_UTF8 || tag == DISCORD_ETF_SMALL_ATOM || tag == DISCORD_ETF_SMALL_ATOM_UTF8;
+}
+
+static bool discord_etf_text_eq(const uint8_t* text, uint32_t len, const char* str) {
+    return strlen(str) == len && memcmp(text, str, len) == 0;
+}
+
+static bool discord_etf_read_int(discord_etf_cursor_t* cur, uint8_t tag, int* out) {
+    uint8_t u8;
+    uint32_t u32;
+
+    switch(tag) {
+        case DISCORD_ETF_SMALL_INTEGER:
+            if(!discord_etf_read_u8(cur, &u8)) {
+                return false;
+            }
+
+            *out = u8;
+            return true;
+
+        case DISCORD_ETF_INTEGER:
+            if(!discord_etf_read_u32(cur, &u32)) {
+                return false;
+            }
+
+            *out = (int32_t) u32;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Read big integer as decimal text. Discord sends snowflakes as big integers
+ * @param str Buffer for the text, empty string if number has more than 64 bits (no such numbers in Discord payloads)
+ */
+static bool discord_etf_read_big(discord_etf_cursor_t* cur, uint8_t tag, char* str, size_t size) {
+    uint8_t n8, sign;
+    uint32_t n;
+    uint8_t* digits;
+
+    if(tag == DISCORD_ETF_SMALL_BIG) {
+        if(!discord_etf_read_u8(cur, &n8)) {
+            return false;
+        }
+
+        n = n8;
+    } else if(!discord_etf_read_u32(cur, &n)) {
+        return false;
+    }
+
+    if(!discord_etf_read_u8(cur, &sign) || !discord_etf_take(cur, n, &digits)) {
+        return false;
+    }
+
+    str[0] = '\0';
+
+    if(n > 8) {
+        return true;
+    }
+
+    uint64_t value = 0;
+
+    for(uint32_t i = n; i > 0; i--) {
+        value = (value << 8) | digits[i - 1];
+    }
+
+    snprintf(str, size, "%s%llu", sign ? "-" : "", (unsigned long long) value);
+    return true;
+}
+
+static bool discord_etf_read_float(discord_etf_cursor_t* cur, uint8_t tag, double* out) {
+    uint8_t* p;
+
+    if(tag == DISCORD_ETF_FLOAT) {
+        if(!discord_etf_take(cur, 31, &p)) {
+            return false;
+        }
+
+        *out = strtod((const char*) p, NULL); // zero padded text
+        return true;
+    }
+
+    if(!discord_etf_take(cur, 8, &p)) {
+        return false;
+    }
+
+    uint64_t bits = 0;
+
+    for(int i = 0; i < 8; i++) {
+        bits = (bits << 8) | p[i];
+    }
+
+    memcpy(out, &bits, sizeof(*out));
+    return true;
+}
+
+static bool discord_etf_skip(discord_etf_cursor_t* cur, int depth) {
+    uint8_t tag, n8;
+    uint32_t n;
+    uint8_t* p;
+
+    if(depth > DISCORD_ETF_MAX_DEPTH || !discord_etf_read_u8(cur, &tag)) {
+        return false;
+    }
+
+    switch(tag) {
+        case DISCORD_ETF_SMALL_INTEGER:
+            return discord_etf_take(cur, 1, &p);
+
+        case DISCORD_ETF_INTEGER:
+            return discord_etf_take(cur, 4, &p);
+
+        case DISCORD_ETF_NEW_FLOAT:
+            return discord_etf_take(cur, 8, &p);
+
+        case DISCORD_ETF_FLOAT:
+            return discord_etf_take(cur, 31, &p);
+
+        case DISCORD_ETF_NIL:
+            return true;
+
+        case DISCORD_ETF_SMALL_BIG:
+            return discord_etf_read_u8(cur, &n8) && discord_etf_take(cur, n8 + 1, &p);
+
+        case DISCORD_ETF_LARGE_BIG:
+            return discord_etf_read_u32(cur, &n) && discord_etf_take(cur, (size_t) n + 1, &p);
+
+        case DISCORD_ETF_SMALL_TUPLE:
+            if(!discord_etf_read_u8(cur, &n8)) {
+                return false;
+            }
+
+            for(uint32_t i = 0; i < n8; i++) {
+                if(!discord_etf_skip(cur, depth + 1)) return false;
+            }
+
+            return true;
+
+        case DISCORD_ETF_LARGE_TUPLE:
+        case DISCORD_ETF_LIST:
+        case DISCORD_ETF_MAP:
+            if(!discord_etf_read_u32(cur, &n)) {
+                return false;
+            }
+
+            // list has a tail, map has key and value for each item
+            uint64_t terms = tag == DISCORD_ETF_MAP ? 2ULL * n : tag == DISCORD_ETF_LIST ? n + 1ULL : n;
+
+            for(uint64_t i = 0; i < terms; i++) {
+                if(!discord_etf_skip(cur, depth + 1)) return false;
+            }
+
+            return true;
+
+        default:
+            return discord_etf_read_text(cur, tag, &p, &n);
+    }
+}
+
+/**
+ * @brief Create cJSON string from text inside of the data. Byte after the text is terminated only for the time of copying
+ */
+static cJSON* discord_etf_create_string(uint8_t* text, uint32_t len) {
+    uint8_t after = text[len];
+    text[len] = '\0';
+    cJSON* str = cJSON_CreateString((const char*) text);
+    text[len] = after;
+
+    return str;
+}
+
+static cJSON* discord_etf_create_big(discord_etf_cursor_t* cur, uint8_t tag) {
+    char str[22];
+
+    if(!discord_etf_read_big(cur, tag, str, sizeof(str))) {
+        return NULL;
+    }
+
+    return str[0] ? cJSON_CreateString(str) : cJSON_CreateNull();
+}
+
+static cJSON* discord_etf_decode(discord_etf_cursor_t* cur, int depth);
+
+static cJSON* discord_etf_decode_items(discord_etf_cursor_t* cur, uint32_t n, bool has_tail, int depth) {
+    cJSON* array = cJSON_CreateArray();
+
+    for(uint32_t i = 0; array && i < n; i++) {
+        cJSON* item = discord_etf_decode(cur, depth + 1);
+
+        if(!item) {
+            cJSON_Delete(array);
+            return NULL;
+        }
+
+        cJSON_AddItemToArray(array, item);
+    }
+
+    // proper list ends with empty list as a tail
+    if(array && has_tail && !discord_etf_skip(cur, depth + 1)) {
+        cJSON_Delete(array);
+        return NULL;
+    }
+
+    return array;
+}
+
+static cJSON* discord_etf_decode_map(discord_etf_cursor_t* cur, uint32_t arity, int depth) {
+    cJSON* object = cJSON_CreateObject();
+
+    for(uint32_t i = 0; object && i < arity; i++) {
+        uint8_t tag;
+        uint8_t* key;
+        uint32_t key_len;
+        cJSON* value = NULL;
+
+        if(!discord_etf_read_u8(cur, &tag) ||
+           !discord_etf_read_text(cur, tag, &key, &key_len) ||
+           !(value = discord_etf_decode(cur, depth + 1))) {
+            cJSON_Delete(object);
+            return NULL;
+        }
+
+        // key is followed by already decoded value, so it can be terminated in place
+        uint8_t after = key[key_len];
+        key[key_len] = '\0';
+        cJSON_AddItemToObject(object, (const char*) key, value);
+        key[key_len] = after;
+    }
+
+    return object;
+}
+
+static cJSON* discord_etf_decode(discord_etf_cursor_t* cur, int depth) {
+    uint8_t tag, n8;
+    uint32_t n;
+    uint8_t* p;
+    int value;
+    double number;
+
+    if(depth > DISCORD_ETF_MAX_DEPTH || !discord_etf_read_u8(cur, &tag)) {
+        return NULL;
+    }
+
+    switch(tag) {
+        case DISCORD_ETF_SMALL_INTEGER:
+        case DISCORD_ETF_INTEGER:
+            return discord_etf_read_int(cur, tag, &value) ? cJSON_CreateNumber(value) : NULL;
+
+        case DISCORD_ETF_NEW_FLOAT:
+        case DISCORD_ETF_FLOAT:
+            return discord_etf_read_float(cur, tag, &number) ? cJSON_CreateNumber(number) : NULL;
+
+        case DISCORD_ETF_SMALL_BIG:
+        case DISCORD_ETF_LARGE_BIG:
+            return discord_etf_create_big(cur, tag);
+
+        case DISCORD_ETF_NIL:
+            return cJSON_CreateArray();
+
+        case DISCORD_ETF_SMALL_TUPLE:
+            return discord_etf_read_u8(cur, &n8) ? discord_etf_decode_items(cur, n8, false, depth) : NULL;
+
+        case DISCORD_ETF_LARGE_TUPLE:
+            return discord_etf_read_u32(cur, &n) ? discord_etf_decode_items(cur, n, false, depth) : NULL;
+
+        case DISCORD_ETF_LIST:
+            return discord_etf_read_u32(cur, &n) ? discord_etf_decode_items(cur, n, true, depth) : NULL;
+
+        case DISCORD_ETF_MAP:
+            return discord_etf_read_u32(cur, &n) ? discord_etf_decode_map(cur, n, depth) : NULL;
+
+        default:
+            if(!discord_etf_read_text(cur, tag, &p, &n)) {
+                return NULL;
+            }
+
+            if(discord_etf_is_atom(tag)) {
+                if(discord_etf_text_eq(p, n, "nil") || discord_etf_text_eq(p, n, "null")) return cJSON_CreateNull();
+                if(discord_etf_text_eq(p, n, "true")) return cJSON_CreateTrue();
+                if(discord_etf_text_eq(p, n, "false")) return cJSON_CreateFalse();
+            }
+
+            return discord_etf_create_string(p, n);
+    }
+}
+
+cJSON* discord_etf_to_cjson(uint8_t* data, size_t len) {
+    discord_etf_cursor_t cur = { .data = data, .len = len };
+
+    if(!data || !discord_etf_read_version(&cur)) {
+        return NULL;
+    }
+
+    return discord_etf_decode(&cur, 0);
+}
+
+// pull reader
+
+static discord_etf_cursor_t discord_etf_cursor(discord_json_reader_t* reader) {
+    return (discord_etf_cursor_t) {
+        .data = (uint8_t*) reader->pos,
+        .len = reader->error ? 0 : reader->end - reader->pos
+    };
+}
+
+/**
+ * @brief Move the reader behind the term which has been read by the cursor. Invalid term stops the reader, see discord_json_reader_t
+ */
+static bool discord_etf_reader_commit(discord_json_reader_t* reader, discord_etf_cursor_t* cur, bool valid) {
+    if(!valid) {
+        reader->error = true;
+        reader->pos = reader->end;
+        return false;
+    }
+
+    reader->pos += cur->pos;
+    return true;
+}
+
+/**
+ * @brief Terminate text in place. Text is moved over the last byte of its length, so the term which follows is not touched
+ */
+static char* discord_etf_terminate(uint8_t* text, uint32_t len) {
+    char* str = (char*) text - 1;
+
+    memmove(str, text, len);
+    str[len] = '\0';
+
+    return str;
+}
+
+static discord_json_type_t discord_etf_text_type(uint8_t tag, const uint8_t* text, uint32_t len) {
+    if(!discord_etf_is_atom(tag)) {
+        return DISCORD_JSON_STRING;
+    }
+
+    if(discord_etf_text_eq(text, len, "nil") || discord_etf_text_eq(text, len, "null")) return DISCORD_JSON_NULL;
+    if(discord_etf_text_eq(text, len, "true") || discord_etf_text_eq(text, len, "false")) return DISCORD_JSON_BOOL;
+
+    return DISCORD_JSON_STRING;
+}
+
+void discord_etf_reader_init(discord_json_reader_t* reader, uint8_t* data, size_t len) {
+    discord_json_reader_init(reader, (char*) data, len);
+    reader->etf = true;
+
+    discord_etf_cursor_t cur = discord_etf_cursor(reader);
+    discord_etf_reader_commit(reader, &cur, data && discord_etf_read_version(&cur));
+}
+
+discord_json_type_t discord_etf_reader_peek(discord_json_reader_t* reader) {
+    discord_etf_cursor_t cur = discord_etf_cursor(reader);
+    uint8_t tag;
+    uint8_t* p;
+    uint32_t n;
+
+    if(!discord_etf_read_u8(&cur, &tag)) {
+        return DISCORD_JSON_NONE;
+    }
+
+    switch(tag) {
+        case DISCORD_ETF_SMALL_INTEGER:
+        case DISCORD_ETF_INTEGER:
+        case DISCORD_ETF_NEW_FLOAT:
+        case DISCORD_ETF_FLOAT:
+            return DISCORD_JSON_NUMBER;
+
+        case DISCORD_ETF_SMALL_BIG:
+        case DISCORD_ETF_LARGE_BIG:
+            return DISCORD_JSON_STRING; // snowflakes are strings in JSON
+
+        case DISCORD_ETF_MAP:
+            return DISCORD_JSON_OBJECT;
+
+        case DISCORD_ETF_NIL:
+        case DISCORD_ETF_LIST:
+        case DISCORD_ETF_SMALL_TUPLE:
+        case DISCORD_ETF_LARGE_TUPLE:
+            return DISCORD_JSON_ARRAY;
+
+        default:
+            return discord_etf_read_text(&cur, tag, &p, &n) ? discord_etf_text_type(tag, p, n) : DISCORD_JSON_NONE;
+    }
+}
+
+void discord_etf_reader_skip(discord_json_reader_t* reader) {
+    discord_etf_cursor_t cur = discord_etf_cursor(reader);
+    discord_etf_reader_commit(reader, &cur, discord_etf_skip(&cur, reader->depth));
+}
+
+/**
+ * @brief Enter the map (object) or the list, tuple or empty list (array). Term of any other type is skipped
+ */
+bool discord_etf_reader_enter(discord_json_reader_t* reader, bool object) {
+    discord_etf_cursor_t cur = discord_etf_cursor(reader);
+    uint8_t tag, n8;
+    uint32_t n = 0;
+
+    if(!discord_etf_read_u8(&cur, &tag) || (object ? tag != DISCORD_ETF_MAP :
+       tag != DISCORD_ETF_NIL && tag != DISCORD_ETF_LIST && tag != DISCORD_ETF_SMALL_TUPLE && tag != DISCORD_ETF_LARGE_TUPLE)) {
+        discord_etf_reader_skip(reader);
+        return false;
+    }
+
+    bool valid = true;
+
+    if(tag == DISCORD_ETF_SMALL_TUPLE) {
+        valid = discord_etf_read_u8(&cur, &n8);
+        n = n8;
+    } else if(tag != DISCORD_ETF_NIL) {
+        valid = discord_etf_read_u32(&cur, &n);
+    }
+
+    if(!discord_etf_reader_commit(reader, &cur, valid && reader->depth < DISCORD_ETF_MAX_DEPTH)) {
+        return false;
+    }
+
+    if(tag == DISCORD_ETF_LIST) {
+        reader->tails |= 1UL << reader->depth;
+    } else {
+        reader->tails &= ~(1UL << reader->depth);
+    }
+
+    reader->left[reader->depth++] = n;
+    return true;
+}
+
+bool discord_etf_reader_next_key(discord_json_reader_t* reader, const char** out_key) {
+    if(reader->error || reader->depth == 0) {
+        return false;
+    }
+
+    if(reader->left[reader->depth - 1] == 0) {
+        reader->depth--;
+        return false;
+    }
+
+    reader->left[reader->depth - 1]--;
+
+    discord_etf_cursor_t cur = discord_etf_cursor(reader);
+    uint8_t tag;
+    uint8_t* key;
+    uint32_t len;
+
+    if(!discord_etf_reader_commit(reader, &cur, discord_etf_read_u8(&cur, &tag) && discord_etf_read_text(&cur, tag, &key, &len))) {
+        return false;
+    }
+
+    *out_key = discord_etf_terminate(key, len);
+    return true;
+}
+
+bool discord_etf_reader_next_item(discord_json_reader_t* reader) {
+    if(reader->error || reader->depth == 0) {
+        return false;
+    }
+
+    uint8_t depth = reader->depth - 1;
+
+    if(reader->left[depth] > 0) {
+        reader->left[depth]--;
+        return true;
+    }
+
+    reader->depth--;
+
+    if(reader->tails & (1UL << depth)) {
+        discord_etf_reader_skip(reader); // proper list ends with empty list as a tail
+    }
+
+    return false;
+}
+
+/**
+ * @brief Length is read from the header of the list, nothing is scanned
+ */
+int discord_etf_reader_count(discord_json_reader_t* reader) {
+    discord_etf_cursor_t cur = discord_etf_cursor(reader);
+    uint8_t tag, n8;
+    uint32_t n;
+
+    if(!discord_etf_read_u8(&cur, &tag)) {
+        return 0;
+    }
+
+    switch(tag) {
+        case DISCORD_ETF_SMALL_TUPLE:
+            return discord_etf_read_u8(&cur, &n8) ? n8 : 0;
+
+        case DISCORD_ETF_LIST:
+        case DISCORD_ETF_LARGE_TUPLE:
+            return discord_etf_read_u32(&cur, &n) ? (n > INT32_MAX ? INT32_MAX : (int) n) : 0;
+
+        default:
+            return 0;
+    }
+}
+
+char* discord_etf_reader_string(discord_json_reader_t* reader, size_t* out_len) {
+    discord_etf_cursor_t cur = discord_etf_cursor(reader);
+    uint8_t tag;
+    uint8_t* text;
+    uint32_t len;
+
+    if(!discord_etf_read_u8(&cur, &tag) || !discord_etf_read_text(&cur, tag, &text, &len)) {
+        discord_etf_reader_skip(reader);
+        return NULL;
+    }
+
+    discord_etf_reader_commit(reader, &cur, true);
+
+    if(discord_etf_text_type(tag, text, len) != DISCORD_JSON_STRING) {
+        return NULL;
+    }
+
+    if(out_len) {
+        *out_len = len;
+    }
+
+    return discord_etf_terminate(text, len);
+}
+
+char* discord_etf_reader_strdup(discord_json_reader_t* reader) {
+    discord_etf_cursor_t cur = discord_etf_cursor(reader);
+    uint8_t tag;
+    uint8_t* text;
+    uint32_t len;
+    char big[22];
+
+    if(!discord_etf_read_u8(&cur, &tag)) {
+        discord_etf_reader_commit(reader, &cur, false);
+        return NULL;
+    }
+
+    if(tag == DISCORD_ETF_SMALL_BIG || tag == DISCORD_ETF_LARGE_BIG) {
+        if(!discord_etf_reader_commit(reader, &cur, discord_etf_read_big(&cur, tag, big, sizeof(big))) || !big[0]) {
+            return NULL;
+        }
+
+        return discord_arena_strndup(reader->arena, big, strlen(big));
+    }
+
+    if(!discord_etf_read_text(&cur, tag, &text, &len)) {
+        discord_etf_reader_skip(reader);
+        return NULL;
+    }
+
+    discord_etf_reader_commit(reader, &cur, true);
+
+    // copy is terminated, so the text does not need to be
+    return discord_etf_text_type(tag, text, len) == DISCORD_JSON_STRING ? discord_arena_strndup(reader->arena, (const char*) text, len) : NULL;
+}
+
+int64_t discord_etf_reader_int(discord_json_reader_t* reader, int64_t default_value) {
+    discord_etf_cursor_t cur = discord_etf_cursor(reader);
+    uint8_t tag;
+    int value;
+    double number;
+    char big[22];
+
+    if(!discord_etf_read_u8(&cur, &tag)) {
+        discord_etf_reader_commit(reader, &cur, false);
+        return default_value;
+    }
+
+    switch(tag) {
+        case DISCORD_ETF_SMALL_INTEGER:
+        case DISCORD_ETF_INTEGER:
+            return discord_etf_reader_commit(reader, &cur, discord_etf_read_int(&cur, tag, &value)) ? value : default_value;
+
+        case DISCORD_ETF_SMALL_BIG:
+        case DISCORD_ETF_LARGE_BIG:
+            return discord_etf_reader_commit(reader, &cur, discord_etf_read_big(&cur, tag, big, sizeof(big))) && big[0] ?
+                strtoll(big, NULL, 10) : default_value;
+
+        case DISCORD_ETF_NEW_FLOAT:
+        case DISCORD_ETF_FLOAT:
+            return discord_etf_reader_commit(reader, &cur, discord_etf_read_float(&cur, tag, &number)) ? (int64_t) number : default_value;
+
+        default:
+            discord_etf_reader_skip(reader);
+            return default_value;
+    }
+}
+
+bool discord_etf_reader_bool(discord_json_reader_t* reader) {
+    discord_etf_cursor_t cur = discord_etf_cursor(reader);
+    uint8_t tag;
+    uint8_t* text;
+    uint32_t len;
+
+    if(!discord_etf_read_u8(&cur, &tag) || !discord_etf_read_text(&cur, tag, &text, &len)) {
+        discord_etf_reader_skip(reader);
+        return false;
+    }
+
+    discord_etf_reader_commit(reader, &cur, true);
+
+    return discord_etf_is_atom(tag) && discord_etf_text_eq(text, len, "true");
+}
+
+cJSON* discord_etf_reader_cjson(discord_json_reader_t* reader) {
+    discord_etf_cursor_t cur = discord_etf_cursor(reader);
+    cJSON* cjson = discord_etf_decode(&cur, reader->depth);
+
+    discord_etf_reader_commit(reader, &cur, cjson != NULL);
+    return cjson;
+}
+
+discord_payload_t* discord_etf_read_payload(uint8_t* data, size_t len, discord_arena_pool_t* pool) {
+    discord_json_reader_t reader;
+    discord_etf_reader_init(&reader, data, len);
+
+    return discord_json_read_payload_from(&reader, pool);
+}
\ No newline at end of file
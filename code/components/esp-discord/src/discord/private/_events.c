@@ -0,0 +1,344 @@
+#include "discord/private/_events.h"
+#include "discord/private/_discord.h"
+#include "discord/message.h"
+#include "discord/message_reaction.h"
+#include "discord/voice_state.h"
+#include "cutils.h"
+#include "estr.h"
+
+DISCORD_LOG_DEFINE_BASE();
+
+char** dcev_ids_copy(const char** ids) {
+    if(!ids)
+        return NULL;
+
+    size_t len = 0;
+    while(ids[len]) { len++; }
+
+    char** copy = calloc(len + 1, sizeof(char*));
+
+    if(!copy)
+        return NULL;
+
+    for(size_t i = 0; i < len; i++) {
+        if(!(copy[i] = strdup(ids[i]))) {
+            cu_list_tfree(copy, size_t, i);
+            return NULL;
+        }
+    }
+
+    return copy;
+}
+
+void dcev_ids_free(const char** ids) {
+    if(!ids)
+        return;
+
+    for(size_t i = 0; ids[i]; i++) {
+        free((char*) ids[i]);
+    }
+
+    free(ids);
+}
+
+static bool dcev_ids_contain(const char** ids, const char* id) {
+    if(!ids)
+        return true; // any
+
+    for(size_t i = 0; ids[i]; i++) {
+        if(estr_eq(ids[i], id)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void dcev_filter_free(discord_event_filter_t* filter) {
+    if(!filter)
+        return;
+
+    dcev_ids_free(filter->channel_ids);
+    dcev_ids_free(filter->guild_ids);
+    free(filter);
+}
+
+static discord_event_filter_t* dcev_filter_copy(const discord_event_filter_t* filter) {
+    discord_event_filter_t* copy = cu_ctor(discord_event_filter_t,
+        .channel_ids = (const char**) dcev_ids_copy(filter->channel_ids),
+        .guild_ids = (const char**) dcev_ids_copy(filter->guild_ids),
+        .author = filter->author,
+        .direct_messages = filter->direct_messages
+    );
+
+    if(copy && ((filter->channel_ids && !copy->channel_ids) || (filter->guild_ids && !copy->guild_ids))) {
+        dcev_filter_free(copy);
+        return NULL;
+    }
+
+    return copy;
+}
+
+static bool dcev_filter_match(const discord_event_filter_t* filter, const discord_event_attrs_t* attrs) {
+    if(!filter || !attrs || !attrs->scoped)
+        return true;
+
+    if(filter->channel_ids && !dcev_ids_contain(filter->channel_ids, attrs->channel_id)) {
+        return false;
+    }
+
+    if(filter->guild_ids && !dcev_ids_contain(filter->guild_ids, attrs->guild_id)) {
+        return false;
+    }
+
+    if(attrs->author_bot >= 0) {
+        if(filter->author == DISCORD_EVENT_FILTER_AUTHOR_BOT && !attrs->author_bot) return false;
+        if(filter->author == DISCORD_EVENT_FILTER_AUTHOR_NOT_BOT && attrs->author_bot) return false;
+    }
+
+    return true;
+}
+
+static bool dcev_registration_match(discord_event_registration_t* reg, discord_event_t event, const discord_event_attrs_t* attrs) {
+    return !reg->removed &&
+        (reg->event == DISCORD_EVENT_ANY || reg->event == event) &&
+        dcev_filter_match(reg->filter, attrs);
+}
+
+/**
+ * @brief Free registrations which are unregistered while events were dispatched
+ */
+static void dcev_sweep(discord_handle_t client) {
+    discord_event_registration_t** link = &client->event_registrations;
+
+    while(*link) {
+        discord_event_registration_t* reg = *link;
+
+        if(reg->removed) {
+            *link = reg->next;
+            dcev_filter_free(reg->filter);
+            free(reg);
+        } else {
+            link = &reg->next;
+        }
+    }
+}
+
+/**
+ * @brief The only handler registered in client event loop. Invokes registered handlers whose filters match the event
+ */
+static void dcev_dispatch(void* arg, esp_event_base_t base, int32_t event_id, void* event_data) {
+    discord_handle_t client = (discord_handle_t) arg;
+    discord_event_data_t* data = (discord_event_data_t*) event_data;
+    discord_event_attrs_t attrs;
+
+    dcev_attrs_from_data(event_id, data ? data->ptr : NULL, &attrs);
+
+    xSemaphoreTakeRecursive(client->events_lock, portMAX_DELAY);
+    client->events_dispatching++;
+
+    for(discord_event_registration_t* reg = client->event_registrations; reg; reg = reg->next) {
+        if(dcev_registration_match(reg, event_id, &attrs)) {
+            reg->handler(reg->handler_arg, base, event_id, event_data);
+        }
+    }
+
+    if(--client->events_dispatching == 0) {
+        dcev_sweep(client);
+    }
+
+    xSemaphoreGiveRecursive(client->events_lock);
+}
+
+esp_err_t dcev_init(discord_handle_t client) {
+    if(!(client->events_lock = xSemaphoreCreateRecursiveMutex())) {
+        DISCORD_LOGE("Fail to create events lock");
+        return ESP_ERR_NO_MEM;
+    }
+
+    client->event_registrations = NULL;
+    client->events_dispatching = 0;
+
+    return esp_event_handler_register_with(client->event_handle, DISCORD_EVENTS, DISCORD_EVENT_ANY, dcev_dispatch, client);
+}
+
+esp_err_t dcev_register(discord_handle_t client, discord_event_t event, const discord_event_filter_t* filter, esp_event_handler_t handler, void* handler_arg) {
+    if(!client || !client->events_lock || !handler) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    discord_event_registration_t* reg = cu_ctor(discord_event_registration_t,
+        .event = event,
+        .filter = filter ? dcev_filter_copy(filter) : NULL,
+        .handler = handler,
+        .handler_arg = handler_arg
+    );
+
+    if(!reg || (filter && !reg->filter)) {
+        free(reg);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xSemaphoreTakeRecursive(client->events_lock, portMAX_DELAY);
+
+    // append in order to keep the order of invocation same as the order of registration
+    discord_event_registration_t** link = &client->event_registrations;
+    while(*link) { link = &(*link)->next; }
+    *link = reg;
+
+    xSemaphoreGiveRecursive(client->events_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t dcev_unregister(discord_handle_t client, discord_event_t event, esp_event_handler_t handler) {
+    if(!client) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(!client->events_lock) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTakeRecursive(client->events_lock, portMAX_DELAY);
+
+    for(discord_event_registration_t* reg = client->event_registrations; reg; reg = reg->next) {
+        if(reg->event == event && reg->handler == handler) {
+            reg->removed = true;
+        }
+    }
+
+    if(client->events_dispatching == 0) {
+        dcev_sweep(client);
+    }
+
+    xSemaphoreGiveRecursive(client->events_lock);
+
+    return ESP_OK;
+}
+
+void dcev_destroy(discord_handle_t client) {
+    if(!client || !client->events_lock)
+        return;
+
+    xSemaphoreTakeRecursive(client->events_lock, portMAX_DELAY);
+
+    for(discord_event_registration_t* reg = client->event_registrations; reg; reg = reg->next) {
+        reg->removed = true;
+    }
+
+    dcev_sweep(client);
+    xSemaphoreGiveRecursive(client->events_lock);
+    vSemaphoreDelete(client->events_lock);
+    client->events_lock = NULL;
+}
+
+void dcev_attrs_from_data(discord_event_t event, discord_event_data_ptr_t data, discord_event_attrs_t* out_attrs) {
+    *out_attrs = (discord_event_attrs_t) { .author_bot = -1 };
+
+    if(!data)
+        return;
+
+    switch(event) {
+        case DISCORD_EVENT_MESSAGE_RECEIVED:
+        case DISCORD_EVENT_MESSAGE_UPDATED:
+        case DISCORD_EVENT_MESSAGE_DELETED: {
+                discord_message_t* msg = (discord_message_t*) data;
+                out_attrs->scoped = true;
+                out_attrs->channel_id = msg->channel_id;
+                out_attrs->guild_id = msg->guild_id;
+                out_attrs->author_bot = msg->author ? msg->author->bot : -1;
+            }
+            break;
+
+        case DISCORD_EVENT_MESSAGE_REACTION_ADDED:
+        case DISCORD_EVENT_MESSAGE_REACTION_REMOVED: {
+                discord_message_reaction_t* react = (discord_message_reaction_t*) data;
+                out_attrs->scoped = true;
+                out_attrs->channel_id = react->channel_id;
+                out_attrs->guild_id = react->guild_id;
+            }
+            break;
+
+        case DISCORD_EVENT_VOICE_STATE_UPDATED: {
+                discord_voice_state_t* state = (discord_voice_state_t*) data;
+                out_attrs->scoped = true;
+                out_attrs->channel_id = state->channel_id;
+                out_attrs->guild_id = state->guild_id;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+bool dcev_is_wanted(discord_handle_t client, discord_event_t event, const discord_event_attrs_t* attrs) {
+    client = DISCORD_OWNER(client); // handlers are registered to the client which runs the shards
+    if(!client || !client->events_lock)
+        return false;
+
+    bool wanted = false;
+
+    // do not wait for handlers which are being invoked, event will be filtered before dispatching anyway
+    if(xSemaphoreTakeRecursive(client->events_lock, 0) != pdTRUE) {
+        return true;
+    }
+
+    for(discord_event_registration_t* reg = client->event_registrations; reg && !wanted; reg = reg->next) {
+        wanted = dcev_registration_match(reg, event, attrs);
+    }
+
+    xSemaphoreGiveRecursive(client->events_lock);
+
+    return wanted;
+}
+
+static int dcev_event_intents(discord_event_t event, const discord_event_filter_t* filter) {
+    // direct messages are not in any guild, and listed channels are guild channels unless DMs are asked for
+    bool guild_only = filter && (filter->guild_ids || (filter->channel_ids && !filter->direct_messages));
+
+    switch(event) {
+        case DISCORD_EVENT_MESSAGE_RECEIVED:
+        case DISCORD_EVENT_MESSAGE_UPDATED:
+            return DISCORD_INTENT_GUILD_MESSAGES | DISCORD_INTENT_MESSAGE_CONTENT | (guild_only ? 0 : DISCORD_INTENT_DIRECT_MESSAGES);
+
+        case DISCORD_EVENT_MESSAGE_DELETED:
+            return DISCORD_INTENT_GUILD_MESSAGES | (guild_only ? 0 : DISCORD_INTENT_DIRECT_MESSAGES);
+
+        case DISCORD_EVENT_MESSAGE_REACTION_ADDED:
+        case DISCORD_EVENT_MESSAGE_REACTION_REMOVED:
+            return DISCORD_INTENT_GUILD_MESSAGE_REACTIONS | (guild_only ? 0 : DISCORD_INTENT_DIRECT_MESSAGE_REACTIONS);
+
+        case DISCORD_EVENT_VOICE_STATE_UPDATED:
+            return DISCORD_INTENT_GUILD_VOICE_STATES;
+
+        case DISCORD_EVENT_ANY:
+            return dcev_event_intents(DISCORD_EVENT_MESSAGE_RECEIVED, filter) |
+                dcev_event_intents(DISCORD_EVENT_MESSAGE_REACTION_ADDED, filter) |
+                dcev_event_intents(DISCORD_EVENT_VOICE_STATE_UPDATED, filter);
+
+        default:
+            return 0;
+    }
+}
+
+int dcev_required_intents(discord_handle_t client) {
+    client = DISCORD_OWNER(client);
+    if(!client || !client->events_lock)
+        return 0;
+
+    int intents = 0;
+
+    xSemaphoreTakeRecursive(client->events_lock, portMAX_DELAY);
+
+    for(discord_event_registration_t* reg = client->event_registrations; reg; reg = reg->next) {
+        if(!reg->removed) {
+            intents |= dcev_event_intents(reg->event, reg->filter);
+        }
+    }
+
+    xSemaphoreGiveRecursive(client->events_lock);
+
+    return intents;
+}
\ No newline at end of file
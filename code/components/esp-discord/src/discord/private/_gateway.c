@@ -1,7 +1,15 @@
 #include "discord/private/_gateway.h"
 #include "discord/private/_json.h"
+#include "discord/private/_json_reader.h"
+#include "discord/private/_etf.h"
+#include "discord/private/_events.h"
 #include "discord/message.h"
 #include "esp_transport_ws.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#if __has_include("esp_random.h")
+#include "esp_random.h"
+#endif
 #include "cutils.h"
 #include "estr.h"
 
@@ -14,6 +22,39 @@ static void dcgw_heartbeat_stop(discord_handle_t client) {
     client->heartbeater.interval = 0;
     client->heartbeater.tick_ms = 0;
     client->heartbeater.received_ack = false;
+    dctm_cancel(client, DISCORD_TIMER_HEARTBEAT);
+    dctm_cancel(client, DISCORD_TIMER_ACK);
+    dctm_cancel(client, DISCORD_TIMER_SILENCE);
+    dctm_cancel(client, DISCORD_TIMER_IDENTIFY); // new connection takes a new slot
+}
+
+/**
+ * @brief Record RTT of the acknowledged heartbeat. Called from ws task, so the event is only marked here
+ */
+static void dcgw_heartbeat_ack(discord_handle_t client) {
+    discord_heartbeater_t* hb = &client->heartbeater;
+
+    if(hb->running && !hb->received_ack) {
+        hb->rtts[hb->rtt_next] = (uint32_t) (discord_tick_ms() - hb->tick_ms);
+        hb->rtt_next = (hb->rtt_next + 1) % DISCORD_HEARTBEAT_RTT_WINDOW;
+
+        if(hb->rtt_count < DISCORD_HEARTBEAT_RTT_WINDOW) {
+            hb->rtt_count++;
+        }
+
+        if(client->config->gateway_latency_threshold_ms > 0) {
+            discord_gateway_latency_t latency;
+            dcgw_get_latency(client, &latency);
+
+            if(latency.above_threshold != hb->latency_high) {
+                hb->latency_high = latency.above_threshold;
+                hb->latency_crossed = true;
+                DISCORD_TASK_NOTIFY(client);
+            }
+        }
+    }
+
+    hb->received_ack = true;
 }
 
 static bool dcgw_whether_payload_should_go_into_queue(discord_handle_t client, discord_payload_t* payload) {
@@ -21,7 +62,7 @@ static bool dcgw_whether_payload_should_go_into_queue(discord_handle_t client, d
         return false;
 
     if(payload->op == DISCORD_OP_DISPATCH) {
-        if(client->state < DISCORD_STATE_CONNECTED && payload->t != DISCORD_EVENT_READY) {
+        if(client->state < DISCORD_STATE_CONNECTED && !client->gw_resuming && payload->t != DISCORD_EVENT_READY) {
             DISCORD_LOGW("Ignoring payload because client is not in CONNECTED state and still not receive READY payload");
             return false;
         }
@@ -59,6 +100,132 @@ static bool dcgw_whether_payload_should_go_into_queue(discord_handle_t client, d
     return true;
 }
 
+static void dcgw_signal_task(discord_handle_t client, uint32_t bit) {
+    if(client->gw_replaying) {
+        client->gw_replay_bits |= bit; // replay handles the bits itself
+    } else {
+        DISCORD_TASK_NOTIFY_BITS(client, bit);
+    }
+}
+
+/**
+ * @brief Hand control opcodes over to the task using notification bits,
+ *        so they never wait in the queue behind dispatch payloads
+ * @return true if payload has been consumed
+ */
+static bool dcgw_signal_control_payload(discord_handle_t client, discord_payload_t* payload) {
+    uint32_t bit;
+
+    switch(payload->op) {
+        case DISCORD_OP_HELLO:
+            client->gw_hello_interval = payload->d ? ((discord_hello_t*) payload->d)->heartbeat_interval : 0;
+            bit = DISCORD_TASK_BIT_HELLO;
+            break;
+
+        case DISCORD_OP_RECONNECT:
+            bit = DISCORD_TASK_BIT_RECONNECT;
+            break;
+
+        case DISCORD_OP_INVALID_SESSION:
+            client->gw_session_resumable = payload->d && ((discord_invalid_session_t*) payload->d)->resumable;
+            bit = DISCORD_TASK_BIT_INVALID_SESSION;
+            break;
+
+        default:
+            return false;
+    }
+
+    discord_payload_free(payload);
+    dcgw_signal_task(client, bit);
+
+    return true;
+}
+
+/**
+ * @brief Decide by the event name only whether dispatch payload is worth decoding
+ */
+static bool dcgw_whether_event_should_be_decoded(discord_handle_t client, discord_event_t event) {
+    if(event == DISCORD_EVENT_UNKNOWN) {
+        return false;
+    }
+
+    if(DISCORD_EVENT_IS_MEMBER_STATE(event)) {
+        if(!client->gw_members_lock) {
+            return false; // member cache is disabled
+        }
+    } else if(DISCORD_EVENT_IS_GUILD_STATE(event) && !client->gw_guilds_lock) {
+        return false; // guild cache is disabled
+    }
+
+    if(client->state < DISCORD_STATE_CONNECTED && !client->gw_resuming && event != DISCORD_EVENT_READY) {
+        return false;
+    }
+
+    return true;
+}
+
+bool dcgw_whether_payload_should_be_decoded(discord_handle_t client, discord_json_stream_t* stream) {
+    int op = discord_json_stream_get_int_field(stream, DISCORD_JSON_STREAM_FIELD_OP, -1);
+
+    if(op != DISCORD_OP_DISPATCH) {
+        return true;
+    }
+
+    discord_event_t event = discord_model_event_by_name(discord_json_stream_get_field(stream, DISCORD_JSON_STREAM_FIELD_T));
+
+    if(!dcgw_whether_event_should_be_decoded(client, event)) {
+        return false;
+    }
+
+    if(DISCORD_EVENT_IS_GUILD_STATE(event)) {
+        return true; // nobody handles these events, they are for the guild and member caches
+    }
+
+    const char* own_id = client->session && client->session->user ? client->session->user->id : NULL;
+
+    switch(event) {
+        case DISCORD_EVENT_MESSAGE_RECEIVED:
+        case DISCORD_EVENT_MESSAGE_UPDATED: {
+                int type = discord_json_stream_get_int_field(stream, DISCORD_JSON_STREAM_FIELD_TYPE, DISCORD_MESSAGE_DEFAULT);
+                const char* author_id = discord_json_stream_get_field(stream, DISCORD_JSON_STREAM_FIELD_AUTHOR_ID);
+
+                if(!author_id ||
+                    !(type == DISCORD_MESSAGE_DEFAULT || type == DISCORD_MESSAGE_REPLY) ||
+                    estr_eq(author_id, own_id)) {
+                    return false;
+                }
+            }
+            break;
+
+        case DISCORD_EVENT_MESSAGE_REACTION_ADDED:
+        case DISCORD_EVENT_MESSAGE_REACTION_REMOVED:
+            if(estr_eq(discord_json_stream_get_field(stream, DISCORD_JSON_STREAM_FIELD_USER_ID), own_id)) {
+                return false;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if(event > DISCORD_EVENT_CONNECTED && event != DISCORD_EVENT_RESUMED) {
+        const char* author_id = discord_json_stream_get_field(stream, DISCORD_JSON_STREAM_FIELD_AUTHOR_ID);
+        discord_event_attrs_t attrs = {
+            .scoped = true,
+            .channel_id = discord_json_stream_get_field(stream, DISCORD_JSON_STREAM_FIELD_CHANNEL_ID),
+            .guild_id = discord_json_stream_get_field(stream, DISCORD_JSON_STREAM_FIELD_GUILD_ID),
+            .author_bot = !author_id ? -1 : estr_eq(discord_json_stream_get_field(stream, DISCORD_JSON_STREAM_FIELD_AUTHOR_BOT), "true")
+        };
+
+        // nobody is going to receive the event
+        if(!dcev_is_wanted(client, event, &attrs)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 static discord_close_code_t dcgw_get_close_opcode(discord_handle_t client) {
     if(client->state == DISCORD_STATE_DISCONNECTING && client->gw_buffer_len >= 2) {
         int code = (256 * client->gw_buffer[0] + client->gw_buffer[1]);
@@ -68,211 +235,1503 @@ static discord_close_code_t dcgw_get_close_opcode(discord_handle_t client) {
     return DISCORD_CLOSEOP_NO_CODE;
 }
 
-static esp_err_t dcgw_buffer_websocket_data(discord_handle_t client, esp_websocket_event_data_t* data) {
-    DISCORD_LOG_FOO();
-
+static esp_err_t dcgw_buffer_close_frame(discord_handle_t client, esp_websocket_event_data_t* data) {
     if(data->payload_len > client->config->gateway_buffer_size) {
-        DISCORD_LOGW("Payload too big. Wider buffer required.");
+        DISCORD_LOGW("Close frame too big. Wider buffer required.");
         return ESP_FAIL;
     }
-    
-    DISCORD_LOGD("Buffering received data:\n%.*s", data->data_len, data->data_ptr);
-    
+
     memcpy(client->gw_buffer + data->payload_offset, data->data_ptr, data->data_len);
 
     if((client->gw_buffer_len = data->data_len + data->payload_offset) >= data->payload_len) {
-        DISCORD_LOGD("Buffering done");
-
         // append null terminator
         client->gw_buffer[client->gw_buffer_len] = '\0';
+        client->state = DISCORD_STATE_DISCONNECTING;
+        client->close_code = dcgw_get_close_opcode(client);
+    }
 
-        if(data->op_code == WS_TRANSPORT_OPCODES_CLOSE) {
-            client->state = DISCORD_STATE_DISCONNECTING;
-            client->close_code = dcgw_get_close_opcode(client);
+    return ESP_OK;
+}
 
-            return ESP_OK;
-        }
+static bool dcgw_is_etf(discord_handle_t client) {
+    return client->config->gateway_encoding == DISCORD_GATEWAY_ENCODING_ETF;
+}
 
-        discord_payload_t* payload = discord_json_deserialize_(payload, client->gw_buffer, client->gw_buffer_len);
+/**
+ * @brief Pass the next part of the payload to the stream. Errors are logged only once per payload
+ */
+static esp_err_t dcgw_stream_payload(discord_handle_t client, const char* data, size_t len) {
+    discord_json_stream_t* stream = &client->gw_stream;
 
-        if(!payload) {
-            DISCORD_LOGE("Fail to deserialize payload");
-            return ESP_FAIL;
-        }
+    if(stream->state == DISCORD_JSON_STREAM_ERROR) {
+        return ESP_FAIL; // rest of the payload which is already dropped
+    }
 
-        if(payload->s != DISCORD_NULL_SEQUENCE_NUMBER) {
-            client->last_sequence_number = payload->s;
-        }
-        
-        if(! dcgw_whether_payload_should_go_into_queue(client, payload)) {
-            DISCORD_LOGD("Payload ignored");
-            discord_payload_free(payload);
-        } else if(xQueueSend(client->queue, &payload, 5000 / portTICK_PERIOD_MS) != pdPASS) { // 5sec timeout
-            DISCORD_LOGW("Fail to queue the payload");
-            discord_payload_free(payload);
-        }
+    DISCORD_LOGD("Streaming received data:\n%.*s", len, data);
+
+    esp_err_t err = discord_json_stream_feed(stream, data, len);
+
+    if(err == ESP_ERR_INVALID_SIZE) {
+        DISCORD_LOGW("Payload too big (retained=%d). Wider buffer required.", stream->len);
+    } else if(err != ESP_OK) {
+        DISCORD_LOGE("Fail to parse payload");
     }
 
-    return ESP_OK;
+    return err;
 }
 
-static void dcgw_websocket_event_handler(void* handler_arg, esp_event_base_t base, int32_t event_id, void* event_data) {
-    discord_handle_t client = (discord_handle_t) handler_arg;
-    esp_websocket_event_data_t* data = (esp_websocket_event_data_t*) event_data;
+static void dcgw_stream_inflated_payload(void* arg, const char* data, size_t len) {
+    dcgw_stream_payload((discord_handle_t) arg, data, len);
+}
 
-    if(data->op_code == WS_TRANSPORT_OPCODES_PONG) { // ignore PONG frame
-        return;
+static void dcgw_queue_item_free(void* item) {
+    discord_payload_free((discord_payload_t*) item);
+}
+
+// fixed frames carry no data, their content is taken from the client when they are written
+static discord_payload_t dcgw_heartbeat_frame = { .op = DISCORD_OP_HEARTBEAT };
+static discord_payload_t dcgw_identify_frame = { .op = DISCORD_OP_IDENTIFY };
+static discord_payload_t dcgw_resume_frame = { .op = DISCORD_OP_RESUME };
+
+static bool dcgw_is_fixed_frame(discord_payload_t* payload) {
+    return payload == &dcgw_heartbeat_frame || payload == &dcgw_identify_frame || payload == &dcgw_resume_frame;
+}
+
+static void dcgw_outbox_item_free(void* item) {
+    if(!dcgw_is_fixed_frame((discord_payload_t*) item)) {
+        discord_payload_free((discord_payload_t*) item);
     }
+}
 
-    DISCORD_LOGD("ws event (event=%d, op_code=%d, payload_len=%d, data_len=%d, payload_offset=%d)",
-        event_id,
-        data->op_code,
-        data->payload_len, 
-        data->data_len, 
-        data->payload_offset
-    );
+/**
+ * @brief Updates of the same message can replace each other while waiting in the queue
+ * @return Message id as number or 0 if payload cannot be coalesced
+ */
+static uint64_t dcgw_queue_coalesce_key(discord_payload_t* payload) {
+    if(payload->op != DISCORD_OP_DISPATCH || payload->t != DISCORD_EVENT_MESSAGE_UPDATED || !payload->d) {
+        return 0;
+    }
 
-    switch (event_id) {
-        case WEBSOCKET_EVENT_CONNECTED:
-            client->state = DISCORD_STATE_CONNECTING;
+    const char* id = ((discord_message_t*) payload->d)->id;
+
+    return id ? strtoull(id, NULL, 10) : 0;
+}
+
+/**
+ * @brief Handle the fields which are read before decoding
+ * @return true if payload is completely handled (heartbeat ACK)
+ */
+static bool dcgw_handle_payload_header(discord_handle_t client, int op, int s) {
+    client->gw_stats.payloads_received++;
+
+    if(s > 0) {
+        client->last_sequence_number = s; // sequence number of ignored payloads is needed as well
+    }
+
+    if(op == DISCORD_OP_HEARTBEAT_ACK) {
+        DISCORD_LOGD("Heartbeat ack received");
+        client->gw_stats.heartbeat_acks++;
+        dcgw_heartbeat_ack(client);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Keep the guild cache current. Guild state events are consumed here in the websocket task,
+ *        so the burst of GUILD_CREATE after READY does not go through the queue
+ * @return true if payload has been consumed
+ */
+static bool dcgw_guild_cache_payload(discord_handle_t client, discord_payload_t* payload) {
+    if(payload->op != DISCORD_OP_DISPATCH || !client->gw_guilds_lock) {
+        return false;
+    }
+
+    bool state_event = DISCORD_EVENT_IS_GUILD_STATE(payload->t);
+
+    if(!state_event && payload->t != DISCORD_EVENT_READY) {
+        return false;
+    }
+
+    discord_guild_state_t* state = (discord_guild_state_t*) payload->d;
+    discord_guild_cache_t* cache = &client->gw_guilds;
+    esp_err_t err = ESP_OK;
+
+    xSemaphoreTake(client->gw_guilds_lock, portMAX_DELAY);
+
+    switch((int) payload->t) {
+        case DISCORD_EVENT_READY:
+            discord_guild_cache_clear(cache); // new session, GUILD_CREATE follows for every guild
             break;
 
-        case WEBSOCKET_EVENT_DATA:
-            if(data->op_code == WS_TRANSPORT_OPCODES_TEXT || data->op_code == WS_TRANSPORT_OPCODES_CLOSE) {
-                dcgw_buffer_websocket_data(client, data);
+        case DISCORD_EVENT_GUILD_CREATED:
+        case DISCORD_EVENT_GUILD_UPDATED:
+            if(state && state->roles) {
+                err = discord_guild_cache_set_roles(cache, state->guild_id, state->roles, state->roles_len);
+            }
+
+            if(err == ESP_OK && state && state->channels) {
+                err = discord_guild_cache_set_channels(cache, state->guild_id, state->channels, state->channels_len);
             }
             break;
-        
-        case WEBSOCKET_EVENT_ERROR:
-            client->state = DISCORD_STATE_ERROR;
+
+        case DISCORD_EVENT_GUILD_DELETED:
+            if(state) {
+                discord_guild_cache_remove_guild(cache, state->guild_id);
+            }
             break;
 
-        case WEBSOCKET_EVENT_DISCONNECTED:
-            client->state = DISCORD_STATE_DISCONNECTED;
+        case DISCORD_EVENT_GUILD_ROLE_CREATED:
+        case DISCORD_EVENT_GUILD_ROLE_UPDATED:
+            if(state && state->roles_len == 1) {
+                err = discord_guild_cache_put_role(cache, state->guild_id, state->roles[0]);
+            }
             break;
 
-        case WEBSOCKET_EVENT_CLOSED:
-            client->state = DISCORD_STATE_DISCONNECTED;
+        case DISCORD_EVENT_GUILD_ROLE_DELETED:
+            if(state) {
+                discord_guild_cache_remove_role(cache, state->guild_id, state->id);
+            }
             break;
-            
-        default:
-            DISCORD_LOGW("Unknown ws event %d", event_id);
+
+        case DISCORD_EVENT_CHANNEL_CREATED:
+        case DISCORD_EVENT_CHANNEL_UPDATED:
+            if(state && state->guild_id && state->channels_len == 1) {
+                err = discord_guild_cache_put_channel(cache, state->guild_id, state->channels[0]);
+            }
+            break;
+
+        case DISCORD_EVENT_CHANNEL_DELETED:
+            if(state && state->guild_id) {
+                discord_guild_cache_remove_channel(cache, state->guild_id, state->id);
+            }
             break;
     }
+
+    xSemaphoreGive(client->gw_guilds_lock);
+
+    if(err == ESP_ERR_INVALID_SIZE) {
+        DISCORD_LOGW("Guild %s does not fit into guild_cache_size (%d)", state->guild_id, client->config->guild_cache_size);
+    } else if(err == ESP_ERR_NO_MEM) {
+        DISCORD_LOGW("Guild %s dropped from cache, out of memory", state->guild_id);
+    }
+
+    if(state_event) {
+        discord_payload_free(payload);
+    }
+
+    return state_event;
 }
 
-esp_err_t dcgw_init(discord_handle_t client) {
-    DISCORD_LOG_FOO();
+static int dcgw_member_cache_guild_index(discord_handle_t client, const char* guild_id) {
+    const char** ids = client->config->member_cache_guild_ids;
 
-    if(client->state >= DISCORD_STATE_INIT) {
-        DISCORD_LOGW("Already inited");
-        return ESP_OK;
+    for(int i = 0; ids && ids[i]; i++) {
+        if(estr_eq(ids[i], guild_id)) {
+            return i;
+        }
     }
-    
-    if(!(client->gw_lock = xSemaphoreCreateMutex()) ||
-       !(client->queue = xQueueCreate(client->config->queue_size, sizeof(discord_payload_t*)))) {
-        DISCORD_LOGE("Fail to create mutex/queue");
-        dcgw_destroy(client);
-        return ESP_FAIL;
+
+    return -1;
+}
+
+/**
+ * @brief Stage the member scanned from d.members. Event of the payload does not have to be known yet (ETF sends "t" after "d"),
+ *        so members are cached only once the payload turns out to be GUILD_MEMBERS_CHUNK
+ */
+static void dcgw_member_cache_stream_member(void* arg, const discord_member_record_t* member) {
+    discord_handle_t client = (discord_handle_t) arg;
+
+    if(client->gw_members_loading < 0) {
+        return;
     }
 
-    if(!(client->gw_buffer = malloc(client->config->gateway_buffer_size + 1))) {
-        DISCORD_LOGE("Fail to allocate buffer");
-        dcgw_destroy(client);
+    xSemaphoreTake(client->gw_members_lock, portMAX_DELAY);
+    discord_member_cache_stage(&client->gw_members, member);
+    xSemaphoreGive(client->gw_members_lock);
+}
+
+/**
+ * @brief Cache members staged while the payload was streamed, or drop them if the payload is not a complete GUILD_MEMBERS_CHUNK.
+ *        Members are requested for one guild at a time, so they belong to the loading guild even if guild_id of the chunk follows them
+ */
+static void dcgw_member_cache_stream_end(discord_handle_t client) {
+    if(!client->gw_members_lock) {
+        return;
+    }
+
+    discord_json_stream_t* stream = &client->gw_stream;
+    int loading = client->gw_members_loading;
+
+    xSemaphoreTake(client->gw_members_lock, portMAX_DELAY);
+
+    if(loading >= 0 && discord_json_stream_is_done(stream) &&
+       estr_eq(discord_json_stream_get_field(stream, DISCORD_JSON_STREAM_FIELD_T), "GUILD_MEMBERS_CHUNK")) {
+        discord_member_cache_commit(&client->gw_members, client->config->member_cache_guild_ids[loading]);
+    } else {
+        discord_member_cache_drop_staged(&client->gw_members);
+    }
+
+    xSemaphoreGive(client->gw_members_lock);
+}
+
+/**
+ * @brief Keep the member cache current. Member events are consumed here in the websocket task,
+ *        the task is only signaled when the last chunk of the loading guild is received
+ * @return true if payload has been consumed
+ */
+static bool dcgw_member_cache_payload(discord_handle_t client, discord_payload_t* payload) {
+    if(payload->op != DISCORD_OP_DISPATCH || !client->gw_members_lock || !DISCORD_EVENT_IS_MEMBER_STATE(payload->t)) {
+        return false;
+    }
+
+    discord_guild_state_t* state = (discord_guild_state_t*) payload->d;
+    discord_member_cache_t* cache = &client->gw_members;
+    int guild = state ? dcgw_member_cache_guild_index(client, state->guild_id) : -1;
+
+    if(guild >= 0) {
+        xSemaphoreTake(client->gw_members_lock, portMAX_DELAY);
+
+        switch((int) payload->t) {
+            case DISCORD_EVENT_GUILD_MEMBERS_CHUNK:
+                for(int i = 0; i < state->members_len; i++) {
+                    discord_member_cache_put(cache, state->guild_id, &state->members[i]);
+                }
+                break;
+
+            case DISCORD_EVENT_GUILD_MEMBER_ADDED:
+            case DISCORD_EVENT_GUILD_MEMBER_UPDATED:
+                if(state->members_len == 1 && discord_member_cache_put(cache, state->guild_id, &state->members[0]) == ESP_OK) {
+                    break;
+                }
+                // fall through, member which cannot be cached must not stay there outdated
+
+            case DISCORD_EVENT_GUILD_MEMBER_REMOVED:
+                discord_member_cache_remove(cache, state->guild_id, state->id);
+                break;
+        }
+
+        xSemaphoreGive(client->gw_members_lock);
+    }
+
+    if((int) payload->t == DISCORD_EVENT_GUILD_MEMBERS_CHUNK && guild >= 0 &&
+       guild == client->gw_members_loading && state->chunk_index + 1 >= state->chunk_count) {
+        dcgw_signal_task(client, DISCORD_TASK_BIT_MEMBERS);
+    }
+
+    discord_payload_free(payload);
+
+    return true;
+}
+
+/**
+ * @brief Put decoded payload into the queue or signal it to the task
+ */
+static esp_err_t dcgw_queue_payload(discord_handle_t client, discord_payload_t* payload) {
+    if(!payload) {
+        DISCORD_LOGE("Fail to deserialize payload");
         return ESP_FAIL;
     }
 
-    dcgw_heartbeat_stop(client);
-    client->last_sequence_number = DISCORD_NULL_SEQUENCE_NUMBER;
-    client->close_reason = DISCORD_CLOSE_REASON_NOT_REQUESTED;
-    client->close_code = DISCORD_CLOSEOP_NO_CODE;
-    client->gw_buffer_len = 0;
-    client->state = DISCORD_STATE_INIT;
+    client->gw_stats.payloads_decoded++;
+    
+    if(dcgw_signal_control_payload(client, payload)) {
+        DISCORD_LOGD("Control payload signaled");
+    } else if(dcgw_member_cache_payload(client, payload)) {
+        DISCORD_LOGD("Member cache updated");
+    } else if(dcgw_guild_cache_payload(client, payload)) {
+        DISCORD_LOGD("Guild cache updated");
+    } else if(! dcgw_whether_payload_should_go_into_queue(client, payload)) {
+        DISCORD_LOGD("Payload ignored");
+        discord_payload_free(payload);
+    } else if(discord_payload_ring_push(&client->queue, payload, dcgw_queue_coalesce_key(payload)) != ESP_OK) {
+        DISCORD_LOGW("Queue is full, payload dropped"); // payload is freed by the queue
+    } else {
+        DISCORD_TASK_NOTIFY(client);
+    }
+
+    return ESP_OK;
+}
+
+static void dcgw_payload_begin(discord_handle_t client) {
+    if(client->gw_members.staged) {
+        dcgw_member_cache_stream_end(client); // previous payload has not been completed
+    }
+
+    discord_json_stream_reset(&client->gw_stream);
+}
+
+/**
+ * @brief Deserialize completely streamed payload and put it into the queue
+ */
+static esp_err_t dcgw_queue_streamed_payload(discord_handle_t client) {
+    discord_json_stream_t* stream = &client->gw_stream;
+    dcgw_member_cache_stream_end(client);
+
+    if(stream->state == DISCORD_JSON_STREAM_ERROR) {
+        return ESP_FAIL; // already logged
+    }
+
+    if(!discord_json_stream_is_done(stream)) {
+        DISCORD_LOGE("Incomplete payload");
+        return ESP_FAIL;
+    }
+
+    DISCORD_LOGD("Buffering done (retained=%d)", stream->len);
+
+    if(dcgw_handle_payload_header(client,
+        discord_json_stream_get_int_field(stream, DISCORD_JSON_STREAM_FIELD_OP, -1),
+        discord_json_stream_get_int_field(stream, DISCORD_JSON_STREAM_FIELD_S, DISCORD_NULL_SEQUENCE_NUMBER))) {
+        return ESP_OK;
+    }
+
+    if(!dcgw_whether_payload_should_be_decoded(client, stream)) {
+        DISCORD_LOGD("Payload ignored before decoding");
+        client->gw_stats.payloads_ignored++;
+        return ESP_OK;
+    }
+
+    client->gw_buffer_len = stream->len;
+    client->gw_buffer[client->gw_buffer_len] = '\0'; // append null terminator, ETF decoder needs the spare byte as well
+
+    discord_arena_pool_t* pool = client->config->gateway_payload_arena ? &client->gw_arenas : NULL;
+
+    return dcgw_queue_payload(client, dcgw_is_etf(client) ?
+        discord_etf_read_payload((uint8_t*) client->gw_buffer, client->gw_buffer_len, pool) :
+        discord_json_read_payload(client->gw_buffer, client->gw_buffer_len, pool));
+}
+
+/**
+ * @brief Inflate zlib-stream frame. Message ends with Z_SYNC_FLUSH marker, which does not have to be in the same frame.
+ *        With per message compression the message is a whole zlib stream which ends with the payload
+ */
+static esp_err_t dcgw_inflate_websocket_data(discord_handle_t client, esp_websocket_event_data_t* data) {
+    if(discord_zlib_stream_is_flushed(&client->gw_zlib)) {
+        dcgw_payload_begin(client); // new message begins
+    }
+
+    if(discord_zlib_stream_feed(&client->gw_zlib, data->data_ptr, data->data_len, dcgw_stream_inflated_payload, client) != ESP_OK) {
+        // context (dictionary) is lost, stream cannot be continued on this connection
+        DISCORD_LOGE("Fail to inflate payload (offset=%d)", data->payload_offset);
+        client->state = DISCORD_STATE_ERROR;
+        return ESP_FAIL;
+    }
+
+    if(data->payload_offset + data->data_len < data->payload_len) {
+        return ESP_OK; // wait for the rest of the payload
+    }
+
+    if(!discord_zlib_stream_is_flushed(&client->gw_zlib)) {
+        if(!client->gw_zlib.per_message) {
+            return ESP_OK; // wait for the rest of the message
+        }
+
+        DISCORD_LOGE("Compressed payload is incomplete");
+        discord_zlib_stream_reset(&client->gw_zlib);
+        return ESP_FAIL;
+    }
+
+    return dcgw_queue_streamed_payload(client);
+}
+
+/**
+ * @brief Check if the frame has to be inflated. Frame is remembered at the start of the payload, because with
+ *        per message compression only large payloads are compressed. Uncompressed ETF payload starts with the version
+ */
+static bool dcgw_is_compressed_frame(discord_handle_t client, esp_websocket_event_data_t* data) {
+    if(data->op_code != WS_TRANSPORT_OPCODES_BINARY || !client->gw_zlib.decomp) {
+        return false;
+    }
+
+    if(!client->gw_zlib.per_message) {
+        return true;
+    }
+
+    if(data->payload_offset == 0) {
+        client->gw_inflating = !dcgw_is_etf(client) || data->data_len < 1 || (uint8_t) data->data_ptr[0] != DISCORD_ETF_VERSION;
+    }
+
+    return client->gw_inflating;
+}
+
+static esp_err_t dcgw_buffer_websocket_data(discord_handle_t client, esp_websocket_event_data_t* data) {
+    DISCORD_LOG_FOO();
+
+    if(data->op_code == WS_TRANSPORT_OPCODES_CLOSE) {
+        return dcgw_buffer_close_frame(client, data);
+    }
+
+    // ETF payloads are binary frames as well
+    if(dcgw_is_compressed_frame(client, data)) {
+        return dcgw_inflate_websocket_data(client, data);
+    }
+
+    if(data->op_code == WS_TRANSPORT_OPCODES_BINARY && !dcgw_is_etf(client)) {
+        DISCORD_LOGW("Binary payload received but compression is not enabled");
+        return ESP_FAIL;
+    }
+
+    if(data->payload_offset == 0) {
+        dcgw_payload_begin(client);
+    }
+
+    esp_err_t err = dcgw_stream_payload(client, data->data_ptr, data->data_len);
+
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    if(data->payload_offset + data->data_len < data->payload_len) {
+        return ESP_OK; // wait for the rest of the payload
+    }
+
+    return dcgw_queue_streamed_payload(client);
+}
+
+/**
+ * @brief Append raw frame to the recording. Recording is debug only, so failure only stops it
+ */
+static void dcgw_record_websocket_event(discord_handle_t client, int32_t event_id, esp_websocket_event_data_t* data) {
+    bool has_data = event_id == WEBSOCKET_EVENT_DATA;
+    discord_recorder_frame_t frame = {
+        .event_id = event_id,
+        .op_code = data->op_code,
+        .payload_len = has_data ? data->payload_len : 0,
+        .payload_offset = has_data ? data->payload_offset : 0,
+        .data_len = has_data ? data->data_len : 0
+    };
+
+    if(discord_recorder_write(&client->gw_recorder, &frame, data->data_ptr) != ESP_OK) {
+        DISCORD_LOGE("Fail to record frame, recording stopped");
+        discord_recorder_close(&client->gw_recorder);
+    }
+}
+
+static void dcgw_handle_websocket_event(discord_handle_t client, int32_t event_id, esp_websocket_event_data_t* data) {
+    if(data->op_code == WS_TRANSPORT_OPCODES_PONG) { // ignore PONG frame
+        return;
+    }
+
+    DISCORD_LOGD("ws event (event=%d, op_code=%d, payload_len=%d, data_len=%d, payload_offset=%d)",
+        event_id,
+        data->op_code,
+        data->payload_len, 
+        data->data_len, 
+        data->payload_offset
+    );
+
+    discord_gateway_state_t state = client->state;
+
+    switch (event_id) {
+        case WEBSOCKET_EVENT_CONNECTED:
+            client->state = DISCORD_STATE_CONNECTING;
+            client->gw_connect_bytes = 0;
+            client->gw_connect_counting = true;
+            break;
+
+        case WEBSOCKET_EVENT_DATA:
+            if(client->gw_connect_counting) {
+                client->gw_connect_bytes += data->data_len;
+            }
+
+            if(data->op_code == WS_TRANSPORT_OPCODES_TEXT ||
+               data->op_code == WS_TRANSPORT_OPCODES_BINARY ||
+               data->op_code == WS_TRANSPORT_OPCODES_CLOSE) {
+                dcgw_buffer_websocket_data(client, data);
+            }
+            break;
+        
+        case WEBSOCKET_EVENT_ERROR:
+            client->state = DISCORD_STATE_ERROR;
+            break;
+
+        case WEBSOCKET_EVENT_DISCONNECTED:
+            client->state = DISCORD_STATE_DISCONNECTED;
+            break;
+
+        case WEBSOCKET_EVENT_CLOSED:
+            client->state = DISCORD_STATE_DISCONNECTED;
+            break;
+            
+        default:
+            DISCORD_LOGW("Unknown ws event %d", event_id);
+            break;
+    }
+
+    if(client->state != state) {
+        DISCORD_TASK_NOTIFY(client); // discord task handles state changes
+    }
+}
+
+/**
+ * @brief Buffer frames of the standby connection until the task switches to it. Called from ws task of the standby,
+ *        or of the replaced connection whose frames are ignored
+ */
+static void dcgw_standby_websocket_event(discord_handle_t client, int32_t event_id, esp_websocket_event_data_t* data) {
+    discord_gateway_standby_t* sb = &client->gw_standby;
+
+    if(data->client != sb->ws || sb->state != DISCORD_GW_STANDBY_WARMING) {
+        return;
+    }
+
+    switch(event_id) {
+        case WEBSOCKET_EVENT_CONNECTED:
+            return; // HELLO follows
+
+        case WEBSOCKET_EVENT_DATA: {
+                if(data->op_code == WS_TRANSPORT_OPCODES_PING || data->op_code == WS_TRANSPORT_OPCODES_PONG) {
+                    return;
+                }
+
+                if(data->op_code == WS_TRANSPORT_OPCODES_CLOSE || sb->frames_len >= DISCORD_GW_STANDBY_FRAMES ||
+                   sb->buffer_len + data->data_len > DISCORD_GW_STANDBY_BUFFER_SIZE) {
+                    sb->state = DISCORD_GW_STANDBY_FAILED;
+                    break;
+                }
+
+                sb->frames[sb->frames_len++] = (discord_recorder_frame_t) {
+                    .event_id = event_id,
+                    .op_code = data->op_code,
+                    .payload_len = data->payload_len,
+                    .payload_offset = data->payload_offset,
+                    .data_len = data->data_len
+                };
+                memcpy(sb->buffer + sb->buffer_len, data->data_ptr, data->data_len);
+                sb->buffer_len += data->data_len;
+
+                if(data->payload_offset + data->data_len < data->payload_len) {
+                    return; // wait for the rest of HELLO
+                }
+
+                uint32_t free_heap = esp_get_free_heap_size();
+                client->gw_stats.standby_memory = sb->free_heap > free_heap ? sb->free_heap - free_heap : 0;
+                sb->state = DISCORD_GW_STANDBY_READY;
+            }
+            break;
+
+        default: // error, disconnected or closed
+            sb->state = DISCORD_GW_STANDBY_FAILED;
+            break;
+    }
+
+    DISCORD_TASK_NOTIFY(client);
+}
+
+static void dcgw_websocket_event_handler(void* handler_arg, esp_event_base_t base, int32_t event_id, void* event_data) {
+    discord_handle_t client = (discord_handle_t) handler_arg;
+    esp_websocket_event_data_t* data = (esp_websocket_event_data_t*) event_data;
+
+    if(client->gw_standby.ws && data->client != client->ws) {
+        dcgw_standby_websocket_event(client, event_id, data); // frames of the standby are recorded when they are switched to
+        return;
+    }
+
+    if(event_id == WEBSOCKET_EVENT_CONNECTED || event_id == WEBSOCKET_EVENT_DATA) {
+        client->gw_rx_tick_ms = (uint32_t) discord_tick_ms(); // pongs count too
+    }
+
+    if(client->gw_recorder.file) {
+        dcgw_record_websocket_event(client, event_id, data);
+    }
+
+    dcgw_handle_websocket_event(client, event_id, data);
+}
+
+static esp_err_t dcgw_record_open(discord_handle_t client) {
+    FILE* file = fopen(client->config->gateway_record_path, "wb");
+    discord_recorder_header_t header = {
+        .encoding = client->config->gateway_encoding,
+        .compress = client->config->gateway_compress,
+        .payload_compress = !client->config->gateway_compress && client->config->gateway_payload_compress
+    };
+
+    if(!file || discord_recorder_init_writer(&client->gw_recorder, file, &header) != ESP_OK) {
+        DISCORD_LOGE("Fail to start recording (path=%s)", client->config->gateway_record_path);
+        discord_recorder_close(&client->gw_recorder); // file is owned by the recorder
+        return ESP_FAIL;
+    }
+
+    DISCORD_LOGW("Gateway traffic is recorded to %s", client->config->gateway_record_path);
+
+    return ESP_OK;
+}
+
+static esp_websocket_client_handle_t dcgw_websocket_create(discord_handle_t client) {
+#ifdef DISCORD_CERTS_EMBEDDED
+    extern const uint8_t gateway_crt[] asm("_binary_gateway_pem_start");
+#endif
+    
+    esp_websocket_client_config_t ws_cfg = {
+        .uri = DISCORD_GW_URL,
+        .buffer_size = 512,
+#ifdef DISCORD_CERTS_EMBEDDED
+        .cert_pem = (const char*) gateway_crt,
+#endif
+        .task_stack = 5 * 1024,
+        .disable_auto_reconnect = true,
+        .ping_interval_sec = client->config->gateway_ping_interval_s,
+        .disable_pingpong_discon = client->config->gateway_silence_timeout_ms > 0, // silence check closes the connection and tells why
+        .keep_alive_enable = client->config->gateway_tcp_keepalive,
+        .keep_alive_idle = DISCORD_GW_KEEPALIVE_IDLE_S,
+        .keep_alive_interval = DISCORD_GW_KEEPALIVE_INTERVAL_S,
+        .keep_alive_count = DISCORD_GW_KEEPALIVE_COUNT
+    };
+
+    esp_websocket_client_handle_t ws = esp_websocket_client_init(&ws_cfg);
+
+    if(!ws) {
+        DISCORD_LOGE("Fail to create ws client");
+        return NULL;
+    }
+
+    if(esp_websocket_register_events(ws, WEBSOCKET_EVENT_ANY, dcgw_websocket_event_handler, (void*) client) != ESP_OK) {
+        DISCORD_LOGE("Fail to register ws handler");
+        esp_websocket_client_destroy(ws);
+        return NULL;
+    }
+
+    return ws;
+}
+
+esp_err_t dcgw_init(discord_handle_t client) {
+    DISCORD_LOG_FOO();
+
+    if(client->state >= DISCORD_STATE_INIT) {
+        DISCORD_LOGW("Already inited");
+        return ESP_OK;
+    }
+    
+    if(!(client->gw_lock = xSemaphoreCreateMutex()) ||
+       discord_payload_ring_init(&client->queue, client->config->queue_size, client->config->queue_policy, DISCORD_QUEUE_BLOCK_TIMEOUT_MS, dcgw_queue_item_free) != ESP_OK) {
+        DISCORD_LOGE("Fail to create mutex/queue");
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    discord_arena_pool_init(&client->gw_arenas);
+
+    if(!(client->gw_buffer = malloc(client->config->gateway_buffer_size + 1)) ||
+       !(client->gw_send_buffer = malloc(DISCORD_GW_SEND_BUFFER_SIZE))) {
+        DISCORD_LOGE("Fail to allocate buffer");
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    if(client->config->guild_cache_size > 0) {
+        if(!(client->gw_guilds_lock = xSemaphoreCreateMutex())) {
+            DISCORD_LOGE("Fail to create guild cache mutex");
+            dcgw_destroy(client);
+            return ESP_FAIL;
+        }
+
+        discord_guild_cache_init(&client->gw_guilds, client->config->guild_cache_size);
+    }
+
+    if(dcgw_member_cache_enabled(client)) {
+        if(!(client->gw_members_lock = xSemaphoreCreateMutex())) {
+            DISCORD_LOGE("Fail to create member cache mutex");
+            dcgw_destroy(client);
+            return ESP_FAIL;
+        }
+
+        discord_member_cache_init(&client->gw_members, client->config->member_cache_size);
+    }
+
+    if(client->config->gateway_record_path && dcgw_record_open(client) != ESP_OK) {
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    if((client->config->gateway_compress || client->config->gateway_payload_compress) &&
+       discord_zlib_stream_init(&client->gw_zlib) != ESP_OK) {
+        DISCORD_LOGE("Fail to init inflate context");
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    client->gw_zlib.per_message = !client->config->gateway_compress; // zlib-stream takes precedence
+
+    if(discord_outbox_init(&client->gw_outbox, DISCORD_GW_RATE_LIMIT, DISCORD_GW_RATE_PERIOD_MS, DISCORD_GW_RATE_RESERVE,
+        DISCORD_GW_PRIORITY_REQUEST, DISCORD_GW_OUTBOX_SIZE, dcgw_outbox_item_free) != ESP_OK) {
+        DISCORD_LOGE("Fail to init outbox");
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    dcgw_heartbeat_stop(client);
+    client->last_sequence_number = DISCORD_NULL_SEQUENCE_NUMBER;
+    client->gw_resuming = false;
+    client->close_reason = DISCORD_CLOSE_REASON_NOT_REQUESTED;
+    client->close_code = DISCORD_CLOSEOP_NO_CODE;
+    client->gw_buffer_len = 0;
+    client->gw_members_loading = -1;
+    client->gw_stream = (discord_json_stream_t) {
+        .buffer = client->gw_buffer,
+        .size = client->config->gateway_buffer_size,
+        .prune_keys = client->gw_guilds_lock ? discord_json_stream_guild_cache_prune_keys :
+            client->gw_members_lock ? discord_json_stream_member_cache_prune_keys : discord_json_stream_default_prune_keys,
+        .member_handler = client->gw_members_lock ? dcgw_member_cache_stream_member : NULL,
+        .member_handler_arg = client,
+        .etf = dcgw_is_etf(client)
+    };
+    discord_json_stream_reset(&client->gw_stream);
+    client->state = DISCORD_STATE_INIT;
+
+    if(!(client->ws = dcgw_websocket_create(client))) {
+        dcgw_destroy(client);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+static discord_gateway_priority_t dcgw_send_priority(discord_payload_t* payload) {
+    switch(payload->op) {
+        case DISCORD_OP_HEARTBEAT:
+            return DISCORD_GW_PRIORITY_HEARTBEAT;
+
+        case DISCORD_OP_IDENTIFY:
+        case DISCORD_OP_RESUME:
+            return DISCORD_GW_PRIORITY_SESSION;
+
+        default:
+            return DISCORD_GW_PRIORITY_REQUEST;
+    }
+}
+
+/**
+ * @brief Write IDENTIFY with the waiting (or the last) presence, so it does not have to be sent after READY.
+ *        If the presence does not fit, identify is written without it and presence is restored after READY as usual
+ */
+static int dcgw_write_identify(discord_handle_t client, char* buffer, size_t size) {
+    const discord_config_t* config = client->config;
+    discord_identify_t identify = {
+        .token = config->token,
+        .intents = client->intents,
+        .large_threshold = config->gateway_large_threshold,
+        .compress = config->gateway_payload_compress && !config->gateway_compress,
+        .presence = client->gw_presence_pending ? client->gw_presence_pending : client->gw_presence,
+        .shard_id = client->shard_id,
+        .shard_count = client->shard_count
+    };
+
+    int len;
+
+    while(true) {
+        len = dcgw_is_etf(client) ? discord_etf_write_identify((uint8_t*) buffer, size, &identify) :
+            discord_json_write_identify(buffer, size, &identify);
+
+        if(len >= 0 || !identify.presence) {
+            break;
+        }
+
+        DISCORD_LOGW("Presence does not fit into IDENTIFY, it will be sent after READY");
+        identify.presence = NULL;
+    }
+
+    if(len >= 0 && identify.presence) {
+        if(client->gw_presence_pending) {
+            discord_presence_free(client->gw_presence);
+            client->gw_presence = client->gw_presence_pending;
+            client->gw_presence_pending = NULL;
+        }
+
+        client->gw_presence_tick_ms = discord_tick_ms();
+        client->gw_presence_identified = true;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Write frame into the send buffer. Frames are written when they are sent,
+ *        so the waiting heartbeat carries the latest sequence number
+ * @return Length of the frame or -1 on failure
+ */
+static int dcgw_write_frame(discord_handle_t client, discord_payload_t* frame) {
+    char* buffer = client->gw_send_buffer;
+    size_t size = DISCORD_GW_SEND_BUFFER_SIZE;
+    bool etf = dcgw_is_etf(client);
+
+    switch(frame->op) {
+        case DISCORD_OP_HEARTBEAT:
+            return etf ? discord_etf_write_heartbeat((uint8_t*) buffer, size, client->last_sequence_number) :
+                discord_json_write_heartbeat(buffer, size, client->last_sequence_number);
+
+        case DISCORD_OP_IDENTIFY:
+            return dcgw_write_identify(client, buffer, size);
+
+        case DISCORD_OP_RESUME:
+            if(!dcgw_can_resume(client)) {
+                return -1; // session has been invalidated while resume was waiting
+            }
+
+            return etf ? discord_etf_write_resume((uint8_t*) buffer, size, client->config->token, client->session->session_id, client->last_sequence_number) :
+                discord_json_write_resume(buffer, size, client->config->token, client->session->session_id, client->last_sequence_number);
+
+        case DISCORD_OP_PRESENCE_UPDATE:
+            if(!frame->d) {
+                return -1;
+            }
+
+            return etf ? discord_etf_write_presence((uint8_t*) buffer, size, (discord_presence_t*) frame->d) :
+                discord_json_write_presence(buffer, size, (discord_presence_t*) frame->d);
+
+        case DISCORD_OP_REQUEST_GUILD_MEMBERS:
+            if(!frame->d) {
+                return -1;
+            }
+
+            return etf ? discord_etf_write_request_guild_members((uint8_t*) buffer, size, (const char*) frame->d) :
+                discord_json_write_request_guild_members(buffer, size, (const char*) frame->d);
+
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Write payload into the send buffer and send it. Gateway lock must be taken
+ */
+static esp_err_t dcgw_send_now(discord_handle_t client, discord_payload_t* payload) {
+    int len = dcgw_write_frame(client, payload);
+    int op = payload->op;
+    dcgw_outbox_item_free(payload);
+
+    if(len < 0) {
+        DISCORD_LOGE("Fail to write frame (op: %d)", op);
+        return ESP_FAIL;
+    }
+
+    const char* data = client->gw_send_buffer;
+
+    int sent_bytes;
+
+    if(client->gw_replaying) {
+        DISCORD_LOGD("Replaying, payload not sent (len: %d)", len);
+        sent_bytes = len;
+    } else if(dcgw_is_etf(client)) {
+        DISCORD_LOGD("Sending binary payload (len: %d)", len);
+        sent_bytes = esp_websocket_client_send_bin(client->ws, data, len, 5000 / portTICK_PERIOD_MS); // 5sec timeout
+    } else {
+        DISCORD_LOGD("%.*s", len, data);
+        sent_bytes = esp_websocket_client_send_text(client->ws, data, len, 5000 / portTICK_PERIOD_MS); // 5sec timeout
+    }
+
+    if(sent_bytes == ESP_FAIL) {
+        DISCORD_LOGW("Fail to send data to gateway");
+        client->state = DISCORD_STATE_ERROR;
+        DISCORD_TASK_NOTIFY(client);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t dcgw_send(discord_handle_t client, discord_payload_t* payload) {
+    DISCORD_LOG_FOO();
+
+    if(xSemaphoreTake(client->gw_lock, 5000 / portTICK_PERIOD_MS) != pdTRUE) { // 5sec timeout
+        DISCORD_LOGW("Gateway is locked");
+        dcgw_outbox_item_free(payload);
+        return ESP_FAIL;
+    }
+
+    discord_gateway_priority_t priority = dcgw_send_priority(payload);
+    esp_err_t err;
+
+    if(discord_outbox_take_token(&client->gw_outbox, priority, discord_tick_ms())) {
+        err = dcgw_send_now(client, payload);
+    } else {
+        DISCORD_LOGD("Send deferred (op: %d)", payload->op);
+        int key = payload->op == DISCORD_OP_PRESENCE_UPDATE ? DISCORD_OP_PRESENCE_UPDATE : 0; // only the latest presence matters
+
+        if((err = discord_outbox_defer(&client->gw_outbox, payload, priority, key)) != ESP_OK) {
+            DISCORD_LOGW("Outbox is full, payload dropped");
+        }
+
+        dctm_set(client, DISCORD_TIMER_OUTBOX, discord_outbox_wait_ms(&client->gw_outbox, discord_tick_ms()));
+    }
+
+    xSemaphoreGive(client->gw_lock);
+
+    return err;
+}
+
+void dcgw_outbox_flush(discord_handle_t client) {
+    if(xSemaphoreTake(client->gw_lock, 5000 / portTICK_PERIOD_MS) != pdTRUE) { // 5sec timeout
+        DISCORD_LOGW("Gateway is locked");
+        dctm_set(client, DISCORD_TIMER_OUTBOX, 0); // try again
+        return;
+    }
+
+    discord_payload_t* payload;
+
+    while(client->state >= DISCORD_STATE_CONNECTING && (payload = discord_outbox_next(&client->gw_outbox, discord_tick_ms()))) {
+        if(dcgw_send_now(client, payload) != ESP_OK) {
+            break;
+        }
+    }
+
+    uint32_t wait_ms = discord_outbox_wait_ms(&client->gw_outbox, discord_tick_ms());
+
+    if(wait_ms != UINT32_MAX) {
+        dctm_set(client, DISCORD_TIMER_OUTBOX, wait_ms);
+    }
+
+    xSemaphoreGive(client->gw_lock);
+}
+
+static discord_presence_t* dcgw_presence_clone(const discord_presence_t* presence) {
+    discord_presence_t* clone = cu_ctor(discord_presence_t,
+        .status = presence->status,
+        .afk = presence->afk
+    );
+
+    if(!clone || !presence->activity) {
+        return clone;
+    }
+
+    clone->activity = cu_ctor(discord_activity_t,
+        .name = STRDUP(presence->activity->name),
+        .type = presence->activity->type,
+        .state = STRDUP(presence->activity->state)
+    );
+
+    if(!clone->activity || !clone->activity->name || (presence->activity->state && !clone->activity->state)) {
+        discord_presence_free(clone);
+        return NULL;
+    }
+
+    return clone;
+}
+
+static bool dcgw_presence_str_eq(const char* a, const char* b) {
+    return a == b || estr_eq(a, b);
+}
+
+static bool dcgw_presence_eq(const discord_presence_t* a, const discord_presence_t* b) {
+    if(!a || !b || a->status != b->status || a->afk != b->afk || !a->activity != !b->activity) {
+        return false;
+    }
+
+    return !a->activity || (
+        a->activity->type == b->activity->type &&
+        dcgw_presence_str_eq(a->activity->name, b->activity->name) &&
+        dcgw_presence_str_eq(a->activity->state, b->activity->state)
+    );
+}
+
+esp_err_t dcgw_presence_update(discord_handle_t client, const discord_presence_t* presence) {
+    discord_presence_t* clone = dcgw_presence_clone(presence);
+
+    if(!clone) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if(xSemaphoreTake(client->gw_lock, 5000 / portTICK_PERIOD_MS) != pdTRUE) { // 5sec timeout
+        DISCORD_LOGW("Gateway is locked");
+        discord_presence_free(clone);
+        return ESP_FAIL;
+    }
+
+    // compare with the presence which is going to be visible once everything is sent
+    if(dcgw_presence_eq(clone, client->gw_presence_pending ? client->gw_presence_pending : client->gw_presence)) {
+        DISCORD_LOGD("Presence has not changed");
+        discord_presence_free(clone);
+        xSemaphoreGive(client->gw_lock);
+        return ESP_OK;
+    }
+
+    discord_presence_free(client->gw_presence_pending); // superseded, only the latest presence matters
+    client->gw_presence_pending = clone;
+
+    uint64_t now = discord_tick_ms();
+    uint64_t next = client->gw_presence ? client->gw_presence_tick_ms + DISCORD_GW_PRESENCE_INTERVAL_MS : 0;
+
+    xSemaphoreGive(client->gw_lock);
+
+    dctm_set(client, DISCORD_TIMER_PRESENCE, next > now ? (uint32_t) (next - now) : 0);
+
+    return ESP_OK;
+}
+
+esp_err_t dcgw_presence_inherit(discord_handle_t client, discord_handle_t from) {
+    xSemaphoreTake(from->gw_lock, portMAX_DELAY);
+    discord_presence_t* presence = from->gw_presence_pending ? from->gw_presence_pending : from->gw_presence;
+    discord_presence_t* clone = presence ? dcgw_presence_clone(presence) : NULL;
+    xSemaphoreGive(from->gw_lock);
+
+    if(!presence) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = clone ? dcgw_presence_update(client, clone) : ESP_ERR_NO_MEM;
+    discord_presence_free(clone);
+
+    return err;
+}
+
+void dcgw_presence_flush(discord_handle_t client) {
+    if(client->state != DISCORD_STATE_CONNECTED) {
+        return; // sent once the session is ready
+    }
+
+    if(xSemaphoreTake(client->gw_lock, 5000 / portTICK_PERIOD_MS) != pdTRUE) { // 5sec timeout
+        DISCORD_LOGW("Gateway is locked");
+        dctm_set(client, DISCORD_TIMER_PRESENCE, 0); // try again
+        return;
+    }
+
+    discord_presence_t* presence = client->gw_presence_pending;
+    discord_presence_t* clone = presence ? dcgw_presence_clone(presence) : NULL;
+    discord_payload_t* payload = clone ? cu_ctor(discord_payload_t,
+        .op = DISCORD_OP_PRESENCE_UPDATE,
+        .d = clone
+    ) : NULL;
+
+    if(payload) {
+        discord_presence_free(client->gw_presence);
+        client->gw_presence = presence;
+        client->gw_presence_pending = NULL;
+        client->gw_presence_tick_ms = discord_tick_ms();
+    } else if(presence) {
+        // presence stays pending
+        discord_presence_free(clone);
+        dctm_set(client, DISCORD_TIMER_PRESENCE, DISCORD_GW_PRESENCE_INTERVAL_MS); // out of memory, try later
+    }
+
+    xSemaphoreGive(client->gw_lock);
+
+    if(payload) {
+        dcgw_send(client, payload);
+    }
+}
+
+/**
+ * @brief New session starts without presence, so the last one has to be sent again unless it was part of IDENTIFY
+ */
+static void dcgw_presence_restore(discord_handle_t client) {
+    xSemaphoreTake(client->gw_lock, portMAX_DELAY);
+
+    if(client->gw_presence && !client->gw_presence_pending && !client->gw_presence_identified) {
+        client->gw_presence_pending = client->gw_presence;
+        client->gw_presence = NULL;
+    }
+
+    bool pending = client->gw_presence_pending != NULL;
+    client->gw_presence_identified = false;
+
+    xSemaphoreGive(client->gw_lock);
+
+    if(pending) {
+        dctm_set(client, DISCORD_TIMER_PRESENCE, 0);
+    }
+}
+
+/**
+ * @brief Request members of the loading guild. Next guild is requested once the last chunk is received (DISCORD_TASK_BIT_MEMBERS)
+ */
+static void dcgw_member_cache_request(discord_handle_t client) {
+    int loading = client->gw_members_loading;
+
+    if(loading < 0) {
+        return;
+    }
+
+    const char* guild_id;
+
+    // members can be requested only on the shard which receives events of the guild
+    while((guild_id = client->config->member_cache_guild_ids[loading]) && !dcsh_has_guild(client, guild_id)) {
+        client->gw_members_loading = ++loading;
+    }
+
+    if(!guild_id) {
+        DISCORD_LOGD("Members of %d guilds requested", loading);
+        client->gw_members_loading = -1;
+        return;
+    }
+
+    DISCORD_LOGD("Requesting members of guild %s", guild_id);
+
+    char* id = strdup(guild_id);
+    discord_payload_t* payload = id ? cu_ctor(discord_payload_t,
+        .op = DISCORD_OP_REQUEST_GUILD_MEMBERS,
+        .d = id
+    ) : NULL;
+
+    if(!payload) {
+        DISCORD_LOGE("Fail to request members of guild %s", guild_id);
+        free(id);
+        client->gw_members_loading = -1;
+        return;
+    }
+
+    dcgw_send(client, payload);
+}
+
+/**
+ * @brief New session starts with empty member cache, members of all configured guilds are requested again
+ */
+static void dcgw_member_cache_load(discord_handle_t client) {
+    if(!client->gw_members_lock) {
+        return;
+    }
+
+    xSemaphoreTake(client->gw_members_lock, portMAX_DELAY);
+    discord_member_cache_clear(&client->gw_members);
+    xSemaphoreGive(client->gw_members_lock);
+
+    client->gw_members_loading = 0;
+    dcgw_member_cache_request(client);
+}
+
+esp_err_t dcgw_guild_cache_get_roles(discord_handle_t client, const char* guild_id, discord_role_t*** out_roles, discord_role_len_t* out_length) {
+    if(!client->gw_guilds_lock) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    xSemaphoreTake(client->gw_guilds_lock, portMAX_DELAY);
+    esp_err_t err = discord_guild_cache_get_roles(&client->gw_guilds, guild_id, out_roles, out_length);
+    xSemaphoreGive(client->gw_guilds_lock);
+
+    return err;
+}
+
+esp_err_t dcgw_guild_cache_get_channels(discord_handle_t client, const char* guild_id, discord_channel_t*** out_channels, int* out_length) {
+    if(!client->gw_guilds_lock) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    xSemaphoreTake(client->gw_guilds_lock, portMAX_DELAY);
+    esp_err_t err = discord_guild_cache_get_channels(&client->gw_guilds, guild_id, out_channels, out_length);
+    xSemaphoreGive(client->gw_guilds_lock);
+
+    return err;
+}
+
+void dcgw_guild_cache_set_roles(discord_handle_t client, const char* guild_id, discord_role_t** roles, discord_role_len_t len) {
+    if(!client->gw_guilds_lock || !(client->intents & DISCORD_INTENT_GUILDS)) {
+        return;
+    }
+
+    xSemaphoreTake(client->gw_guilds_lock, portMAX_DELAY);
+    discord_guild_cache_set_roles(&client->gw_guilds, guild_id, roles, len);
+    xSemaphoreGive(client->gw_guilds_lock);
+}
+
+void dcgw_guild_cache_set_channels(discord_handle_t client, const char* guild_id, discord_channel_t** channels, int len) {
+    if(!client->gw_guilds_lock || !(client->intents & DISCORD_INTENT_GUILDS)) {
+        return;
+    }
+
+    xSemaphoreTake(client->gw_guilds_lock, portMAX_DELAY);
+    discord_guild_cache_set_channels(&client->gw_guilds, guild_id, channels, len);
+    xSemaphoreGive(client->gw_guilds_lock);
+}
+
+void dcgw_guild_cache_get_stats(discord_handle_t client, discord_gateway_stats_t* out_stats) {
+    if(!client->gw_guilds_lock) {
+        return;
+    }
+
+    xSemaphoreTake(client->gw_guilds_lock, portMAX_DELAY);
+    out_stats->guild_cache_hits = client->gw_guilds.hits;
+    out_stats->guild_cache_misses = client->gw_guilds.misses;
+    out_stats->guild_cache_evictions = client->gw_guilds.evictions;
+    xSemaphoreGive(client->gw_guilds_lock);
+}
+
+bool dcgw_member_cache_enabled(discord_handle_t client) {
+    const char** ids = client->config->member_cache_guild_ids;
+
+    return client->config->member_cache_size > 0 && ids && ids[0];
+}
+
+esp_err_t dcgw_member_cache_get(discord_handle_t client, const char* guild_id, const char* user_id, discord_member_t** out_member) {
+    if(!client->gw_members_lock || dcgw_member_cache_guild_index(client, guild_id) < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    xSemaphoreTake(client->gw_members_lock, portMAX_DELAY);
+    esp_err_t err = discord_member_cache_get(&client->gw_members, guild_id, user_id, out_member);
+    xSemaphoreGive(client->gw_members_lock);
+
+    return err;
+}
+
+void dcgw_member_cache_put(discord_handle_t client, const char* guild_id, const char* user_id, const discord_member_t* member) {
+    discord_member_record_t record;
+
+    if(!client->gw_members_lock || !(client->intents & DISCORD_INTENT_GUILD_MEMBERS) ||
+       dcgw_member_cache_guild_index(client, guild_id) < 0 ||
+       discord_member_record_from_member(user_id, member, &record) != ESP_OK) {
+        return;
+    }
+
+    xSemaphoreTake(client->gw_members_lock, portMAX_DELAY);
+    discord_member_cache_put(&client->gw_members, guild_id, &record);
+    xSemaphoreGive(client->gw_members_lock);
+}
+
+void dcgw_member_cache_get_stats(discord_handle_t client, discord_gateway_stats_t* out_stats) {
+    if(!client->gw_members_lock) {
+        return;
+    }
+
+    xSemaphoreTake(client->gw_members_lock, portMAX_DELAY);
+    out_stats->member_cache_hits = client->gw_members.hits;
+    out_stats->member_cache_misses = client->gw_members.misses;
+    out_stats->member_cache_evictions = client->gw_members.evictions;
+    xSemaphoreGive(client->gw_members_lock);
+}
+
+esp_err_t dcgw_get_close_desc(discord_handle_t client, char** out_description) {
+    if(! client || ! out_description) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *out_description = client->close_code != DISCORD_CLOSEOP_NO_CODE 
+        ? client->gw_buffer + 2 : NULL;
+    
+    return ESP_OK;
+}
+
+bool dcgw_can_resume(discord_handle_t client) {
+    return client && client->session && client->session->session_id &&
+        client->last_sequence_number != DISCORD_NULL_SEQUENCE_NUMBER;
+}
+
+void dcgw_session_invalidate(discord_handle_t client) {
+    if(!client)
+        return;
+
+    DISCORD_LOG_FOO();
+
+    discord_session_free(client->session);
+    client->session = NULL;
+    client->last_sequence_number = DISCORD_NULL_SEQUENCE_NUMBER;
+    client->gw_resuming = false;
+}
+
+bool dcgw_is_open(discord_handle_t client) {
+    return client && client->state >= DISCORD_STATE_OPEN;
+}
+
+esp_err_t dcgw_open(discord_handle_t client) {
+    if(client == NULL)
+        return ESP_ERR_INVALID_ARG;
+    
+    DISCORD_LOG_FOO();
+
+    if(dcgw_is_open(client)) {
+        DISCORD_LOGD("Already open");
+        return ESP_OK;
+    }
+
+    return dcgw_start(client);
+}
+
+static char* dcgw_uri(discord_handle_t client) {
+    // resumed session must be continued on the url received in READY payload
+    const char* base_url = dcgw_can_resume(client) && client->session->resume_gateway_url ?
+        client->session->resume_gateway_url : (client->config->gateway_url ? client->config->gateway_url : DISCORD_GW_BASE_URL);
+
+    return estr_cat(base_url, DISCORD_GW_QUERY,
+        dcgw_is_etf(client) ? DISCORD_GW_QUERY_ETF : DISCORD_GW_QUERY_JSON,
+        client->gw_zlib.decomp && !client->gw_zlib.per_message ? DISCORD_GW_QUERY_COMPRESS : "");
+}
+
+static void dcgw_standby_discard(discord_handle_t client) {
+    discord_gateway_standby_t* sb = &client->gw_standby;
+
+    if(sb->ws) {
+        DISCORD_LOG_FOO();
+
+        sb->state = DISCORD_GW_STANDBY_RETIRING; // events of the closing connection are ignored
+
+        if(esp_websocket_client_is_connected(sb->ws)) {
+            esp_websocket_client_close_with_code(sb->ws, DISCORD_GW_CLOSE_CODE_RESUMABLE, NULL, 0, pdMS_TO_TICKS(DISCORD_GW_STANDBY_CLOSE_MS));
+        }
+
+        esp_websocket_client_destroy(sb->ws);
+    }
+
+    free(sb->buffer);
+    *sb = (discord_gateway_standby_t) { .state = DISCORD_GW_STANDBY_IDLE };
+    dctm_cancel(client, DISCORD_TIMER_STANDBY);
+}
+
+/**
+ * @brief Connect the standby ahead of the reconnection. Session stays on the current connection until the standby receives HELLO
+ * @param fallback Close reason of the current connection if the standby fails
+ */
+static esp_err_t dcgw_standby_open(discord_handle_t client, uint8_t trigger, discord_gateway_close_reason_t fallback) {
+    discord_gateway_standby_t* sb = &client->gw_standby;
+
+    if(!(client->config->gateway_standby & trigger) || client->gw_replaying ||
+       client->state != DISCORD_STATE_CONNECTED || !dcgw_can_resume(client)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if(sb->ws) {
+        if(sb->state == DISCORD_GW_STANDBY_RETIRING) {
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        if(fallback != DISCORD_CLOSE_REASON_NOT_REQUESTED) {
+            sb->fallback = fallback; // reconnection requested while the standby is already opening
+        }
+
+        return ESP_OK;
+    }
 
-#ifndef CONFIG_ESP_TLS_SKIP_SERVER_CERT_VERIFY
-    extern const uint8_t gateway_crt[] asm("_binary_gateway_pem_start");
-#endif
-    
-    esp_websocket_client_config_t ws_cfg = {
-        .uri = DISCORD_GW_URL,
-        .buffer_size = 512,
-#ifndef CONFIG_ESP_TLS_SKIP_SERVER_CERT_VERIFY
-        .cert_pem = (const char*) gateway_crt,
-#endif
-        .task_stack = 5 * 1024,
-        .disable_auto_reconnect = true
-    };
+    uint32_t free_heap = esp_get_free_heap_size();
 
-    if(!(client->ws = esp_websocket_client_init(&ws_cfg))) {
-        DISCORD_LOGE("Fail to create ws client");
-        dcgw_destroy(client);
-        return ESP_FAIL;
+    if(free_heap < client->config->gateway_standby_min_free_heap) {
+        DISCORD_LOGW("Not enough heap for standby connection (free=%d)", free_heap);
+        return ESP_ERR_NO_MEM;
     }
 
-    if(esp_websocket_register_events(client->ws, WEBSOCKET_EVENT_ANY, dcgw_websocket_event_handler, (void*) client) != ESP_OK) {
-        DISCORD_LOGE("Fail to register ws handler");
-        dcgw_destroy(client);
+    char* uri = dcgw_uri(client);
+
+    *sb = (discord_gateway_standby_t) {
+        .state = DISCORD_GW_STANDBY_WARMING,
+        .fallback = fallback,
+        .free_heap = free_heap
+    };
+
+    if(!uri || !(sb->buffer = malloc(DISCORD_GW_STANDBY_BUFFER_SIZE)) || !(sb->ws = dcgw_websocket_create(client)) ||
+       esp_websocket_client_set_uri(sb->ws, uri) != ESP_OK || esp_websocket_client_start(sb->ws) != ESP_OK) {
+        DISCORD_LOGE("Fail to open standby connection");
+        free(uri);
+        dcgw_standby_discard(client);
+        client->gw_stats.standby_failures++;
         return ESP_FAIL;
     }
 
+    free(uri);
+    client->gw_stats.standby_opened++;
+    dctm_set(client, DISCORD_TIMER_STANDBY, DISCORD_GW_STANDBY_TIMEOUT_MS);
+    DISCORD_LOGI("Opening standby connection (free heap=%d)", free_heap);
+
     return ESP_OK;
 }
 
-esp_err_t dcgw_send(discord_handle_t client, discord_payload_t* payload) {
-    DISCORD_LOG_FOO();
+static void dcgw_standby_fail(discord_handle_t client) {
+    discord_gateway_close_reason_t fallback = client->gw_standby.fallback;
 
-    if(xSemaphoreTake(client->gw_lock, 5000 / portTICK_PERIOD_MS) != pdTRUE) { // 5sec timeout
-        DISCORD_LOGW("Gateway is locked");
-        return ESP_FAIL;
+    DISCORD_LOGW("Standby connection failed");
+    client->gw_stats.standby_failures++;
+    dcgw_standby_discard(client);
+
+    if(fallback != DISCORD_CLOSE_REASON_NOT_REQUESTED && client->state > DISCORD_STATE_DISCONNECTED) {
+        dcgw_close(client, fallback); // usual reconnection
     }
-    
-    char* payload_raw = discord_json_serialize(payload);
-    discord_payload_free(payload);
+}
 
-    DISCORD_LOGD("%s", payload_raw);
+/**
+ * @brief Move the session to the standby connection. Frames received by the standby go through the usual path
+ *        as if they were just received, so its HELLO makes the task start heartbeat and send RESUME.
+ *        Discord sends nothing else before RESUME, so ws task of the new connection does not race with this
+ */
+static void dcgw_standby_switch(discord_handle_t client) {
+    discord_gateway_standby_t* sb = &client->gw_standby;
+    esp_websocket_client_handle_t ws = sb->ws;
+    char* buffer = sb->buffer;
+    uint8_t frames_len = sb->frames_len;
+    discord_recorder_frame_t frames[DISCORD_GW_STANDBY_FRAMES];
 
-    int sent_bytes = esp_websocket_client_send_text(client->ws, payload_raw, strlen(payload_raw), 5000 / portTICK_PERIOD_MS); // 5sec timeout
-    free(payload_raw);
+    DISCORD_LOGI("Switching to standby connection (memory=%d)", client->gw_stats.standby_memory);
 
-    if(sent_bytes == ESP_FAIL) {
-        DISCORD_LOGW("Fail to send data to gateway");
-        client->state = DISCORD_STATE_ERROR;
-        xSemaphoreGive(client->gw_lock);
-        return ESP_FAIL;
-    }
-    
+    memcpy(frames, sb->frames, sizeof(frames));
+
+    xSemaphoreTake(client->gw_lock, portMAX_DELAY);
+    dcgw_heartbeat_stop(client);
+    sb->ws = client->ws; // replaced connection is closed once the session is resumed
+    sb->state = DISCORD_GW_STANDBY_RETIRING;
+    sb->buffer = NULL;
+    client->ws = ws;
+    client->close_reason = DISCORD_CLOSE_REASON_NOT_REQUESTED;
+    client->close_code = DISCORD_CLOSEOP_NO_CODE;
+    client->gw_resuming = false;
+    client->gw_buffer_len = 0;
+    discord_zlib_stream_reset(&client->gw_zlib); // new connection starts a new zlib stream
+    discord_outbox_reset(&client->gw_outbox, discord_tick_ms()); // limit is per connection
+    dctm_cancel(client, DISCORD_TIMER_OUTBOX);
     xSemaphoreGive(client->gw_lock);
 
-    return ESP_OK;
-}
+    if(client->reconnector.lost_tick_ms == 0) {
+        client->reconnector.lost_tick_ms = discord_tick_ms(); // gap is measured until RESUMED
+    }
 
-esp_err_t dcgw_get_close_desc(discord_handle_t client, char** out_description) {
-    if(! client || ! out_description) {
-        return ESP_ERR_INVALID_ARG;
+    client->gw_stats.standby_switches++;
+    dctm_set(client, DISCORD_TIMER_STANDBY, DISCORD_GW_STANDBY_TIMEOUT_MS);
+
+    esp_websocket_event_data_t data = { .client = ws };
+    dcgw_websocket_event_handler(client, NULL, WEBSOCKET_EVENT_CONNECTED, &data);
+
+    size_t offset = 0;
+
+    for(uint8_t i = 0; i < frames_len; offset += frames[i].data_len, i++) {
+        data = (esp_websocket_event_data_t) {
+            .client = ws,
+            .data_ptr = buffer + offset,
+            .data_len = frames[i].data_len,
+            .op_code = frames[i].op_code,
+            .payload_len = frames[i].payload_len,
+            .payload_offset = frames[i].payload_offset
+        };
+
+        dcgw_websocket_event_handler(client, NULL, WEBSOCKET_EVENT_DATA, &data);
     }
 
-    *out_description = client->close_code != DISCORD_CLOSEOP_NO_CODE 
-        ? client->gw_buffer + 2 : NULL;
-    
-    return ESP_OK;
+    free(buffer);
 }
 
-bool dcgw_is_open(discord_handle_t client) {
-    return client && client->state >= DISCORD_STATE_OPEN;
-}
+void dcgw_standby_step(discord_handle_t client) {
+    discord_gateway_standby_t* sb = &client->gw_standby;
 
-esp_err_t dcgw_open(discord_handle_t client) {
-    if(client == NULL)
-        return ESP_ERR_INVALID_ARG;
-    
-    DISCORD_LOG_FOO();
+    if(!sb->ws) {
+        return;
+    }
 
-    if(dcgw_is_open(client)) {
-        DISCORD_LOGD("Already open");
-        return ESP_OK;
+    bool expired = dctm_take_expired(client, DISCORD_TIMER_STANDBY);
+
+    switch(sb->state) {
+        case DISCORD_GW_STANDBY_READY:
+            dcgw_standby_switch(client);
+            break;
+
+        case DISCORD_GW_STANDBY_WARMING:
+            if(client->state <= DISCORD_STATE_DISCONNECTED) {
+                dcgw_heartbeat_stop(client); // nothing to keep alive until the standby takes over
+            }
+
+            if(!expired) {
+                break;
+            }
+
+            DISCORD_LOGW("Standby connection has not received HELLO in time");
+            // fall through
+        case DISCORD_GW_STANDBY_FAILED:
+            dcgw_standby_fail(client);
+            break;
+
+        case DISCORD_GW_STANDBY_RETIRING:
+            if(expired) {
+                dcgw_standby_discard(client); // session has not been resumed in time, replaced connection is not needed anyway
+            }
+            break;
+
+        default:
+            break;
     }
+}
 
-    return dcgw_start(client);
+bool dcgw_standby_is_warming(discord_handle_t client) {
+    return client->gw_standby.ws && client->gw_standby.state == DISCORD_GW_STANDBY_WARMING;
 }
 
 esp_err_t dcgw_start(discord_handle_t client) {
@@ -284,8 +1743,27 @@ esp_err_t dcgw_start(discord_handle_t client) {
     }
     
     client->close_reason = DISCORD_CLOSE_REASON_NOT_REQUESTED;
+    client->gw_resuming = false;
+
+    char* uri = dcgw_uri(client);
+
+    if(!uri || esp_websocket_client_set_uri(client->ws, uri) != ESP_OK) {
+        DISCORD_LOGE("Fail to set gateway uri");
+        free(uri);
+        client->state = DISCORD_STATE_ERROR;
+        DISCORD_TASK_NOTIFY(client);
+        return ESP_FAIL;
+    }
+
+    free(uri);
+    discord_zlib_stream_reset(&client->gw_zlib); // every connection starts a new zlib stream
+
     esp_err_t err = esp_websocket_client_start(client->ws);
     client->state = err == ESP_OK ? DISCORD_STATE_OPEN : DISCORD_STATE_ERROR;
+
+    if(err != ESP_OK) {
+        DISCORD_TASK_NOTIFY(client); // let the task schedule reconnection
+    }
     
     return err;
 }
@@ -300,17 +1778,25 @@ esp_err_t dcgw_close(discord_handle_t client, discord_gateway_close_reason_t rea
     // do not set client status in this function
     // it will be automatically set in ws task
 
+    dcgw_standby_discard(client);
+
     if(client->gw_lock) { xSemaphoreTake(client->gw_lock, portMAX_DELAY); } // wait to unlock
     client->close_reason = reason;
     dcgw_heartbeat_stop(client);
-    client->last_sequence_number = DISCORD_NULL_SEQUENCE_NUMBER;
+    // session and sequence number are kept in order to resume the session later
     
     if(esp_websocket_client_is_connected(client->ws)) {
-        esp_websocket_client_close(client->ws, portMAX_DELAY);
+        if(reason == DISCORD_CLOSE_REASON_LOGOUT || reason == DISCORD_CLOSE_REASON_DESTROY) {
+            esp_websocket_client_close(client->ws, portMAX_DELAY);
+        } else {
+            esp_websocket_client_close_with_code(client->ws, DISCORD_GW_CLOSE_CODE_RESUMABLE, NULL, 0, portMAX_DELAY);
+        }
     }
 
     client->gw_buffer_len = 0;
     dcgw_queue_flush(client);
+    discord_outbox_reset(&client->gw_outbox, discord_tick_ms()); // limit is per connection
+    dctm_cancel(client, DISCORD_TIMER_OUTBOX);
     if(client->gw_lock) { xSemaphoreGive(client->gw_lock); }
 
     return ESP_OK;
@@ -326,8 +1812,17 @@ esp_err_t dcgw_destroy(discord_handle_t client) {
     dcgw_close(client, DISCORD_CLOSE_REASON_DESTROY);
     esp_websocket_client_destroy(client->ws);
     client->ws = NULL;
+    discord_recorder_close(&client->gw_recorder); // ws task which writes the recording is gone
     free(client->gw_buffer);
     client->gw_buffer = NULL;
+    free(client->gw_send_buffer);
+    client->gw_send_buffer = NULL;
+    client->gw_stream.buffer = NULL;
+    discord_zlib_stream_destroy(&client->gw_zlib);
+    discord_outbox_destroy(&client->gw_outbox);
+    discord_presence_free(client->gw_presence);
+    discord_presence_free(client->gw_presence_pending);
+    client->gw_presence = client->gw_presence_pending = NULL;
 
     if(client->gw_lock) {
         xSemaphoreTake(client->gw_lock, portMAX_DELAY); // wait to unlock
@@ -335,86 +1830,217 @@ esp_err_t dcgw_destroy(discord_handle_t client) {
         client->gw_lock = NULL;
     }
 
-    if(client->queue) {
-        dcgw_queue_flush(client);
-        vQueueDelete(client->queue);
-        client->queue = NULL;
+    if(client->gw_guilds_lock) {
+        discord_guild_cache_clear(&client->gw_guilds);
+        vSemaphoreDelete(client->gw_guilds_lock);
+        client->gw_guilds_lock = NULL;
+    }
+
+    if(client->gw_members_lock) {
+        discord_member_cache_clear(&client->gw_members);
+        vSemaphoreDelete(client->gw_members_lock);
+        client->gw_members_lock = NULL;
     }
 
+    discord_payload_ring_destroy(&client->queue);
+    discord_arena_pool_destroy(&client->gw_arenas); // after the queue, which returns regions of the waiting payloads
+
     client->state = DISCORD_STATE_UNKNOWN;
 
     return ESP_OK;
 }
 
 esp_err_t dcgw_queue_flush(discord_handle_t client) {
-    if(!client || !client->queue) {
+    if(!client || !client->queue.slots) {
         return ESP_ERR_INVALID_ARG;
     }
-    
-    discord_payload_t* payload = NULL;
 
-    while(xQueueReceive(client->queue, &payload, (TickType_t) 0) == pdPASS) {
-        discord_payload_free(payload);
-    }
+    discord_payload_ring_flush(&client->queue);
 
     return ESP_OK;
 }
 
-static esp_err_t dcgw_heartbeat_start(discord_handle_t client, discord_hello_t* hello) {
+static esp_err_t dcgw_heartbeat_start(discord_handle_t client, int interval) {
     if(client->heartbeater.running)
         return ESP_OK;
     
     DISCORD_LOG_FOO();
     
     client->heartbeater.received_ack = true; // True to prevent first ack checking
-    client->heartbeater.interval = hello->heartbeat_interval;
+    client->heartbeater.interval = interval;
     client->heartbeater.tick_ms = discord_tick_ms();
     client->heartbeater.running = true;
+    dctm_set(client, DISCORD_TIMER_HEARTBEAT, client->heartbeater.interval);
+
+    if(client->config->gateway_silence_timeout_ms > 0) {
+        dctm_set(client, DISCORD_TIMER_SILENCE, client->config->gateway_silence_timeout_ms);
+    }
 
     return ESP_OK;
 }
 
-esp_err_t dcgw_heartbeat_send_if_expired(discord_handle_t client) {
-    if(client->heartbeater.running && discord_tick_ms() - client->heartbeater.tick_ms > client->heartbeater.interval) {
-        DISCORD_LOGD("Heartbeat");
+esp_err_t dcgw_heartbeat_send(discord_handle_t client) {
+    if(!client->heartbeater.running)
+        return ESP_OK;
 
-        client->heartbeater.tick_ms = discord_tick_ms();
+    DISCORD_LOGD("Heartbeat");
 
-        if(!client->heartbeater.received_ack) {
-            DISCORD_LOGW("ACK has not been received since the last heartbeat. Reconnection will follow using IDENTIFY (RESUME is not implemented yet)");
-            dcgw_close(client, DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED);
-            return ESP_ERR_INVALID_STATE;
+    client->heartbeater.tick_ms = discord_tick_ms();
+
+    if(!client->heartbeater.received_ack) {
+        DISCORD_LOGW("ACK has not been received since the last heartbeat. Reconnection will follow");
+        dcgw_close(client, DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    client->heartbeater.received_ack = false;
+    dctm_set(client, DISCORD_TIMER_HEARTBEAT, client->heartbeater.interval);
+
+    uint32_t ack_timeout_ms = client->config->gateway_ack_timeout_ms;
+
+    if(ack_timeout_ms > 0 && ack_timeout_ms < (uint32_t) client->heartbeater.interval) {
+        dctm_set(client, DISCORD_TIMER_ACK, ack_timeout_ms);
+    }
+
+    return dcgw_send(client, &dcgw_heartbeat_frame);
+}
+
+void dcgw_heartbeat_check_ack(discord_handle_t client) {
+    if(!client->heartbeater.running || client->heartbeater.received_ack)
+        return;
+
+    DISCORD_LOGW("ACK has not been received in %d ms. Reconnection will follow", client->config->gateway_ack_timeout_ms);
+    dcgw_close(client, DISCORD_CLOSE_REASON_HEARTBEAT_ACK_NOT_RECEIVED);
+}
+
+void dcgw_check_silence(discord_handle_t client) {
+    uint32_t timeout_ms = client->config->gateway_silence_timeout_ms;
+
+    if(!client->heartbeater.running || timeout_ms == 0)
+        return;
+
+    uint32_t silence_ms = (uint32_t) discord_tick_ms() - client->gw_rx_tick_ms;
+
+    if(silence_ms < timeout_ms) {
+        dctm_set(client, DISCORD_TIMER_SILENCE, timeout_ms - silence_ms);
+        return;
+    }
+
+    DISCORD_LOGW("Nothing has been received for %d ms. Reconnection will follow", silence_ms);
+    dcgw_close(client, DISCORD_CLOSE_REASON_SILENCE);
+}
+
+void dcgw_get_latency(discord_handle_t client, discord_gateway_latency_t* out_latency) {
+    discord_heartbeater_t* hb = &client->heartbeater;
+    uint8_t count = hb->rtt_count;
+    uint32_t sorted[DISCORD_HEARTBEAT_RTT_WINDOW];
+    uint64_t sum = 0;
+
+    *out_latency = (discord_gateway_latency_t) { .samples = count };
+
+    if(count == 0) {
+        return;
+    }
+
+    // window is tiny, insertion sort is good enough
+    for(uint8_t i = 0; i < count; i++) {
+        uint32_t rtt = hb->rtts[i];
+        uint8_t j = i;
+
+        for(; j > 0 && sorted[j - 1] > rtt; j--) {
+            sorted[j] = sorted[j - 1];
         }
 
-        client->heartbeater.received_ack = false;
-        int s = client->last_sequence_number;
+        sorted[j] = rtt;
+        sum += rtt;
+    }
 
-        // todo: memcheck
-        return dcgw_send(client, cu_ctor(discord_payload_t,
-            .op = DISCORD_OP_HEARTBEAT,
-            .d = (discord_heartbeat_t*) &s
-        ));
+    out_latency->last_ms = hb->rtts[(hb->rtt_next + DISCORD_HEARTBEAT_RTT_WINDOW - 1) % DISCORD_HEARTBEAT_RTT_WINDOW];
+    out_latency->min_ms = sorted[0];
+    out_latency->avg_ms = (uint32_t) (sum / count);
+    out_latency->p95_ms = sorted[(95 * count + 99) / 100 - 1];
+    out_latency->above_threshold = client->config->gateway_latency_threshold_ms > 0 &&
+        out_latency->avg_ms > client->config->gateway_latency_threshold_ms;
+}
+
+void dcgw_latency_fire_if_crossed(discord_handle_t client) {
+    if(!client->heartbeater.latency_crossed)
+        return;
+
+    client->heartbeater.latency_crossed = false;
+
+    discord_gateway_latency_t latency;
+    dcgw_get_latency(client, &latency);
+
+    if(latency.above_threshold) {
+        DISCORD_LOGW("Gateway latency is high (avg=%d ms, p95=%d ms)", latency.avg_ms, latency.p95_ms);
+        dcgw_standby_open(client, DISCORD_GATEWAY_STANDBY_ON_LATENCY, DISCORD_CLOSE_REASON_NOT_REQUESTED);
+    } else {
+        DISCORD_LOGI("Gateway latency is back to normal (avg=%d ms)", latency.avg_ms);
     }
 
-    return ESP_OK;
+    DISCORD_EVENT_FIRE(DISCORD_EVENT_GATEWAY_LATENCY, &latency);
+}
+
+uint32_t dcgw_reconnect_schedule(discord_handle_t client) {
+    discord_reconnector_t* rc = &client->reconnector;
+
+    if(rc->lost_tick_ms == 0) {
+        rc->lost_tick_ms = discord_tick_ms();
+    }
+
+    rc->attempts++;
+    client->gw_stats.reconnect_attempts++;
+
+    switch(client->close_reason) {
+        case DISCORD_CLOSE_REASON_RECONNECT:
+            return 0;
+
+        case DISCORD_CLOSE_REASON_INVALID_SESSION:
+            return 1000 + esp_random() % 4000; // Discord recommends random wait between 1 and 5 seconds
+
+        default: {
+                uint32_t shift = rc->attempts - 1 < 16 ? rc->attempts - 1 : 16;
+                uint32_t ceiling = DISCORD_RECONNECT_BASE_MS << shift;
+
+                if(ceiling > DISCORD_RECONNECT_MAX_MS) {
+                    ceiling = DISCORD_RECONNECT_MAX_MS;
+                }
+
+                return ceiling / 2 + esp_random() % (ceiling / 2 + 1);
+            }
+    }
+}
+
+static void dcgw_reconnect_done(discord_handle_t client) {
+    discord_reconnector_t* rc = &client->reconnector;
+
+    client->gw_connect_counting = false;
+    client->gw_stats.connect_bytes = client->gw_connect_bytes;
+    DISCORD_LOGI("Session ready after %d bytes received", client->gw_stats.connect_bytes);
+
+    if(rc->lost_tick_ms > 0) {
+        client->gw_stats.reconnects++;
+        client->gw_stats.last_reconnect_ms = discord_tick_ms() - rc->lost_tick_ms;
+        DISCORD_LOGI("Reconnected in %d ms (attempts=%d)", client->gw_stats.last_reconnect_ms, rc->attempts);
+    }
+
+    rc->lost_tick_ms = 0;
+    rc->attempts = 0;
 }
 
 esp_err_t dcgw_identify(discord_handle_t client) {
     DISCORD_LOG_FOO();
 
-    // todo: memchecks
-    return dcgw_send(client, cu_ctor(discord_payload_t,
-        .op = DISCORD_OP_IDENTIFY,
-        .d = cu_ctor(discord_identify_t,
-            .token = strdup(client->config->token),
-            .intents = client->config->intents,
-            .properties = cu_ctor(discord_identify_properties_t,
-                .os = estr_cat("esp-idf (", esp_get_idf_version(), ")"),
-                .browser = strdup("esp-discord (" DISCORD_VER_STRING ")"),
-                .device = strdup(CONFIG_IDF_TARGET)
-            )
-        )
-    ));
+    return dcgw_send(client, &dcgw_identify_frame);
+}
+
+static esp_err_t dcgw_resume(discord_handle_t client) {
+    DISCORD_LOG_FOO();
+
+    client->gw_resuming = true;
+
+    return dcgw_send(client, &dcgw_resume_frame);
 }
 
 /**
@@ -434,6 +2060,9 @@ static esp_err_t dcgw_dispatch(discord_handle_t client, discord_payload_t* paylo
         payload->d = NULL;
 
         client->state = DISCORD_STATE_CONNECTED;
+        dcgw_reconnect_done(client);
+        dcgw_presence_restore(client);
+        dcgw_member_cache_load(client);
         
         DISCORD_LOGD("Identified [%s#%s (%s), session: %s]", 
             client->session->user->username,
@@ -462,6 +2091,28 @@ static esp_err_t dcgw_dispatch(discord_handle_t client, discord_payload_t* paylo
         return ESP_OK;
     }
 
+    if(DISCORD_EVENT_RESUMED == payload->t) {
+        client->gw_resuming = false;
+        client->state = DISCORD_STATE_CONNECTED;
+        dcgw_reconnect_done(client);
+
+        if(client->gw_presence_pending) {
+            dctm_set(client, DISCORD_TIMER_PRESENCE, 0); // resumed session keeps its presence, only the waiting one is sent
+        }
+
+        dcgw_member_cache_request(client); // chunks of the loading guild could have been lost
+
+        if(client->gw_standby.state == DISCORD_GW_STANDBY_RETIRING) {
+            dcgw_standby_discard(client); // session has moved, connection it came from is not needed
+        }
+
+        DISCORD_LOGD("Resumed [session: %s, seq: %d]", client->session->session_id, client->last_sequence_number);
+
+        DISCORD_EVENT_FIRE(DISCORD_EVENT_RESUMED, NULL);
+
+        return ESP_OK;
+    }
+
     if(payload->t > DISCORD_EVENT_CONNECTED) {
         // client is connected. fire the event!
         DISCORD_EVENT_FIRE(payload->t, payload->d);
@@ -470,6 +2121,55 @@ static esp_err_t dcgw_dispatch(discord_handle_t client, discord_payload_t* paylo
     return ESP_OK;
 }
 
+void dcgw_handle_control(discord_handle_t client, uint32_t bits) {
+    if(bits & DISCORD_TASK_BIT_HELLO) {
+        DISCORD_LOGD("Hello received (heartbeat_interval: %d)", client->gw_hello_interval);
+
+        if(client->gw_hello_interval <= 0) {
+            DISCORD_LOGE("Invalid heartbeat interval");
+            client->state = DISCORD_STATE_ERROR;
+            DISCORD_TASK_NOTIFY(client);
+            return;
+        }
+
+        dcgw_heartbeat_start(client, client->gw_hello_interval);
+
+        uint32_t delay_ms = 0;
+
+        if(dcgw_can_resume(client)) {
+            dcgw_resume(client);
+        } else if((delay_ms = dcsh_identify_delay(client)) > 0) {
+            DISCORD_LOGI("Shard %d identifies in %d ms (identify rate limit)", client->shard_id, delay_ms);
+            dctm_set(client, DISCORD_TIMER_IDENTIFY, delay_ms);
+        } else {
+            dcgw_identify(client);
+        }
+    }
+
+    if((bits & DISCORD_TASK_BIT_MEMBERS) && client->gw_members_loading >= 0) {
+        client->gw_members_loading++;
+        dcgw_member_cache_request(client);
+    }
+
+    if(bits & DISCORD_TASK_BIT_INVALID_SESSION) {
+        if(!client->gw_session_resumable) {
+            DISCORD_LOGW("Session invalidated. Reconnection will follow using IDENTIFY");
+            dcgw_session_invalidate(client);
+            dcgw_close(client, DISCORD_CLOSE_REASON_INVALID_SESSION);
+        } else {
+            DISCORD_LOGW("Session invalidated but it can be resumed. Reconnection will follow");
+            dcgw_close(client, DISCORD_CLOSE_REASON_RECONNECT);
+        }
+    } else if(bits & DISCORD_TASK_BIT_RECONNECT) {
+        if(dcgw_standby_open(client, DISCORD_GATEWAY_STANDBY_ON_RECONNECT, DISCORD_CLOSE_REASON_RECONNECT) == ESP_OK) {
+            DISCORD_LOGI("Reconnection requested, session is going to move to standby connection");
+        } else {
+            DISCORD_LOGI("Reconnection requested");
+            dcgw_close(client, DISCORD_CLOSE_REASON_RECONNECT);
+        }
+    }
+}
+
 esp_err_t dcgw_handle_payload(discord_handle_t client, discord_payload_t* payload) {
     DISCORD_LOG_FOO();
 
@@ -479,16 +2179,9 @@ esp_err_t dcgw_handle_payload(discord_handle_t client, discord_payload_t* payloa
     DISCORD_LOGD("Received payload (op: %d)", payload->op);
 
     switch (payload->op) {
-        case DISCORD_OP_HELLO:
-            dcgw_heartbeat_start(client, (discord_hello_t*) payload->d);
-            discord_payload_free(payload);
-            payload = NULL;
-            dcgw_identify(client);
-            break;
-        
         case DISCORD_OP_HEARTBEAT_ACK:
             DISCORD_LOGD("Heartbeat ack received");
-            client->heartbeater.received_ack = true;
+            dcgw_heartbeat_ack(client);
             break;
 
         case DISCORD_OP_DISPATCH:
@@ -505,4 +2198,133 @@ esp_err_t dcgw_handle_payload(discord_handle_t client, discord_payload_t* payloa
     }
 
     return ESP_OK;
+}
+
+/**
+ * @brief Do what the discord task does after it is woken up by the ws handler, in the same order.
+ *        Reconnection is not replayed, connection loss only closes the gateway and the recording continues with the next connection
+ */
+static void dcgw_replay_task_step(discord_handle_t client) {
+    uint32_t bits = client->gw_replay_bits;
+    client->gw_replay_bits = 0;
+
+    if(client->state <= DISCORD_STATE_DISCONNECTED) {
+        dcgw_close(client, client->state == DISCORD_STATE_ERROR ? DISCORD_CLOSE_REASON_ERROR : client->close_reason);
+        client->state = DISCORD_STATE_OPEN;
+        return;
+    }
+
+    if(client->state >= DISCORD_STATE_CONNECTING) {
+        discord_payload_t* payload = NULL;
+
+        dcgw_handle_control(client, bits & (DISCORD_TASK_BIT_HELLO | DISCORD_TASK_BIT_MEMBERS));
+
+        while((payload = discord_payload_ring_pop(&client->queue))) {
+            dcgw_handle_payload(client, payload);
+        }
+
+        dcgw_handle_control(client, bits & (DISCORD_TASK_BIT_RECONNECT | DISCORD_TASK_BIT_INVALID_SESSION));
+    }
+}
+
+esp_err_t dcgw_replay(discord_handle_t client, const char* path) {
+    DISCORD_LOG_FOO();
+
+    if(client->state != DISCORD_STATE_INIT) {
+        DISCORD_LOGE("Gateway is not ready to replay");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    FILE* file = fopen(path, "rb");
+    discord_recorder_t recorder = { 0 };
+    discord_recorder_header_t header;
+    esp_err_t err;
+
+    if(!file) {
+        DISCORD_LOGE("Fail to open recording (path=%s)", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if((err = discord_recorder_init_reader(&recorder, file, &header)) != ESP_OK) {
+        DISCORD_LOGE("Not a recording (path=%s)", path);
+        discord_recorder_close(&recorder);
+        return err;
+    }
+
+    if(header.encoding != client->config->gateway_encoding ||
+       header.compress != (client->gw_zlib.decomp && !client->gw_zlib.per_message) ||
+       header.payload_compress != (client->gw_zlib.decomp && client->gw_zlib.per_message)) {
+        DISCORD_LOGE("Recording has different encoding or compression than the client");
+        discord_recorder_close(&recorder);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    discord_recorder_frame_t frame;
+    char* data = NULL;
+    uint32_t data_size = 0;
+    uint32_t frames = 0;
+    size_t bytes = 0;
+    int64_t start_us = esp_timer_get_time();
+
+    client->gw_replaying = true;
+    client->gw_replay_bits = 0;
+    client->state = DISCORD_STATE_OPEN;
+
+    while((err = discord_recorder_read_frame(&recorder, &frame)) == ESP_OK) {
+        if(frame.data_len > data_size) {
+            char* grown = realloc(data, frame.data_len);
+
+            if(!grown) {
+                err = ESP_ERR_NO_MEM;
+                break;
+            }
+
+            data = grown;
+            data_size = frame.data_len;
+        }
+
+        if((err = discord_recorder_read_data(&recorder, data)) != ESP_OK) {
+            break;
+        }
+
+        if(frame.event_id == WEBSOCKET_EVENT_CONNECTED) {
+            discord_zlib_stream_reset(&client->gw_zlib); // every connection starts a new zlib stream
+        }
+
+        esp_websocket_event_data_t event_data = {
+            .data_ptr = data,
+            .data_len = frame.data_len,
+            .op_code = frame.op_code,
+            .payload_len = frame.payload_len,
+            .payload_offset = frame.payload_offset
+        };
+
+        dcgw_handle_websocket_event(client, frame.event_id, &event_data);
+        dcgw_replay_task_step(client);
+
+        frames++;
+        bytes += frame.data_len;
+    }
+
+    if(err == ESP_ERR_NOT_FOUND) {
+        err = ESP_OK; // end of the recording
+    } else {
+        DISCORD_LOGE("Replay failed after %d frames (err=%s)", frames, esp_err_to_name(err));
+    }
+
+    DISCORD_LOGI("Replayed %d frames (%d bytes) in %lld us", frames, bytes, esp_timer_get_time() - start_us);
+
+    free(data);
+    discord_recorder_close(&recorder);
+
+    // leave the gateway as it was before the replay, so the client can log in
+    dcgw_close(client, DISCORD_CLOSE_REASON_LOGOUT);
+    dcgw_session_invalidate(client);
+    dctm_cancel(client, DISCORD_TIMER_PRESENCE);
+    discord_zlib_stream_reset(&client->gw_zlib);
+    client->close_code = DISCORD_CLOSEOP_NO_CODE;
+    client->gw_replaying = false;
+    client->state = DISCORD_STATE_INIT;
+
+    return err;
 }
\ No newline at end of file
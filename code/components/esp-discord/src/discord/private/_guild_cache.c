@@ -0,0 +1,496 @@
+#include "discord/private/_guild_cache.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DISCORD_GUILD_CACHE_ID_SIZE (21) /*<! Longest uint64 has 20 digits */
+
+typedef discord_guild_cache_guild_t guild_t;
+
+static uint64_t discord_guild_cache_id(const char* id) {
+    return id ? strtoull(id, NULL, 10) : 0;
+}
+
+static char* discord_guild_cache_id_str(uint64_t id) {
+    char buffer[DISCORD_GUILD_CACHE_ID_SIZE];
+    snprintf(buffer, sizeof(buffer), "%" PRIu64, id);
+    return strdup(buffer);
+}
+
+static size_t discord_guild_cache_name_size(const char* name) {
+    return name ? strlen(name) + 1 : 0;
+}
+
+/**
+ * @brief Replace the name. Old name is kept if the new one cannot be allocated
+ */
+static bool discord_guild_cache_set_name(char** name, const char* new_name) {
+    char* copy = new_name ? strdup(new_name) : NULL;
+
+    if(new_name && !copy) {
+        return false;
+    }
+
+    free(*name);
+    *name = copy;
+    return true;
+}
+
+static void discord_guild_cache_measure(discord_guild_cache_t* cache, guild_t* guild) {
+    size_t size = sizeof(guild_t) +
+        guild->roles_len * sizeof(discord_guild_cache_role_t) +
+        guild->channels_len * sizeof(discord_guild_cache_channel_t);
+
+    for(uint16_t i = 0; i < guild->roles_len; i++) {
+        size += discord_guild_cache_name_size(guild->roles[i].name);
+    }
+
+    for(uint16_t i = 0; i < guild->channels_len; i++) {
+        size += discord_guild_cache_name_size(guild->channels[i].name);
+    }
+
+    cache->size = cache->size - guild->size + size;
+    guild->size = size;
+}
+
+static void discord_guild_cache_roles_free(guild_t* guild) {
+    for(uint16_t i = 0; i < guild->roles_len; i++) {
+        free(guild->roles[i].name);
+    }
+
+    free(guild->roles);
+    guild->roles = NULL;
+    guild->roles_len = 0;
+    guild->roles_cached = false;
+}
+
+static void discord_guild_cache_channels_free(guild_t* guild) {
+    for(uint16_t i = 0; i < guild->channels_len; i++) {
+        free(guild->channels[i].name);
+    }
+
+    free(guild->channels);
+    guild->channels = NULL;
+    guild->channels_len = 0;
+    guild->channels_cached = false;
+}
+
+static guild_t** discord_guild_cache_link(discord_guild_cache_t* cache, uint64_t id) {
+    for(guild_t** link = &cache->guilds; *link; link = &(*link)->next) {
+        if((*link)->id == id) {
+            return link;
+        }
+    }
+
+    return NULL;
+}
+
+static void discord_guild_cache_unlink(discord_guild_cache_t* cache, guild_t** link) {
+    guild_t* guild = *link;
+    *link = guild->next;
+    cache->size -= guild->size;
+    discord_guild_cache_roles_free(guild);
+    discord_guild_cache_channels_free(guild);
+    free(guild);
+}
+
+/**
+ * @brief Find the guild and mark it as the most recently used one
+ */
+static guild_t* discord_guild_cache_find(discord_guild_cache_t* cache, const char* guild_id) {
+    guild_t** link = discord_guild_cache_link(cache, discord_guild_cache_id(guild_id));
+
+    if(!link) {
+        return NULL;
+    }
+
+    guild_t* guild = *link;
+    *link = guild->next;
+    guild->next = cache->guilds;
+    cache->guilds = guild;
+
+    return guild;
+}
+
+static guild_t* discord_guild_cache_find_or_add(discord_guild_cache_t* cache, const char* guild_id) {
+    guild_t* guild = discord_guild_cache_find(cache, guild_id);
+
+    if(guild || !(guild = calloc(1, sizeof(guild_t)))) {
+        return guild;
+    }
+
+    guild->id = discord_guild_cache_id(guild_id);
+    guild->next = cache->guilds;
+    cache->guilds = guild;
+    discord_guild_cache_measure(cache, guild);
+
+    return guild;
+}
+
+static void discord_guild_cache_remove(discord_guild_cache_t* cache, guild_t* guild) {
+    guild_t** link = discord_guild_cache_link(cache, guild->id);
+
+    if(link) {
+        discord_guild_cache_unlink(cache, link);
+    }
+}
+
+/**
+ * @brief Evict least recently used guilds until the cache fits into the limit
+ * @param guild Guild which has just been changed (the most recently used one)
+ * @return ESP_ERR_INVALID_SIZE if the changed guild alone does not fit (only that guild is removed then)
+ */
+static esp_err_t discord_guild_cache_fit(discord_guild_cache_t* cache, guild_t* guild) {
+    if(guild->size > cache->limit) {
+        discord_guild_cache_remove(cache, guild);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    while(cache->size > cache->limit) {
+        guild_t** link = &cache->guilds;
+
+        while((*link)->next) {
+            link = &(*link)->next;
+        }
+
+        discord_guild_cache_unlink(cache, link);
+        cache->evictions++;
+    }
+
+    return ESP_OK;
+}
+
+static bool discord_guild_cache_role_set(discord_guild_cache_role_t* dst, const discord_role_t* src) {
+    if(!discord_guild_cache_set_name(&dst->name, src->name)) {
+        return false;
+    }
+
+    dst->id = discord_guild_cache_id(src->id);
+    dst->permissions = discord_guild_cache_id(src->permissions);
+    dst->position = src->position;
+
+    return true;
+}
+
+static bool discord_guild_cache_channel_set(discord_guild_cache_channel_t* dst, const discord_channel_t* src) {
+    if(!discord_guild_cache_set_name(&dst->name, src->name)) {
+        return false;
+    }
+
+    dst->id = discord_guild_cache_id(src->id);
+    dst->type = src->type;
+
+    return true;
+}
+
+void discord_guild_cache_init(discord_guild_cache_t* cache, size_t limit) {
+    *cache = (discord_guild_cache_t) {
+        .limit = limit
+    };
+}
+
+esp_err_t discord_guild_cache_set_roles(discord_guild_cache_t* cache, const char* guild_id, discord_role_t** roles, int len) {
+    if(!cache || !discord_guild_cache_id(guild_id) || len < 0 || len > UINT16_MAX || (len > 0 && !roles)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    guild_t* guild = discord_guild_cache_find_or_add(cache, guild_id);
+
+    if(!guild) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    discord_guild_cache_roles_free(guild);
+
+    if(len > 0 && !(guild->roles = calloc(len, sizeof(discord_guild_cache_role_t)))) {
+        discord_guild_cache_remove(cache, guild);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for(; guild->roles_len < len; guild->roles_len++) {
+        if(!roles[guild->roles_len] || !discord_guild_cache_role_set(&guild->roles[guild->roles_len], roles[guild->roles_len])) {
+            discord_guild_cache_remove(cache, guild);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    guild->roles_cached = true;
+    discord_guild_cache_measure(cache, guild);
+
+    return discord_guild_cache_fit(cache, guild);
+}
+
+esp_err_t discord_guild_cache_set_channels(discord_guild_cache_t* cache, const char* guild_id, discord_channel_t** channels, int len) {
+    if(!cache || !discord_guild_cache_id(guild_id) || len < 0 || len > UINT16_MAX || (len > 0 && !channels)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    guild_t* guild = discord_guild_cache_find_or_add(cache, guild_id);
+
+    if(!guild) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    discord_guild_cache_channels_free(guild);
+
+    if(len > 0 && !(guild->channels = calloc(len, sizeof(discord_guild_cache_channel_t)))) {
+        discord_guild_cache_remove(cache, guild);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for(; guild->channels_len < len; guild->channels_len++) {
+        if(!channels[guild->channels_len] || !discord_guild_cache_channel_set(&guild->channels[guild->channels_len], channels[guild->channels_len])) {
+            discord_guild_cache_remove(cache, guild);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    guild->channels_cached = true;
+    discord_guild_cache_measure(cache, guild);
+
+    return discord_guild_cache_fit(cache, guild);
+}
+
+esp_err_t discord_guild_cache_put_role(discord_guild_cache_t* cache, const char* guild_id, const discord_role_t* role) {
+    if(!cache || !guild_id || !role || !discord_guild_cache_id(role->id)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    guild_t* guild = discord_guild_cache_find(cache, guild_id);
+
+    if(!guild || !guild->roles_cached) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint64_t id = discord_guild_cache_id(role->id);
+    uint16_t i = 0;
+
+    while(i < guild->roles_len && guild->roles[i].id != id) {
+        i++;
+    }
+
+    if(i == guild->roles_len) {
+        discord_guild_cache_role_t* roles = guild->roles_len < UINT16_MAX ?
+            realloc(guild->roles, (guild->roles_len + 1) * sizeof(discord_guild_cache_role_t)) : NULL;
+
+        if(!roles) {
+            discord_guild_cache_remove(cache, guild); // cache must not miss the role
+            return ESP_ERR_NO_MEM;
+        }
+
+        guild->roles = roles;
+        guild->roles[guild->roles_len++] = (discord_guild_cache_role_t) { 0 };
+    }
+
+    if(!discord_guild_cache_role_set(&guild->roles[i], role)) {
+        discord_guild_cache_remove(cache, guild);
+        return ESP_ERR_NO_MEM;
+    }
+
+    discord_guild_cache_measure(cache, guild);
+
+    return discord_guild_cache_fit(cache, guild);
+}
+
+esp_err_t discord_guild_cache_remove_role(discord_guild_cache_t* cache, const char* guild_id, const char* role_id) {
+    if(!cache || !guild_id || !role_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    guild_t* guild = discord_guild_cache_find(cache, guild_id);
+
+    if(!guild || !guild->roles_cached) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint64_t id = discord_guild_cache_id(role_id);
+
+    for(uint16_t i = 0; i < guild->roles_len; i++) {
+        if(guild->roles[i].id == id) {
+            free(guild->roles[i].name);
+            memmove(&guild->roles[i], &guild->roles[i + 1], (guild->roles_len - i - 1) * sizeof(discord_guild_cache_role_t));
+            guild->roles_len--;
+            discord_guild_cache_measure(cache, guild);
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t discord_guild_cache_put_channel(discord_guild_cache_t* cache, const char* guild_id, const discord_channel_t* channel) {
+    if(!cache || !guild_id || !channel || !discord_guild_cache_id(channel->id)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    guild_t* guild = discord_guild_cache_find(cache, guild_id);
+
+    if(!guild || !guild->channels_cached) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint64_t id = discord_guild_cache_id(channel->id);
+    uint16_t i = 0;
+
+    while(i < guild->channels_len && guild->channels[i].id != id) {
+        i++;
+    }
+
+    if(i == guild->channels_len) {
+        discord_guild_cache_channel_t* channels = guild->channels_len < UINT16_MAX ?
+            realloc(guild->channels, (guild->channels_len + 1) * sizeof(discord_guild_cache_channel_t)) : NULL;
+
+        if(!channels) {
+            discord_guild_cache_remove(cache, guild); // cache must not miss the channel
+            return ESP_ERR_NO_MEM;
+        }
+
+        guild->channels = channels;
+        guild->channels[guild->channels_len++] = (discord_guild_cache_channel_t) { 0 };
+    }
+
+    if(!discord_guild_cache_channel_set(&guild->channels[i], channel)) {
+        discord_guild_cache_remove(cache, guild);
+        return ESP_ERR_NO_MEM;
+    }
+
+    discord_guild_cache_measure(cache, guild);
+
+    return discord_guild_cache_fit(cache, guild);
+}
+
+esp_err_t discord_guild_cache_remove_channel(discord_guild_cache_t* cache, const char* guild_id, const char* channel_id) {
+    if(!cache || !guild_id || !channel_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    guild_t* guild = discord_guild_cache_find(cache, guild_id);
+
+    if(!guild || !guild->channels_cached) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint64_t id = discord_guild_cache_id(channel_id);
+
+    for(uint16_t i = 0; i < guild->channels_len; i++) {
+        if(guild->channels[i].id == id) {
+            free(guild->channels[i].name);
+            memmove(&guild->channels[i], &guild->channels[i + 1], (guild->channels_len - i - 1) * sizeof(discord_guild_cache_channel_t));
+            guild->channels_len--;
+            discord_guild_cache_measure(cache, guild);
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+void discord_guild_cache_remove_guild(discord_guild_cache_t* cache, const char* guild_id) {
+    if(!cache || !guild_id) {
+        return;
+    }
+
+    guild_t** link = discord_guild_cache_link(cache, discord_guild_cache_id(guild_id));
+
+    if(link) {
+        discord_guild_cache_unlink(cache, link);
+    }
+}
+
+esp_err_t discord_guild_cache_get_roles(discord_guild_cache_t* cache, const char* guild_id, discord_role_t*** out_roles, discord_role_len_t* out_length) {
+    if(!cache || !guild_id || !out_roles || !out_length) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    guild_t* guild = discord_guild_cache_find(cache, guild_id);
+
+    if(!guild || !guild->roles_cached || guild->roles_len > (discord_role_len_t) -1) {
+        cache->misses++;
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    discord_role_t** roles = calloc(guild->roles_len > 0 ? guild->roles_len : 1, sizeof(discord_role_t*));
+
+    if(!roles) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for(uint16_t i = 0; i < guild->roles_len; i++) {
+        discord_guild_cache_role_t* role = &guild->roles[i];
+
+        if(!(roles[i] = calloc(1, sizeof(discord_role_t))) ||
+           !(roles[i]->id = discord_guild_cache_id_str(role->id)) ||
+           !(roles[i]->permissions = discord_guild_cache_id_str(role->permissions)) ||
+           (role->name && !(roles[i]->name = strdup(role->name)))) {
+            for(uint16_t j = 0; j <= i; j++) {
+                discord_role_free(roles[j]);
+            }
+
+            free(roles);
+            return ESP_ERR_NO_MEM;
+        }
+
+        roles[i]->position = role->position;
+    }
+
+    cache->hits++;
+    *out_roles = roles;
+    *out_length = guild->roles_len;
+
+    return ESP_OK;
+}
+
+esp_err_t discord_guild_cache_get_channels(discord_guild_cache_t* cache, const char* guild_id, discord_channel_t*** out_channels, int* out_length) {
+    if(!cache || !guild_id || !out_channels || !out_length) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    guild_t* guild = discord_guild_cache_find(cache, guild_id);
+
+    if(!guild || !guild->channels_cached) {
+        cache->misses++;
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    discord_channel_t** channels = calloc(guild->channels_len > 0 ? guild->channels_len : 1, sizeof(discord_channel_t*));
+
+    if(!channels) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for(uint16_t i = 0; i < guild->channels_len; i++) {
+        discord_guild_cache_channel_t* channel = &guild->channels[i];
+
+        if(!(channels[i] = calloc(1, sizeof(discord_channel_t))) ||
+           !(channels[i]->id = discord_guild_cache_id_str(channel->id)) ||
+           (channel->name && !(channels[i]->name = strdup(channel->name)))) {
+            for(uint16_t j = 0; j <= i; j++) {
+                discord_channel_free(channels[j]);
+            }
+
+            free(channels);
+            return ESP_ERR_NO_MEM;
+        }
+
+        channels[i]->type = channel->type;
+    }
+
+    cache->hits++;
+    *out_channels = channels;
+    *out_length = guild->channels_len;
+
+    return ESP_OK;
+}
+
+void discord_guild_cache_clear(discord_guild_cache_t* cache) {
+    if(!cache) {
+        return;
+    }
+
+    while(cache->guilds) {
+        discord_guild_cache_unlink(cache, &cache->guilds);
+    }
+
+    cache->size = 0;
+}
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "discord/private/_json.h"
+#include <string.h>
+#include <stdio.h>
 #include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_system.h"
 #include "discord/private/_discord.h"
 #include "cutils.h"
 #include "estr.h"
@@ -12,15 +15,29 @@ static struct {
     discord_event_t event;
 } discord_event_name_map[] = {
     { "READY",                    DISCORD_EVENT_READY },
+    { "RESUMED",                  DISCORD_EVENT_RESUMED },
     { "MESSAGE_CREATE",           DISCORD_EVENT_MESSAGE_RECEIVED },
     { "MESSAGE_DELETE",           DISCORD_EVENT_MESSAGE_DELETED },
     { "MESSAGE_UPDATE",           DISCORD_EVENT_MESSAGE_UPDATED },
     { "MESSAGE_REACTION_ADD",     DISCORD_EVENT_MESSAGE_REACTION_ADDED },
     { "MESSAGE_REACTION_REMOVE",  DISCORD_EVENT_MESSAGE_REACTION_REMOVED },
     { "VOICE_STATE_UPDATE",       DISCORD_EVENT_VOICE_STATE_UPDATED },
+    { "GUILD_CREATE",             DISCORD_EVENT_GUILD_CREATED },
+    { "GUILD_UPDATE",             DISCORD_EVENT_GUILD_UPDATED },
+    { "GUILD_DELETE",             DISCORD_EVENT_GUILD_DELETED },
+    { "GUILD_ROLE_CREATE",        DISCORD_EVENT_GUILD_ROLE_CREATED },
+    { "GUILD_ROLE_UPDATE",        DISCORD_EVENT_GUILD_ROLE_UPDATED },
+    { "GUILD_ROLE_DELETE",        DISCORD_EVENT_GUILD_ROLE_DELETED },
+    { "CHANNEL_CREATE",           DISCORD_EVENT_CHANNEL_CREATED },
+    { "CHANNEL_UPDATE",           DISCORD_EVENT_CHANNEL_UPDATED },
+    { "CHANNEL_DELETE",           DISCORD_EVENT_CHANNEL_DELETED },
+    { "GUILD_MEMBERS_CHUNK",      DISCORD_EVENT_GUILD_MEMBERS_CHUNK },
+    { "GUILD_MEMBER_ADD",         DISCORD_EVENT_GUILD_MEMBER_ADDED },
+    { "GUILD_MEMBER_UPDATE",      DISCORD_EVENT_GUILD_MEMBER_UPDATED },
+    { "GUILD_MEMBER_REMOVE",      DISCORD_EVENT_GUILD_MEMBER_REMOVED },
 };
 
-static discord_event_t discord_model_event_by_name(const char* name) {
+discord_event_t discord_model_event_by_name(const char* name) {
     size_t map_len = sizeof(discord_event_name_map) / sizeof(discord_event_name_map[0]);
 
     for(size_t i = 0; i < map_len; i++) {
@@ -32,34 +49,6 @@ static discord_event_t discord_model_event_by_name(const char* name) {
     return DISCORD_EVENT_UNKNOWN;
 }
 
-cJSON* discord_payload_to_cjson(discord_payload_t* payload) {
-    if(!payload)
-        return NULL;
-    
-    cJSON* root = cJSON_CreateObject();
-    cJSON_AddNumberToObject(root, "op", payload->op);
-
-    const char* d = "d";
-
-    switch (payload->op) {
-        case DISCORD_OP_HEARTBEAT:
-            cJSON_AddItemToObject(root, d, discord_heartbeat_to_cjson((discord_heartbeat_t*) payload->d));
-            break;
-
-        case DISCORD_OP_IDENTIFY:
-            cJSON_AddItemToObject(root, d, discord_identify_to_cjson((discord_identify_t*) payload->d));
-            break;
-        
-        default:
-            DISCORD_LOGW("Cannot recognize payload type");
-            cJSON_Delete(root);
-            root = NULL;
-            break;
-    }
-
-    return root;
-}
-
 discord_payload_t* discord_payload_from_cjson(cJSON* cjson) {
     discord_payload_t* pl = cu_ctor(discord_payload_t,
         .op = cJSON_GetObjectItem(cjson, "op")->valueint
@@ -87,7 +76,12 @@ discord_payload_t* discord_payload_from_cjson(cJSON* cjson) {
             pl->d = discord_dispatch_event_data_from_cjson(pl->t, d);
             break;
 
+        case DISCORD_OP_INVALID_SESSION:
+            pl->d = cu_ctor(discord_invalid_session_t, .resumable = cJSON_IsTrue(d));
+            break;
+
         case DISCORD_OP_HEARTBEAT_ACK:
+        case DISCORD_OP_RECONNECT:
             // Ignore
             break;
         
@@ -100,9 +94,16 @@ discord_payload_t* discord_payload_from_cjson(cJSON* cjson) {
 }
 
 discord_payload_data_t discord_dispatch_event_data_from_cjson(discord_event_t e, cJSON* cjson) {
+    if(DISCORD_EVENT_IS_GUILD_STATE(e)) {
+        return discord_guild_state_from_cjson(e, cjson);
+    }
+
     switch (e) {
         case DISCORD_EVENT_READY:
             return discord_session_from_cjson(cjson);
+
+        case DISCORD_EVENT_RESUMED:
+            return NULL;
         
         case DISCORD_EVENT_MESSAGE_RECEIVED:
         case DISCORD_EVENT_MESSAGE_UPDATED:
@@ -122,33 +123,318 @@ discord_payload_data_t discord_dispatch_event_data_from_cjson(discord_event_t e,
     }
 }
 
-cJSON* discord_heartbeat_to_cjson(discord_heartbeat_t* heartbeat) {
-    int hb = *((int*) (heartbeat));
+static void discord_json_put(discord_json_writer_t* writer, const char* data, size_t len) {
+    if(writer->buffer && writer->len + len <= writer->size) {
+        memcpy(writer->buffer + writer->len, data, len);
+    }
 
-    // todo: memcheck
-    return hb == DISCORD_NULL_SEQUENCE_NUMBER ? cJSON_CreateNull() : cJSON_CreateNumber(hb);
+    writer->len += len;
 }
 
-cJSON* discord_identify_properties_to_cjson(discord_identify_properties_t* properties) {
-    cJSON* root = cJSON_CreateObject();
+/**
+ * @brief Write separator if the container already has a value. Value which follows is the next value of the container
+ */
+static void discord_json_put_separator(discord_json_writer_t* writer) {
+    if(writer->after_value) {
+        discord_json_put(writer, ",", 1);
+    }
 
-    // todo: memchecks
-    cJSON_AddItemToObject(root, "os", cJSON_CreateStringReference(properties->os));
-    cJSON_AddItemToObject(root, "browser", cJSON_CreateStringReference(properties->browser));
-    cJSON_AddItemToObject(root, "device", cJSON_CreateStringReference(properties->device));
+    writer->after_value = true;
+}
 
-    return root;
+static void discord_json_put_value(discord_json_writer_t* writer, const char* literal, size_t len) {
+    discord_json_put_separator(writer);
+    discord_json_put(writer, literal, len);
 }
 
-cJSON* discord_identify_to_cjson(discord_identify_t* identify) {
-    cJSON* root = cJSON_CreateObject();
+void discord_json_writer_init(discord_json_writer_t* writer, char* buffer, size_t size) {
+    *writer = (discord_json_writer_t) {
+        .buffer = buffer,
+        .size = size
+    };
+}
 
-    // todo: memchecks
-    cJSON_AddItemToObject(root, "token", cJSON_CreateStringReference(identify->token));
-    cJSON_AddNumberToObject(root, "intents", identify->intents);
-    cJSON_AddItemToObject(root, "properties", discord_identify_properties_to_cjson(identify->properties));
+void discord_json_write_object(discord_json_writer_t* writer) {
+    discord_json_put_value(writer, "{", 1);
+    writer->after_value = false;
+}
 
-    return root;
+void discord_json_write_object_end(discord_json_writer_t* writer) {
+    discord_json_put(writer, "}", 1);
+    writer->after_value = true;
+}
+
+void discord_json_write_array(discord_json_writer_t* writer) {
+    discord_json_put_value(writer, "[", 1);
+    writer->after_value = false;
+}
+
+void discord_json_write_array_end(discord_json_writer_t* writer) {
+    discord_json_put(writer, "]", 1);
+    writer->after_value = true;
+}
+
+void discord_json_write_key(discord_json_writer_t* writer, const char* key) {
+    discord_json_put_value(writer, "\"", 1);
+    discord_json_put(writer, key, strlen(key));
+    discord_json_put(writer, "\":", 2);
+    writer->after_value = false;
+}
+
+/**
+ * @brief Check four bytes at once for characters which have to be escaped: '"', '\' and control characters.
+ *        (x - 0x01..) & ~x & 0x80.. is not zero only if some byte of x is zero, (x - 0x20..) & ~x & 0x80.. only if some byte is below 0x20
+ */
+static inline bool discord_json_word_is_plain(uint32_t word) {
+    uint32_t quote = word ^ 0x22222222;
+    uint32_t backslash = word ^ 0x5c5c5c5c;
+
+    return !((((quote - 0x01010101) & ~quote) | ((backslash - 0x01010101) & ~backslash) | ((word - 0x20202020) & ~word)) & 0x80808080);
+}
+
+void discord_json_write_string(discord_json_writer_t* writer, const char* str) {
+    if(!str) {
+        discord_json_write_null(writer);
+        return;
+    }
+
+    discord_json_put_value(writer, "\"", 1);
+
+    const char* end = str + strlen(str);
+    const char* run = str; // characters which do not need escaping are copied at once
+    const char* c = str;
+
+    while(c < end) {
+        uint32_t word;
+
+        if(end - c >= 4 && (memcpy(&word, c, 4), discord_json_word_is_plain(word))) {
+            c += 4;
+            continue;
+        }
+
+        unsigned char ch = *c;
+
+        if(ch == '"' || ch == '\\' || ch < 0x20) {
+            char escape[7] = { '\\', ch };
+            size_t escape_len = 2;
+
+            switch(ch) {
+                case '\b': escape[1] = 'b'; break;
+                case '\f': escape[1] = 'f'; break;
+                case '\n': escape[1] = 'n'; break;
+                case '\r': escape[1] = 'r'; break;
+                case '\t': escape[1] = 't'; break;
+                case '"':
+                case '\\': break;
+                default:
+                    escape_len = snprintf(escape, sizeof(escape), "\\u%04x", ch);
+                    break;
+            }
+
+            discord_json_put(writer, run, c - run);
+            discord_json_put(writer, escape, escape_len);
+            run = c + 1;
+        }
+
+        c++;
+    }
+
+    discord_json_put(writer, run, c - run);
+    discord_json_put(writer, "\"", 1);
+}
+
+// printf of newlib nano does not support 64 bit integers
+void discord_json_write_int(discord_json_writer_t* writer, int64_t value) {
+    char digits[21];
+    size_t i = sizeof(digits);
+    uint64_t n = value < 0 ? -(uint64_t) value : (uint64_t) value;
+
+    do {
+        digits[--i] = '0' + n % 10;
+        n /= 10;
+    } while(n > 0);
+
+    if(value < 0) {
+        digits[--i] = '-';
+    }
+
+    discord_json_put_value(writer, digits + i, sizeof(digits) - i);
+}
+
+void discord_json_write_bool(discord_json_writer_t* writer, bool value) {
+    if(value) {
+        discord_json_put_value(writer, "true", 4);
+    } else {
+        discord_json_put_value(writer, "false", 5);
+    }
+}
+
+void discord_json_write_null(discord_json_writer_t* writer) {
+    discord_json_put_value(writer, "null", 4);
+}
+
+int discord_json_writer_result(discord_json_writer_t* writer) {
+    if(!writer->buffer || writer->len >= writer->size || writer->len > INT32_MAX) {
+        return -1;
+    }
+
+    writer->buffer[writer->len] = '\0';
+
+    return (int) writer->len;
+}
+
+static void discord_json_write_frame(discord_json_writer_t* writer, char* buffer, size_t size, int op) {
+    discord_json_writer_init(writer, buffer, size);
+    discord_json_write_object(writer);
+    discord_json_write_key(writer, "op");
+    discord_json_write_int(writer, op);
+    discord_json_write_key(writer, "d");
+}
+
+int discord_json_write_heartbeat(char* buffer, size_t size, int seq) {
+    discord_json_writer_t w;
+    discord_json_write_frame(&w, buffer, size, DISCORD_OP_HEARTBEAT);
+
+    if(seq == DISCORD_NULL_SEQUENCE_NUMBER) {
+        discord_json_write_null(&w);
+    } else {
+        discord_json_write_int(&w, seq);
+    }
+
+    discord_json_write_object_end(&w);
+
+    return discord_json_writer_result(&w);
+}
+
+static void discord_json_write_presence_data(discord_json_writer_t* w, const discord_presence_t* presence) {
+    discord_json_write_object(w);
+    discord_json_write_key(w, "since");
+    discord_json_write_null(w);
+    discord_json_write_key(w, "activities");
+    discord_json_write_array(w);
+
+    if(presence->activity) {
+        discord_json_write_object(w);
+        discord_json_write_key(w, "name");
+        discord_json_write_string(w, presence->activity->name);
+        discord_json_write_key(w, "type");
+        discord_json_write_int(w, presence->activity->type);
+
+        if(presence->activity->state) {
+            discord_json_write_key(w, "state");
+            discord_json_write_string(w, presence->activity->state);
+        }
+
+        discord_json_write_object_end(w);
+    }
+
+    discord_json_write_array_end(w);
+    discord_json_write_key(w, "status");
+    discord_json_write_string(w, discord_presence_status_name(presence->status));
+    discord_json_write_key(w, "afk");
+    discord_json_write_bool(w, presence->afk);
+    discord_json_write_object_end(w);
+}
+
+int discord_json_write_identify(char* buffer, size_t size, const discord_identify_t* identify) {
+    char os[48];
+    snprintf(os, sizeof(os), "esp-idf (%s)", esp_get_idf_version());
+
+    discord_json_writer_t w;
+    discord_json_write_frame(&w, buffer, size, DISCORD_OP_IDENTIFY);
+    discord_json_write_object(&w);
+    discord_json_write_key(&w, "token");
+    discord_json_write_string(&w, identify->token);
+    discord_json_write_key(&w, "intents");
+    discord_json_write_int(&w, identify->intents);
+    discord_json_write_key(&w, "properties");
+    discord_json_write_object(&w);
+    discord_json_write_key(&w, "os");
+    discord_json_write_string(&w, os);
+    discord_json_write_key(&w, "browser");
+    discord_json_write_string(&w, "esp-discord (" DISCORD_VER_STRING ")");
+    discord_json_write_key(&w, "device");
+    discord_json_write_string(&w, CONFIG_IDF_TARGET);
+    discord_json_write_object_end(&w);
+
+    if(identify->large_threshold > 0) {
+        discord_json_write_key(&w, "large_threshold");
+        discord_json_write_int(&w, identify->large_threshold);
+    }
+
+    if(identify->compress) {
+        discord_json_write_key(&w, "compress");
+        discord_json_write_bool(&w, true);
+    }
+
+    if(identify->shard_count > 0) {
+        discord_json_write_key(&w, "shard");
+        discord_json_write_array(&w);
+        discord_json_write_int(&w, identify->shard_id);
+        discord_json_write_int(&w, identify->shard_count);
+        discord_json_write_array_end(&w);
+    }
+
+    if(identify->presence) {
+        discord_json_write_key(&w, "presence");
+        discord_json_write_presence_data(&w, identify->presence);
+    }
+
+    discord_json_write_object_end(&w);
+    discord_json_write_object_end(&w);
+
+    return discord_json_writer_result(&w);
+}
+
+int discord_json_write_resume(char* buffer, size_t size, const char* token, const char* session_id, int seq) {
+    discord_json_writer_t w;
+    discord_json_write_frame(&w, buffer, size, DISCORD_OP_RESUME);
+    discord_json_write_object(&w);
+    discord_json_write_key(&w, "token");
+    discord_json_write_string(&w, token);
+    discord_json_write_key(&w, "session_id");
+    discord_json_write_string(&w, session_id);
+    discord_json_write_key(&w, "seq");
+    discord_json_write_int(&w, seq);
+    discord_json_write_object_end(&w);
+    discord_json_write_object_end(&w);
+
+    return discord_json_writer_result(&w);
+}
+
+int discord_json_write_presence(char* buffer, size_t size, const discord_presence_t* presence) {
+    discord_json_writer_t w;
+    discord_json_write_frame(&w, buffer, size, DISCORD_OP_PRESENCE_UPDATE);
+    discord_json_write_presence_data(&w, presence);
+    discord_json_write_object_end(&w);
+
+    return discord_json_writer_result(&w);
+}
+
+int discord_json_write_request_guild_members(char* buffer, size_t size, const char* guild_id) {
+    discord_json_writer_t w;
+    discord_json_write_frame(&w, buffer, size, DISCORD_OP_REQUEST_GUILD_MEMBERS);
+    discord_json_write_object(&w);
+    discord_json_write_key(&w, "guild_id");
+    discord_json_write_string(&w, guild_id);
+    discord_json_write_key(&w, "query");
+    discord_json_write_string(&w, ""); // all members
+    discord_json_write_key(&w, "limit");
+    discord_json_write_int(&w, 0);
+    discord_json_write_object_end(&w);
+    discord_json_write_object_end(&w);
+
+    return discord_json_writer_result(&w);
+}
+
+const char* discord_presence_status_name(discord_presence_status_t status) {
+    switch(status) {
+        case DISCORD_PRESENCE_DND:          return "dnd";
+        case DISCORD_PRESENCE_IDLE:         return "idle";
+        case DISCORD_PRESENCE_INVISIBLE:    return "invisible";
+        case DISCORD_PRESENCE_OFFLINE:      return "offline";
+        default:                            return "online";
+    }
 }
 
 discord_session_t* discord_session_from_cjson(cJSON* root) {
@@ -156,15 +442,18 @@ discord_session_t* discord_session_from_cjson(cJSON* root) {
         return NULL;
 
     cJSON* _id = cJSON_GetObjectItem(root, "session_id");
+    cJSON* _resume_url = cJSON_GetObjectItem(root, "resume_gateway_url");
 
     discord_session_t* session = cu_ctor(discord_session_t,
         .session_id = _id->valuestring,
+        .resume_gateway_url = cJSON_IsString(_resume_url) ? _resume_url->valuestring : NULL,
         .user = discord_user_from_cjson(cJSON_GetObjectItem(root, "user"))
     );
 
     // todo: memcheck
 
     _id->valuestring = NULL;
+    if(cJSON_IsString(_resume_url)) _resume_url->valuestring = NULL;
 
     return session;
 }
@@ -195,19 +484,6 @@ discord_user_t* discord_user_from_cjson(cJSON* root) {
     return user;
 }
 
-cJSON* discord_user_to_cjson(discord_user_t* user) {
-    cJSON* root = cJSON_CreateObject();
-
-    cJSON_AddItemToObject(root, "id", cJSON_CreateStringReference(user->id));
-    cJSON_AddItemToObject(root, "username", cJSON_CreateStringReference(user->username));
-    cJSON_AddItemToObject(root, "discriminator", cJSON_CreateStringReference(user->discriminator));
-    cJSON_AddBoolToObject(root, "bot", user->bot);
-
-    // todo: memchecks
-
-    return root;
-}
-
 discord_member_t* discord_member_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
@@ -242,20 +518,6 @@ discord_member_t* discord_member_from_cjson(cJSON* root) {
     return member;
 }
 
-cJSON* discord_member_to_cjson(discord_member_t* member) {
-    if(!member)
-        return NULL;
-    
-    cJSON* root = cJSON_CreateObject();
-
-    if(member->nick) cJSON_AddItemToObject(root, "nick", cJSON_CreateStringReference(member->nick));
-    if(member->permissions) cJSON_AddItemToObject(root, "permissions", cJSON_CreateStringReference(member->permissions));
-
-    // todo: memchecks
-
-    return root;
-}
-
 discord_attachment_t* discord_attachment_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
@@ -285,100 +547,150 @@ discord_attachment_t* discord_attachment_from_cjson(cJSON* root) {
     return attachment;
 }
 
-cJSON* discord_attachment_to_cjson(discord_attachment_t* attachment) {
-    if(!attachment)
-        return NULL;
-    
-    cJSON* root = cJSON_CreateObject();
-
-    if(attachment->id) cJSON_AddItemToObject(root, "id", cJSON_CreateStringReference(attachment->id));
-    if(attachment->filename) cJSON_AddItemToObject(root, "filename", cJSON_CreateStringReference(attachment->filename));
+/**
+ * @brief Write member only if the value is set
+ */
+static void discord_json_write_optional_string(discord_json_writer_t* w, const char* key, const char* str) {
+    if(str) {
+        discord_json_write_key(w, key);
+        discord_json_write_string(w, str);
+    }
+}
 
-    // todo: memchecks
+static void discord_json_write_embed_image(discord_json_writer_t* w, const char* key, const discord_embed_image_t* image) {
+    if(!image)
+        return;
 
-    return root;
+    discord_json_write_key(w, key);
+    discord_json_write_object(w);
+    discord_json_write_optional_string(w, "url", image->url);
+    discord_json_write_object_end(w);
 }
 
-static cJSON* discord_embed_footer_to_cjson(discord_embed_footer_t* footer)
-{
-    if(!footer)
-        return NULL;
-    
-    cJSON* root = cJSON_CreateObject();
+void discord_json_write_embed(discord_json_writer_t* w, const discord_embed_t* embed) {
+    if(!embed) {
+        discord_json_write_null(w);
+        return;
+    }
 
-    if(footer->text) cJSON_AddItemToObject(root, "text", cJSON_CreateStringReference(footer->text));
-    if(footer->icon_url) cJSON_AddItemToObject(root, "icon_url", cJSON_CreateStringReference(footer->icon_url));
+    discord_json_write_object(w);
+    discord_json_write_optional_string(w, "title", embed->title);
+    discord_json_write_optional_string(w, "description", embed->description);
+    discord_json_write_optional_string(w, "url", embed->url);
+    discord_json_write_key(w, "color");
+    discord_json_write_int(w, embed->color);
+
+    if(embed->footer) {
+        discord_json_write_key(w, "footer");
+        discord_json_write_object(w);
+        discord_json_write_optional_string(w, "text", embed->footer->text);
+        discord_json_write_optional_string(w, "icon_url", embed->footer->icon_url);
+        discord_json_write_object_end(w);
+    }
 
-    return root;
-}
+    discord_json_write_embed_image(w, "image", embed->image);
+    discord_json_write_embed_image(w, "thumbnail", embed->thumbnail);
 
-static cJSON* discord_embed_image_to_cjson(discord_embed_image_t* image)
-{
-    if(!image)
-        return NULL;
-    
-    cJSON* root = cJSON_CreateObject();
+    if(embed->author) {
+        discord_json_write_key(w, "author");
+        discord_json_write_object(w);
+        discord_json_write_optional_string(w, "name", embed->author->name);
+        discord_json_write_optional_string(w, "url", embed->author->url);
+        discord_json_write_optional_string(w, "icon_url", embed->author->icon_url);
+        discord_json_write_object_end(w);
+    }
 
-    if(image->url) cJSON_AddItemToObject(root, "url", cJSON_CreateStringReference(image->url));
+    if(embed->_fields_len > 0) {
+        discord_json_write_key(w, "fields");
+        discord_json_write_array(w);
 
-    return root;
+        for(uint8_t i = 0; i < embed->_fields_len; i++) {
+            discord_embed_field_t* field = embed->fields[i];
+
+            if(!field) {
+                discord_json_write_null(w);
+                continue;
+            }
+
+            discord_json_write_object(w);
+            discord_json_write_optional_string(w, "name", field->name);
+            discord_json_write_optional_string(w, "value", field->value);
+            discord_json_write_key(w, "inline");
+            discord_json_write_bool(w, field->is_inline);
+            discord_json_write_object_end(w);
+        }
+
+        discord_json_write_array_end(w);
+    }
+
+    discord_json_write_object_end(w);
 }
 
-static cJSON* discord_embed_author_to_cjson(discord_embed_author_t* author)
-{
-    if(!author)
-        return NULL;
-    
-    cJSON* root = cJSON_CreateObject();
+void discord_json_write_message(discord_json_writer_t* w, const discord_message_t* msg) {
+    discord_json_write_object(w);
+    discord_json_write_optional_string(w, "id", msg->id);
+    discord_json_write_key(w, "content");
+    discord_json_write_string(w, msg->content ? msg->content : "");
+    discord_json_write_key(w, "channel_id");
+    discord_json_write_string(w, msg->channel_id);
+
+    if(msg->author) {
+        discord_json_write_key(w, "author");
+        discord_json_write_object(w);
+        discord_json_write_key(w, "id");
+        discord_json_write_string(w, msg->author->id);
+        discord_json_write_key(w, "username");
+        discord_json_write_string(w, msg->author->username);
+        discord_json_write_key(w, "discriminator");
+        discord_json_write_string(w, msg->author->discriminator);
+        discord_json_write_key(w, "bot");
+        discord_json_write_bool(w, msg->author->bot);
+        discord_json_write_object_end(w);
+    }
 
-    if(author->name) cJSON_AddItemToObject(root, "name", cJSON_CreateStringReference(author->name));
-    if(author->url) cJSON_AddItemToObject(root, "url", cJSON_CreateStringReference(author->url));
-    if(author->icon_url) cJSON_AddItemToObject(root, "icon_url", cJSON_CreateStringReference(author->icon_url));
+    discord_json_write_optional_string(w, "guild_id", msg->guild_id);
 
-    return root;
-}
+    if(msg->member) {
+        discord_json_write_key(w, "member");
+        discord_json_write_object(w);
+        discord_json_write_optional_string(w, "nick", msg->member->nick);
+        discord_json_write_optional_string(w, "permissions", msg->member->permissions);
+        discord_json_write_object_end(w);
+    }
 
-static cJSON* discord_embed_field_to_cjson(discord_embed_field_t* field)
-{
-    if(!field)
-        return NULL;
-    
-    cJSON* root = cJSON_CreateObject();
+    if(msg->_attachments_len > 0 && msg->attachments) {
+        discord_json_write_key(w, "attachments");
+        discord_json_write_array(w);
 
-    if(field->name) cJSON_AddItemToObject(root, "name", cJSON_CreateStringReference(field->name));
-    if(field->value) cJSON_AddItemToObject(root, "value", cJSON_CreateStringReference(field->value));
-    cJSON_AddBoolToObject(root, "inline", field->is_inline);
+        for(uint8_t i = 0; i < msg->_attachments_len; i++) {
+            discord_attachment_t* attachment = msg->attachments[i];
 
-    return root;
-}
+            if(!attachment) {
+                discord_json_write_null(w);
+                continue;
+            }
 
-cJSON* discord_embed_to_cjson(discord_embed_t* embed)
-{
-    if(!embed)
-        return NULL;
-    
-    cJSON* root = cJSON_CreateObject();
+            discord_json_write_object(w);
+            discord_json_write_optional_string(w, "id", attachment->id);
+            discord_json_write_optional_string(w, "filename", attachment->filename);
+            discord_json_write_object_end(w);
+        }
 
-    if(embed->title) cJSON_AddItemToObject(root, "title", cJSON_CreateStringReference(embed->title));
-    if(embed->description) cJSON_AddItemToObject(root, "description", cJSON_CreateStringReference(embed->description));
-    if(embed->url) cJSON_AddItemToObject(root, "url", cJSON_CreateStringReference(embed->url));
-    cJSON_AddNumberToObject(root, "color", embed->color);
-    if(embed->footer) cJSON_AddItemToObject(root, "footer", discord_embed_footer_to_cjson(embed->footer));
-    if(embed->image) cJSON_AddItemToObject(root, "image", discord_embed_image_to_cjson(embed->image));
-    if(embed->thumbnail) cJSON_AddItemToObject(root, "thumbnail", discord_embed_image_to_cjson(embed->thumbnail));
-    if(embed->author) cJSON_AddItemToObject(root, "author", discord_embed_author_to_cjson(embed->author));
+        discord_json_write_array_end(w);
+    }
 
-    if(embed->_fields_len > 0) {
-        cJSON* fields = cJSON_CreateArray();
+    if(msg->_embeds_len > 0 && msg->embeds) {
+        discord_json_write_key(w, "embeds");
+        discord_json_write_array(w);
 
-        for(uint8_t i = 0; i < embed->_fields_len; i++) {
-            cJSON_AddItemToArray(fields, discord_embed_field_to_cjson(embed->fields[i]));
+        for(uint8_t i = 0; i < msg->_embeds_len; i++) {
+            discord_json_write_embed(w, msg->embeds[i]);
         }
 
-        cJSON_AddItemToObject(root, "fields", fields);
+        discord_json_write_array_end(w);
     }
 
-    return root;
+    discord_json_write_object_end(w);
 }
 
 discord_guild_t* discord_guild_from_cjson(cJSON* root) {
@@ -552,41 +864,6 @@ discord_message_t* discord_message_from_cjson(cJSON* root) {
     return message;
 }
 
-cJSON* discord_message_to_cjson(discord_message_t* msg) {
-    cJSON* root = cJSON_CreateObject();
-
-    if(msg->id) cJSON_AddItemToObject(root, "id", cJSON_CreateStringReference(msg->id));
-    cJSON_AddItemToObject(root, "content", cJSON_CreateStringReference(msg->content));
-    cJSON_AddItemToObject(root, "channel_id", cJSON_CreateStringReference(msg->channel_id));
-    if(msg->author) cJSON_AddItemToObject(root, "author", discord_user_to_cjson(msg->author));
-    if(msg->guild_id) cJSON_AddItemToObject(root, "guild_id", cJSON_CreateStringReference(msg->guild_id));
-    if(msg->member) cJSON_AddItemToObject(root, "member", discord_member_to_cjson(msg->member));
-
-    if(msg->_attachments_len > 0 && msg->attachments) {
-        cJSON* attachments = cJSON_CreateArray();
-
-        for(uint8_t i = 0; i < msg->_attachments_len; i++) {
-            cJSON_AddItemToArray(attachments, discord_attachment_to_cjson(msg->attachments[i]));
-        }
-
-        cJSON_AddItemToObject(root, "attachments", attachments);
-    }
-
-    if(msg->_embeds_len > 0 && msg->embeds) {
-        cJSON* embeds = cJSON_CreateArray();
-
-        for(uint8_t i = 0; i < msg->_embeds_len; i++) {
-            cJSON_AddItemToArray(embeds, discord_embed_to_cjson(msg->embeds[i]));
-        }
-
-        cJSON_AddItemToObject(root, "embeds", embeds);
-    }
-
-    // todo: memchecks
-
-    return root;
-}
-
 discord_emoji_t* discord_emoji_from_cjson(cJSON* root) {
     if(!root)
         return NULL;
@@ -614,11 +891,13 @@ discord_message_reaction_t* discord_message_reaction_from_cjson(cJSON* root) {
     cJSON* _uid = cJSON_GetObjectItem(root, "user_id");
     cJSON* _mid = cJSON_GetObjectItem(root, "message_id");
     cJSON* _cid = cJSON_GetObjectItem(root, "channel_id");
+    cJSON* _gid = cJSON_GetObjectItem(root, "guild_id");
 
     discord_message_reaction_t* react = cu_ctor(discord_message_reaction_t,
         .user_id = _uid->valuestring,
         .message_id = _mid->valuestring,
         .channel_id = _cid->valuestring,
+        .guild_id = _gid ? _gid->valuestring : NULL,
         .emoji = discord_emoji_from_cjson(cJSON_GetObjectItem(root, "emoji"))
     );
 
@@ -629,6 +908,8 @@ discord_message_reaction_t* discord_message_reaction_from_cjson(cJSON* root) {
     _cid->valuestring =
     NULL;
 
+    if(_gid) _gid->valuestring = NULL;
+
     return react;
 }
 
@@ -660,5 +941,173 @@ discord_voice_state_t* discord_voice_state_from_cjson(cJSON* root) {
 
     if(_cid) { _cid->valuestring = NULL; }
 
+    return state;
+}
+
+static char* discord_json_take_string(cJSON* root, const char* key) {
+    cJSON* item = cJSON_GetObjectItem(root, key);
+
+    if(!cJSON_IsString(item)) {
+        return NULL;
+    }
+
+    char* value = item->valuestring;
+    item->valuestring = NULL;
+
+    return value;
+}
+
+static discord_role_t** discord_role_list_from_cjson(cJSON* array, int* out_length) {
+    int len = cJSON_GetArraySize(array);
+    discord_role_t** roles = calloc(len > 0 ? len : 1, sizeof(discord_role_t*));
+
+    // todo: memcheck
+
+    for(int i = 0; i < len; i++) {
+        roles[i] = discord_role_from_cjson(cJSON_GetArrayItem(array, i));
+    }
+
+    *out_length = len;
+    return roles;
+}
+
+static discord_channel_t** discord_channel_list_from_cjson(cJSON* array, int* out_length) {
+    int len = cJSON_GetArraySize(array);
+    discord_channel_t** channels = calloc(len > 0 ? len : 1, sizeof(discord_channel_t*));
+
+    // todo: memcheck
+
+    for(int i = 0; i < len; i++) {
+        channels[i] = discord_channel_from_cjson(cJSON_GetArrayItem(array, i));
+    }
+
+    *out_length = len;
+    return channels;
+}
+
+/**
+ * @brief Convert the member which carries its user
+ * @return false if member cannot be cached
+ */
+static bool discord_member_record_from_cjson(cJSON* root, discord_member_record_t* out_record) {
+    cJSON* _uid = cJSON_GetObjectItem(cJSON_GetObjectItem(root, "user"), "id");
+    cJSON* _nick = cJSON_GetObjectItem(root, "nick");
+    cJSON* _roles = cJSON_GetObjectItem(root, "roles");
+    int roles_len = cJSON_GetArraySize(_roles);
+
+    if(!cJSON_IsString(_uid) || roles_len > DISCORD_MEMBER_CACHE_ROLES_MAX ||
+       (cJSON_IsString(_nick) && strlen(_nick->valuestring) > DISCORD_MEMBER_CACHE_NICK_MAX)) {
+        return false;
+    }
+
+    out_record->user_id = strtoull(_uid->valuestring, NULL, 10);
+    out_record->roles_len = roles_len;
+    out_record->has_nick = cJSON_IsString(_nick);
+
+    for(int i = 0; i < roles_len; i++) {
+        cJSON* _role = cJSON_GetArrayItem(_roles, i);
+        out_record->roles[i] = cJSON_IsString(_role) ? strtoull(_role->valuestring, NULL, 10) : 0;
+    }
+
+    if(out_record->has_nick) {
+        strcpy(out_record->nick, _nick->valuestring);
+    }
+
+    return out_record->user_id != 0;
+}
+
+discord_guild_state_t* discord_guild_state_from_cjson(discord_event_t e, cJSON* root) {
+    if(!root)
+        return NULL;
+
+    discord_guild_state_t* state = cu_ctor(discord_guild_state_t, .guild_id = NULL);
+
+    // todo: memcheck
+
+    switch((int) e) {
+        case DISCORD_EVENT_GUILD_CREATED:
+        case DISCORD_EVENT_GUILD_UPDATED:
+        case DISCORD_EVENT_GUILD_DELETED: {
+                state->guild_id = discord_json_take_string(root, "id");
+
+                cJSON* _roles = cJSON_GetObjectItem(root, "roles");
+                cJSON* _channels = cJSON_GetObjectItem(root, "channels");
+
+                if(cJSON_IsArray(_roles)) {
+                    state->roles = discord_role_list_from_cjson(_roles, &state->roles_len);
+                }
+
+                if(cJSON_IsArray(_channels)) {
+                    state->channels = discord_channel_list_from_cjson(_channels, &state->channels_len);
+                }
+            }
+            break;
+
+        case DISCORD_EVENT_GUILD_ROLE_CREATED:
+        case DISCORD_EVENT_GUILD_ROLE_UPDATED: {
+                state->guild_id = discord_json_take_string(root, "guild_id");
+                discord_role_t* role = discord_role_from_cjson(cJSON_GetObjectItem(root, "role"));
+
+                if(role) {
+                    state->roles = cu_ctor(discord_role_t*, role);
+                    state->roles_len = 1;
+                }
+            }
+            break;
+
+        case DISCORD_EVENT_GUILD_ROLE_DELETED:
+            state->guild_id = discord_json_take_string(root, "guild_id");
+            state->id = discord_json_take_string(root, "role_id");
+            break;
+
+        case DISCORD_EVENT_CHANNEL_CREATED:
+        case DISCORD_EVENT_CHANNEL_UPDATED:
+        case DISCORD_EVENT_CHANNEL_DELETED: {
+                state->guild_id = discord_json_take_string(root, "guild_id");
+                discord_channel_t* channel = discord_channel_from_cjson(root);
+
+                if(channel) {
+                    state->id = STRDUP(channel->id);
+                    state->channels = cu_ctor(discord_channel_t*, channel);
+                    state->channels_len = 1;
+                }
+            }
+            break;
+
+        case DISCORD_EVENT_GUILD_MEMBERS_CHUNK: {
+                state->guild_id = discord_json_take_string(root, "guild_id");
+                cJSON* _index = cJSON_GetObjectItem(root, "chunk_index");
+                cJSON* _count = cJSON_GetObjectItem(root, "chunk_count");
+                state->chunk_index = cJSON_IsNumber(_index) ? _index->valueint : 0;
+                state->chunk_count = cJSON_IsNumber(_count) ? _count->valueint : 1;
+
+                cJSON* _members = cJSON_GetObjectItem(root, "members"); // only with ETF, JSON stream scans and prunes them
+                int len = cJSON_GetArraySize(_members);
+
+                if(len > 0 && (state->members = calloc(len, sizeof(discord_member_record_t)))) {
+                    for(int i = 0; i < len; i++) {
+                        if(discord_member_record_from_cjson(cJSON_GetArrayItem(_members, i), &state->members[state->members_len])) {
+                            state->members_len++;
+                        }
+                    }
+                }
+            }
+            break;
+
+        case DISCORD_EVENT_GUILD_MEMBER_ADDED:
+        case DISCORD_EVENT_GUILD_MEMBER_UPDATED:
+        case DISCORD_EVENT_GUILD_MEMBER_REMOVED:
+            if((int) e != DISCORD_EVENT_GUILD_MEMBER_REMOVED && (state->members = calloc(1, sizeof(discord_member_record_t)))) {
+                state->members_len = discord_member_record_from_cjson(root, state->members) ? 1 : 0; // member which cannot be cached is removed
+            }
+
+            state->guild_id = discord_json_take_string(root, "guild_id");
+            state->id = discord_json_take_string(cJSON_GetObjectItem(root, "user"), "id");
+            break;
+
+        default:
+            break;
+    }
+
     return state;
 }
\ No newline at end of file
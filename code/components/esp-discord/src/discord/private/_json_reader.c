@@ -0,0 +1,903 @@
+#include "discord/private/_json_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "cJSON.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_json.h"
+#include "discord/private/_etf.h"
+#include "discord/session.h"
+#include "discord/message_reaction.h"
+#include "discord/voice_state.h"
+#include "cutils.h"
+#include "estr.h"
+
+#define _is_digit(c) ((c) >= '0' && (c) <= '9')
+
+DISCORD_LOG_DEFINE_BASE();
+
+// tokenizer
+
+static void discord_json_reader_fail(discord_json_reader_t* reader) {
+    reader->error = true;
+    reader->pos = reader->end;
+}
+
+/**
+ * @brief Skip whitespace
+ * @return Next character or '\0' at the end of the input
+ */
+static char discord_json_reader_ws(discord_json_reader_t* reader) {
+    if(reader->etf) {
+        return reader->pos < reader->end ? *reader->pos : '\0'; // terms are not separated
+    }
+
+    for(; reader->pos < reader->end; reader->pos++) {
+        char c = *reader->pos;
+
+        if(c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            return c;
+        }
+    }
+
+    return '\0';
+}
+
+static bool discord_json_reader_literal(discord_json_reader_t* reader, const char* literal) {
+    size_t len = strlen(literal);
+
+    if((size_t) (reader->end - reader->pos) < len || strncmp(reader->pos, literal, len) != 0) {
+        discord_json_reader_fail(reader);
+        return false;
+    }
+
+    reader->pos += len;
+    reader->after_value = true;
+
+    return true;
+}
+
+/**
+ * @brief Integer part is the value. Fraction and exponent are consumed, Discord sends integers only
+ */
+static int64_t discord_json_reader_number(discord_json_reader_t* reader) {
+    char* p = reader->pos;
+    bool negative = p < reader->end && *p == '-';
+    uint64_t value = 0;
+
+    p += negative;
+
+    if(p >= reader->end || !_is_digit(*p)) {
+        discord_json_reader_fail(reader);
+        return 0;
+    }
+
+    for(; p < reader->end && _is_digit(*p); p++) {
+        value = value * 10 + (*p - '0');
+    }
+
+    for(; p < reader->end && (_is_digit(*p) || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-'); p++) { }
+
+    reader->pos = p;
+    reader->after_value = true;
+
+    return negative ? -(int64_t) value : (int64_t) value;
+}
+
+static bool discord_json_reader_hex4(const char* p, const char* end, uint32_t* out_value) {
+    uint32_t value = 0;
+
+    if(end - p < 4) {
+        return false;
+    }
+
+    for(int i = 0; i < 4; i++) {
+        char c = p[i];
+        value <<= 4;
+
+        if(_is_digit(c)) value |= c - '0';
+        else if(c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if(c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return false;
+    }
+
+    *out_value = value;
+    return true;
+}
+
+static size_t discord_json_reader_utf8(uint32_t cp, char* out) {
+    if(cp < 0x80) {
+        out[0] = cp;
+        return 1;
+    }
+
+    if(cp < 0x800) {
+        out[0] = 0xC0 | (cp >> 6);
+        out[1] = 0x80 | (cp & 0x3F);
+        return 2;
+    }
+
+    if(cp < 0x10000) {
+        out[0] = 0xE0 | (cp >> 12);
+        out[1] = 0x80 | ((cp >> 6) & 0x3F);
+        out[2] = 0x80 | (cp & 0x3F);
+        return 3;
+    }
+
+    out[0] = 0xF0 | (cp >> 18);
+    out[1] = 0x80 | ((cp >> 12) & 0x3F);
+    out[2] = 0x80 | ((cp >> 6) & 0x3F);
+    out[3] = 0x80 | (cp & 0x3F);
+    return 4;
+}
+
+/**
+ * @brief Unescape string in place and terminate it where the closing quote was.
+ *        Decoded escape is never longer than the escape itself, so the string only shrinks
+ */
+static char* discord_json_reader_unescape(discord_json_reader_t* reader, size_t* out_len) {
+    char* start = reader->pos + 1;
+    char* dst = start;
+
+    for(char* p = start; p < reader->end; p++) {
+        if(*p == '"') {
+            *dst = '\0';
+            reader->pos = p + 1;
+            reader->after_value = true;
+            if(out_len) *out_len = dst - start;
+            return start;
+        }
+
+        if(*p != '\\') {
+            *dst++ = *p;
+            continue;
+        }
+
+        if(++p == reader->end) {
+            break;
+        }
+
+        switch(*p) {
+            case '"': case '\\': case '/': *dst++ = *p; break;
+            case 'b': *dst++ = '\b'; break;
+            case 'f': *dst++ = '\f'; break;
+            case 'n': *dst++ = '\n'; break;
+            case 'r': *dst++ = '\r'; break;
+            case 't': *dst++ = '\t'; break;
+
+            case 'u': {
+                uint32_t cp, low;
+
+                if(!discord_json_reader_hex4(p + 1, reader->end, &cp)) {
+                    discord_json_reader_fail(reader);
+                    return NULL;
+                }
+
+                p += 4;
+
+                if(cp >= 0xD800 && cp <= 0xDBFF) { // surrogate pair
+                    if(reader->end - p < 7 || p[1] != '\\' || p[2] != 'u' ||
+                       !discord_json_reader_hex4(p + 3, reader->end, &low) || low < 0xDC00 || low > 0xDFFF) {
+                        discord_json_reader_fail(reader);
+                        return NULL;
+                    }
+
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+
+                dst += discord_json_reader_utf8(cp, dst);
+                break;
+            }
+
+            default:
+                discord_json_reader_fail(reader);
+                return NULL;
+        }
+    }
+
+    discord_json_reader_fail(reader); // unterminated
+    return NULL;
+}
+
+static void discord_json_reader_skip_string(discord_json_reader_t* reader) {
+    for(char* p = reader->pos + 1; p < reader->end; p++) {
+        if(*p == '\\') {
+            p++; // escaped character, even the quote, does not end the string
+        } else if(*p == '"') {
+            reader->pos = p + 1;
+            return;
+        }
+    }
+
+    discord_json_reader_fail(reader);
+}
+
+void discord_json_reader_init(discord_json_reader_t* reader, char* json, size_t len) {
+    *reader = (discord_json_reader_t) {
+        .pos = json,
+        .end = json + len
+    };
+}
+
+discord_json_type_t discord_json_reader_peek(discord_json_reader_t* reader) {
+    if(reader->etf) {
+        return discord_etf_reader_peek(reader);
+    }
+
+    char c = discord_json_reader_ws(reader);
+
+    switch(c) {
+        case 'n': return DISCORD_JSON_NULL;
+        case 't':
+        case 'f': return DISCORD_JSON_BOOL;
+        case '"': return DISCORD_JSON_STRING;
+        case '{': return DISCORD_JSON_OBJECT;
+        case '[': return DISCORD_JSON_ARRAY;
+        default: return c == '-' || _is_digit(c) ? DISCORD_JSON_NUMBER : DISCORD_JSON_NONE;
+    }
+}
+
+/**
+ * @brief Skipped containers are not validated, only their nesting is tracked. Nothing is allocated, no recursion
+ */
+void discord_json_reader_skip(discord_json_reader_t* reader) {
+    if(reader->etf) {
+        discord_etf_reader_skip(reader);
+        return;
+    }
+
+    int depth = 0;
+
+    do {
+        char c = discord_json_reader_ws(reader);
+
+        switch(c) {
+            case '{':
+            case '[':
+                depth++;
+                reader->pos++;
+                break;
+
+            case '}':
+            case ']':
+            case ',':
+            case ':':
+                if(depth == 0) {
+                    discord_json_reader_fail(reader); // value is missing
+                } else {
+                    depth -= c == '}' || c == ']';
+                    reader->pos++;
+                }
+                break;
+
+            case '"': discord_json_reader_skip_string(reader); break;
+            case 't': discord_json_reader_literal(reader, "true"); break;
+            case 'f': discord_json_reader_literal(reader, "false"); break;
+            case 'n': discord_json_reader_literal(reader, "null"); break;
+            default: discord_json_reader_number(reader); break;
+        }
+    } while(depth > 0 && !reader->error);
+
+    reader->after_value = true;
+}
+
+static bool discord_json_reader_enter(discord_json_reader_t* reader, char open) {
+    if(discord_json_reader_ws(reader) != open) {
+        discord_json_reader_skip(reader);
+        return false;
+    }
+
+    reader->pos++;
+    reader->after_value = false;
+
+    return true;
+}
+
+bool discord_json_reader_object(discord_json_reader_t* reader) {
+    return reader->etf ? discord_etf_reader_enter(reader, true) : discord_json_reader_enter(reader, '{');
+}
+
+bool discord_json_reader_array(discord_json_reader_t* reader) {
+    return reader->etf ? discord_etf_reader_enter(reader, false) : discord_json_reader_enter(reader, '[');
+}
+
+bool discord_json_reader_next_key(discord_json_reader_t* reader, const char** out_key) {
+    if(reader->etf) {
+        return discord_etf_reader_next_key(reader, out_key);
+    }
+
+    if(reader->error) {
+        return false;
+    }
+
+    char c = discord_json_reader_ws(reader);
+
+    if(c == '}') {
+        reader->pos++;
+        reader->after_value = true;
+        return false;
+    }
+
+    if(reader->after_value) {
+        if(c != ',') {
+            discord_json_reader_fail(reader);
+            return false;
+        }
+
+        reader->pos++;
+        c = discord_json_reader_ws(reader);
+    }
+
+    char* key = c == '"' ? discord_json_reader_unescape(reader, NULL) : NULL;
+
+    if(!key || discord_json_reader_ws(reader) != ':') {
+        discord_json_reader_fail(reader);
+        return false;
+    }
+
+    reader->pos++;
+    reader->after_value = false;
+    *out_key = key;
+
+    return true;
+}
+
+bool discord_json_reader_next_item(discord_json_reader_t* reader) {
+    if(reader->etf) {
+        return discord_etf_reader_next_item(reader);
+    }
+
+    if(reader->error) {
+        return false;
+    }
+
+    char c = discord_json_reader_ws(reader);
+
+    if(c == ']') {
+        reader->pos++;
+        reader->after_value = true;
+        return false;
+    }
+
+    if(reader->after_value) {
+        if(c != ',') {
+            discord_json_reader_fail(reader);
+            return false;
+        }
+
+        reader->pos++;
+    }
+
+    reader->after_value = false;
+
+    return true;
+}
+
+int discord_json_reader_count(discord_json_reader_t* reader) {
+    if(reader->etf) {
+        return discord_etf_reader_count(reader);
+    }
+
+    discord_json_reader_t probe = *reader; // skipping does not modify the input, so the array can be scanned twice
+    int count = 0;
+
+    if(discord_json_reader_array(&probe)) {
+        for(; discord_json_reader_next_item(&probe); count++) {
+            discord_json_reader_skip(&probe);
+        }
+    }
+
+    return probe.error ? 0 : count;
+}
+
+char* discord_json_reader_string(discord_json_reader_t* reader, size_t* out_len) {
+    if(reader->etf) {
+        return discord_etf_reader_string(reader, out_len);
+    }
+
+    if(discord_json_reader_ws(reader) != '"') {
+        discord_json_reader_skip(reader);
+        return NULL;
+    }
+
+    return discord_json_reader_unescape(reader, out_len);
+}
+
+char* discord_json_reader_strdup(discord_json_reader_t* reader) {
+    if(reader->etf) {
+        return discord_etf_reader_strdup(reader);
+    }
+
+    size_t len = 0;
+    char* value = discord_json_reader_string(reader, &len);
+
+    return value ? discord_arena_strndup(reader->arena, value, len) : NULL;
+}
+
+int64_t discord_json_reader_int(discord_json_reader_t* reader, int64_t default_value) {
+    if(reader->etf) {
+        return discord_etf_reader_int(reader, default_value);
+    }
+
+    if(discord_json_reader_peek(reader) != DISCORD_JSON_NUMBER) {
+        discord_json_reader_skip(reader);
+        return default_value;
+    }
+
+    return discord_json_reader_number(reader);
+}
+
+bool discord_json_reader_bool(discord_json_reader_t* reader) {
+    if(reader->etf) {
+        return discord_etf_reader_bool(reader);
+    }
+
+    if(discord_json_reader_ws(reader) == 't') {
+        return discord_json_reader_literal(reader, "true");
+    }
+
+    discord_json_reader_skip(reader);
+    return false;
+}
+
+// models
+
+/**
+ * @brief Read string member into the model field. First occurrence of the key wins
+ */
+static void discord_json_read_str(discord_json_reader_t* reader, char** field) {
+    if(*field) {
+        discord_json_reader_skip(reader);
+    } else {
+        *field = discord_json_reader_strdup(reader);
+    }
+}
+
+/**
+ * @brief Allocation failure is handled as syntax error, so the partially decoded model is dropped
+ */
+static void* discord_json_read_check(discord_json_reader_t* reader, void* model) {
+    if(!model && !reader->error) {
+        DISCORD_LOGE("Fail to allocate model");
+        discord_json_reader_fail(reader);
+    }
+
+    return model;
+}
+
+#define discord_json_read_ctor(reader, type, ...) ({ \
+        type* _model = discord_json_read_check(reader, discord_arena_calloc((reader)->arena, sizeof(type))); \
+        if(_model) { *_model = (type) { __VA_ARGS__ }; } \
+        _model; \
+    })
+
+static discord_user_t* discord_json_read_user_object(discord_json_reader_t* reader) {
+    discord_user_t* user = discord_json_reader_object(reader) ? discord_json_read_ctor(reader, discord_user_t) : NULL;
+    const char* key;
+
+    while(user && discord_json_reader_next_key(reader, &key)) {
+        if(estr_eq(key, "id")) {
+            discord_json_read_str(reader, &user->id);
+        } else if(estr_eq(key, "username")) {
+            discord_json_read_str(reader, &user->username);
+        } else if(estr_eq(key, "discriminator")) {
+            discord_json_read_str(reader, &user->discriminator);
+        } else if(estr_eq(key, "bot")) {
+            user->bot = discord_json_reader_bool(reader);
+        } else {
+            discord_json_reader_skip(reader);
+        }
+    }
+
+    return user;
+}
+
+static discord_member_t* discord_json_read_member_object(discord_json_reader_t* reader) {
+    discord_member_t* member = discord_json_reader_object(reader) ? discord_json_read_ctor(reader, discord_member_t) : NULL;
+    const char* key;
+
+    while(member && discord_json_reader_next_key(reader, &key)) {
+        if(estr_eq(key, "nick")) {
+            discord_json_read_str(reader, &member->nick);
+        } else if(estr_eq(key, "permissions")) {
+            discord_json_read_str(reader, &member->permissions);
+        } else if(estr_eq(key, "roles") && !member->roles) {
+            int count = discord_json_reader_count(reader);
+            count = count > UINT8_MAX ? UINT8_MAX : count;
+
+            if(!discord_json_reader_array(reader)) {
+                continue;
+            }
+
+            member->roles = count > 0 ? discord_json_read_check(reader, discord_arena_calloc(reader->arena, count * sizeof(char*))) : NULL;
+
+            while(discord_json_reader_next_item(reader)) {
+                if(member->_roles_len < count) {
+                    member->roles[member->_roles_len++] = discord_json_reader_strdup(reader);
+                } else {
+                    discord_json_reader_skip(reader);
+                }
+            }
+        } else {
+            discord_json_reader_skip(reader);
+        }
+    }
+
+    return member;
+}
+
+static discord_attachment_t* discord_json_read_attachment_object(discord_json_reader_t* reader) {
+    discord_attachment_t* attachment = discord_json_reader_object(reader) ? discord_json_read_ctor(reader, discord_attachment_t) : NULL;
+    const char* key;
+
+    while(attachment && discord_json_reader_next_key(reader, &key)) {
+        if(estr_eq(key, "id")) {
+            discord_json_read_str(reader, &attachment->id);
+        } else if(estr_eq(key, "filename")) {
+            discord_json_read_str(reader, &attachment->filename);
+        } else if(estr_eq(key, "content_type")) {
+            discord_json_read_str(reader, &attachment->content_type);
+        } else if(estr_eq(key, "url")) {
+            discord_json_read_str(reader, &attachment->url);
+        } else if(estr_eq(key, "size")) {
+            attachment->size = discord_json_reader_int(reader, 0);
+        } else {
+            discord_json_reader_skip(reader);
+        }
+    }
+
+    return attachment;
+}
+
+static void discord_json_read_attachments(discord_json_reader_t* reader, discord_message_t* message) {
+    int count = discord_json_reader_count(reader);
+    count = count > UINT8_MAX ? UINT8_MAX : count;
+
+    if(!discord_json_reader_array(reader)) {
+        return;
+    }
+
+    message->attachments = count > 0 ? discord_json_read_check(reader, discord_arena_calloc(reader->arena, count * sizeof(discord_attachment_t*))) : NULL;
+
+    while(discord_json_reader_next_item(reader)) {
+        discord_attachment_t* attachment = message->_attachments_len < count ? discord_json_read_attachment_object(reader) : NULL;
+
+        if(attachment) {
+            message->attachments[message->_attachments_len++] = attachment;
+        } else if(message->_attachments_len >= count) {
+            discord_json_reader_skip(reader);
+        }
+    }
+}
+
+static discord_message_t* discord_json_read_message_object(discord_json_reader_t* reader) {
+    discord_message_t* message = discord_json_reader_object(reader) ?
+        discord_json_read_ctor(reader, discord_message_t, .type = DISCORD_MESSAGE_UNDEFINED) : NULL;
+    const char* key;
+
+    while(message && discord_json_reader_next_key(reader, &key)) {
+        if(estr_eq(key, "id")) {
+            discord_json_read_str(reader, &message->id);
+        } else if(estr_eq(key, "type")) {
+            message->type = (discord_message_type_t) discord_json_reader_int(reader, DISCORD_MESSAGE_UNDEFINED);
+        } else if(estr_eq(key, "content")) {
+            discord_json_read_str(reader, &message->content);
+        } else if(estr_eq(key, "channel_id")) {
+            discord_json_read_str(reader, &message->channel_id);
+        } else if(estr_eq(key, "guild_id")) {
+            discord_json_read_str(reader, &message->guild_id);
+        } else if(estr_eq(key, "author") && !message->author) {
+            message->author = discord_json_read_user_object(reader);
+        } else if(estr_eq(key, "member") && !message->member) {
+            message->member = discord_json_read_member_object(reader);
+        } else if(estr_eq(key, "attachments") && !message->attachments) {
+            discord_json_read_attachments(reader, message);
+        } else {
+            discord_json_reader_skip(reader); // embeds, mentions, components, ...
+        }
+    }
+
+    return message;
+}
+
+static discord_emoji_t* discord_json_read_emoji_object(discord_json_reader_t* reader) {
+    discord_emoji_t* emoji = discord_json_reader_object(reader) ? discord_json_read_ctor(reader, discord_emoji_t) : NULL;
+    bool has_name = false;
+    const char* key;
+
+    while(emoji && discord_json_reader_next_key(reader, &key)) {
+        if(estr_eq(key, "name")) {
+            discord_json_read_str(reader, &emoji->name);
+            has_name = true;
+        } else {
+            discord_json_reader_skip(reader);
+        }
+    }
+
+    if(emoji && !has_name) {
+        DISCORD_LOGW("Missing name");
+
+        if(!reader->arena) {
+            discord_emoji_free(emoji); // otherwise it is released with the arena
+        }
+
+        return NULL;
+    }
+
+    return emoji;
+}
+
+static discord_message_reaction_t* discord_json_read_reaction_object(discord_json_reader_t* reader) {
+    discord_message_reaction_t* reaction = discord_json_reader_object(reader) ? discord_json_read_ctor(reader, discord_message_reaction_t) : NULL;
+    const char* key;
+
+    while(reaction && discord_json_reader_next_key(reader, &key)) {
+        if(estr_eq(key, "user_id")) {
+            discord_json_read_str(reader, &reaction->user_id);
+        } else if(estr_eq(key, "message_id")) {
+            discord_json_read_str(reader, &reaction->message_id);
+        } else if(estr_eq(key, "channel_id")) {
+            discord_json_read_str(reader, &reaction->channel_id);
+        } else if(estr_eq(key, "guild_id")) {
+            discord_json_read_str(reader, &reaction->guild_id);
+        } else if(estr_eq(key, "emoji") && !reaction->emoji) {
+            reaction->emoji = discord_json_read_emoji_object(reader);
+        } else {
+            discord_json_reader_skip(reader); // member is not part of the model
+        }
+    }
+
+    return reaction;
+}
+
+static discord_voice_state_t* discord_json_read_voice_state_object(discord_json_reader_t* reader) {
+    discord_voice_state_t* state = discord_json_reader_object(reader) ? discord_json_read_ctor(reader, discord_voice_state_t) : NULL;
+    const char* key;
+
+    while(state && discord_json_reader_next_key(reader, &key)) {
+        if(estr_eq(key, "guild_id")) {
+            discord_json_read_str(reader, &state->guild_id);
+        } else if(estr_eq(key, "channel_id")) {
+            discord_json_read_str(reader, &state->channel_id);
+        } else if(estr_eq(key, "user_id")) {
+            discord_json_read_str(reader, &state->user_id);
+        } else if(estr_eq(key, "member") && !state->member) {
+            state->member = discord_json_read_member_object(reader);
+        } else if(estr_eq(key, "deaf")) {
+            state->deaf = discord_json_reader_bool(reader);
+        } else if(estr_eq(key, "mute")) {
+            state->mute = discord_json_reader_bool(reader);
+        } else if(estr_eq(key, "self_deaf")) {
+            state->self_deaf = discord_json_reader_bool(reader);
+        } else if(estr_eq(key, "self_mute")) {
+            state->self_mute = discord_json_reader_bool(reader);
+        } else {
+            discord_json_reader_skip(reader);
+        }
+    }
+
+    return state;
+}
+
+static discord_session_t* discord_json_read_session_object(discord_json_reader_t* reader) {
+    discord_session_t* session = discord_json_reader_object(reader) ? discord_json_read_ctor(reader, discord_session_t) : NULL;
+    const char* key;
+
+    while(session && discord_json_reader_next_key(reader, &key)) {
+        if(estr_eq(key, "session_id")) {
+            discord_json_read_str(reader, &session->session_id);
+        } else if(estr_eq(key, "resume_gateway_url")) {
+            discord_json_read_str(reader, &session->resume_gateway_url);
+        } else if(estr_eq(key, "user") && !session->user) {
+            session->user = discord_json_read_user_object(reader);
+        } else {
+            discord_json_reader_skip(reader);
+        }
+    }
+
+    return session;
+}
+
+/**
+ * @brief Guild state events are rare and have their own cJSON decoder, which the ETF encoding shares.
+ *        Only the data member is parsed to the tree, the input is not modified while it is skipped
+ */
+static discord_guild_state_t* discord_json_read_guild_state(discord_json_reader_t* reader, discord_event_t e) {
+    cJSON* cjson = NULL;
+
+    if(reader->etf) {
+        cjson = discord_etf_reader_cjson(reader);
+    } else {
+        discord_json_reader_ws(reader);
+        char* start = reader->pos;
+
+        discord_json_reader_skip(reader);
+
+        if(reader->error) {
+            return NULL;
+        }
+
+        cjson = cJSON_ParseWithLength(start, reader->pos - start);
+    }
+
+    discord_guild_state_t* state = cjson ? discord_guild_state_from_cjson(e, cjson) : NULL;
+    cJSON_Delete(cjson);
+
+    return state;
+}
+
+static discord_payload_data_t discord_json_read_event_data(discord_json_reader_t* reader, discord_event_t e) {
+    if(DISCORD_EVENT_IS_GUILD_STATE(e)) {
+        return discord_json_read_guild_state(reader, e);
+    }
+
+    switch(e) {
+        case DISCORD_EVENT_READY:
+            return discord_json_read_session_object(reader);
+
+        case DISCORD_EVENT_MESSAGE_RECEIVED:
+        case DISCORD_EVENT_MESSAGE_UPDATED:
+        case DISCORD_EVENT_MESSAGE_DELETED:
+            return discord_json_read_message_object(reader);
+
+        case DISCORD_EVENT_MESSAGE_REACTION_ADDED:
+        case DISCORD_EVENT_MESSAGE_REACTION_REMOVED:
+            return discord_json_read_reaction_object(reader);
+
+        case DISCORD_EVENT_VOICE_STATE_UPDATED:
+            return discord_json_read_voice_state_object(reader);
+
+        case DISCORD_EVENT_RESUMED:
+            discord_json_reader_skip(reader);
+            return NULL;
+
+        default:
+            DISCORD_LOGW("Cannot recognize event type");
+            discord_json_reader_skip(reader);
+            return NULL;
+    }
+}
+
+static discord_payload_data_t discord_json_read_payload_data(discord_json_reader_t* reader, discord_payload_t* payload) {
+    const char* key;
+
+    switch(payload->op) {
+        case DISCORD_OP_HELLO: {
+                discord_hello_t* hello = discord_json_reader_object(reader) ? discord_json_read_ctor(reader, discord_hello_t) : NULL;
+
+                while(hello && discord_json_reader_next_key(reader, &key)) {
+                    if(estr_eq(key, "heartbeat_interval")) {
+                        hello->heartbeat_interval = discord_json_reader_int(reader, 0);
+                    } else {
+                        discord_json_reader_skip(reader);
+                    }
+                }
+
+                return hello;
+            }
+
+        case DISCORD_OP_DISPATCH:
+            return discord_json_read_event_data(reader, payload->t);
+
+        case DISCORD_OP_INVALID_SESSION:
+            return discord_json_read_ctor(reader, discord_invalid_session_t, .resumable = discord_json_reader_bool(reader));
+
+        case DISCORD_OP_HEARTBEAT_ACK:
+        case DISCORD_OP_RECONNECT:
+            discord_json_reader_skip(reader);
+            return NULL;
+
+        default:
+            DISCORD_LOGW("Cannot recognize payload type. Unable to set payload data.");
+            discord_json_reader_skip(reader);
+            return NULL;
+    }
+}
+
+/**
+ * @brief Events delivered to the handlers are decoded into the arena. Data of READY is kept as the session
+ *        and guild state data is decoded by cJSON decoder, so they are allocated field by field
+ */
+static void discord_json_read_arena_create(discord_json_reader_t* reader, discord_payload_t* payload, discord_arena_pool_t* pool, size_t len) {
+    if(pool && !payload->arena && payload->op == DISCORD_OP_DISPATCH && payload->t != DISCORD_EVENT_READY && !DISCORD_EVENT_IS_GUILD_STATE(payload->t)) {
+        // decoded strings are never longer than the input, the region grows if models do not fit
+        payload->arena = discord_arena_create(pool, len);
+    }
+
+    reader->arena = payload->arena;
+}
+
+discord_payload_t* discord_json_read_payload(char* json, size_t len, discord_arena_pool_t* pool) {
+    discord_json_reader_t reader;
+    discord_json_reader_init(&reader, json, len);
+
+    return discord_json_read_payload_from(&reader, pool);
+}
+
+discord_payload_t* discord_json_read_payload_from(discord_json_reader_t* reader, discord_arena_pool_t* pool) {
+    size_t len = reader->end - reader->pos;
+    discord_payload_t* payload = discord_json_reader_object(reader) ?
+        discord_json_read_ctor(reader, discord_payload_t, .op = -1, .s = DISCORD_NULL_SEQUENCE_NUMBER, .t = DISCORD_EVENT_UNKNOWN) : NULL;
+    char* data = NULL;
+    bool has_op = false, has_t = false;
+    const char* key;
+
+    while(payload && discord_json_reader_next_key(reader, &key)) {
+        if(estr_eq(key, "op")) {
+            payload->op = discord_json_reader_int(reader, -1);
+            has_op = true;
+        } else if(estr_eq(key, "s")) {
+            payload->s = discord_json_reader_int(reader, DISCORD_NULL_SEQUENCE_NUMBER);
+            payload->s = payload->s > 0 ? payload->s : DISCORD_NULL_SEQUENCE_NUMBER;
+        } else if(estr_eq(key, "t")) {
+            const char* t = discord_json_reader_string(reader, NULL);
+            payload->t = t ? discord_model_event_by_name(t) : DISCORD_EVENT_UNKNOWN;
+            has_t = true;
+        } else if(estr_eq(key, "d") && !payload->d && !data && has_op && (has_t || payload->op != DISCORD_OP_DISPATCH)) {
+            discord_json_read_arena_create(reader, payload, pool, len);
+            payload->d = discord_json_read_payload_data(reader, payload);
+        } else if(estr_eq(key, "d") && !payload->d && !data) {
+            // Discord sends "d" last, otherwise it is decoded once the op and the event are known
+            discord_json_reader_ws(reader);
+            data = reader->pos;
+            discord_json_reader_skip(reader);
+        } else {
+            discord_json_reader_skip(reader);
+        }
+    }
+
+    if(payload && data && !reader->error) {
+        discord_json_reader_t data_reader = *reader;
+        data_reader.pos = data;
+        data_reader.after_value = false;
+
+        discord_json_read_arena_create(&data_reader, payload, pool, len);
+        payload->d = discord_json_read_payload_data(&data_reader, payload);
+        reader->error = data_reader.error;
+    }
+
+    if(reader->error) {
+        DISCORD_LOGW("%s parsing (syntax?) error", reader->etf ? "ETF" : "JSON");
+
+        if(payload && (payload->d || payload->arena)) {
+            discord_payload_free(payload);
+        } else {
+            free(payload);
+        }
+
+        return NULL;
+    }
+
+    return payload;
+}
+
+discord_message_t* discord_json_read_message(char* json, size_t len) {
+    discord_json_reader_t reader;
+    discord_json_reader_init(&reader, json, len);
+
+    discord_message_t* message = discord_json_read_message_object(&reader);
+
+    if(reader.error) {
+        DISCORD_LOGW("JSON parsing (syntax?) error");
+        discord_message_free(message);
+        return NULL;
+    }
+
+    return message;
+}
+
+discord_member_t* discord_json_read_member(char* json, size_t len) {
+    discord_json_reader_t reader;
+    discord_json_reader_init(&reader, json, len);
+
+    discord_member_t* member = discord_json_read_member_object(&reader);
+
+    if(reader.error) {
+        DISCORD_LOGW("JSON parsing (syntax?) error");
+        discord_member_free(member);
+        return NULL;
+    }
+
+    return member;
+}
\ No newline at end of file
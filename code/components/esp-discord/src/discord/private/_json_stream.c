@@ -0,0 +1,1120 @@
+#include "discord/private/_json_stream.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "discord/private/_etf.h"
+
+#define _bit(depth) (1UL << ((depth) - 1))
+#define _is_array(stream) ((stream)->depth > 0 && ((stream)->arrays & _bit((stream)->depth)))
+
+#define DCJS_MEMBERS_DEPTH   (3)                   /* d.members array of GUILD_MEMBERS_CHUNK */
+#define DCJS_MEMBERS         (1 << 0)              /* Members are being scanned */
+#define DCJS_MEMBER_USER     (1 << 1)              /* Inside of member.user */
+#define DCJS_MEMBER_ROLES    (1 << 2)              /* Inside of member.roles */
+#define DCJS_MEMBER_VALID    (1 << 3)              /* Member can be cached */
+
+enum {
+    DCJS_MEMBER_VALUE_NONE,
+    DCJS_MEMBER_VALUE_USER,
+    DCJS_MEMBER_VALUE_ROLES,
+    DCJS_MEMBER_VALUE_USER_ID,
+    DCJS_MEMBER_VALUE_NICK,
+    DCJS_MEMBER_VALUE_ROLE
+};
+
+const char* const discord_json_stream_default_prune_keys[] = {
+    // GUILD_CREATE, GUILD_MEMBER_* (these two have to stay first and in this order, see discord_json_stream_member_cache_prune_keys)
+    "roles",
+    "channels",
+    // READY
+    "guilds",
+    "private_channels",
+    "relationships",
+    "presences",
+    "application",
+    "user_settings",
+    "user_guild_settings",
+    "guild_join_requests",
+    "geo_ordered_rtc_regions",
+    "auth",
+    "_trace",
+    // MESSAGE_*
+    "embeds",
+    "mentions",
+    "mention_roles",
+    "mention_channels",
+    "components",
+    "referenced_message",
+    "message_reference",
+    "sticker_items",
+    "reactions",
+    "interaction",
+    // GUILD_*
+    "members",
+    "threads",
+    "emojis",
+    "stickers",
+    "voice_states",
+    "guild_scheduled_events",
+    "stage_instances",
+    NULL
+};
+
+static bool dcjs_is_ws(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool dcjs_is_literal(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+static bool dcjs_emit(discord_json_stream_t* stream, char c) {
+    if(stream->skip_depth > 0) {
+        return true;
+    }
+
+    if(stream->len >= stream->size) {
+        return false;
+    }
+
+    stream->buffer[stream->len++] = c;
+    return true;
+}
+
+static bool dcjs_key_is_pruned(discord_json_stream_t* stream) {
+    if(!stream->prune_keys || !stream->key_matchable) {
+        return false;
+    }
+
+    for(const char* const* key = stream->prune_keys; *key; key++) {
+        if(strcmp(*key, stream->key) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Find out whether the value of the member with just received key needs to be captured
+ */
+static discord_json_stream_field_t dcjs_key_field(discord_json_stream_t* stream) {
+    if(!stream->key_matchable) {
+        return DISCORD_JSON_STREAM_FIELD_NONE;
+    }
+
+    const char* key = stream->key;
+
+    if(stream->depth == 1) {
+        if(strcmp(key, "op") == 0) return DISCORD_JSON_STREAM_FIELD_OP;
+        if(strcmp(key, "s") == 0) return DISCORD_JSON_STREAM_FIELD_S;
+        if(strcmp(key, "t") == 0) return DISCORD_JSON_STREAM_FIELD_T;
+    } else if(stream->depth == 2 && stream->in_data) {
+        if(strcmp(key, "type") == 0) return DISCORD_JSON_STREAM_FIELD_TYPE;
+        if(strcmp(key, "channel_id") == 0) return DISCORD_JSON_STREAM_FIELD_CHANNEL_ID;
+        if(strcmp(key, "guild_id") == 0) return DISCORD_JSON_STREAM_FIELD_GUILD_ID;
+        if(strcmp(key, "user_id") == 0) return DISCORD_JSON_STREAM_FIELD_USER_ID;
+    } else if(stream->depth == 3 && stream->in_author) {
+        if(strcmp(key, "id") == 0) return DISCORD_JSON_STREAM_FIELD_AUTHOR_ID;
+        if(strcmp(key, "bot") == 0) return DISCORD_JSON_STREAM_FIELD_AUTHOR_BOT;
+    }
+
+    return DISCORD_JSON_STREAM_FIELD_NONE;
+}
+
+static void dcjs_field_char(discord_json_stream_t* stream, char c) {
+    if(stream->field == DISCORD_JSON_STREAM_FIELD_NONE) {
+        return;
+    }
+
+    char* value = stream->fields[stream->field];
+
+    if(stream->field_len >= DISCORD_JSON_STREAM_FIELD_MAX) {
+        value[0] = '\0'; // too long to be captured
+        stream->field = DISCORD_JSON_STREAM_FIELD_NONE;
+        return;
+    }
+
+    value[stream->field_len++] = c;
+    value[stream->field_len] = '\0';
+}
+
+static void dcjs_member_invalid(discord_json_stream_t* stream) {
+    stream->member_scan &= ~DCJS_MEMBER_VALID;
+    stream->member_value = DCJS_MEMBER_VALUE_NONE;
+}
+
+/**
+ * @brief Find out which member value follows the just received key
+ */
+static void dcjs_member_key(discord_json_stream_t* stream) {
+    const char* key = stream->key_matchable ? stream->key : "";
+    stream->member_value = DCJS_MEMBER_VALUE_NONE;
+
+    if(stream->depth == DCJS_MEMBERS_DEPTH + 1) {
+        if(strcmp(key, "user") == 0) stream->member_value = DCJS_MEMBER_VALUE_USER;
+        else if(strcmp(key, "roles") == 0) stream->member_value = DCJS_MEMBER_VALUE_ROLES;
+        else if(strcmp(key, "nick") == 0) stream->member_value = DCJS_MEMBER_VALUE_NICK;
+    } else if(stream->depth == DCJS_MEMBERS_DEPTH + 2 && (stream->member_scan & DCJS_MEMBER_USER)) {
+        if(strcmp(key, "id") == 0) stream->member_value = DCJS_MEMBER_VALUE_USER_ID;
+    }
+}
+
+static void dcjs_member_open(discord_json_stream_t* stream) {
+    if(stream->depth == DCJS_MEMBERS_DEPTH + 1) {
+        stream->member_scan = DCJS_MEMBERS | DCJS_MEMBER_VALID;
+        stream->member.user_id = 0;
+        stream->member.roles_len = 0;
+        stream->member.has_nick = false;
+    } else if(stream->depth == DCJS_MEMBERS_DEPTH + 2) {
+        if(stream->member_value == DCJS_MEMBER_VALUE_USER) stream->member_scan |= DCJS_MEMBER_USER;
+        else if(stream->member_value == DCJS_MEMBER_VALUE_ROLES) stream->member_scan |= DCJS_MEMBER_ROLES;
+    }
+
+    stream->member_value = DCJS_MEMBER_VALUE_NONE;
+}
+
+static void dcjs_member_close(discord_json_stream_t* stream) {
+    if(stream->depth == DCJS_MEMBERS_DEPTH + 2) {
+        stream->member_scan &= ~(DCJS_MEMBER_USER | DCJS_MEMBER_ROLES);
+    } else if(stream->depth == DCJS_MEMBERS_DEPTH + 1 && (stream->member_scan & DCJS_MEMBER_VALID) && stream->member.user_id) {
+        stream->member_handler(stream->member_handler_arg, &stream->member);
+    }
+}
+
+static void dcjs_member_value_begin(discord_json_stream_t* stream, char c) {
+    if(c == '{' || c == '[') {
+        return; // see dcjs_member_open
+    }
+
+    if(stream->depth == DCJS_MEMBERS_DEPTH + 2 && (stream->member_scan & DCJS_MEMBER_ROLES)) {
+        if(stream->member.roles_len >= DISCORD_MEMBER_CACHE_ROLES_MAX) {
+            dcjs_member_invalid(stream); // too many roles to be cached
+            return;
+        }
+
+        stream->member_value = DCJS_MEMBER_VALUE_ROLE;
+        stream->member.roles[stream->member.roles_len] = 0;
+    }
+
+    if(stream->member_value == DCJS_MEMBER_VALUE_NONE) {
+        return;
+    }
+
+    if(c != '"') {
+        if(c == 'n' && stream->member_value == DCJS_MEMBER_VALUE_NICK) {
+            stream->member_value = DCJS_MEMBER_VALUE_NONE; // member without nick
+        } else {
+            dcjs_member_invalid(stream);
+        }
+
+        return;
+    }
+
+    if(stream->member_value == DCJS_MEMBER_VALUE_USER_ID) {
+        stream->member.user_id = 0;
+    } else if(stream->member_value == DCJS_MEMBER_VALUE_NICK) {
+        stream->member.has_nick = true;
+        stream->member.nick[0] = '\0';
+        stream->member_len = 0;
+    }
+}
+
+static void dcjs_member_char(discord_json_stream_t* stream, char c) {
+    uint64_t* id = NULL;
+
+    switch(stream->member_value) {
+        case DCJS_MEMBER_VALUE_USER_ID:
+            id = &stream->member.user_id;
+            break;
+
+        case DCJS_MEMBER_VALUE_ROLE:
+            id = &stream->member.roles[stream->member.roles_len];
+            break;
+
+        case DCJS_MEMBER_VALUE_NICK:
+            if(c == '\\' || stream->member_len >= DISCORD_MEMBER_CACHE_NICK_MAX) {
+                dcjs_member_invalid(stream); // nick is cached only as it is
+                return;
+            }
+
+            stream->member.nick[stream->member_len++] = c;
+            stream->member.nick[stream->member_len] = '\0';
+            return;
+
+        default:
+            return;
+    }
+
+    if(c < '0' || c > '9') {
+        dcjs_member_invalid(stream);
+        return;
+    }
+
+    *id = *id * 10 + (c - '0');
+}
+
+static void dcjs_value_end(discord_json_stream_t* stream) {
+    stream->field = DISCORD_JSON_STREAM_FIELD_NONE;
+
+    if(stream->member_value == DCJS_MEMBER_VALUE_ROLE) {
+        stream->member.roles_len++;
+    }
+
+    stream->member_value = DCJS_MEMBER_VALUE_NONE;
+
+    if(stream->skip_depth > 0 && stream->depth == stream->skip_depth) {
+        stream->skip_depth = 0;
+        stream->member_scan = 0;
+    }
+
+    stream->state = stream->depth == 0 ? DISCORD_JSON_STREAM_DONE : DISCORD_JSON_STREAM_AFTER_VALUE;
+}
+
+static esp_err_t dcjs_open(discord_json_stream_t* stream, char c) {
+    if(stream->depth >= DISCORD_JSON_STREAM_MAX_DEPTH) {
+        return ESP_FAIL;
+    }
+
+    if(!dcjs_emit(stream, c)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    stream->depth++;
+    stream->members &= ~_bit(stream->depth);
+
+    if(stream->member_scan) {
+        dcjs_member_open(stream);
+    }
+
+    if(c == '[') {
+        stream->arrays |= _bit(stream->depth);
+        stream->state = DISCORD_JSON_STREAM_VALUE_OR_END;
+    } else {
+        stream->arrays &= ~_bit(stream->depth);
+        stream->state = DISCORD_JSON_STREAM_KEY_OR_END;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t dcjs_close(discord_json_stream_t* stream, char c) {
+    if(stream->depth == 0 || (c == ']') != _is_array(stream)) {
+        return ESP_FAIL;
+    }
+
+    if(!dcjs_emit(stream, c)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if(stream->member_scan) {
+        dcjs_member_close(stream);
+    }
+
+    if(--stream->depth == 0) {
+        stream->in_data = false;
+    }
+
+    dcjs_value_end(stream);
+    return ESP_OK;
+}
+
+static esp_err_t dcjs_value_begin(discord_json_stream_t* stream, char c) {
+    if(_is_array(stream)) {
+        if((stream->members & _bit(stream->depth)) && !dcjs_emit(stream, ',')) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        stream->members |= _bit(stream->depth);
+    }
+
+    if(stream->member_scan) {
+        dcjs_member_value_begin(stream, c);
+    }
+
+    if(c == '{' || c == '[') {
+        stream->field = DISCORD_JSON_STREAM_FIELD_NONE;
+        return dcjs_open(stream, c);
+    }
+
+    if(c == '"') {
+        stream->state = DISCORD_JSON_STREAM_STRING;
+    } else if(c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f') {
+        stream->state = DISCORD_JSON_STREAM_LITERAL;
+        dcjs_field_char(stream, c);
+    } else if(c == 'n') {
+        stream->state = DISCORD_JSON_STREAM_LITERAL;
+        stream->field = DISCORD_JSON_STREAM_FIELD_NONE; // nulls are not captured
+    } else {
+        return ESP_FAIL;
+    }
+
+    return dcjs_emit(stream, c) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+static esp_err_t dcjs_key_begin(discord_json_stream_t* stream) {
+    stream->key_len = 0;
+    stream->key_matchable = true;
+    stream->key_pending = true;
+    stream->state = DISCORD_JSON_STREAM_KEY_STRING;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Write the key which has been held back until it was known whether the member is going to be retained
+ */
+static esp_err_t dcjs_key_flush(discord_json_stream_t* stream) {
+    stream->key_pending = false;
+
+    if(stream->skip_depth > 0) {
+        return ESP_OK;
+    }
+
+    if((stream->members & _bit(stream->depth)) && !dcjs_emit(stream, ',')) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    stream->members |= _bit(stream->depth);
+
+    if(!dcjs_emit(stream, '"')) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    for(uint8_t i = 0; i < stream->key_len; i++) {
+        if(!dcjs_emit(stream, stream->key[i])) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t dcjs_key_char(discord_json_stream_t* stream, char c) {
+    if(!stream->key_pending) {
+        return dcjs_emit(stream, c) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+    }
+
+    if(stream->key_len < DISCORD_JSON_STREAM_KEY_MAX) {
+        stream->key[stream->key_len++] = c;
+        return ESP_OK;
+    }
+
+    // key is too long to be held back
+    stream->key_matchable = false;
+    esp_err_t err = dcjs_key_flush(stream);
+
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    return dcjs_emit(stream, c) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+/**
+ * @brief Find out what happens with the value of the member with just received key
+ * @return true if the member is pruned, its value is skipped then
+ */
+static bool dcjs_key_match(discord_json_stream_t* stream) {
+    stream->key[stream->key_len] = '\0';
+
+    if(stream->skip_depth > 0) {
+        if(stream->member_scan) {
+            dcjs_member_key(stream);
+        }
+
+        return false;
+    }
+
+    stream->field = dcjs_key_field(stream);
+    stream->field_len = 0;
+
+    if(stream->field != DISCORD_JSON_STREAM_FIELD_NONE) {
+        stream->fields[stream->field][0] = '\0';
+    }
+
+    if(stream->depth == 1) {
+        stream->in_data = stream->key_matchable && strcmp(stream->key, "d") == 0;
+        stream->in_author = false;
+    } else if(stream->depth == 2 && stream->in_data) {
+        stream->in_author = stream->key_matchable && strcmp(stream->key, "author") == 0;
+    }
+
+    if(stream->depth == 2 && stream->in_data && dcjs_key_is_pruned(stream)) {
+        stream->skip_depth = stream->depth;
+
+        // ETF map keys are sorted, so "t" arrives after "d" and the event is not known yet
+        const char* t = stream->fields[DISCORD_JSON_STREAM_FIELD_T];
+
+        if(stream->member_handler && strcmp(stream->key, "members") == 0 && (t[0] == '\0' || strcmp(t, "GUILD_MEMBERS_CHUNK") == 0)) {
+            stream->member_scan = DCJS_MEMBERS;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+static esp_err_t dcjs_key_end(discord_json_stream_t* stream) {
+    stream->state = DISCORD_JSON_STREAM_VALUE;
+    dcjs_key_match(stream);
+
+    if(stream->skip_depth > 0) {
+        // key of skipped (or pruned) member has never been written, just skip the value
+        stream->key_pending = false;
+        return ESP_OK;
+    }
+
+    if(stream->key_pending) {
+        esp_err_t err = dcjs_key_flush(stream);
+
+        if(err != ESP_OK) {
+            return err;
+        }
+
+        if(!dcjs_emit(stream, '"')) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    return dcjs_emit(stream, ':') ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+static esp_err_t dcjs_process(discord_json_stream_t* stream, char c) {
+    switch(stream->state) {
+        case DISCORD_JSON_STREAM_VALUE_OR_END:
+            if(c == ']') {
+                return dcjs_close(stream, c);
+            }
+            // fall through
+
+        case DISCORD_JSON_STREAM_VALUE:
+            return dcjs_is_ws(c) ? ESP_OK : dcjs_value_begin(stream, c);
+
+        case DISCORD_JSON_STREAM_KEY_OR_END:
+            if(c == '}') {
+                return dcjs_close(stream, c);
+            }
+            // fall through
+
+        case DISCORD_JSON_STREAM_KEY:
+            if(dcjs_is_ws(c)) {
+                return ESP_OK;
+            }
+
+            return c == '"' ? dcjs_key_begin(stream) : ESP_FAIL;
+
+        case DISCORD_JSON_STREAM_KEY_STRING:
+            if(c == '"') {
+                stream->state = DISCORD_JSON_STREAM_COLON;
+
+                if(stream->key_pending) {
+                    return ESP_OK; // closing quote is written together with the key
+                }
+            } else if(c == '\\') {
+                stream->key_matchable = false;
+                stream->state = DISCORD_JSON_STREAM_KEY_STRING_ESC;
+            }
+
+            return dcjs_key_char(stream, c);
+
+        case DISCORD_JSON_STREAM_KEY_STRING_ESC:
+            stream->state = DISCORD_JSON_STREAM_KEY_STRING;
+            return dcjs_key_char(stream, c);
+
+        case DISCORD_JSON_STREAM_COLON:
+            if(dcjs_is_ws(c)) {
+                return ESP_OK;
+            }
+
+            return c == ':' ? dcjs_key_end(stream) : ESP_FAIL;
+
+        case DISCORD_JSON_STREAM_STRING:
+            if(!dcjs_emit(stream, c)) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+
+            if(c == '"') {
+                dcjs_value_end(stream);
+                return ESP_OK;
+            }
+
+            if(c == '\\') {
+                stream->state = DISCORD_JSON_STREAM_STRING_ESC;
+            }
+
+            if(stream->member_value != DCJS_MEMBER_VALUE_NONE) {
+                dcjs_member_char(stream, c);
+            }
+
+            dcjs_field_char(stream, c);
+            return ESP_OK;
+
+        case DISCORD_JSON_STREAM_STRING_ESC:
+            stream->state = DISCORD_JSON_STREAM_STRING;
+            dcjs_field_char(stream, c);
+            return dcjs_emit(stream, c) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+
+        case DISCORD_JSON_STREAM_LITERAL:
+            if(dcjs_is_literal(c)) {
+                dcjs_field_char(stream, c);
+                return dcjs_emit(stream, c) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+            }
+
+            dcjs_value_end(stream);
+            return dcjs_process(stream, c); // delimiter belongs to the next state
+
+        case DISCORD_JSON_STREAM_AFTER_VALUE:
+            if(dcjs_is_ws(c)) {
+                return ESP_OK;
+            }
+
+            if(c == ',') {
+                stream->state = _is_array(stream) ? DISCORD_JSON_STREAM_VALUE : DISCORD_JSON_STREAM_KEY;
+                return ESP_OK;
+            }
+
+            if(c == '}' || c == ']') {
+                return dcjs_close(stream, c);
+            }
+
+            return ESP_FAIL;
+
+        case DISCORD_JSON_STREAM_DONE:
+            return dcjs_is_ws(c) ? ESP_OK : ESP_FAIL;
+
+        default:
+            return ESP_FAIL;
+    }
+}
+
+// ETF
+
+static bool dcjs_etf_is_atom(uint8_t tag) {
+    return tag == DISCORD_ETF_ATOM || tag == DISCORD_ETF_ATOM_UTF8 || tag == DISCORD_ETF_SMALL_ATOM || tag == DISCORD_ETF_SMALL_ATOM_UTF8;
+}
+
+static bool dcjs_etf_is_text(uint8_t tag) {
+    return tag == DISCORD_ETF_BINARY || tag == DISCORD_ETF_STRING || dcjs_etf_is_atom(tag);
+}
+
+static bool dcjs_etf_is_integer(uint8_t tag) {
+    return tag == DISCORD_ETF_SMALL_INTEGER || tag == DISCORD_ETF_INTEGER || tag == DISCORD_ETF_SMALL_BIG || tag == DISCORD_ETF_LARGE_BIG;
+}
+
+static bool dcjs_etf_is_container(uint8_t tag) {
+    return tag == DISCORD_ETF_MAP || tag == DISCORD_ETF_LIST || tag == DISCORD_ETF_NIL ||
+        tag == DISCORD_ETF_SMALL_TUPLE || tag == DISCORD_ETF_LARGE_TUPLE;
+}
+
+/**
+ * @return Number of header (length or arity) bytes which follow the tag or -1 if term is not supported
+ */
+static int dcjs_etf_header_len(uint8_t tag) {
+    switch(tag) {
+        case DISCORD_ETF_SMALL_INTEGER:
+        case DISCORD_ETF_INTEGER:
+        case DISCORD_ETF_NEW_FLOAT:
+        case DISCORD_ETF_FLOAT:
+        case DISCORD_ETF_NIL:
+            return 0;
+
+        case DISCORD_ETF_SMALL_BIG:
+        case DISCORD_ETF_SMALL_TUPLE:
+        case DISCORD_ETF_SMALL_ATOM:
+        case DISCORD_ETF_SMALL_ATOM_UTF8:
+            return 1;
+
+        case DISCORD_ETF_STRING:
+        case DISCORD_ETF_ATOM:
+        case DISCORD_ETF_ATOM_UTF8:
+            return 2;
+
+        case DISCORD_ETF_LARGE_BIG:
+        case DISCORD_ETF_LARGE_TUPLE:
+        case DISCORD_ETF_LIST:
+        case DISCORD_ETF_MAP:
+        case DISCORD_ETF_BINARY:
+            return 4;
+
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Key is written before it is known whether its member is retained, so overflow is checked once it is known (see dcjs_etf_key_end)
+ */
+static bool dcjs_etf_emit(discord_json_stream_t* stream, uint8_t c) {
+    if(!stream->etf_key) {
+        return dcjs_emit(stream, (char) c);
+    }
+
+    if(stream->skip_depth == 0) {
+        if(stream->len < stream->size) {
+            stream->buffer[stream->len] = c;
+        }
+
+        stream->len++;
+    }
+
+    return true;
+}
+
+static void dcjs_etf_member_value_begin(discord_json_stream_t* stream, uint8_t tag) {
+    if(dcjs_etf_is_container(tag)) {
+        return; // see dcjs_member_open
+    }
+
+    if(stream->depth == DCJS_MEMBERS_DEPTH + 2 && (stream->member_scan & DCJS_MEMBER_ROLES)) {
+        if(stream->member.roles_len >= DISCORD_MEMBER_CACHE_ROLES_MAX) {
+            dcjs_member_invalid(stream); // too many roles to be cached
+            return;
+        }
+
+        stream->member_value = DCJS_MEMBER_VALUE_ROLE;
+        stream->member.roles[stream->member.roles_len] = 0;
+    }
+
+    if(stream->member_value == DCJS_MEMBER_VALUE_NONE) {
+        return;
+    }
+
+    if(stream->member_value == DCJS_MEMBER_VALUE_NICK) {
+        if(dcjs_etf_is_atom(tag)) {
+            stream->member_value = DCJS_MEMBER_VALUE_NONE; // member without nick
+        } else if(!dcjs_etf_is_text(tag)) {
+            dcjs_member_invalid(stream);
+        } else {
+            stream->member.has_nick = true;
+            stream->member.nick[0] = '\0';
+            stream->member_len = 0;
+        }
+
+        return;
+    }
+
+    // ids are big integers, strings are accepted as well
+    if(tag != DISCORD_ETF_SMALL_BIG && tag != DISCORD_ETF_LARGE_BIG && (!dcjs_etf_is_text(tag) || dcjs_etf_is_atom(tag))) {
+        dcjs_member_invalid(stream);
+    } else if(stream->member_value == DCJS_MEMBER_VALUE_USER_ID) {
+        stream->member.user_id = 0;
+    }
+}
+
+static void dcjs_etf_close(discord_json_stream_t* stream) {
+    if(stream->member_scan) {
+        dcjs_member_close(stream);
+    }
+
+    if(stream->depth == 2 && stream->etf_arity_at > 0) {
+        // "d" map is written with arity it has been received with
+        uint32_t arity = stream->etf_arity - stream->etf_pruned;
+        uint8_t* p = (uint8_t*) stream->buffer + stream->etf_arity_at;
+
+        p[0] = arity >> 24;
+        p[1] = arity >> 16;
+        p[2] = arity >> 8;
+        p[3] = arity;
+        stream->etf_arity_at = 0;
+    }
+
+    if(--stream->depth == 0) {
+        stream->in_data = false;
+    }
+
+    dcjs_value_end(stream);
+}
+
+/**
+ * @brief Close containers whose last term has just ended
+ */
+static void dcjs_etf_close_finished(discord_json_stream_t* stream) {
+    while(stream->depth > 0 && stream->etf_left[stream->depth - 1] == 0) {
+        dcjs_etf_close(stream);
+    }
+
+    stream->state = stream->depth == 0 ? DISCORD_JSON_STREAM_DONE : DISCORD_JSON_STREAM_ETF_TAG;
+}
+
+static esp_err_t dcjs_etf_open(discord_json_stream_t* stream, uint32_t terms, bool array) {
+    if(stream->depth >= DISCORD_JSON_STREAM_MAX_DEPTH) {
+        return ESP_FAIL;
+    }
+
+    stream->depth++;
+    stream->etf_left[stream->depth - 1] = terms;
+
+    if(array) {
+        stream->arrays |= _bit(stream->depth);
+    } else {
+        stream->arrays &= ~_bit(stream->depth);
+    }
+
+    if(stream->member_scan) {
+        dcjs_member_open(stream);
+    }
+
+    if(!array && stream->depth == 2 && stream->in_data && stream->skip_depth == 0) {
+        stream->etf_arity_at = stream->len - 4;
+        stream->etf_arity = stream->etf_n;
+        stream->etf_pruned = 0;
+    }
+
+    dcjs_etf_close_finished(stream); // empty container ends right away
+    return ESP_OK;
+}
+
+static esp_err_t dcjs_etf_key_end(discord_json_stream_t* stream) {
+    stream->etf_key = false;
+
+    if(dcjs_key_match(stream)) {
+        // key has been written already, remove it and skip the value
+        stream->len = stream->etf_key_start;
+        stream->etf_pruned++;
+        return ESP_OK;
+    }
+
+    return stream->len <= stream->size ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+static void dcjs_etf_value_end(discord_json_stream_t* stream) {
+    if(dcjs_etf_is_integer(stream->etf_tag)) {
+        if(stream->etf_tag == DISCORD_ETF_INTEGER && (stream->etf_value & 0x80000000)) {
+            stream->etf_negative = true;
+            stream->etf_value = 0x100000000ULL - stream->etf_value;
+        }
+
+        if(stream->field != DISCORD_JSON_STREAM_FIELD_NONE) {
+            snprintf(stream->fields[stream->field], DISCORD_JSON_STREAM_FIELD_MAX + 1, "%s%llu", stream->etf_negative ? "-" : "", (unsigned long long) stream->etf_value);
+        }
+
+        if(stream->member_value == DCJS_MEMBER_VALUE_USER_ID) {
+            stream->member.user_id = stream->etf_value;
+        } else if(stream->member_value == DCJS_MEMBER_VALUE_ROLE) {
+            stream->member.roles[stream->member.roles_len] = stream->etf_value;
+        }
+    } else if(stream->field != DISCORD_JSON_STREAM_FIELD_NONE && dcjs_etf_is_atom(stream->etf_tag) && strcmp(stream->fields[stream->field], "nil") == 0) {
+        stream->fields[stream->field][0] = '\0'; // nulls are not captured
+    }
+
+    dcjs_value_end(stream);
+}
+
+static esp_err_t dcjs_etf_term_end(discord_json_stream_t* stream) {
+    if(stream->etf_key) {
+        stream->state = DISCORD_JSON_STREAM_ETF_TAG;
+        return dcjs_etf_key_end(stream);
+    }
+
+    dcjs_etf_value_end(stream);
+    dcjs_etf_close_finished(stream);
+
+    return ESP_OK;
+}
+
+static esp_err_t dcjs_etf_header_end(discord_json_stream_t* stream) {
+    uint32_t n = stream->etf_n;
+
+    switch(stream->etf_tag) {
+        case DISCORD_ETF_SMALL_TUPLE:
+        case DISCORD_ETF_LARGE_TUPLE:
+            return dcjs_etf_open(stream, n, true);
+
+        case DISCORD_ETF_LIST:
+            return n < UINT32_MAX ? dcjs_etf_open(stream, n + 1, true) : ESP_FAIL; // list ends with a tail
+
+        case DISCORD_ETF_MAP:
+            return n <= UINT32_MAX / 2 ? dcjs_etf_open(stream, 2 * n, false) : ESP_FAIL; // key and value of each member
+
+        case DISCORD_ETF_NIL:
+            return dcjs_etf_term_end(stream);
+
+        case DISCORD_ETF_SMALL_INTEGER: n = 1; break;
+        case DISCORD_ETF_INTEGER: n = 4; break;
+        case DISCORD_ETF_NEW_FLOAT: n = 8; break;
+        case DISCORD_ETF_FLOAT: n = 31; break;
+
+        case DISCORD_ETF_SMALL_BIG:
+        case DISCORD_ETF_LARGE_BIG:
+            if(n > sizeof(uint64_t)) {
+                // no such numbers in Discord payloads
+                stream->field = DISCORD_JSON_STREAM_FIELD_NONE;
+
+                if(stream->member_value != DCJS_MEMBER_VALUE_NONE) {
+                    dcjs_member_invalid(stream);
+                }
+            }
+
+            if(n == UINT32_MAX) {
+                return ESP_FAIL;
+            }
+
+            n++; // sign and digits
+            break;
+
+        default:
+            break; // text
+    }
+
+    stream->etf_body_len = n;
+    stream->state = DISCORD_JSON_STREAM_ETF_BODY;
+
+    return n > 0 ? ESP_OK : dcjs_etf_term_end(stream);
+}
+
+static esp_err_t dcjs_etf_tag(discord_json_stream_t* stream, uint8_t tag) {
+    int header_len = dcjs_etf_header_len(tag);
+
+    if(header_len < 0) {
+        return ESP_FAIL;
+    }
+
+    stream->etf_key = false;
+
+    if(stream->depth > 0) {
+        // map holds key and value of each member, so even number of expected terms means key
+        stream->etf_key = !_is_array(stream) && stream->etf_left[stream->depth - 1] % 2 == 0;
+        stream->etf_left[stream->depth - 1]--;
+    }
+
+    if(stream->etf_key) {
+        if(dcjs_etf_is_container(tag)) {
+            return ESP_FAIL; // Discord keys are atoms
+        }
+
+        stream->etf_key_start = stream->len;
+        stream->key_len = 0;
+        stream->key_matchable = dcjs_etf_is_text(tag);
+    } else {
+        if(stream->member_scan) {
+            dcjs_etf_member_value_begin(stream, tag);
+        }
+
+        if(!dcjs_etf_is_text(tag) && !dcjs_etf_is_integer(tag)) {
+            stream->field = DISCORD_JSON_STREAM_FIELD_NONE; // only strings and numbers are captured
+        }
+    }
+
+    stream->etf_tag = tag;
+    stream->etf_header_len = header_len;
+    stream->etf_n = 0;
+    stream->etf_value = 0;
+    stream->etf_negative = false;
+
+    if(!dcjs_etf_emit(stream, tag)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    stream->state = DISCORD_JSON_STREAM_ETF_HEADER;
+    return header_len > 0 ? ESP_OK : dcjs_etf_header_end(stream);
+}
+
+static void dcjs_etf_body_char(discord_json_stream_t* stream, uint8_t c) {
+    if(stream->etf_key) {
+        if(stream->key_len < DISCORD_JSON_STREAM_KEY_MAX) {
+            stream->key[stream->key_len++] = c;
+        } else {
+            stream->key_matchable = false;
+        }
+
+        return;
+    }
+
+    switch(stream->etf_tag) {
+        case DISCORD_ETF_SMALL_INTEGER:
+        case DISCORD_ETF_INTEGER:
+            stream->etf_value = (stream->etf_value << 8) | c;
+            return;
+
+        case DISCORD_ETF_SMALL_BIG:
+        case DISCORD_ETF_LARGE_BIG: {
+                // sign is followed by digits, least significant first
+                uint32_t i = stream->etf_n + 1 - stream->etf_body_len;
+
+                if(i == 0) {
+                    stream->etf_negative = c != 0;
+                } else if(i <= sizeof(uint64_t)) {
+                    stream->etf_value |= (uint64_t) c << (8 * (i - 1));
+                }
+
+                return;
+            }
+
+        case DISCORD_ETF_NEW_FLOAT:
+        case DISCORD_ETF_FLOAT:
+            return;
+
+        default:
+            break;
+    }
+
+    dcjs_field_char(stream, c);
+
+    if(stream->member_value == DCJS_MEMBER_VALUE_NICK) {
+        // unlike JSON, text is not escaped, so nick is cached as it is
+        if(stream->member_len >= DISCORD_MEMBER_CACHE_NICK_MAX) {
+            dcjs_member_invalid(stream);
+            return;
+        }
+
+        stream->member.nick[stream->member_len++] = c;
+        stream->member.nick[stream->member_len] = '\0';
+    } else if(stream->member_value != DCJS_MEMBER_VALUE_NONE) {
+        dcjs_member_char(stream, c);
+    }
+}
+
+static esp_err_t dcjs_etf_process(discord_json_stream_t* stream, uint8_t c) {
+    switch(stream->state) {
+        case DISCORD_JSON_STREAM_ETF_VERSION:
+            if(c != DISCORD_ETF_VERSION) {
+                return ESP_FAIL;
+            }
+
+            stream->state = DISCORD_JSON_STREAM_ETF_TAG;
+            return dcjs_emit(stream, (char) c) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+
+        case DISCORD_JSON_STREAM_ETF_TAG:
+            return dcjs_etf_tag(stream, c);
+
+        case DISCORD_JSON_STREAM_ETF_HEADER:
+            if(!dcjs_etf_emit(stream, c)) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+
+            stream->etf_n = (stream->etf_n << 8) | c;
+            return --stream->etf_header_len == 0 ? dcjs_etf_header_end(stream) : ESP_OK;
+
+        case DISCORD_JSON_STREAM_ETF_BODY:
+            if(!dcjs_etf_emit(stream, c)) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+
+            dcjs_etf_body_char(stream, c);
+            return --stream->etf_body_len == 0 ? dcjs_etf_term_end(stream) : ESP_OK;
+
+        default:
+            return ESP_FAIL; // data after the term
+    }
+}
+
+/**
+ * @brief Text which nothing is captured from is copied (or skipped) at once, message content is most of the payload
+ */
+static esp_err_t dcjs_etf_feed(discord_json_stream_t* stream, const uint8_t* data, size_t len) {
+    for(size_t i = 0; i < len;) {
+        esp_err_t err;
+
+        if(stream->state == DISCORD_JSON_STREAM_ETF_BODY && !stream->etf_key && dcjs_etf_is_text(stream->etf_tag) &&
+           stream->field == DISCORD_JSON_STREAM_FIELD_NONE && stream->member_value == DCJS_MEMBER_VALUE_NONE) {
+            size_t n = len - i < stream->etf_body_len ? len - i : stream->etf_body_len;
+
+            if(stream->skip_depth == 0) {
+                if(n > stream->size - stream->len) {
+                    return ESP_ERR_INVALID_SIZE;
+                }
+
+                memcpy(stream->buffer + stream->len, data + i, n);
+                stream->len += n;
+            }
+
+            i += n;
+            stream->etf_body_len -= n;
+            err = stream->etf_body_len == 0 ? dcjs_etf_term_end(stream) : ESP_OK;
+        } else {
+            err = dcjs_etf_process(stream, data[i++]);
+        }
+
+        if(err != ESP_OK) {
+            return err;
+        }
+    }
+
+    return ESP_OK;
+}
+
+void discord_json_stream_reset(discord_json_stream_t* stream) {
+    if(!stream)
+        return;
+
+    stream->len = 0;
+    stream->state = stream->etf ? DISCORD_JSON_STREAM_ETF_VERSION : DISCORD_JSON_STREAM_VALUE;
+    stream->depth = 0;
+    stream->skip_depth = 0;
+    stream->arrays = 0;
+    stream->members = 0;
+    stream->in_data = false;
+    stream->key_len = 0;
+    stream->key_matchable = false;
+    stream->key_pending = false;
+    stream->in_author = false;
+    stream->field = DISCORD_JSON_STREAM_FIELD_NONE;
+    stream->field_len = 0;
+    stream->member_scan = 0;
+    stream->member_value = DCJS_MEMBER_VALUE_NONE;
+    stream->etf_key = false;
+    stream->etf_arity_at = 0;
+    stream->etf_pruned = 0;
+
+    for(int i = 0; i < _DISCORD_JSON_STREAM_FIELD_COUNT; i++) {
+        stream->fields[i][0] = '\0';
+    }
+}
+
+esp_err_t discord_json_stream_feed(discord_json_stream_t* stream, const char* data, size_t len) {
+    if(!stream || !stream->buffer || (!data && len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(stream->state == DISCORD_JSON_STREAM_ERROR) {
+        return ESP_FAIL;
+    }
+
+    if(stream->etf) {
+        esp_err_t err = dcjs_etf_feed(stream, (const uint8_t*) data, len);
+
+        if(err != ESP_OK) {
+            stream->state = DISCORD_JSON_STREAM_ERROR;
+        }
+
+        return err;
+    }
+
+    for(size_t i = 0; i < len; i++) {
+        esp_err_t err = dcjs_process(stream, data[i]);
+
+        if(err != ESP_OK) {
+            stream->state = DISCORD_JSON_STREAM_ERROR;
+            return err;
+        }
+    }
+
+    return ESP_OK;
+}
+
+bool discord_json_stream_is_done(discord_json_stream_t* stream) {
+    if(!stream)
+        return false;
+
+    // top-level literal is terminated only by the end of the payload
+    if(stream->state == DISCORD_JSON_STREAM_LITERAL && stream->depth == 0) {
+        dcjs_value_end(stream);
+    }
+
+    return stream->state == DISCORD_JSON_STREAM_DONE;
+}
+
+const char* discord_json_stream_get_field(discord_json_stream_t* stream, discord_json_stream_field_t field) {
+    if(!stream || field <= DISCORD_JSON_STREAM_FIELD_NONE || field >= _DISCORD_JSON_STREAM_FIELD_COUNT)
+        return NULL;
+
+    return stream->fields[field][0] != '\0' ? stream->fields[field] : NULL;
+}
+
+int discord_json_stream_get_int_field(discord_json_stream_t* stream, discord_json_stream_field_t field, int default_value) {
+    const char* value = discord_json_stream_get_field(stream, field);
+
+    return value ? atoi(value) : default_value;
+}
\ No newline at end of file
@@ -0,0 +1,294 @@
+#include "discord/private/_member_cache.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DISCORD_MEMBER_CACHE_ID_SIZE (21) /*<! Longest uint64 has 20 digits */
+
+typedef discord_member_cache_entry_t entry_t;
+
+static uint64_t discord_member_cache_id(const char* id) {
+    return id ? strtoull(id, NULL, 10) : 0;
+}
+
+static char* discord_member_cache_id_str(uint64_t id) {
+    char buffer[DISCORD_MEMBER_CACHE_ID_SIZE];
+    snprintf(buffer, sizeof(buffer), "%" PRIu64, id);
+    return strdup(buffer);
+}
+
+static const char* discord_member_cache_nick(const entry_t* entry) {
+    return (const char*) &entry->roles[entry->roles_len];
+}
+
+static size_t discord_member_cache_entry_size(uint8_t roles_len, const char* nick) {
+    return sizeof(entry_t) + roles_len * sizeof(uint64_t) + strlen(nick) + 1;
+}
+
+static entry_t** discord_member_cache_link(discord_member_cache_t* cache, uint64_t guild_id, uint64_t user_id) {
+    for(entry_t** link = &cache->members; *link; link = &(*link)->next) {
+        if((*link)->user_id == user_id && (*link)->guild_id == guild_id) {
+            return link;
+        }
+    }
+
+    return NULL;
+}
+
+static void discord_member_cache_unlink(discord_member_cache_t* cache, entry_t** link) {
+    entry_t* entry = *link;
+    *link = entry->next;
+    cache->size -= discord_member_cache_entry_size(entry->roles_len, discord_member_cache_nick(entry));
+    free(entry);
+}
+
+static void discord_member_cache_evict(discord_member_cache_t* cache) {
+    while(cache->size > cache->limit) {
+        entry_t** link = &cache->members;
+
+        while((*link)->next) {
+            link = &(*link)->next;
+        }
+
+        discord_member_cache_unlink(cache, link);
+        cache->evictions++;
+    }
+}
+
+/**
+ * @brief Make the entry the most recently used member of the guild, replacing the cached one
+ */
+static void discord_member_cache_insert(discord_member_cache_t* cache, uint64_t guild_id, entry_t* entry) {
+    entry_t** link = discord_member_cache_link(cache, guild_id, entry->user_id);
+
+    if(link) {
+        discord_member_cache_unlink(cache, link);
+    }
+
+    entry->guild_id = guild_id;
+    entry->next = cache->members;
+    cache->members = entry;
+    cache->size += discord_member_cache_entry_size(entry->roles_len, discord_member_cache_nick(entry));
+}
+
+/**
+ * @param out_entry Entry with guild_id 0, NULL if record does not fit into the limit
+ */
+static esp_err_t discord_member_cache_entry_create(discord_member_cache_t* cache, const discord_member_record_t* record, entry_t** out_entry) {
+    const char* nick = record->has_nick ? record->nick : "";
+    size_t size = discord_member_cache_entry_size(record->roles_len, nick);
+    *out_entry = NULL;
+
+    if(size > cache->limit) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    entry_t* entry = malloc(size);
+
+    if(!entry) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    entry->next = NULL;
+    entry->guild_id = 0;
+    entry->user_id = record->user_id;
+    entry->roles_len = record->roles_len;
+    entry->has_nick = record->has_nick;
+    memcpy(entry->roles, record->roles, record->roles_len * sizeof(uint64_t));
+    strcpy((char*) discord_member_cache_nick(entry), nick);
+    *out_entry = entry;
+
+    return ESP_OK;
+}
+
+void discord_member_cache_init(discord_member_cache_t* cache, size_t limit) {
+    *cache = (discord_member_cache_t) {
+        .limit = limit
+    };
+}
+
+esp_err_t discord_member_cache_put(discord_member_cache_t* cache, const char* guild_id, const discord_member_record_t* record) {
+    uint64_t gid = discord_member_cache_id(guild_id);
+
+    if(!cache || !gid || !record || !record->user_id || record->roles_len > DISCORD_MEMBER_CACHE_ROLES_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    entry_t** link = discord_member_cache_link(cache, gid, record->user_id);
+
+    if(link) {
+        discord_member_cache_unlink(cache, link);
+    }
+
+    entry_t* entry;
+    esp_err_t err = discord_member_cache_entry_create(cache, record, &entry);
+
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    discord_member_cache_insert(cache, gid, entry);
+    discord_member_cache_evict(cache);
+
+    return ESP_OK;
+}
+
+esp_err_t discord_member_cache_stage(discord_member_cache_t* cache, const discord_member_record_t* record) {
+    if(!cache || !record || !record->user_id || record->roles_len > DISCORD_MEMBER_CACHE_ROLES_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    entry_t* entry;
+    esp_err_t err = discord_member_cache_entry_create(cache, record, &entry);
+
+    if(err != ESP_OK) {
+        return err;
+    }
+
+    if(cache->staged_last) {
+        cache->staged_last->next = entry;
+    } else {
+        cache->staged = entry;
+    }
+
+    cache->staged_last = entry;
+    cache->staged_size += discord_member_cache_entry_size(entry->roles_len, discord_member_cache_nick(entry));
+
+    while(cache->staged_size > cache->limit) {
+        entry_t* oldest = cache->staged;
+        cache->staged = oldest->next;
+        cache->staged_size -= discord_member_cache_entry_size(oldest->roles_len, discord_member_cache_nick(oldest));
+        free(oldest);
+        cache->evictions++;
+    }
+
+    return ESP_OK;
+}
+
+void discord_member_cache_commit(discord_member_cache_t* cache, const char* guild_id) {
+    uint64_t gid = discord_member_cache_id(guild_id);
+
+    if(!cache || !gid) {
+        discord_member_cache_drop_staged(cache);
+        return;
+    }
+
+    while(cache->staged) {
+        entry_t* entry = cache->staged;
+        cache->staged = entry->next;
+        discord_member_cache_insert(cache, gid, entry);
+    }
+
+    cache->staged_last = NULL;
+    cache->staged_size = 0;
+    discord_member_cache_evict(cache);
+}
+
+void discord_member_cache_drop_staged(discord_member_cache_t* cache) {
+    if(!cache) {
+        return;
+    }
+
+    while(cache->staged) {
+        entry_t* entry = cache->staged;
+        cache->staged = entry->next;
+        free(entry);
+    }
+
+    cache->staged_last = NULL;
+    cache->staged_size = 0;
+}
+
+void discord_member_cache_remove(discord_member_cache_t* cache, const char* guild_id, const char* user_id) {
+    if(!cache || !guild_id || !user_id) {
+        return;
+    }
+
+    entry_t** link = discord_member_cache_link(cache, discord_member_cache_id(guild_id), discord_member_cache_id(user_id));
+
+    if(link) {
+        discord_member_cache_unlink(cache, link);
+    }
+}
+
+esp_err_t discord_member_cache_get(discord_member_cache_t* cache, const char* guild_id, const char* user_id, discord_member_t** out_member) {
+    if(!cache || !guild_id || !user_id || !out_member) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    entry_t** link = discord_member_cache_link(cache, discord_member_cache_id(guild_id), discord_member_cache_id(user_id));
+
+    if(!link) {
+        cache->misses++;
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    entry_t* entry = *link;
+    *link = entry->next;
+    entry->next = cache->members;
+    cache->members = entry;
+
+    discord_member_t* member = calloc(1, sizeof(discord_member_t));
+
+    if(!member) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if((entry->has_nick && !(member->nick = strdup(discord_member_cache_nick(entry)))) ||
+       (entry->roles_len > 0 && !(member->roles = calloc(entry->roles_len, sizeof(char*))))) {
+        discord_member_free(member);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for(; member->_roles_len < entry->roles_len; member->_roles_len++) {
+        if(!(member->roles[member->_roles_len] = discord_member_cache_id_str(entry->roles[member->_roles_len]))) {
+            discord_member_free(member);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    cache->hits++;
+    *out_member = member;
+
+    return ESP_OK;
+}
+
+void discord_member_cache_clear(discord_member_cache_t* cache) {
+    if(!cache) {
+        return;
+    }
+
+    while(cache->members) {
+        discord_member_cache_unlink(cache, &cache->members);
+    }
+
+    cache->size = 0;
+    discord_member_cache_drop_staged(cache);
+}
+
+esp_err_t discord_member_record_from_member(const char* user_id, const discord_member_t* member, discord_member_record_t* out_record) {
+    if(!discord_member_cache_id(user_id) || !member || !out_record) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(member->_roles_len > DISCORD_MEMBER_CACHE_ROLES_MAX || (member->nick && strlen(member->nick) > DISCORD_MEMBER_CACHE_NICK_MAX)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    *out_record = (discord_member_record_t) {
+        .user_id = discord_member_cache_id(user_id),
+        .roles_len = member->_roles_len,
+        .has_nick = member->nick != NULL
+    };
+
+    for(uint8_t i = 0; i < out_record->roles_len; i++) {
+        out_record->roles[i] = discord_member_cache_id(member->roles[i]);
+    }
+
+    if(member->nick) {
+        strcpy(out_record->nick, member->nick);
+    }
+
+    return ESP_OK;
+}
\ No newline at end of file
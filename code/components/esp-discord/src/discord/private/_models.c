@@ -11,6 +11,7 @@
 #include "discord/message_reaction.h"
 #include "discord/role.h"
 #include "discord/voice_state.h"
+#include "discord/presence.h"
 
 DISCORD_LOG_DEFINE_BASE();
 
@@ -18,6 +19,12 @@ void discord_payload_free(discord_payload_t* payload) {
     if(!payload)
         return;
 
+    if(payload->arena) {
+        discord_arena_free(payload->arena);
+        free(payload);
+        return;
+    }
+
     switch (payload->op) {
         case DISCORD_OP_HELLO:
             discord_hello_free((discord_hello_t*) payload->d);
@@ -29,11 +36,20 @@ void discord_payload_free(discord_payload_t* payload) {
 
         case DISCORD_OP_HEARTBEAT:
         case DISCORD_OP_HEARTBEAT_ACK:
+        case DISCORD_OP_RECONNECT:
             // Ignore
             break;
 
-        case DISCORD_OP_IDENTIFY:
-            discord_identify_free((discord_identify_t*) payload->d);
+        case DISCORD_OP_PRESENCE_UPDATE:
+            discord_presence_free((discord_presence_t*) payload->d);
+            break;
+
+        case DISCORD_OP_REQUEST_GUILD_MEMBERS:
+            free(payload->d); // guild id
+            break;
+
+        case DISCORD_OP_INVALID_SESSION:
+            discord_invalid_session_free((discord_invalid_session_t*) payload->d);
             break;
         
         default:
@@ -48,9 +64,17 @@ void discord_dispatch_event_data_free(discord_payload_t* payload) {
     if(!payload)
         return;
 
+    if(DISCORD_EVENT_IS_GUILD_STATE(payload->t)) {
+        return discord_guild_state_free((discord_guild_state_t*) payload->d);
+    }
+
     switch (payload->t) {
         case DISCORD_EVENT_READY:
             return discord_session_free((discord_session_t*) payload->d);
+
+        case DISCORD_EVENT_RESUMED:
+            // Ignore
+            return;
         
         case DISCORD_EVENT_MESSAGE_RECEIVED:
         case DISCORD_EVENT_MESSAGE_UPDATED:
@@ -77,21 +101,145 @@ void discord_hello_free(discord_hello_t* hello) {
     free(hello);
 }
 
-void discord_identify_properties_free(discord_identify_properties_t* properties) {
-    if(!properties)
+void discord_invalid_session_free(discord_invalid_session_t* invalid_session) {
+    if(!invalid_session)
         return;
 
-    free(properties->os);
-    free(properties->browser);
-    free(properties->device);
-    free(properties);
+    free(invalid_session);
 }
 
-void discord_identify_free(discord_identify_t* identify) {
-    if(!identify)
+void discord_guild_state_free(discord_guild_state_t* state) {
+    if(!state)
         return;
 
-    free(identify->token);
-    discord_identify_properties_free(identify->properties);
-    free(identify);
+    free(state->guild_id);
+    free(state->id);
+    cu_list_freex(state->roles, state->roles_len, discord_role_free);
+    cu_list_freex(state->channels, state->channels_len, discord_channel_free);
+    free(state->members);
+    free(state);
+}
+
+/**
+ * @brief Copy string into the field, NULL stays NULL
+ * @return false if there is no memory
+ */
+static bool discord_model_strdup(char** field, const char* str) {
+    return !str || (*field = strdup(str));
+}
+
+discord_user_t* discord_user_clone(const discord_user_t* user) {
+    discord_user_t* clone = user ? cu_ctor(discord_user_t, .bot = user->bot) : NULL;
+
+    if(clone && !(discord_model_strdup(&clone->id, user->id) &&
+                  discord_model_strdup(&clone->username, user->username) &&
+                  discord_model_strdup(&clone->discriminator, user->discriminator))) {
+        discord_user_free(clone);
+        return NULL;
+    }
+
+    return clone;
+}
+
+discord_member_t* discord_member_clone(const discord_member_t* member) {
+    discord_member_t* clone = member ? cu_ctor(discord_member_t, .nick = NULL) : NULL;
+    bool ok = clone && discord_model_strdup(&clone->nick, member->nick) && discord_model_strdup(&clone->permissions, member->permissions);
+
+    if(ok && member->_roles_len > 0 && member->roles) {
+        ok = (clone->roles = calloc(member->_roles_len, sizeof(char*))) != NULL;
+
+        // length counts the copied roles, so the partial copy is freed as usual
+        for(discord_role_len_t i = 0; ok && i < member->_roles_len; i++) {
+            ok = discord_model_strdup(&clone->roles[i], member->roles[i]);
+            clone->_roles_len++;
+        }
+    }
+
+    if(clone && !ok) {
+        discord_member_free(clone);
+        return NULL;
+    }
+
+    return clone;
+}
+
+discord_attachment_t* discord_attachment_clone(const discord_attachment_t* attachment) {
+    discord_attachment_t* clone = attachment ? cu_ctor(discord_attachment_t, .size = attachment->size) : NULL;
+
+    if(clone && !(discord_model_strdup(&clone->id, attachment->id) &&
+                  discord_model_strdup(&clone->filename, attachment->filename) &&
+                  discord_model_strdup(&clone->content_type, attachment->content_type) &&
+                  discord_model_strdup(&clone->url, attachment->url))) {
+        discord_attachment_free(clone);
+        return NULL;
+    }
+
+    return clone;
+}
+
+discord_message_t* discord_message_clone(const discord_message_t* message) {
+    discord_message_t* clone = message ? cu_ctor(discord_message_t, .type = message->type) : NULL;
+    bool ok = clone &&
+        discord_model_strdup(&clone->id, message->id) &&
+        discord_model_strdup(&clone->content, message->content) &&
+        discord_model_strdup(&clone->channel_id, message->channel_id) &&
+        discord_model_strdup(&clone->guild_id, message->guild_id) &&
+        (!message->author || (clone->author = discord_user_clone(message->author))) &&
+        (!message->member || (clone->member = discord_member_clone(message->member)));
+
+    if(ok && message->_attachments_len > 0 && message->attachments) {
+        ok = (clone->attachments = calloc(message->_attachments_len, sizeof(discord_attachment_t*))) != NULL;
+
+        for(uint8_t i = 0; ok && i < message->_attachments_len; i++) {
+            discord_attachment_t* attachment = message->attachments[i];
+            ok = !attachment || (clone->attachments[i] = discord_attachment_clone(attachment));
+            clone->_attachments_len++;
+        }
+    }
+
+    if(clone && !ok) {
+        discord_message_free(clone);
+        return NULL;
+    }
+
+    return clone;
+}
+
+discord_message_reaction_t* discord_message_reaction_clone(const discord_message_reaction_t* reaction) {
+    discord_message_reaction_t* clone = reaction ? cu_ctor(discord_message_reaction_t, .emoji = NULL) : NULL;
+    bool ok = clone &&
+        discord_model_strdup(&clone->user_id, reaction->user_id) &&
+        discord_model_strdup(&clone->message_id, reaction->message_id) &&
+        discord_model_strdup(&clone->channel_id, reaction->channel_id) &&
+        discord_model_strdup(&clone->guild_id, reaction->guild_id) &&
+        (!reaction->emoji || (clone->emoji = cu_ctor(discord_emoji_t, .name = NULL))) &&
+        (!reaction->emoji || discord_model_strdup(&clone->emoji->name, reaction->emoji->name));
+
+    if(clone && !ok) {
+        discord_message_reaction_free(clone);
+        return NULL;
+    }
+
+    return clone;
+}
+
+discord_voice_state_t* discord_voice_state_clone(const discord_voice_state_t* state) {
+    discord_voice_state_t* clone = state ? cu_ctor(discord_voice_state_t,
+        .deaf = state->deaf,
+        .mute = state->mute,
+        .self_deaf = state->self_deaf,
+        .self_mute = state->self_mute
+    ) : NULL;
+    bool ok = clone &&
+        discord_model_strdup(&clone->guild_id, state->guild_id) &&
+        discord_model_strdup(&clone->channel_id, state->channel_id) &&
+        discord_model_strdup(&clone->user_id, state->user_id) &&
+        (!state->member || (clone->member = discord_member_clone(state->member)));
+
+    if(clone && !ok) {
+        discord_voice_state_free(clone);
+        return NULL;
+    }
+
+    return clone;
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "discord/private/_outbox.h"
+#include <stdlib.h>
+
+esp_err_t discord_outbox_init(discord_outbox_t* outbox, uint32_t capacity, uint32_t period_ms, uint32_t reserve, uint8_t reserved_from, uint8_t limit, discord_outbox_free_t free_item) {
+    if(!outbox || capacity == 0 || period_ms < capacity || reserve >= capacity || !free_item) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *outbox = (discord_outbox_t) {
+        .limit = limit,
+        .capacity = capacity,
+        .refill_ms = period_ms / capacity,
+        .reserve = reserve,
+        .reserved_from = reserved_from,
+        .tokens = capacity,
+        .free_item = free_item
+    };
+
+    return ESP_OK;
+}
+
+static void discord_outbox_refill(discord_outbox_t* outbox, uint64_t now_ms) {
+    if(outbox->tokens >= outbox->capacity || now_ms < outbox->refill_tick_ms) {
+        outbox->refill_tick_ms = now_ms;
+        return;
+    }
+
+    uint64_t refilled = (now_ms - outbox->refill_tick_ms) / outbox->refill_ms;
+
+    if(refilled == 0) {
+        return;
+    }
+
+    outbox->refill_tick_ms += refilled * outbox->refill_ms;
+
+    if(outbox->tokens + refilled >= outbox->capacity) {
+        outbox->tokens = outbox->capacity;
+        outbox->refill_tick_ms = now_ms;
+    } else {
+        outbox->tokens += (uint32_t) refilled;
+    }
+}
+
+/**
+ * @brief Number of tokens required before item of given priority can be sent
+ */
+static uint32_t discord_outbox_tokens_needed(discord_outbox_t* outbox, uint8_t priority) {
+    return priority < outbox->reserved_from ? 1 : outbox->reserve + 1;
+}
+
+void discord_outbox_reset(discord_outbox_t* outbox, uint64_t now_ms) {
+    if(!outbox)
+        return;
+
+    while(outbox->items) {
+        discord_outbox_item_t* it = outbox->items;
+        outbox->items = it->next;
+        outbox->free_item(it->item);
+        free(it);
+    }
+
+    outbox->count = 0;
+    outbox->tokens = outbox->capacity;
+    outbox->refill_tick_ms = now_ms;
+}
+
+bool discord_outbox_take_token(discord_outbox_t* outbox, uint8_t priority, uint64_t now_ms) {
+    discord_outbox_refill(outbox, now_ms);
+
+    if(outbox->items && outbox->items->priority <= priority) {
+        return false; // do not overtake waiting items
+    }
+
+    if(outbox->tokens < discord_outbox_tokens_needed(outbox, priority)) {
+        return false;
+    }
+
+    outbox->tokens--;
+    return true;
+}
+
+esp_err_t discord_outbox_defer(discord_outbox_t* outbox, void* item, uint8_t priority, int key) {
+    if(key != 0) {
+        for(discord_outbox_item_t* it = outbox->items; it; it = it->next) {
+            if(it->key == key) {
+                outbox->free_item(it->item); // superseded by the newer one
+                it->item = item;
+                outbox->coalesced++;
+                return ESP_OK;
+            }
+        }
+    }
+
+    discord_outbox_item_t* waiting = NULL;
+
+    if(outbox->count >= outbox->limit || !(waiting = calloc(1, sizeof(discord_outbox_item_t)))) {
+        outbox->free_item(item);
+        return ESP_ERR_NO_MEM;
+    }
+
+    waiting->item = item;
+    waiting->priority = priority;
+    waiting->key = key;
+
+    discord_outbox_item_t** link = &outbox->items;
+
+    while(*link && (*link)->priority <= priority) {
+        link = &(*link)->next;
+    }
+
+    waiting->next = *link;
+    *link = waiting;
+    outbox->count++;
+    outbox->deferred++;
+
+    return ESP_OK;
+}
+
+void* discord_outbox_next(discord_outbox_t* outbox, uint64_t now_ms) {
+    discord_outbox_item_t* it = outbox->items;
+
+    if(!it) {
+        return NULL;
+    }
+
+    discord_outbox_refill(outbox, now_ms);
+
+    if(outbox->tokens < discord_outbox_tokens_needed(outbox, it->priority)) {
+        return NULL;
+    }
+
+    void* item = it->item;
+    outbox->items = it->next;
+    outbox->count--;
+    outbox->tokens--;
+    free(it);
+
+    return item;
+}
+
+uint32_t discord_outbox_wait_ms(discord_outbox_t* outbox, uint64_t now_ms) {
+    if(!outbox->items) {
+        return UINT32_MAX;
+    }
+
+    discord_outbox_refill(outbox, now_ms);
+
+    uint32_t needed = discord_outbox_tokens_needed(outbox, outbox->items->priority);
+
+    if(outbox->tokens >= needed) {
+        return 0;
+    }
+
+    return (needed - outbox->tokens) * outbox->refill_ms - (uint32_t) (now_ms - outbox->refill_tick_ms);
+}
+
+void discord_outbox_destroy(discord_outbox_t* outbox) {
+    discord_outbox_reset(outbox, 0);
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "discord/private/_payload_ring.h"
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+esp_err_t discord_payload_ring_init(discord_payload_ring_t* ring, uint32_t limit, discord_queue_policy_t policy, uint32_t block_timeout_ms, discord_payload_ring_free_t free_item) {
+    if(!ring || limit == 0 || !free_item) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *ring = (discord_payload_ring_t) {
+        .capacity = 2 * limit,
+        .limit = limit,
+        .policy = policy,
+        .block_timeout_ms = block_timeout_ms,
+        .free_item = free_item
+    };
+
+    if(!(ring->slots = calloc(ring->capacity, sizeof(discord_payload_ring_slot_t)))) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for(uint32_t i = 0; i < ring->capacity; i++) {
+        atomic_init(&ring->slots[i].item, NULL);
+    }
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->pending_drops, 0);
+    atomic_init(&ring->drops, 0);
+    atomic_init(&ring->coalesced, 0);
+    atomic_init(&ring->max_depth, 0);
+
+    return ESP_OK;
+}
+
+static esp_err_t discord_payload_ring_drop(discord_payload_ring_t* ring, void* item) {
+    ring->free_item(item);
+    atomic_fetch_add(&ring->drops, 1);
+    return ESP_ERR_NO_MEM;
+}
+
+/**
+ * @brief Replace waiting item with the same key. Waiting items which are going to be dropped are skipped
+ */
+static bool discord_payload_ring_coalesce(discord_payload_ring_t* ring, void* item, uint64_t key, uint32_t head) {
+    // pending drops are read before tail, consumer updates them in reverse order, so the start is never too early
+    uint32_t pending = atomic_load(&ring->pending_drops);
+    uint32_t start = atomic_load(&ring->tail) + pending;
+
+    for(uint32_t i = start; (int32_t) (head - i) > 0; i++) {
+        discord_payload_ring_slot_t* slot = &ring->slots[i % ring->capacity];
+
+        if(slot->key != key) {
+            continue;
+        }
+
+        void* waiting = atomic_load(&slot->item);
+
+        // fails if consumer has just taken the waiting item
+        if(waiting && atomic_compare_exchange_strong(&slot->item, &waiting, item)) {
+            ring->free_item(waiting);
+            atomic_fetch_add(&ring->coalesced, 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+esp_err_t discord_payload_ring_push(discord_payload_ring_t* ring, void* item, uint64_t key) {
+    if(!ring || !ring->slots || !item) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if(ring->policy == DISCORD_QUEUE_POLICY_COALESCE && key != 0 && discord_payload_ring_coalesce(ring, item, key, head)) {
+        return ESP_OK;
+    }
+
+    if(head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= ring->capacity) {
+        // consumer has not run for a while, oldest items are already waiting to be dropped
+        return discord_payload_ring_drop(ring, item);
+    }
+
+    uint32_t waited_ms = 0;
+
+    while(discord_payload_ring_depth(ring) >= ring->limit) {
+        if(ring->policy == DISCORD_QUEUE_POLICY_DROP_OLDEST || ring->policy == DISCORD_QUEUE_POLICY_COALESCE) {
+            atomic_fetch_add(&ring->pending_drops, 1);
+            atomic_fetch_add(&ring->drops, 1);
+            break;
+        }
+
+        if(ring->policy != DISCORD_QUEUE_POLICY_BLOCK || waited_ms >= ring->block_timeout_ms) {
+            return discord_payload_ring_drop(ring, item);
+        }
+
+        vTaskDelay(1);
+        waited_ms += portTICK_PERIOD_MS;
+    }
+
+    discord_payload_ring_slot_t* slot = &ring->slots[head % ring->capacity];
+    slot->key = key;
+    atomic_store_explicit(&slot->item, item, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    uint32_t depth = discord_payload_ring_depth(ring);
+
+    if(depth > atomic_load_explicit(&ring->max_depth, memory_order_relaxed)) {
+        atomic_store_explicit(&ring->max_depth, depth, memory_order_relaxed);
+    }
+
+    return ESP_OK;
+}
+
+void* discord_payload_ring_pop(discord_payload_ring_t* ring) {
+    if(!ring || !ring->slots)
+        return NULL;
+
+    for(;;) {
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+        if(tail == atomic_load_explicit(&ring->head, memory_order_acquire)) {
+            return NULL;
+        }
+
+        void* item = atomic_exchange(&ring->slots[tail % ring->capacity].item, NULL);
+        atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+        uint32_t pending = atomic_load(&ring->pending_drops);
+
+        while(pending > 0 && !atomic_compare_exchange_weak(&ring->pending_drops, &pending, pending - 1)) { }
+
+        if(pending > 0) {
+            ring->free_item(item); // dropped by producer
+            continue;
+        }
+
+        return item;
+    }
+}
+
+uint32_t discord_payload_ring_depth(discord_payload_ring_t* ring) {
+    uint32_t pending = atomic_load(&ring->pending_drops);
+    uint32_t tail = atomic_load(&ring->tail);
+    uint32_t head = atomic_load(&ring->head);
+    uint32_t used = head - tail;
+
+    return used > pending ? used - pending : 0;
+}
+
+void discord_payload_ring_flush(discord_payload_ring_t* ring) {
+    void* item;
+
+    while((item = discord_payload_ring_pop(ring))) {
+        ring->free_item(item);
+    }
+}
+
+void discord_payload_ring_destroy(discord_payload_ring_t* ring) {
+    if(!ring || !ring->slots)
+        return;
+
+    discord_payload_ring_flush(ring);
+    free(ring->slots);
+    ring->slots = NULL;
+}
\ No newline at end of file
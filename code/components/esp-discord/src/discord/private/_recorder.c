@@ -0,0 +1,180 @@
+#include "discord/private/_recorder.h"
+#include <string.h>
+#include "esp_timer.h"
+
+#define DISCORD_RECORDER_FLAG_COMPRESS          (1 << 0)
+#define DISCORD_RECORDER_FLAG_PAYLOAD_COMPRESS  (1 << 1)
+
+static bool discord_recorder_put_varint(FILE* file, uint64_t value) {
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+
+        if(fputc(value ? byte | 0x80 : byte, file) == EOF) {
+            return false;
+        }
+    } while(value);
+
+    return true;
+}
+
+/**
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if file ends before the first byte or ESP_ERR_INVALID_SIZE if it ends in the middle
+ */
+static esp_err_t discord_recorder_get_varint(FILE* file, uint64_t* out_value) {
+    uint64_t value = 0;
+
+    for(int shift = 0; shift < 64; shift += 7) {
+        int byte = fgetc(file);
+
+        if(byte == EOF) {
+            return shift == 0 ? ESP_ERR_NOT_FOUND : ESP_ERR_INVALID_SIZE;
+        }
+
+        value |= (uint64_t) (byte & 0x7F) << shift;
+
+        if(!(byte & 0x80)) {
+            *out_value = value;
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_INVALID_SIZE;
+}
+
+esp_err_t discord_recorder_init_writer(discord_recorder_t* recorder, FILE* file, const discord_recorder_header_t* header) {
+    if(!recorder || !file || !header) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *recorder = (discord_recorder_t) {
+        .file = file,
+        .start_us = esp_timer_get_time()
+    };
+
+    const uint8_t info[] = {
+        DISCORD_RECORDER_VERSION,
+        (uint8_t) header->encoding,
+        (header->compress ? DISCORD_RECORDER_FLAG_COMPRESS : 0) | (header->payload_compress ? DISCORD_RECORDER_FLAG_PAYLOAD_COMPRESS : 0),
+        0 // reserved
+    };
+
+    if(fwrite(DISCORD_RECORDER_MAGIC, 1, 4, file) != 4 || fwrite(info, 1, sizeof(info), file) != sizeof(info) || fflush(file) != 0) {
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t discord_recorder_write(discord_recorder_t* recorder, const discord_recorder_frame_t* frame, const char* data) {
+    if(!recorder || !recorder->file || !frame || (frame->data_len > 0 && !data)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint64_t time_us = esp_timer_get_time() - recorder->start_us;
+    uint64_t delta_us = time_us > recorder->time_us ? time_us - recorder->time_us : 0;
+    recorder->time_us += delta_us;
+
+    FILE* file = recorder->file;
+
+    if(!discord_recorder_put_varint(file, delta_us) ||
+       !discord_recorder_put_varint(file, (uint32_t) frame->event_id) ||
+       fputc(frame->op_code, file) == EOF ||
+       !discord_recorder_put_varint(file, frame->payload_len) ||
+       !discord_recorder_put_varint(file, frame->payload_offset) ||
+       !discord_recorder_put_varint(file, frame->data_len) ||
+       (frame->data_len > 0 && fwrite(data, 1, frame->data_len, file) != frame->data_len) ||
+       fflush(file) != 0) {
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t discord_recorder_init_reader(discord_recorder_t* recorder, FILE* file, discord_recorder_header_t* out_header) {
+    if(!recorder || !file || !out_header) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *recorder = (discord_recorder_t) { .file = file };
+
+    uint8_t header[8];
+
+    if(fread(header, 1, sizeof(header), file) != sizeof(header) ||
+       memcmp(header, DISCORD_RECORDER_MAGIC, 4) != 0 ||
+       header[4] != DISCORD_RECORDER_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    out_header->encoding = (discord_gateway_encoding_t) header[5];
+    out_header->compress = header[6] & DISCORD_RECORDER_FLAG_COMPRESS;
+    out_header->payload_compress = header[6] & DISCORD_RECORDER_FLAG_PAYLOAD_COMPRESS;
+
+    return ESP_OK;
+}
+
+esp_err_t discord_recorder_read_frame(discord_recorder_t* recorder, discord_recorder_frame_t* out_frame) {
+    if(!recorder || !recorder->file || !out_frame) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    FILE* file = recorder->file;
+
+    if(recorder->data_left > 0 && fseek(file, recorder->data_left, SEEK_CUR) != 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    recorder->data_left = 0;
+
+    uint64_t delta_us, event_id, payload_len, payload_offset, data_len;
+    esp_err_t err = discord_recorder_get_varint(file, &delta_us);
+
+    if(err != ESP_OK) {
+        return err; // end of the log is allowed only here
+    }
+
+    int op_code;
+
+    if(discord_recorder_get_varint(file, &event_id) != ESP_OK ||
+       (op_code = fgetc(file)) == EOF ||
+       discord_recorder_get_varint(file, &payload_len) != ESP_OK ||
+       discord_recorder_get_varint(file, &payload_offset) != ESP_OK ||
+       discord_recorder_get_varint(file, &data_len) != ESP_OK ||
+       data_len > UINT32_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    recorder->time_us += delta_us;
+    recorder->data_left = data_len;
+
+    *out_frame = (discord_recorder_frame_t) {
+        .time_us = recorder->time_us,
+        .event_id = (int32_t) event_id,
+        .op_code = op_code,
+        .payload_len = payload_len,
+        .payload_offset = payload_offset,
+        .data_len = data_len
+    };
+
+    return ESP_OK;
+}
+
+esp_err_t discord_recorder_read_data(discord_recorder_t* recorder, char* buffer) {
+    if(!recorder || !recorder->file || (recorder->data_left > 0 && !buffer)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t len = recorder->data_left;
+    recorder->data_left = 0;
+
+    return len == 0 || fread(buffer, 1, len, recorder->file) == len ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+void discord_recorder_close(discord_recorder_t* recorder) {
+    if(!recorder || !recorder->file) {
+        return;
+    }
+
+    fclose(recorder->file);
+    recorder->file = NULL;
+}
\ No newline at end of file
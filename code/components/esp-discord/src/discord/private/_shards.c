@@ -0,0 +1,98 @@
+#include "discord/private/_shards.h"
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_api.h"
+
+DISCORD_LOG_DEFINE_BASE();
+
+esp_err_t discord_identify_limiter_init(discord_identify_limiter_t* limiter, uint16_t max_concurrency) {
+    if(!limiter || max_concurrency == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *limiter = (discord_identify_limiter_t) {
+        .max_concurrency = max_concurrency,
+        .bucket_tick_ms = calloc(max_concurrency, sizeof(uint64_t))
+    };
+
+    return limiter->bucket_tick_ms ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+uint32_t discord_identify_limiter_take(discord_identify_limiter_t* limiter, uint16_t shard_id, uint64_t now_ms) {
+    if(!limiter || !limiter->bucket_tick_ms) {
+        return 0;
+    }
+
+    uint64_t* tick_ms = &limiter->bucket_tick_ms[shard_id % limiter->max_concurrency];
+    uint64_t slot_ms = *tick_ms > now_ms ? *tick_ms : now_ms;
+    *tick_ms = slot_ms + DISCORD_SHARD_IDENTIFY_INTERVAL_MS;
+
+    return (uint32_t) (slot_ms - now_ms);
+}
+
+void discord_identify_limiter_destroy(discord_identify_limiter_t* limiter) {
+    if(!limiter)
+        return;
+
+    free(limiter->bucket_tick_ms);
+    limiter->bucket_tick_ms = NULL;
+    limiter->max_concurrency = 0;
+}
+
+uint16_t discord_shard_of_guild(const char* guild_id, uint16_t shard_count) {
+    return guild_id && shard_count > 0 ? (strtoull(guild_id, NULL, 10) >> 22) % shard_count : 0;
+}
+
+esp_err_t dcsh_get_gateway_bot(discord_handle_t client, uint16_t* out_shards, uint16_t* out_max_concurrency) {
+    esp_err_t err = ESP_OK;
+    discord_api_response_t* res = NULL;
+
+    if((err = dcapi_get(client, strdup("/gateway/bot"), NULL, &res)) != ESP_OK) {
+        DISCORD_LOGE("Fail to fetch gateway info");
+        return err;
+    }
+
+    err = ESP_FAIL;
+
+    if(dcapi_response_is_success(res) && res->data_len > 0) {
+        cJSON* root = cJSON_ParseWithLength(res->data, res->data_len);
+        cJSON* shards = cJSON_GetObjectItem(root, "shards");
+        cJSON* max_concurrency = cJSON_GetObjectItem(cJSON_GetObjectItem(root, "session_start_limit"), "max_concurrency");
+
+        if(cJSON_IsNumber(shards) && shards->valueint > 0 && shards->valueint < DISCORD_GATEWAY_SHARD_COUNT_AUTO) {
+            *out_shards = shards->valueint;
+            *out_max_concurrency = cJSON_IsNumber(max_concurrency) && max_concurrency->valueint > 0 ? max_concurrency->valueint : 1;
+            err = ESP_OK;
+        }
+
+        cJSON_Delete(root);
+    }
+
+    if(err != ESP_OK) {
+        DISCORD_LOGE("Invalid gateway info (status=%d)", res->code);
+    }
+
+    dcapi_response_free(client, res);
+
+    return err;
+}
+
+uint32_t dcsh_identify_delay(discord_handle_t client) {
+    discord_shards_t* shards = DISCORD_OWNER(client)->shards;
+
+    if(!shards) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&shards->lock);
+    uint32_t delay_ms = discord_identify_limiter_take(&shards->limiter, client->shard_id, discord_tick_ms());
+    portEXIT_CRITICAL(&shards->lock);
+
+    return delay_ms;
+}
+
+bool dcsh_has_guild(discord_handle_t client, const char* guild_id) {
+    return client->shard_count == 0 || discord_shard_of_guild(guild_id, client->shard_count) == client->shard_id;
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "discord/private/_timer.h"
+#include "discord/private/_discord.h"
+
+DISCORD_LOG_DEFINE_BASE();
+
+static void dctm_on_expired(void* arg) {
+    discord_handle_t client = (discord_handle_t) arg;
+
+    DISCORD_TASK_NOTIFY(client);
+}
+
+esp_err_t dctm_init(discord_handle_t client) {
+    DISCORD_LOG_FOO();
+
+    discord_timers_t* tm = &client->timers;
+
+    *tm = (discord_timers_t) { 0 };
+    portMUX_INITIALIZE(&tm->lock);
+
+    esp_timer_create_args_t args = {
+        .callback = dctm_on_expired,
+        .arg = client,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "discord"
+    };
+
+    if(esp_timer_create(&args, &tm->handle) != ESP_OK) {
+        DISCORD_LOGE("Fail to create timer");
+        tm->handle = NULL;
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+void dctm_set(discord_handle_t client, discord_timer_t timer, uint32_t delay_ms) {
+    discord_timers_t* tm = &client->timers;
+
+    portENTER_CRITICAL(&tm->lock);
+    tm->deadlines[timer] = discord_tick_ms() + delay_ms;
+    portEXIT_CRITICAL(&tm->lock);
+
+    if(xTaskGetCurrentTaskHandle() != client->task_handle) {
+        DISCORD_TASK_NOTIFY(client); // let the task re-arm esp_timer
+    }
+}
+
+void dctm_cancel(discord_handle_t client, discord_timer_t timer) {
+    discord_timers_t* tm = &client->timers;
+
+    portENTER_CRITICAL(&tm->lock);
+    tm->deadlines[timer] = 0;
+    portEXIT_CRITICAL(&tm->lock);
+}
+
+bool dctm_is_set(discord_handle_t client, discord_timer_t timer) {
+    discord_timers_t* tm = &client->timers;
+
+    portENTER_CRITICAL(&tm->lock);
+    bool set = tm->deadlines[timer] > 0;
+    portEXIT_CRITICAL(&tm->lock);
+
+    return set;
+}
+
+bool dctm_take_expired(discord_handle_t client, discord_timer_t timer) {
+    discord_timers_t* tm = &client->timers;
+    uint64_t now = discord_tick_ms();
+    bool expired = false;
+
+    portENTER_CRITICAL(&tm->lock);
+    if(tm->deadlines[timer] > 0 && tm->deadlines[timer] <= now) {
+        tm->deadlines[timer] = 0;
+        expired = true;
+    }
+    portEXIT_CRITICAL(&tm->lock);
+
+    return expired;
+}
+
+void dctm_arm(discord_handle_t client) {
+    discord_timers_t* tm = &client->timers;
+
+    if(!tm->handle)
+        return;
+
+    uint64_t nearest = 0;
+
+    portENTER_CRITICAL(&tm->lock);
+    for(int i = 0; i < _DISCORD_TIMER_COUNT; i++) {
+        if(tm->deadlines[i] > 0 && (nearest == 0 || tm->deadlines[i] < nearest)) {
+            nearest = tm->deadlines[i];
+        }
+    }
+    portEXIT_CRITICAL(&tm->lock);
+
+    if(nearest == tm->armed_deadline) {
+        return; // already armed (or stopped)
+    }
+
+    esp_timer_stop(tm->handle); // fails if timer is not running, which is fine
+    tm->armed_deadline = nearest;
+
+    if(nearest == 0) {
+        return;
+    }
+
+    uint64_t now = discord_tick_ms();
+    esp_timer_start_once(tm->handle, nearest > now ? (nearest - now) * 1000 : 0);
+}
+
+void dctm_destroy(discord_handle_t client) {
+    discord_timers_t* tm = &client->timers;
+
+    if(!tm->handle)
+        return;
+
+    esp_timer_stop(tm->handle);
+    esp_timer_delete(tm->handle);
+    tm->handle = NULL;
+    tm->armed_deadline = 0;
+
+    for(int i = 0; i < _DISCORD_TIMER_COUNT; i++) {
+        tm->deadlines[i] = 0;
+    }
+}
\ No newline at end of file
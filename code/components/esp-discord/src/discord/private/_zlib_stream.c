@@ -0,0 +1,155 @@
+#include "discord/private/_zlib_stream.h"
+#include <stdlib.h>
+
+#ifndef CONFIG_IDF_TARGET_LINUX
+#define DISCORD_ZLIB_STREAM_FLAGS (TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT)
+#endif
+
+esp_err_t discord_zlib_stream_init(discord_zlib_stream_t* stream) {
+    if(!stream) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+    stream->decomp = calloc(1, sizeof(z_stream));
+
+    if(stream->decomp && inflateInit(stream->decomp) != Z_OK) {
+        free(stream->decomp);
+        stream->decomp = NULL;
+    }
+#else
+    stream->decomp = malloc(sizeof(tinfl_decompressor));
+#endif
+    stream->window = malloc(DISCORD_ZLIB_STREAM_WINDOW_SIZE);
+
+    if(!stream->decomp || !stream->window) {
+        discord_zlib_stream_destroy(stream);
+        return ESP_ERR_NO_MEM;
+    }
+
+    discord_zlib_stream_reset(stream);
+
+    return ESP_OK;
+}
+
+void discord_zlib_stream_reset(discord_zlib_stream_t* stream) {
+    if(!stream || !stream->decomp)
+        return;
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+    inflateReset(stream->decomp);
+#else
+    tinfl_init(stream->decomp);
+#endif
+    stream->window_offset = 0;
+    stream->tail = UINT32_MAX; // cannot be mistaken for the suffix
+    stream->flushed = true;
+}
+
+esp_err_t discord_zlib_stream_feed(discord_zlib_stream_t* stream, const void* data, size_t len, discord_zlib_stream_sink_t sink, void* arg) {
+    if(!stream || !stream->decomp || (!data && len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint8_t* in = (const uint8_t*) data;
+
+    if(stream->per_message) {
+        if(len > 0 && stream->flushed) {
+            discord_zlib_stream_reset(stream); // previous message has ended, next one is a new stream
+            stream->flushed = false;
+        }
+    } else {
+        for(size_t i = 0; i < len; i++) {
+            stream->tail = (stream->tail << 8) | in[i];
+        }
+
+        if(len > 0) {
+            stream->flushed = stream->tail == DISCORD_ZLIB_STREAM_SUFFIX;
+        }
+    }
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+    while(true) {
+        stream->decomp->next_in = (Bytef*) in;
+        stream->decomp->avail_in = len;
+        stream->decomp->next_out = stream->window;
+        stream->decomp->avail_out = DISCORD_ZLIB_STREAM_WINDOW_SIZE;
+
+        int status = inflate(stream->decomp, Z_SYNC_FLUSH);
+
+        size_t out_size = DISCORD_ZLIB_STREAM_WINDOW_SIZE - stream->decomp->avail_out;
+        in += len - stream->decomp->avail_in;
+        len = stream->decomp->avail_in;
+
+        if(out_size > 0 && sink) {
+            sink(arg, (const char*) stream->window, out_size);
+        }
+
+        if(status == Z_STREAM_END && stream->per_message && len == 0) {
+            stream->flushed = true;
+            return ESP_OK;
+        }
+
+        // Z_BUF_ERROR only tells that there was nothing to do. As with tinfl, end of zlib-stream is malformed input
+        if(status != Z_OK && status != Z_BUF_ERROR) {
+            return ESP_FAIL;
+        }
+
+        if(stream->decomp->avail_out > 0) {
+            return ESP_OK;
+        }
+    }
+#else
+    while(true) {
+        size_t in_size = len;
+        size_t out_size = DISCORD_ZLIB_STREAM_WINDOW_SIZE - stream->window_offset;
+        uint8_t* out = stream->window + stream->window_offset;
+
+        tinfl_status status = tinfl_decompress(stream->decomp, in, &in_size, stream->window, out, &out_size, DISCORD_ZLIB_STREAM_FLAGS);
+
+        in += in_size;
+        len -= in_size;
+
+        if(out_size > 0 && sink) {
+            sink(arg, (const char*) out, out_size);
+        }
+
+        // window is circular, wrap around when it is filled up. tinfl rejects the zlib header
+        // which declares bigger window than the output buffer, so back-references always stay in it
+        stream->window_offset = (stream->window_offset + out_size) & (DISCORD_ZLIB_STREAM_WINDOW_SIZE - 1);
+
+        if(status < TINFL_STATUS_DONE) {
+            return ESP_FAIL;
+        }
+
+        if(status == TINFL_STATUS_DONE && stream->per_message && len == 0) {
+            stream->flushed = true;
+            return ESP_OK;
+        }
+
+        if(status != TINFL_STATUS_HAS_MORE_OUTPUT) {
+            // zlib-stream never ends, so DONE can be only the result of malformed input (or of data after the end of the message)
+            return status == TINFL_STATUS_NEEDS_MORE_INPUT ? ESP_OK : ESP_FAIL;
+        }
+    }
+#endif
+}
+
+bool discord_zlib_stream_is_flushed(discord_zlib_stream_t* stream) {
+    return stream && stream->flushed;
+}
+
+void discord_zlib_stream_destroy(discord_zlib_stream_t* stream) {
+    if(!stream)
+        return;
+
+#ifdef CONFIG_IDF_TARGET_LINUX
+    if(stream->decomp) {
+        inflateEnd(stream->decomp);
+    }
+#endif
+    free(stream->decomp);
+    stream->decomp = NULL;
+    free(stream->window);
+    stream->window = NULL;
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "discord/role.h"
 #include "discord/private/_discord.h"
 #include "discord/private/_api.h"
+#include "discord/private/_gateway.h"
 #include "discord/private/_json.h"
 #include "estr.h"
 
@@ -12,6 +13,10 @@ esp_err_t discord_role_get_all(discord_handle_t client, const char* guild_id, di
         return ESP_ERR_INVALID_ARG;
     }
 
+    if(dcgw_guild_cache_get_roles(client, guild_id, out_roles, out_length) == ESP_OK) {
+        return ESP_OK;
+    }
+
     esp_err_t err = ESP_OK;
     discord_api_response_t* res = NULL;
     
@@ -22,6 +27,10 @@ esp_err_t discord_role_get_all(discord_handle_t client, const char* guild_id, di
     
     if(dcapi_response_is_success(res) && res->data_len > 0) {
         *out_roles = discord_json_list_deserialize_(role, res->data, res->data_len, out_length);
+
+        if(*out_roles) {
+            dcgw_guild_cache_set_roles(client, guild_id, *out_roles, *out_length);
+        }
     }
 
     dcapi_response_free(client, res);
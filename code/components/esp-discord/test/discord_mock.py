@@ -0,0 +1,761 @@
+#!/usr/bin/env python3
+"""
+Local stand-in for the Discord gateway and REST API, so esp-discord can be run and measured without network.
+
+Gateway and REST API are served on the same port. Point the client at it with:
+
+    discord_config_t cfg = {
+        .token = "mock.token",
+        .gateway_url = "ws://<host>:8080",
+        .api_url = "http://<host>:8080/api/v10",
+    };
+
+Gateway handles HELLO, HEARTBEAT/ACK, IDENTIFY/READY (and GUILD_CREATE with GUILDS intent), RESUME/RESUMED (with missed dispatches,
+connection the session moved from is closed), PRESENCE_UPDATE,
+REQUEST_GUILD_MEMBERS/GUILD_MEMBERS_CHUNK, zlib-stream compression and IDENTIFY options (compress of large payloads one by one,
+large_threshold with --guild-members, presence and shard). With --shards, connection without shard is closed (sharding required) and
+identifies of one rate limit bucket (shard_id % --max-concurrency) sooner than 5 s apart are invalidated.
+Only JSON encoding is supported. REST API handles gateway/bot, messages (JSON and multipart with
+attachments), reactions, guilds, channels, roles and members. Sent messages and reactions are dispatched back
+over the gateway, as Discord does.
+
+Traffic is controlled over HTTP on the same port:
+
+    curl -X POST localhost:8080/mock/dispatch -d '{"t": "MESSAGE_CREATE", "d": {"content": "knock"}}'
+    curl -X POST localhost:8080/mock/flood -d '{"count": 1000, "t": "MESSAGE_CREATE", "d": {"content": "x"}}'
+    curl -X POST localhost:8080/mock/close -d '{"code": 4000}'
+    curl -X POST localhost:8080/mock/reconnect
+    curl -X POST localhost:8080/mock/stall -d '{"seconds": 60}'
+    curl -X POST localhost:8080/mock/invalid_session -d '{"resumable": false}'
+    curl localhost:8080/mock/stats
+
+Dispatch data is completed with channel, guild and author, so short payloads produce valid events.
+Only the Python standard library is used.
+"""
+
+import argparse
+import asyncio
+import base64
+import collections
+import hashlib
+import json
+import logging
+import random
+import re
+import struct
+import time
+import uuid
+import zlib
+from typing import Any, Dict, List, Optional, Tuple
+
+DISCORD_EPOCH_MS = 1420070400000
+WS_GUID = '258EAFA5-E914-47DA-95CA-C5AB0DC85B11'
+
+OP_DISPATCH = 0
+OP_HEARTBEAT = 1
+OP_IDENTIFY = 2
+OP_PRESENCE_UPDATE = 3
+OP_RESUME = 6
+OP_RECONNECT = 7
+OP_REQUEST_GUILD_MEMBERS = 8
+OP_INVALID_SESSION = 9
+OP_HELLO = 10
+OP_HEARTBEAT_ACK = 11
+
+CLOSE_UNKNOWN_OPCODE = 4001
+CLOSE_DECODE_ERROR = 4002
+CLOSE_NOT_AUTHENTICATED = 4003
+CLOSE_AUTHENTICATION_FAILED = 4004
+CLOSE_ALREADY_AUTHENTICATED = 4005
+CLOSE_INVALID_SHARD = 4010
+CLOSE_SHARDING_REQUIRED = 4011
+
+INTENT_GUILDS = 1 << 0
+
+LARGE_THRESHOLD_DEFAULT = 50
+PAYLOAD_COMPRESS_MIN = 1024  # identify compress: shorter payloads are sent as they are
+IDENTIFY_INTERVAL_S = 5.0  # every identify rate limit bucket starts one session per interval
+
+WS_TEXT = 0x1
+WS_BINARY = 0x2
+WS_CLOSE = 0x8
+WS_PING = 0x9
+WS_PONG = 0xA
+
+GUILD_ID = '1049316126236839946'
+CHANNEL_ID = '1049316126681444372'
+VOICE_CHANNEL_ID = '1049316127147008061'
+ROLE_ID = '1049317394820878437'
+BOT = {'id': '1110502089848782858', 'username': 'key-bot', 'discriminator': '4215', 'bot': True, 'avatar': None}
+USER = {'id': '462290384412901376', 'username': 'user', 'discriminator': '0', 'avatar': None}
+
+_snowflake_counter = 0
+
+
+def snowflake() -> str:
+    global _snowflake_counter
+    _snowflake_counter = (_snowflake_counter + 1) & 0xFFF
+    return str(((int(time.time() * 1000) - DISCORD_EPOCH_MS) << 22) | _snowflake_counter)
+
+
+def member(user: Dict[str, Any]) -> Dict[str, Any]:
+    return {'user': user, 'nick': None, 'roles': [ROLE_ID], 'joined_at': '2022-12-05T19:57:02.115000+00:00', 'deaf': False, 'mute': False}
+
+
+def guild_members(count: int) -> List[Tuple[Dict[str, Any], str]]:
+    """Members of the mock guild besides the bot, with their status. Every fourth member is online"""
+    return [({'id': str(462290384412901376 + i), 'username': 'user%d' % i, 'discriminator': '0', 'avatar': None},
+             'online' if i % 4 == 0 else 'offline') for i in range(count)]
+
+
+def channels(guild_id: str) -> List[Dict[str, Any]]:
+    return [
+        {'id': CHANNEL_ID, 'type': 0, 'guild_id': guild_id, 'name': 'general', 'position': 0},
+        {'id': VOICE_CHANNEL_ID, 'type': 2, 'guild_id': guild_id, 'name': 'General', 'position': 1},
+    ]
+
+
+def roles(guild_id: str) -> List[Dict[str, Any]]:
+    return [
+        {'id': guild_id, 'name': '@everyone', 'position': 0, 'permissions': '1071698660929'},
+        {'id': ROLE_ID, 'name': 'keyholder', 'position': 1, 'permissions': '0'},
+    ]
+
+
+class Stats:
+    def __init__(self) -> None:
+        self.counters: Dict[str, int] = collections.Counter()
+        self.started = time.monotonic()
+
+    def count(self, name: str, n: int = 1) -> None:
+        self.counters[name] += n
+
+    def to_dict(self) -> Dict[str, Any]:
+        return dict(self.counters, uptime_s=round(time.monotonic() - self.started, 3))
+
+
+class WebSocket:
+    """Server side of RFC 6455 connection. Frames from the client are masked, frames to the client are not"""
+
+    def __init__(self, reader: asyncio.StreamReader, writer: asyncio.StreamWriter) -> None:
+        self.reader = reader
+        self.writer = writer
+        self.closed = False
+
+    async def receive(self) -> Tuple[int, bytes]:
+        """Return opcode and payload of the next message. Control frames are returned as they come"""
+        message_op, message = None, b''
+
+        while True:
+            head = await self.reader.readexactly(2)
+            fin, op = head[0] & 0x80, head[0] & 0x0F
+            masked, length = head[1] & 0x80, head[1] & 0x7F
+
+            if length == 126:
+                length = struct.unpack('!H', await self.reader.readexactly(2))[0]
+            elif length == 127:
+                length = struct.unpack('!Q', await self.reader.readexactly(8))[0]
+
+            mask = await self.reader.readexactly(4) if masked else b'\0\0\0\0'
+            data = bytearray(await self.reader.readexactly(length))
+
+            for i in range(length):
+                data[i] ^= mask[i % 4]
+
+            if op >= WS_CLOSE:
+                return op, bytes(data)
+
+            if op != 0:
+                message_op, message = op, b''
+
+            message += data
+
+            if fin:
+                return message_op or WS_TEXT, message
+
+    async def send(self, op: int, data: bytes) -> None:
+        if self.closed:
+            return
+
+        length = len(data)
+
+        if length < 126:
+            head = struct.pack('!BB', 0x80 | op, length)
+        elif length < 65536:
+            head = struct.pack('!BBH', 0x80 | op, 126, length)
+        else:
+            head = struct.pack('!BBQ', 0x80 | op, 127, length)
+
+        self.writer.write(head + data)
+        await self.writer.drain()
+
+    async def close(self, code: int, reason: str = '') -> None:
+        if not self.closed:
+            await self.send(WS_CLOSE, struct.pack('!H', code) + reason.encode())
+            self.closed = True
+            self.writer.close()
+
+
+class Session:
+    def __init__(self) -> None:
+        self.id = uuid.uuid4().hex
+        self.seq = 0
+        self.backlog: collections.deque = collections.deque(maxlen=1000)  # dispatches which can be replayed on resume
+
+
+class GatewayConnection:
+    def __init__(self, mock: 'DiscordMock', ws: WebSocket, compress: bool) -> None:
+        self.mock = mock
+        self.ws = ws
+        self.deflate = zlib.compressobj() if compress else None
+        self.payload_compress = False  # identify compress, used only without zlib-stream
+        self.session: Optional[Session] = None
+
+    async def send(self, payload: Dict[str, Any]) -> None:
+        if self.mock.is_stalled():
+            self.mock.stats.count('gateway_payloads_stalled')
+            return
+
+        data = json.dumps(payload, separators=(',', ':')).encode()
+        self.mock.stats.count('gateway_payloads_sent')
+
+        if self.deflate:
+            data = self.deflate.compress(data) + self.deflate.flush(zlib.Z_SYNC_FLUSH)
+            await self.ws.send(WS_BINARY, data)
+        elif self.payload_compress and len(data) >= PAYLOAD_COMPRESS_MIN:
+            data = zlib.compress(data)
+            await self.ws.send(WS_BINARY, data)
+        else:
+            await self.ws.send(WS_TEXT, data)
+
+        self.mock.stats.count('gateway_bytes_sent', len(data))
+
+    async def dispatch(self, t: str, d: Any) -> None:
+        session = self.session
+        session.seq += 1
+        payload = {'op': OP_DISPATCH, 's': session.seq, 't': t, 'd': d}
+        session.backlog.append(payload)
+        self.mock.stats.count('gateway_dispatches')
+        await self.send(payload)
+
+    async def ack(self) -> None:
+        args = self.mock.args
+
+        if random.random() < args.drop_ack:
+            self.mock.stats.count('gateway_acks_dropped')
+            return
+
+        if args.ack_delay_ms:
+            await asyncio.sleep(args.ack_delay_ms / 1000)
+
+        self.mock.stats.count('gateway_acks')
+        await self.send({'op': OP_HEARTBEAT_ACK, 'd': None})
+
+    async def handle(self, payload: Dict[str, Any]) -> None:
+        op, d = payload.get('op'), payload.get('d')
+
+        if op == OP_HEARTBEAT:
+            self.mock.stats.count('gateway_heartbeats')
+            asyncio.ensure_future(self.ack())
+        elif op == OP_IDENTIFY:
+            if self.session:
+                return await self.ws.close(CLOSE_ALREADY_AUTHENTICATED, 'Already authenticated')
+
+            if not self.mock.token_is_valid(d.get('token') if isinstance(d, dict) else None):
+                return await self.ws.close(CLOSE_AUTHENTICATION_FAILED, 'Authentication failed')
+
+            shard = d.get('shard') or [0, 1]
+
+            if len(shard) != 2 or not 0 <= shard[0] < shard[1]:
+                return await self.ws.close(CLOSE_INVALID_SHARD, 'Invalid shard')
+
+            if shard[1] < self.mock.args.shards:
+                return await self.ws.close(CLOSE_SHARDING_REQUIRED, 'Sharding required')
+
+            if not self.mock.identify_slot(shard[0]):
+                self.mock.stats.count('gateway_identifies_rate_limited')
+                return await self.send({'op': OP_INVALID_SESSION, 'd': False})
+
+            self.mock.stats.count('gateway_identifies')
+            self.payload_compress = bool(d.get('compress'))
+            self.session = Session()
+            self.mock.sessions[self.session.id] = self.session
+
+            if d.get('presence'):
+                self.mock.stats.count('gateway_identify_presences')
+                self.mock.presence = d['presence']
+
+            # guild belongs to the shard by its id, as Discord assigns it
+            guilds = [GUILD_ID] if (int(GUILD_ID) >> 22) % shard[1] == shard[0] else []
+            await self.dispatch('READY', {
+                'v': 10,
+                'user': BOT,
+                'session_id': self.session.id,
+                'resume_gateway_url': self.mock.gateway_url,
+                'shard': shard,
+                'guilds': [{'id': guild_id, 'unavailable': True} for guild_id in guilds],
+            })
+
+            if guilds and d.get('intents', 0) & INTENT_GUILDS:
+                others = guild_members(self.mock.args.guild_members)
+                large = len(others) + 1 > d.get('large_threshold', LARGE_THRESHOLD_DEFAULT)
+                # large guild is sent without offline members, as Discord does
+                await self.dispatch('GUILD_CREATE', {
+                    'id': GUILD_ID,
+                    'name': 'Mock guild',
+                    'large': large,
+                    'member_count': len(others) + 1,
+                    'roles': roles(GUILD_ID),
+                    'channels': channels(GUILD_ID),
+                    'members': [member(BOT)] + [member(u) for u, status in others if status == 'online' or not large],
+                    'presences': [{'user': {'id': u['id']}, 'status': status, 'activities': [], 'client_status': {'desktop': status}}
+                                  for u, status in others if status == 'online'],
+                })
+        elif op == OP_RESUME:
+            session = self.mock.sessions.get(d.get('session_id')) if isinstance(d, dict) else None
+            seq = d.get('seq') if isinstance(d, dict) else None
+            missed = [p for p in session.backlog if p['s'] > (seq or 0)] if session else []
+
+            if not session or not self.mock.token_is_valid(d.get('token')) or (missed and missed[0]['s'] != (seq or 0) + 1):
+                self.mock.stats.count('gateway_resumes_rejected')
+                return await self.send({'op': OP_INVALID_SESSION, 'd': False})
+
+            self.mock.stats.count('gateway_resumes')
+            self.session = session
+
+            # session lives on one connection, the one it moved from is closed as Discord does
+            for other in [c for c in self.mock.connections if c is not self and c.session is session]:
+                other.session = None
+                await other.ws.close(1000, 'Session resumed on another connection')
+
+            for missed_payload in missed:
+                await self.send(missed_payload)
+
+            await self.dispatch('RESUMED', None)
+        elif op == OP_PRESENCE_UPDATE:
+            self.mock.stats.count('gateway_presence_updates')
+            self.mock.presence = d
+        elif op == OP_REQUEST_GUILD_MEMBERS:
+            if not self.session:
+                return await self.ws.close(CLOSE_NOT_AUTHENTICATED, 'Not authenticated')
+
+            self.mock.stats.count('gateway_member_requests')
+            guild_id = d.get('guild_id') if isinstance(d, dict) else None
+
+            if guild_id != GUILD_ID:
+                return await self.dispatch('GUILD_MEMBERS_CHUNK', {
+                    'guild_id': guild_id, 'members': [], 'chunk_index': 0, 'chunk_count': 1, 'not_found': [guild_id],
+                })
+
+            # one member per chunk, so the client goes through the whole chunk sequence
+            members = [member(BOT), member(USER)]
+
+            for i, m in enumerate(members):
+                await self.dispatch('GUILD_MEMBERS_CHUNK', {
+                    'guild_id': guild_id, 'members': [m], 'chunk_index': i, 'chunk_count': len(members),
+                })
+        else:
+            await self.ws.close(CLOSE_UNKNOWN_OPCODE, 'Unknown opcode')
+
+    async def run(self) -> None:
+        await self.send({'op': OP_HELLO, 'd': {'heartbeat_interval': self.mock.args.heartbeat_interval}})
+
+        while not self.ws.closed:
+            op, data = await self.ws.receive()
+
+            if op == WS_CLOSE:
+                code = struct.unpack('!H', data[:2])[0] if len(data) >= 2 else None
+                logging.info('Client closed the gateway (code=%s)', code)
+                await self.ws.close(code or 1000)
+                return
+
+            if self.mock.is_stalled():
+                continue  # silent outage, nothing is answered (not even pings)
+
+            if op == WS_PING:
+                await self.ws.send(WS_PONG, data)
+                continue
+
+            if op != WS_TEXT:
+                continue
+
+            try:
+                payload = json.loads(data)
+            except ValueError:
+                return await self.ws.close(CLOSE_DECODE_ERROR, 'Decode error')
+
+            if payload.get('op') not in (OP_HEARTBEAT, OP_IDENTIFY, OP_RESUME) and not self.session:
+                return await self.ws.close(CLOSE_NOT_AUTHENTICATED, 'Not authenticated')
+
+            await self.handle(payload)
+
+
+class RateLimiter:
+    """Fixed window per bucket, with the headers Discord sends"""
+
+    def __init__(self, limit: int, period_s: float) -> None:
+        self.limit = limit
+        self.period_s = period_s
+        self.windows: Dict[str, Tuple[float, int]] = {}
+
+    def take(self, bucket: str) -> Tuple[bool, Dict[str, str]]:
+        now = time.time()
+        reset, remaining = self.windows.get(bucket, (0.0, self.limit))
+
+        if now >= reset:
+            reset, remaining = now + self.period_s, self.limit
+
+        allowed = remaining > 0
+        remaining = max(remaining - 1, 0)
+        self.windows[bucket] = (reset, remaining)
+
+        return allowed, {
+            'X-RateLimit-Limit': str(self.limit),
+            'X-RateLimit-Remaining': str(remaining),
+            'X-RateLimit-Reset': '%.3f' % reset,
+            'X-RateLimit-Reset-After': '%.3f' % (reset - now),
+            'X-RateLimit-Bucket': hashlib.md5(bucket.encode()).hexdigest()[:16],
+        }
+
+
+class DiscordMock:
+    def __init__(self, args: argparse.Namespace) -> None:
+        self.args = args
+        self.stats = Stats()
+        self.sessions: Dict[str, Session] = {}
+        self.connections: List[GatewayConnection] = []
+        self.limiter = RateLimiter(args.rate_limit, args.rate_period)
+        self.attachments: Dict[str, bytes] = {}
+        self.presence: Any = None
+        self.identify_buckets: Dict[int, float] = {}
+        self.stalled_until = 0.0
+        self.gateway_url = 'ws://%s:%d' % (args.public_host, args.port)
+        self.base_url = 'http://%s:%d' % (args.public_host, args.port)
+        self.routes = [
+            ('GET', r'/api/v10/gateway/bot', self.get_gateway_bot),
+            ('GET', r'/api/v10/users/@me/guilds', self.get_guilds),
+            ('GET', r'/api/v10/guilds/(\d+)/channels', self.get_channels),
+            ('GET', r'/api/v10/guilds/(\d+)/roles', self.get_roles),
+            ('GET', r'/api/v10/guilds/(\d+)/members/(\d+)', self.get_member),
+            ('POST', r'/api/v10/channels/(\d+)/messages', self.post_message),
+            ('PUT', r'/api/v10/channels/(\d+)/messages/(\d+)/reactions/([^/]+)/@me', self.put_reaction),
+            ('GET', r'/attachments/(.+)', self.get_attachment),
+            ('POST', r'/mock/dispatch', self.mock_dispatch),
+            ('POST', r'/mock/flood', self.mock_flood),
+            ('POST', r'/mock/close', self.mock_close),
+            ('POST', r'/mock/reconnect', self.mock_reconnect),
+            ('POST', r'/mock/stall', self.mock_stall),
+            ('POST', r'/mock/invalid_session', self.mock_invalid_session),
+            ('GET', r'/mock/stats', self.mock_stats),
+        ]
+
+    def is_stalled(self) -> bool:
+        return time.monotonic() < self.stalled_until
+
+    def token_is_valid(self, token: Optional[str]) -> bool:
+        return bool(token) and (not self.args.token or token == self.args.token)
+
+    def identify_slot(self, shard_id: int) -> bool:
+        bucket = shard_id % self.args.max_concurrency
+        now = time.monotonic()
+
+        if now < self.identify_buckets.get(bucket, 0.0):
+            return False
+
+        self.identify_buckets[bucket] = now + IDENTIFY_INTERVAL_S
+        return True
+
+    async def dispatch_all(self, t: str, d: Any) -> int:
+        connections = [c for c in self.connections if c.session and not c.ws.closed]
+
+        for connection in connections:
+            await connection.dispatch(t, d)
+
+        return len(connections)
+
+    # REST API
+
+    async def get_gateway_bot(self, body: bytes, headers: Dict[str, str]) -> Tuple[int, Any]:
+        return 200, {
+            'url': self.gateway_url,
+            'shards': max(self.args.shards, 1),
+            'session_start_limit': {'total': 1000, 'remaining': 1000, 'reset_after': 0, 'max_concurrency': self.args.max_concurrency},
+        }
+
+    async def get_guilds(self, body: bytes, headers: Dict[str, str]) -> Tuple[int, Any]:
+        return 200, [{'id': GUILD_ID, 'name': 'Mock guild', 'owner': False, 'permissions': '2147483647'}]
+
+    async def get_channels(self, body: bytes, headers: Dict[str, str], guild_id: str) -> Tuple[int, Any]:
+        return 200, channels(guild_id)
+
+    async def get_roles(self, body: bytes, headers: Dict[str, str], guild_id: str) -> Tuple[int, Any]:
+        return 200, roles(guild_id)
+
+    async def get_member(self, body: bytes, headers: Dict[str, str], guild_id: str, user_id: str) -> Tuple[int, Any]:
+        user = BOT if user_id == BOT['id'] else dict(USER, id=user_id)
+        return 200, member(user)
+
+    async def post_message(self, body: bytes, headers: Dict[str, str], channel_id: str) -> Tuple[int, Any]:
+        content_type = headers.get('content-type', '')
+        files: List[Tuple[str, bytes]] = []
+
+        try:
+            if content_type.startswith('multipart/form-data'):
+                payload, files = self.parse_multipart(body, content_type)
+            else:
+                payload = json.loads(body or b'{}')
+        except ValueError:
+            return 400, {'message': '400: Bad Request', 'code': 50109}
+
+        message_id = snowflake()
+        attachments = []
+
+        for name, data in files:
+            key = '%s/%s/%s' % (channel_id, message_id, name)
+            self.attachments[key] = data
+            attachments.append({
+                'id': snowflake(), 'filename': name, 'size': len(data),
+                'url': '%s/attachments/%s' % (self.base_url, key), 'content_type': 'application/octet-stream',
+            })
+
+        message = {
+            'id': message_id, 'type': 0, 'channel_id': channel_id, 'guild_id': GUILD_ID,
+            'content': payload.get('content', ''), 'author': BOT, 'member': member(BOT),
+            'embeds': payload.get('embeds', []), 'attachments': attachments,
+            'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S.000000+00:00', time.gmtime()),
+        }
+
+        await self.dispatch_all('MESSAGE_CREATE', message)
+        return 200, message
+
+    async def put_reaction(self, body: bytes, headers: Dict[str, str], channel_id: str, message_id: str, emoji: str) -> Tuple[int, Any]:
+        await self.dispatch_all('MESSAGE_REACTION_ADD', {
+            'user_id': BOT['id'], 'message_id': message_id, 'channel_id': channel_id, 'guild_id': GUILD_ID,
+            'member': member(BOT), 'emoji': {'id': None, 'name': emoji},
+        })
+        return 204, None
+
+    async def get_attachment(self, body: bytes, headers: Dict[str, str], key: str) -> Tuple[int, Any]:
+        if key in self.attachments:
+            return 200, self.attachments[key]
+
+        match = re.match(r'generated/(\d+)', key)  # /attachments/generated/<size> for download benchmarks
+        return (200, bytes(i & 0xFF for i in range(int(match.group(1))))) if match else (404, {'message': 'Unknown attachment'})
+
+    @staticmethod
+    def parse_multipart(body: bytes, content_type: str) -> Tuple[Dict[str, Any], List[Tuple[str, bytes]]]:
+        boundary = re.search(r'boundary=([^;]+)', content_type)
+
+        if not boundary:
+            raise ValueError('no boundary')
+
+        payload: Dict[str, Any] = {}
+        files = []
+
+        for part in body.split(b'--' + boundary.group(1).strip('"').encode()):
+            if b'\r\n\r\n' not in part:
+                continue
+
+            head, data = part.split(b'\r\n\r\n', 1)
+            data = data[:-2] if data.endswith(b'\r\n') else data
+            name = re.search(rb'name="([^"]*)"', head)
+            filename = re.search(rb'filename="([^"]*)"', head)
+
+            if filename:
+                files.append((filename.group(1).decode(), data))
+            elif name and name.group(1) == b'payload_json':
+                payload = json.loads(data)
+
+        return payload, files
+
+    # control
+
+    @staticmethod
+    def complete_dispatch(t: str, d: Any) -> Any:
+        if t == 'MESSAGE_CREATE' and isinstance(d, dict):
+            return dict({
+                'id': snowflake(), 'type': 0, 'channel_id': CHANNEL_ID, 'guild_id': GUILD_ID, 'content': '',
+                'author': USER, 'member': member(USER), 'embeds': [], 'attachments': [],
+            }, **d)
+
+        return d
+
+    async def mock_dispatch(self, body: bytes, headers: Dict[str, str]) -> Tuple[int, Any]:
+        request = json.loads(body or b'{}')
+        t = request.get('t', 'MESSAGE_CREATE')
+        return 200, {'connections': await self.dispatch_all(t, self.complete_dispatch(t, request.get('d', {})))}
+
+    async def mock_flood(self, body: bytes, headers: Dict[str, str]) -> Tuple[int, Any]:
+        request = json.loads(body or b'{}')
+        t, count = request.get('t', 'MESSAGE_CREATE'), int(request.get('count', 100))
+        started = time.monotonic()
+
+        for _ in range(count):
+            await self.dispatch_all(t, self.complete_dispatch(t, request.get('d', {})))
+
+        elapsed = time.monotonic() - started
+        return 200, {'count': count, 'elapsed_s': round(elapsed, 3), 'per_second': round(count / elapsed, 1) if elapsed else None}
+
+    async def mock_close(self, body: bytes, headers: Dict[str, str]) -> Tuple[int, Any]:
+        code = int(json.loads(body or b'{}').get('code', 4000))
+
+        for connection in list(self.connections):
+            await connection.ws.close(code, 'Closed by mock')
+
+        return 200, {'code': code}
+
+    async def mock_reconnect(self, body: bytes, headers: Dict[str, str]) -> Tuple[int, Any]:
+        for connection in [c for c in self.connections if c.session]:
+            await connection.send({'op': OP_RECONNECT, 'd': None})
+
+        return 200, {}
+
+    async def mock_stall(self, body: bytes, headers: Dict[str, str]) -> Tuple[int, Any]:
+        seconds = float(json.loads(body or b'{}').get('seconds', 60))
+        self.stalled_until = time.monotonic() + seconds
+        return 200, {'seconds': seconds}
+
+    async def mock_invalid_session(self, body: bytes, headers: Dict[str, str]) -> Tuple[int, Any]:
+        resumable = bool(json.loads(body or b'{}').get('resumable', False))
+
+        for connection in list(self.connections):
+            await connection.send({'op': OP_INVALID_SESSION, 'd': resumable})
+
+        return 200, {'resumable': resumable}
+
+    async def mock_stats(self, body: bytes, headers: Dict[str, str]) -> Tuple[int, Any]:
+        return 200, dict(self.stats.to_dict(), connections=len(self.connections), presence=self.presence)
+
+    # HTTP
+
+    async def respond(self, writer: asyncio.StreamWriter, status: int, data: Any, headers: Dict[str, str]) -> None:
+        if data is None:
+            body, content_type = b'', None
+        elif isinstance(data, bytes):
+            body, content_type = data, 'application/octet-stream'
+        else:
+            body, content_type = json.dumps(data).encode(), 'application/json'
+
+        reason = {200: 'OK', 204: 'No Content', 400: 'Bad Request', 401: 'Unauthorized', 404: 'Not Found', 429: 'Too Many Requests'}.get(status, '')
+        lines = ['HTTP/1.1 %d %s' % (status, reason), 'Content-Length: %d' % len(body)]
+        lines += ['Content-Type: %s' % content_type] if content_type else []
+        lines += ['%s: %s' % item for item in headers.items()]
+        writer.write(('\r\n'.join(lines) + '\r\n\r\n').encode() + body)
+        await writer.drain()
+
+    async def handle_request(self, method: str, path: str, headers: Dict[str, str], body: bytes, writer: asyncio.StreamWriter) -> None:
+        path = path.split('?', 1)[0]
+        self.stats.count('http_requests')
+
+        for route_method, pattern, handler in self.routes:
+            match = re.fullmatch(pattern, path)
+
+            if not match or route_method != method:
+                continue
+
+            if not path.startswith('/api/'):
+                return await self.respond(writer, *await handler(body, headers, *match.groups()), {})
+
+            if self.args.api_latency_ms:
+                await asyncio.sleep(random.uniform(0.5, 1.5) * self.args.api_latency_ms / 1000)
+
+            auth = headers.get('authorization', '')
+
+            if not self.token_is_valid(auth[4:] if auth.startswith('Bot ') else None):
+                self.stats.count('http_401')
+                return await self.respond(writer, 401, {'message': '401: Unauthorized', 'code': 0}, {})
+
+            allowed, limit_headers = self.limiter.take(method + ' ' + pattern)
+
+            if not allowed or random.random() < self.args.error_rate:
+                self.stats.count('http_429')
+                retry_after = float(limit_headers['X-RateLimit-Reset-After'])
+                return await self.respond(writer, 429, {'message': 'You are being rate limited.', 'retry_after': retry_after, 'global': False},
+                                          dict(limit_headers, **{'Retry-After': '%d' % max(1, round(retry_after))}))
+
+            self.stats.count('http_%s' % method.lower())
+            return await self.respond(writer, *await handler(body, headers, *match.groups()), limit_headers)
+
+        await self.respond(writer, 404, {'message': '404: Not Found', 'code': 0}, {})
+
+    async def handle_connection(self, reader: asyncio.StreamReader, writer: asyncio.StreamWriter) -> None:
+        try:
+            while True:
+                head = await reader.readuntil(b'\r\n\r\n')
+                lines = head.decode('latin-1').split('\r\n')
+                method, path, _ = lines[0].split(' ', 2)
+                headers = {k.strip().lower(): v.strip() for k, v in (line.split(':', 1) for line in lines[1:] if ':' in line)}
+
+                if headers.get('upgrade', '').lower() == 'websocket':
+                    return await self.handle_gateway(reader, writer, path, headers)
+
+                body = await reader.readexactly(int(headers.get('content-length', 0)))
+                await self.handle_request(method, path, headers, body, writer)
+
+                if headers.get('connection', '').lower() == 'close':
+                    break
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            writer.close()
+
+    async def handle_gateway(self, reader: asyncio.StreamReader, writer: asyncio.StreamWriter, path: str, headers: Dict[str, str]) -> None:
+        accept = base64.b64encode(hashlib.sha1((headers['sec-websocket-key'] + WS_GUID).encode()).digest()).decode()
+        writer.write(('HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n'
+                      'Sec-WebSocket-Accept: %s\r\n\r\n' % accept).encode())
+        await writer.drain()
+
+        ws = WebSocket(reader, writer)
+
+        if 'encoding=etf' in path:
+            return await ws.close(CLOSE_DECODE_ERROR, 'Mock supports only JSON encoding')
+
+        connection = GatewayConnection(self, ws, 'compress=zlib-stream' in path)
+        self.connections.append(connection)
+        self.stats.count('gateway_connections')
+        logging.info('Gateway connected (%s)', path)
+
+        try:
+            await connection.run()
+        finally:
+            self.connections.remove(connection)
+            logging.info('Gateway disconnected')
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description='Local stand-in for the Discord gateway and REST API')
+    parser.add_argument('--host', default='0.0.0.0', help='Address to listen on')
+    parser.add_argument('--public-host', default='127.0.0.1', help='Address of this machine as seen by the client (resume and attachment urls)')
+    parser.add_argument('--port', type=int, default=8080)
+    parser.add_argument('--token', default=None, help='Accept only this token. Any non-empty token is accepted by default')
+    parser.add_argument('--heartbeat-interval', type=int, default=41250, help='Heartbeat interval sent in HELLO (ms)')
+    parser.add_argument('--ack-delay-ms', type=int, default=0, help='Delay of heartbeat ACKs')
+    parser.add_argument('--drop-ack', type=float, default=0.0, help='Probability of not acknowledging a heartbeat')
+    parser.add_argument('--api-latency-ms', type=int, default=0, help='Average latency of REST responses (+-50%%)')
+    parser.add_argument('--rate-limit', type=int, default=5, help='Requests per bucket and period before 429')
+    parser.add_argument('--rate-period', type=float, default=5.0, help='Rate limit window (s)')
+    parser.add_argument('--error-rate', type=float, default=0.0, help='Probability of 429 regardless of the rate limit')
+    parser.add_argument('--guild-members', type=int, default=0, help='Members of the mock guild besides the bot (every fourth online), sent in GUILD_CREATE')
+    parser.add_argument('--shards', type=int, default=0, help='Shards required and recommended by gateway/bot. 0 does not require sharding')
+    parser.add_argument('--max-concurrency', type=int, default=1, help='Identify rate limit buckets (gateway/bot max_concurrency)')
+    parser.add_argument('-v', '--verbose', action='store_true')
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO if args.verbose else logging.WARNING, format='%(asctime)s %(message)s')
+    mock = DiscordMock(args)
+
+    async def serve() -> None:
+        server = await asyncio.start_server(mock.handle_connection, args.host, args.port)
+        logging.warning('Discord mock listening on %s (api %s/api/v10)', mock.gateway_url, mock.base_url)
+
+        async with server:
+            await server.serve_forever()
+
+    try:
+        asyncio.run(serve())
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
\ No newline at end of file
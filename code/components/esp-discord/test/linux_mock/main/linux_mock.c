@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "discord.h"
+#include "discord/session.h"
+#include "discord/message.h"
+
+#define MOCK_DEFAULT_HOST "127.0.0.1:8080"
+
+static const char* TAG = "linux_mock";
+static SemaphoreHandle_t disconnected;
+
+static void bot_event_handler(void* handler_arg, esp_event_base_t base, int32_t event_id, void* event_data) {
+    discord_handle_t bot = (discord_handle_t) handler_arg;
+    discord_event_data_t* data = (discord_event_data_t*) event_data;
+
+    switch(event_id) {
+        case DISCORD_EVENT_CONNECTED: {
+            discord_session_t* session = (discord_session_t*) data->ptr;
+            ESP_LOGI(TAG, "Bot %s#%s connected", session->user->username, session->user->discriminator);
+        } break;
+
+        case DISCORD_EVENT_MESSAGE_RECEIVED: {
+            discord_message_t* msg = (discord_message_t*) data->ptr;
+            ESP_LOGI(TAG, "New message (channel=%s): %s", msg->channel_id, msg->content);
+
+            discord_message_t echo = {
+                .content = msg->content,
+                .channel_id = msg->channel_id
+            };
+
+            discord_message_t* sent_msg = NULL;
+
+            if(discord_message_send(bot, &echo, &sent_msg) == ESP_OK) {
+                ESP_LOGI(TAG, "Echo sent (id=%s)", sent_msg->id);
+                discord_message_free(sent_msg);
+            } else {
+                ESP_LOGE(TAG, "Fail to send echo");
+            }
+        } break;
+
+        case DISCORD_EVENT_DISCONNECTED:
+            ESP_LOGW(TAG, "Bot disconnected");
+            xSemaphoreGive(disconnected);
+            break;
+    }
+}
+
+/**
+ * @brief Connect to the mock (DISCORD_MOCK_HOST environment variable, 127.0.0.1:8080 by default),
+ *        echo messages of users until the mock disconnects the bot
+ */
+void app_main(void) {
+    const char* host = getenv("DISCORD_MOCK_HOST") ? getenv("DISCORD_MOCK_HOST") : MOCK_DEFAULT_HOST;
+    char gateway_url[64], api_url[64];
+    snprintf(gateway_url, sizeof(gateway_url), "ws://%s", host);
+    snprintf(api_url, sizeof(api_url), "http://%s/api/v10", host);
+
+    discord_config_t cfg = {
+        .gateway_url = gateway_url,
+        .api_url = api_url
+    };
+
+    disconnected = xSemaphoreCreateBinary();
+    discord_handle_t bot = discord_create(&cfg);
+
+    // echoed messages are dispatched back by the mock, so only users are answered
+    discord_event_filter_t users_only = {
+        .author = DISCORD_EVENT_FILTER_AUTHOR_NOT_BOT
+    };
+
+    ESP_ERROR_CHECK(discord_register_events(bot, DISCORD_EVENT_CONNECTED, bot_event_handler, bot));
+    ESP_ERROR_CHECK(discord_register_events(bot, DISCORD_EVENT_DISCONNECTED, bot_event_handler, bot));
+    ESP_ERROR_CHECK(discord_register_events_filtered(bot, DISCORD_EVENT_MESSAGE_RECEIVED, &users_only, bot_event_handler, bot));
+    ESP_ERROR_CHECK(discord_login(bot));
+
+    xSemaphoreTake(disconnected, portMAX_DELAY);
+
+    discord_destroy(bot);
+    exit(0);
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_arena.h"
+#include "discord/private/_json_reader.h"
+
+DISCORD_LOG_DEFINE_BASE();
+
+static const char frame_message[] =
+    "{\"t\":\"MESSAGE_CREATE\",\"s\":3,\"op\":0,\"d\":{\"type\":0,"
+    "\"member\":{\"roles\":[\"1049317394820878437\",\"1049317470620307556\"],\"nick\":\"door\"},"
+    "\"id\":\"1110841226081644624\",\"content\":\"knock \\\"please\\\"\",\"channel_id\":\"1049316126681444372\","
+    "\"author\":{\"username\":\"user\",\"id\":\"462290384412901376\",\"discriminator\":\"0\"},"
+    "\"attachments\":[{\"id\":\"1110841225612312345\",\"filename\":\"log.txt\",\"size\":1234,\"url\":\"https://cdn.discordapp.com/log.txt\"}],"
+    "\"guild_id\":\"1049316126236839946\"}}";
+
+static void assert_message(const discord_message_t* msg) {
+    TEST_ASSERT_NOT_NULL(msg);
+    TEST_ASSERT_EQUAL_STRING("1110841226081644624", msg->id);
+    TEST_ASSERT_EQUAL_STRING("knock \"please\"", msg->content);
+    TEST_ASSERT_EQUAL_STRING("462290384412901376", msg->author->id);
+    TEST_ASSERT_EQUAL_STRING("door", msg->member->nick);
+    TEST_ASSERT_EQUAL(2, msg->member->_roles_len);
+    TEST_ASSERT_EQUAL_STRING("1049317470620307556", msg->member->roles[1]);
+    TEST_ASSERT_EQUAL(1, msg->_attachments_len);
+    TEST_ASSERT_EQUAL_STRING("log.txt", msg->attachments[0]->filename);
+    TEST_ASSERT_EQUAL(1234, msg->attachments[0]->size);
+}
+
+static bool arena_contains(const discord_arena_t* arena, const void* ptr) {
+    for(; arena; arena = arena->next) {
+        const uint8_t* start = (const uint8_t*) arena;
+
+        if((const uint8_t*) ptr > start && (const uint8_t*) ptr < start + sizeof(discord_arena_t) + DISCORD_ARENA_ALIGN + arena->size) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+TEST_CASE("arena allocates aligned memory and grows by regions", "[arena]")
+{
+    discord_arena_pool_t pool;
+    discord_arena_pool_init(&pool);
+
+    discord_arena_t* arena = discord_arena_create(&pool, 100);
+    TEST_ASSERT_NOT_NULL(arena);
+    TEST_ASSERT_EQUAL(DISCORD_ARENA_CLASS_MIN_SIZE, arena->size);
+
+    char* str = discord_arena_strndup(arena, "abcdef", 3);
+    TEST_ASSERT_EQUAL_STRING("abc", str);
+
+    for(int i = 0; i < 100; i++) {
+        uint64_t* value = discord_arena_calloc(arena, sizeof(uint64_t) + 1);
+        TEST_ASSERT_NOT_NULL(value);
+        TEST_ASSERT_EQUAL(0, (uintptr_t) value % DISCORD_ARENA_ALIGN);
+        TEST_ASSERT_EQUAL(0, *value);
+        *value = i;
+    }
+
+    TEST_ASSERT_NOT_NULL(arena->next); // 100 * 16 B does not fit into one region
+    TEST_ASSERT_EQUAL_STRING("abc", str);
+
+    // allocation bigger than the region gets its own
+    TEST_ASSERT_NOT_NULL(discord_arena_calloc(arena, 10000));
+    TEST_ASSERT_EQUAL(-1, arena->current->size_class);
+
+    discord_arena_t* first = arena;
+    discord_arena_t* second = arena->next;
+    discord_arena_free(arena);
+    TEST_ASSERT_EQUAL(DISCORD_ARENA_POOL_DEPTH, pool.free_len[0]);
+
+    // regions of the class are reused
+    arena = discord_arena_create(&pool, DISCORD_ARENA_CLASS_MIN_SIZE);
+    TEST_ASSERT_TRUE(arena == first || arena == second);
+    TEST_ASSERT_EQUAL(DISCORD_ARENA_POOL_DEPTH - 1, pool.free_len[0]);
+    discord_arena_free(arena);
+
+    // heap arena without pool
+    arena = discord_arena_create(NULL, 64);
+    TEST_ASSERT_NOT_NULL(discord_arena_calloc(arena, 32));
+    discord_arena_free(arena);
+
+    discord_arena_pool_destroy(&pool);
+    TEST_ASSERT_NULL(pool.free[0]);
+}
+
+TEST_CASE("payload decoded into arena keeps the model of heap decoding", "[arena]")
+{
+    discord_arena_pool_t pool;
+    discord_arena_pool_init(&pool);
+
+    for(int i = 0; i < 3; i++) {
+        char* json = strdup(frame_message);
+        discord_payload_t* payload = discord_json_read_payload(json, strlen(json), &pool);
+        free(json);
+
+        TEST_ASSERT_NOT_NULL(payload);
+        TEST_ASSERT_NOT_NULL(payload->arena);
+        TEST_ASSERT_EQUAL(DISCORD_EVENT_MESSAGE_RECEIVED, (int) payload->t);
+
+        discord_message_t* msg = (discord_message_t*) payload->d;
+        assert_message(msg);
+        TEST_ASSERT_TRUE(arena_contains(payload->arena, msg));
+        TEST_ASSERT_TRUE(arena_contains(payload->arena, msg->member->roles[0]));
+        TEST_ASSERT_TRUE(arena_contains(payload->arena, msg->attachments[0]->url));
+
+        // copy is allocated field by field and outlives the payload
+        discord_message_t* kept = discord_message_clone(msg);
+        TEST_ASSERT_FALSE(arena_contains(payload->arena, kept));
+        discord_payload_free(payload);
+
+        assert_message(kept);
+        discord_message_free(kept);
+        TEST_ASSERT_EQUAL(1, pool.free_len[0] + pool.free_len[1]); // region is reused by the next payload
+    }
+
+    // truncated payload releases its arena
+    char* json = strndup(frame_message, strlen(frame_message) - 40);
+    TEST_ASSERT_NULL(discord_json_read_payload(json, strlen(json), &pool));
+    TEST_ASSERT_EQUAL(1, pool.free_len[0] + pool.free_len[1]);
+    free(json);
+
+    // control and guild state payloads are decoded field by field
+    json = strdup("{\"op\":10,\"d\":{\"heartbeat_interval\":41250}}");
+    discord_payload_t* payload = discord_json_read_payload(json, strlen(json), &pool);
+    TEST_ASSERT_NULL(payload->arena);
+    discord_payload_free(payload);
+    free(json);
+
+    json = strdup("{\"t\":\"GUILD_ROLE_DELETE\",\"s\":8,\"op\":0,\"d\":{\"guild_id\":\"100\",\"role_id\":\"200\"}}");
+    payload = discord_json_read_payload(json, strlen(json), &pool);
+    TEST_ASSERT_NULL(payload->arena);
+    discord_payload_free(payload);
+    free(json);
+
+    discord_arena_pool_destroy(&pool);
+}
+
+TEST_CASE("reaction and voice state copies are owned by the caller", "[arena]")
+{
+    discord_emoji_t emoji = { .name = "\xf0\x9f\x91\x8d" };
+    discord_message_reaction_t reaction = { .user_id = "1", .message_id = "2", .channel_id = "3", .emoji = &emoji };
+    discord_message_reaction_t* reaction_copy = discord_message_reaction_clone(&reaction);
+    TEST_ASSERT_NOT_NULL(reaction_copy);
+    TEST_ASSERT_EQUAL_STRING("2", reaction_copy->message_id);
+    TEST_ASSERT_NULL(reaction_copy->guild_id);
+    TEST_ASSERT_EQUAL_STRING(emoji.name, reaction_copy->emoji->name);
+    TEST_ASSERT_TRUE(reaction_copy->emoji != &emoji);
+    discord_message_reaction_free(reaction_copy);
+
+    char* roles[] = { "10", "11" };
+    discord_member_t member = { .nick = "n", .roles = roles, ._roles_len = 2 };
+    discord_voice_state_t state = { .guild_id = "1", .user_id = "2", .member = &member, .self_mute = true };
+    discord_voice_state_t* state_copy = discord_voice_state_clone(&state);
+    TEST_ASSERT_NOT_NULL(state_copy);
+    TEST_ASSERT_NULL(state_copy->channel_id);
+    TEST_ASSERT_TRUE(state_copy->self_mute);
+    TEST_ASSERT_EQUAL_STRING("11", state_copy->member->roles[1]);
+    discord_voice_state_free(state_copy);
+
+    TEST_ASSERT_NULL(discord_message_clone(NULL));
+}
\ No newline at end of file
@@ -0,0 +1,677 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_timer.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_json.h"
+#include "discord/private/_etf.h"
+#include "discord/private/_json_reader.h"
+#include "discord/private/_json_stream.h"
+
+DISCORD_LOG_DEFINE_BASE();
+
+// Recorded payloads in both encodings (ids are anonymized). In ETF, snowflakes are integers and keys are atoms
+
+static const char json_ready[] =
+    "{\"t\":\"READY\",\"s\":1,\"op\":0,\"d\":{\"v\":10,\"user\":{\"username\":\"key-bot\",\"public_flags\":0,\"id\":\"1110502089848782858\""
+    ",\"discriminator\":\"4215\",\"bot\":true,\"avatar\":null},\"session_type\":\"normal\",\"session_id\":\"3f1c2e9bd5a84d6e9e0f4c"
+    "27a1b3d5e7\",\"resume_gateway_url\":\"wss://gateway-us-east1-b.discord.gg\",\"guilds\":[{\"unavailable\":true,\"id\":\"104"
+    "9316126236839946\"}],\"application\":{\"id\":\"1110502089848782858\",\"flags\":565248}}}";
+
+static const uint8_t etf_ready[] = {
+    0x83, 0x74, 0x00, 0x00, 0x00, 0x04, 0x77, 0x01, 0x74, 0x77, 0x05, 0x52, 0x45, 0x41, 0x44, 0x59,
+    0x77, 0x01, 0x73, 0x61, 0x01, 0x77, 0x02, 0x6f, 0x70, 0x61, 0x00, 0x77, 0x01, 0x64, 0x74, 0x00,
+    0x00, 0x00, 0x07, 0x77, 0x01, 0x76, 0x61, 0x0a, 0x77, 0x04, 0x75, 0x73, 0x65, 0x72, 0x74, 0x00,
+    0x00, 0x00, 0x06, 0x77, 0x08, 0x75, 0x73, 0x65, 0x72, 0x6e, 0x61, 0x6d, 0x65, 0x6d, 0x00, 0x00,
+    0x00, 0x07, 0x6b, 0x65, 0x79, 0x2d, 0x62, 0x6f, 0x74, 0x77, 0x0c, 0x70, 0x75, 0x62, 0x6c, 0x69,
+    0x63, 0x5f, 0x66, 0x6c, 0x61, 0x67, 0x73, 0x61, 0x00, 0x77, 0x02, 0x69, 0x64, 0x6e, 0x08, 0x00,
+    0x0a, 0x00, 0xc4, 0x5b, 0xc4, 0x4b, 0x69, 0x0f, 0x77, 0x0d, 0x64, 0x69, 0x73, 0x63, 0x72, 0x69,
+    0x6d, 0x69, 0x6e, 0x61, 0x74, 0x6f, 0x72, 0x6d, 0x00, 0x00, 0x00, 0x04, 0x34, 0x32, 0x31, 0x35,
+    0x77, 0x03, 0x62, 0x6f, 0x74, 0x77, 0x04, 0x74, 0x72, 0x75, 0x65, 0x77, 0x06, 0x61, 0x76, 0x61,
+    0x74, 0x61, 0x72, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x0c, 0x73, 0x65, 0x73, 0x73, 0x69, 0x6f,
+    0x6e, 0x5f, 0x74, 0x79, 0x70, 0x65, 0x6d, 0x00, 0x00, 0x00, 0x06, 0x6e, 0x6f, 0x72, 0x6d, 0x61,
+    0x6c, 0x77, 0x0a, 0x73, 0x65, 0x73, 0x73, 0x69, 0x6f, 0x6e, 0x5f, 0x69, 0x64, 0x6d, 0x00, 0x00,
+    0x00, 0x20, 0x33, 0x66, 0x31, 0x63, 0x32, 0x65, 0x39, 0x62, 0x64, 0x35, 0x61, 0x38, 0x34, 0x64,
+    0x36, 0x65, 0x39, 0x65, 0x30, 0x66, 0x34, 0x63, 0x32, 0x37, 0x61, 0x31, 0x62, 0x33, 0x64, 0x35,
+    0x65, 0x37, 0x77, 0x12, 0x72, 0x65, 0x73, 0x75, 0x6d, 0x65, 0x5f, 0x67, 0x61, 0x74, 0x65, 0x77,
+    0x61, 0x79, 0x5f, 0x75, 0x72, 0x6c, 0x6d, 0x00, 0x00, 0x00, 0x23, 0x77, 0x73, 0x73, 0x3a, 0x2f,
+    0x2f, 0x67, 0x61, 0x74, 0x65, 0x77, 0x61, 0x79, 0x2d, 0x75, 0x73, 0x2d, 0x65, 0x61, 0x73, 0x74,
+    0x31, 0x2d, 0x62, 0x2e, 0x64, 0x69, 0x73, 0x63, 0x6f, 0x72, 0x64, 0x2e, 0x67, 0x67, 0x77, 0x06,
+    0x67, 0x75, 0x69, 0x6c, 0x64, 0x73, 0x6c, 0x00, 0x00, 0x00, 0x01, 0x74, 0x00, 0x00, 0x00, 0x02,
+    0x77, 0x0b, 0x75, 0x6e, 0x61, 0x76, 0x61, 0x69, 0x6c, 0x61, 0x62, 0x6c, 0x65, 0x77, 0x04, 0x74,
+    0x72, 0x75, 0x65, 0x77, 0x02, 0x69, 0x64, 0x6e, 0x08, 0x00, 0x0a, 0x90, 0x6f, 0x11, 0x75, 0xeb,
+    0x8f, 0x0e, 0x6a, 0x77, 0x0b, 0x61, 0x70, 0x70, 0x6c, 0x69, 0x63, 0x61, 0x74, 0x69, 0x6f, 0x6e,
+    0x74, 0x00, 0x00, 0x00, 0x02, 0x77, 0x02, 0x69, 0x64, 0x6e, 0x08, 0x00, 0x0a, 0x00, 0xc4, 0x5b,
+    0xc4, 0x4b, 0x69, 0x0f, 0x77, 0x05, 0x66, 0x6c, 0x61, 0x67, 0x73, 0x62, 0x00, 0x08, 0xa0, 0x00,
+};
+
+static const char json_message[] =
+    "{\"t\":\"MESSAGE_CREATE\",\"s\":3,\"op\":0,\"d\":{\"type\":0,\"tts\":false,\"timestamp\":\"2023-05-24T10:12:41.503000+00:00\",\"r"
+    "eferenced_message\":null,\"pinned\":false,\"nonce\":\"1110841224735440896\",\"mentions\":[],\"mention_roles\":[],\"mention"
+    "_everyone\":false,\"member\":{\"roles\":[\"1049317394820878437\"],\"premium_since\":null,\"pending\":false,\"nick\":null,\"m"
+    "ute\":false,\"joined_at\":\"2022-12-05T19:57:02.115000+00:00\",\"flags\":0,\"deaf\":false,\"communication_disabled_until"
+    "\":null,\"avatar\":null},\"id\":\"1110841226187161630\",\"flags\":0,\"embeds\":[],\"edited_timestamp\":null,\"content\":\"knoc"
+    "k\",\"components\":[],\"channel_id\":\"1049316126681444372\",\"author\":{\"username\":\"user\",\"public_flags\":0,\"id\":\"46229"
+    "0384412901376\",\"discriminator\":\"0\",\"avatar\":null,\"global_name\":\"User\"},\"attachments\":[],\"guild_id\":\"1049316126"
+    "236839946\"}}";
+
+static const uint8_t etf_message[] = {
+    0x83, 0x74, 0x00, 0x00, 0x00, 0x04, 0x77, 0x01, 0x74, 0x77, 0x0e, 0x4d, 0x45, 0x53, 0x53, 0x41,
+    0x47, 0x45, 0x5f, 0x43, 0x52, 0x45, 0x41, 0x54, 0x45, 0x77, 0x01, 0x73, 0x61, 0x03, 0x77, 0x02,
+    0x6f, 0x70, 0x61, 0x00, 0x77, 0x01, 0x64, 0x74, 0x00, 0x00, 0x00, 0x14, 0x77, 0x04, 0x74, 0x79,
+    0x70, 0x65, 0x61, 0x00, 0x77, 0x03, 0x74, 0x74, 0x73, 0x77, 0x05, 0x66, 0x61, 0x6c, 0x73, 0x65,
+    0x77, 0x09, 0x74, 0x69, 0x6d, 0x65, 0x73, 0x74, 0x61, 0x6d, 0x70, 0x6d, 0x00, 0x00, 0x00, 0x20,
+    0x32, 0x30, 0x32, 0x33, 0x2d, 0x30, 0x35, 0x2d, 0x32, 0x34, 0x54, 0x31, 0x30, 0x3a, 0x31, 0x32,
+    0x3a, 0x34, 0x31, 0x2e, 0x35, 0x30, 0x33, 0x30, 0x30, 0x30, 0x2b, 0x30, 0x30, 0x3a, 0x30, 0x30,
+    0x77, 0x12, 0x72, 0x65, 0x66, 0x65, 0x72, 0x65, 0x6e, 0x63, 0x65, 0x64, 0x5f, 0x6d, 0x65, 0x73,
+    0x73, 0x61, 0x67, 0x65, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x06, 0x70, 0x69, 0x6e, 0x6e, 0x65,
+    0x64, 0x77, 0x05, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x77, 0x05, 0x6e, 0x6f, 0x6e, 0x63, 0x65, 0x6e,
+    0x08, 0x00, 0x00, 0x40, 0x37, 0x5a, 0x35, 0x80, 0x6a, 0x0f, 0x77, 0x08, 0x6d, 0x65, 0x6e, 0x74,
+    0x69, 0x6f, 0x6e, 0x73, 0x6a, 0x77, 0x0d, 0x6d, 0x65, 0x6e, 0x74, 0x69, 0x6f, 0x6e, 0x5f, 0x72,
+    0x6f, 0x6c, 0x65, 0x73, 0x6a, 0x77, 0x10, 0x6d, 0x65, 0x6e, 0x74, 0x69, 0x6f, 0x6e, 0x5f, 0x65,
+    0x76, 0x65, 0x72, 0x79, 0x6f, 0x6e, 0x65, 0x77, 0x05, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x77, 0x06,
+    0x6d, 0x65, 0x6d, 0x62, 0x65, 0x72, 0x74, 0x00, 0x00, 0x00, 0x0a, 0x77, 0x05, 0x72, 0x6f, 0x6c,
+    0x65, 0x73, 0x6c, 0x00, 0x00, 0x00, 0x01, 0x6e, 0x08, 0x00, 0x65, 0xd0, 0xef, 0x6e, 0x9c, 0xec,
+    0x8f, 0x0e, 0x6a, 0x77, 0x0d, 0x70, 0x72, 0x65, 0x6d, 0x69, 0x75, 0x6d, 0x5f, 0x73, 0x69, 0x6e,
+    0x63, 0x65, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x07, 0x70, 0x65, 0x6e, 0x64, 0x69, 0x6e, 0x67,
+    0x77, 0x05, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x77, 0x04, 0x6e, 0x69, 0x63, 0x6b, 0x77, 0x03, 0x6e,
+    0x69, 0x6c, 0x77, 0x04, 0x6d, 0x75, 0x74, 0x65, 0x77, 0x05, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x77,
+    0x09, 0x6a, 0x6f, 0x69, 0x6e, 0x65, 0x64, 0x5f, 0x61, 0x74, 0x6d, 0x00, 0x00, 0x00, 0x20, 0x32,
+    0x30, 0x32, 0x32, 0x2d, 0x31, 0x32, 0x2d, 0x30, 0x35, 0x54, 0x31, 0x39, 0x3a, 0x35, 0x37, 0x3a,
+    0x30, 0x32, 0x2e, 0x31, 0x31, 0x35, 0x30, 0x30, 0x30, 0x2b, 0x30, 0x30, 0x3a, 0x30, 0x30, 0x77,
+    0x05, 0x66, 0x6c, 0x61, 0x67, 0x73, 0x61, 0x00, 0x77, 0x04, 0x64, 0x65, 0x61, 0x66, 0x77, 0x05,
+    0x66, 0x61, 0x6c, 0x73, 0x65, 0x77, 0x1c, 0x63, 0x6f, 0x6d, 0x6d, 0x75, 0x6e, 0x69, 0x63, 0x61,
+    0x74, 0x69, 0x6f, 0x6e, 0x5f, 0x64, 0x69, 0x73, 0x61, 0x62, 0x6c, 0x65, 0x64, 0x5f, 0x75, 0x6e,
+    0x74, 0x69, 0x6c, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x06, 0x61, 0x76, 0x61, 0x74, 0x61, 0x72,
+    0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x02, 0x69, 0x64, 0x6e, 0x08, 0x00, 0x1e, 0xc0, 0xbe, 0xb0,
+    0x35, 0x80, 0x6a, 0x0f, 0x77, 0x05, 0x66, 0x6c, 0x61, 0x67, 0x73, 0x61, 0x00, 0x77, 0x06, 0x65,
+    0x6d, 0x62, 0x65, 0x64, 0x73, 0x6a, 0x77, 0x10, 0x65, 0x64, 0x69, 0x74, 0x65, 0x64, 0x5f, 0x74,
+    0x69, 0x6d, 0x65, 0x73, 0x74, 0x61, 0x6d, 0x70, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x07, 0x63,
+    0x6f, 0x6e, 0x74, 0x65, 0x6e, 0x74, 0x6d, 0x00, 0x00, 0x00, 0x05, 0x6b, 0x6e, 0x6f, 0x63, 0x6b,
+    0x77, 0x0a, 0x63, 0x6f, 0x6d, 0x70, 0x6f, 0x6e, 0x65, 0x6e, 0x74, 0x73, 0x6a, 0x77, 0x0a, 0x63,
+    0x68, 0x61, 0x6e, 0x6e, 0x65, 0x6c, 0x5f, 0x69, 0x64, 0x6e, 0x08, 0x00, 0x14, 0xb0, 0xef, 0x2b,
+    0x75, 0xeb, 0x8f, 0x0e, 0x77, 0x06, 0x61, 0x75, 0x74, 0x68, 0x6f, 0x72, 0x74, 0x00, 0x00, 0x00,
+    0x06, 0x77, 0x08, 0x75, 0x73, 0x65, 0x72, 0x6e, 0x61, 0x6d, 0x65, 0x6d, 0x00, 0x00, 0x00, 0x04,
+    0x75, 0x73, 0x65, 0x72, 0x77, 0x0c, 0x70, 0x75, 0x62, 0x6c, 0x69, 0x63, 0x5f, 0x66, 0x6c, 0x61,
+    0x67, 0x73, 0x61, 0x00, 0x77, 0x02, 0x69, 0x64, 0x6e, 0x08, 0x00, 0x00, 0x80, 0x02, 0xc2, 0xa7,
+    0x62, 0x6a, 0x06, 0x77, 0x0d, 0x64, 0x69, 0x73, 0x63, 0x72, 0x69, 0x6d, 0x69, 0x6e, 0x61, 0x74,
+    0x6f, 0x72, 0x6d, 0x00, 0x00, 0x00, 0x01, 0x30, 0x77, 0x06, 0x61, 0x76, 0x61, 0x74, 0x61, 0x72,
+    0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x0b, 0x67, 0x6c, 0x6f, 0x62, 0x61, 0x6c, 0x5f, 0x6e, 0x61,
+    0x6d, 0x65, 0x6d, 0x00, 0x00, 0x00, 0x04, 0x55, 0x73, 0x65, 0x72, 0x77, 0x0b, 0x61, 0x74, 0x74,
+    0x61, 0x63, 0x68, 0x6d, 0x65, 0x6e, 0x74, 0x73, 0x6a, 0x77, 0x08, 0x67, 0x75, 0x69, 0x6c, 0x64,
+    0x5f, 0x69, 0x64, 0x6e, 0x08, 0x00, 0x0a, 0x90, 0x6f, 0x11, 0x75, 0xeb, 0x8f, 0x0e,
+};
+
+static const char json_reaction[] =
+    "{\"t\":\"MESSAGE_REACTION_ADD\",\"s\":4,\"op\":0,\"d\":{\"user_id\":\"462290384412901376\",\"type\":0,\"message_id\":\"1110841226"
+    "187161630\",\"member\":{\"roles\":[\"1049317394820878437\"],\"premium_since\":null,\"pending\":false,\"nick\":null,\"mute\":f"
+    "alse,\"joined_at\":\"2022-12-05T19:57:02.115000+00:00\",\"flags\":0,\"deaf\":false,\"communication_disabled_until\":null"
+    ",\"avatar\":null},\"emoji\":{\"name\":\"✅\",\"id\":null},\"channel_id\":\"1049316126681444372\",\"burst\":false,\"guild_id\":\"10"
+    "49316126236839946\"}}";
+
+static const uint8_t etf_reaction[] = {
+    0x83, 0x74, 0x00, 0x00, 0x00, 0x04, 0x77, 0x01, 0x74, 0x77, 0x14, 0x4d, 0x45, 0x53, 0x53, 0x41,
+    0x47, 0x45, 0x5f, 0x52, 0x45, 0x41, 0x43, 0x54, 0x49, 0x4f, 0x4e, 0x5f, 0x41, 0x44, 0x44, 0x77,
+    0x01, 0x73, 0x61, 0x04, 0x77, 0x02, 0x6f, 0x70, 0x61, 0x00, 0x77, 0x01, 0x64, 0x74, 0x00, 0x00,
+    0x00, 0x08, 0x77, 0x07, 0x75, 0x73, 0x65, 0x72, 0x5f, 0x69, 0x64, 0x6e, 0x08, 0x00, 0x00, 0x80,
+    0x02, 0xc2, 0xa7, 0x62, 0x6a, 0x06, 0x77, 0x04, 0x74, 0x79, 0x70, 0x65, 0x61, 0x00, 0x77, 0x0a,
+    0x6d, 0x65, 0x73, 0x73, 0x61, 0x67, 0x65, 0x5f, 0x69, 0x64, 0x6e, 0x08, 0x00, 0x1e, 0xc0, 0xbe,
+    0xb0, 0x35, 0x80, 0x6a, 0x0f, 0x77, 0x06, 0x6d, 0x65, 0x6d, 0x62, 0x65, 0x72, 0x74, 0x00, 0x00,
+    0x00, 0x0a, 0x77, 0x05, 0x72, 0x6f, 0x6c, 0x65, 0x73, 0x6c, 0x00, 0x00, 0x00, 0x01, 0x6e, 0x08,
+    0x00, 0x65, 0xd0, 0xef, 0x6e, 0x9c, 0xec, 0x8f, 0x0e, 0x6a, 0x77, 0x0d, 0x70, 0x72, 0x65, 0x6d,
+    0x69, 0x75, 0x6d, 0x5f, 0x73, 0x69, 0x6e, 0x63, 0x65, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x07,
+    0x70, 0x65, 0x6e, 0x64, 0x69, 0x6e, 0x67, 0x77, 0x05, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x77, 0x04,
+    0x6e, 0x69, 0x63, 0x6b, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x04, 0x6d, 0x75, 0x74, 0x65, 0x77,
+    0x05, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x77, 0x09, 0x6a, 0x6f, 0x69, 0x6e, 0x65, 0x64, 0x5f, 0x61,
+    0x74, 0x6d, 0x00, 0x00, 0x00, 0x20, 0x32, 0x30, 0x32, 0x32, 0x2d, 0x31, 0x32, 0x2d, 0x30, 0x35,
+    0x54, 0x31, 0x39, 0x3a, 0x35, 0x37, 0x3a, 0x30, 0x32, 0x2e, 0x31, 0x31, 0x35, 0x30, 0x30, 0x30,
+    0x2b, 0x30, 0x30, 0x3a, 0x30, 0x30, 0x77, 0x05, 0x66, 0x6c, 0x61, 0x67, 0x73, 0x61, 0x00, 0x77,
+    0x04, 0x64, 0x65, 0x61, 0x66, 0x77, 0x05, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x77, 0x1c, 0x63, 0x6f,
+    0x6d, 0x6d, 0x75, 0x6e, 0x69, 0x63, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0x5f, 0x64, 0x69, 0x73, 0x61,
+    0x62, 0x6c, 0x65, 0x64, 0x5f, 0x75, 0x6e, 0x74, 0x69, 0x6c, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77,
+    0x06, 0x61, 0x76, 0x61, 0x74, 0x61, 0x72, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x05, 0x65, 0x6d,
+    0x6f, 0x6a, 0x69, 0x74, 0x00, 0x00, 0x00, 0x02, 0x77, 0x04, 0x6e, 0x61, 0x6d, 0x65, 0x6d, 0x00,
+    0x00, 0x00, 0x03, 0xe2, 0x9c, 0x85, 0x77, 0x02, 0x69, 0x64, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77,
+    0x0a, 0x63, 0x68, 0x61, 0x6e, 0x6e, 0x65, 0x6c, 0x5f, 0x69, 0x64, 0x6e, 0x08, 0x00, 0x14, 0xb0,
+    0xef, 0x2b, 0x75, 0xeb, 0x8f, 0x0e, 0x77, 0x05, 0x62, 0x75, 0x72, 0x73, 0x74, 0x77, 0x05, 0x66,
+    0x61, 0x6c, 0x73, 0x65, 0x77, 0x08, 0x67, 0x75, 0x69, 0x6c, 0x64, 0x5f, 0x69, 0x64, 0x6e, 0x08,
+    0x00, 0x0a, 0x90, 0x6f, 0x11, 0x75, 0xeb, 0x8f, 0x0e,
+};
+
+static const char json_voice_state[] =
+    "{\"t\":\"VOICE_STATE_UPDATE\",\"s\":5,\"op\":0,\"d\":{\"member\":{\"roles\":[\"1049317394820878437\"],\"premium_since\":null,\"pe"
+    "nding\":false,\"nick\":null,\"mute\":false,\"joined_at\":\"2022-12-05T19:57:02.115000+00:00\",\"flags\":0,\"deaf\":false,\"c"
+    "ommunication_disabled_until\":null,\"avatar\":null},\"user_id\":\"462290384412901376\",\"suppress\":false,\"session_id\":"
+    "\"9a7c1f0e2b3d4c5e6f708192a3b4c5d6\",\"self_video\":false,\"self_mute\":true,\"self_deaf\":false,\"request_to_speak_tim"
+    "estamp\":null,\"mute\":false,\"guild_id\":\"1049316126236839946\",\"deaf\":false,\"channel_id\":\"1049316127147008061\"}}";
+
+static const uint8_t etf_voice_state[] = {
+    0x83, 0x74, 0x00, 0x00, 0x00, 0x04, 0x77, 0x01, 0x74, 0x77, 0x12, 0x56, 0x4f, 0x49, 0x43, 0x45,
+    0x5f, 0x53, 0x54, 0x41, 0x54, 0x45, 0x5f, 0x55, 0x50, 0x44, 0x41, 0x54, 0x45, 0x77, 0x01, 0x73,
+    0x61, 0x05, 0x77, 0x02, 0x6f, 0x70, 0x61, 0x00, 0x77, 0x01, 0x64, 0x74, 0x00, 0x00, 0x00, 0x0c,
+    0x77, 0x06, 0x6d, 0x65, 0x6d, 0x62, 0x65, 0x72, 0x74, 0x00, 0x00, 0x00, 0x0a, 0x77, 0x05, 0x72,
+    0x6f, 0x6c, 0x65, 0x73, 0x6c, 0x00, 0x00, 0x00, 0x01, 0x6e, 0x08, 0x00, 0x65, 0xd0, 0xef, 0x6e,
+    0x9c, 0xec, 0x8f, 0x0e, 0x6a, 0x77, 0x0d, 0x70, 0x72, 0x65, 0x6d, 0x69, 0x75, 0x6d, 0x5f, 0x73,
+    0x69, 0x6e, 0x63, 0x65, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x07, 0x70, 0x65, 0x6e, 0x64, 0x69,
+    0x6e, 0x67, 0x77, 0x05, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x77, 0x04, 0x6e, 0x69, 0x63, 0x6b, 0x77,
+    0x03, 0x6e, 0x69, 0x6c, 0x77, 0x04, 0x6d, 0x75, 0x74, 0x65, 0x77, 0x05, 0x66, 0x61, 0x6c, 0x73,
+    0x65, 0x77, 0x09, 0x6a, 0x6f, 0x69, 0x6e, 0x65, 0x64, 0x5f, 0x61, 0x74, 0x6d, 0x00, 0x00, 0x00,
+    0x20, 0x32, 0x30, 0x32, 0x32, 0x2d, 0x31, 0x32, 0x2d, 0x30, 0x35, 0x54, 0x31, 0x39, 0x3a, 0x35,
+    0x37, 0x3a, 0x30, 0x32, 0x2e, 0x31, 0x31, 0x35, 0x30, 0x30, 0x30, 0x2b, 0x30, 0x30, 0x3a, 0x30,
+    0x30, 0x77, 0x05, 0x66, 0x6c, 0x61, 0x67, 0x73, 0x61, 0x00, 0x77, 0x04, 0x64, 0x65, 0x61, 0x66,
+    0x77, 0x05, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x77, 0x1c, 0x63, 0x6f, 0x6d, 0x6d, 0x75, 0x6e, 0x69,
+    0x63, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0x5f, 0x64, 0x69, 0x73, 0x61, 0x62, 0x6c, 0x65, 0x64, 0x5f,
+    0x75, 0x6e, 0x74, 0x69, 0x6c, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x06, 0x61, 0x76, 0x61, 0x74,
+    0x61, 0x72, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x07, 0x75, 0x73, 0x65, 0x72, 0x5f, 0x69, 0x64,
+    0x6e, 0x08, 0x00, 0x00, 0x80, 0x02, 0xc2, 0xa7, 0x62, 0x6a, 0x06, 0x77, 0x08, 0x73, 0x75, 0x70,
+    0x70, 0x72, 0x65, 0x73, 0x73, 0x77, 0x05, 0x66, 0x61, 0x6c, 0x73, 0x65, 0x77, 0x0a, 0x73, 0x65,
+    0x73, 0x73, 0x69, 0x6f, 0x6e, 0x5f, 0x69, 0x64, 0x6d, 0x00, 0x00, 0x00, 0x20, 0x39, 0x61, 0x37,
+    0x63, 0x31, 0x66, 0x30, 0x65, 0x32, 0x62, 0x33, 0x64, 0x34, 0x63, 0x35, 0x65, 0x36, 0x66, 0x37,
+    0x30, 0x38, 0x31, 0x39, 0x32, 0x61, 0x33, 0x62, 0x34, 0x63, 0x35, 0x64, 0x36, 0x77, 0x0a, 0x73,
+    0x65, 0x6c, 0x66, 0x5f, 0x76, 0x69, 0x64, 0x65, 0x6f, 0x77, 0x05, 0x66, 0x61, 0x6c, 0x73, 0x65,
+    0x77, 0x09, 0x73, 0x65, 0x6c, 0x66, 0x5f, 0x6d, 0x75, 0x74, 0x65, 0x77, 0x04, 0x74, 0x72, 0x75,
+    0x65, 0x77, 0x09, 0x73, 0x65, 0x6c, 0x66, 0x5f, 0x64, 0x65, 0x61, 0x66, 0x77, 0x05, 0x66, 0x61,
+    0x6c, 0x73, 0x65, 0x77, 0x1a, 0x72, 0x65, 0x71, 0x75, 0x65, 0x73, 0x74, 0x5f, 0x74, 0x6f, 0x5f,
+    0x73, 0x70, 0x65, 0x61, 0x6b, 0x5f, 0x74, 0x69, 0x6d, 0x65, 0x73, 0x74, 0x61, 0x6d, 0x70, 0x77,
+    0x03, 0x6e, 0x69, 0x6c, 0x77, 0x04, 0x6d, 0x75, 0x74, 0x65, 0x77, 0x05, 0x66, 0x61, 0x6c, 0x73,
+    0x65, 0x77, 0x08, 0x67, 0x75, 0x69, 0x6c, 0x64, 0x5f, 0x69, 0x64, 0x6e, 0x08, 0x00, 0x0a, 0x90,
+    0x6f, 0x11, 0x75, 0xeb, 0x8f, 0x0e, 0x77, 0x04, 0x64, 0x65, 0x61, 0x66, 0x77, 0x05, 0x66, 0x61,
+    0x6c, 0x73, 0x65, 0x77, 0x0a, 0x63, 0x68, 0x61, 0x6e, 0x6e, 0x65, 0x6c, 0x5f, 0x69, 0x64, 0x6e,
+    0x08, 0x00, 0x3d, 0xa0, 0xaf, 0x47, 0x75, 0xeb, 0x8f, 0x0e,
+};
+
+static const char json_heartbeat_ack[] =
+    "{\"t\":null,\"s\":null,\"op\":11,\"d\":null}";
+
+static const uint8_t etf_heartbeat_ack[] = {
+    0x83, 0x74, 0x00, 0x00, 0x00, 0x04, 0x77, 0x01, 0x74, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x01,
+    0x73, 0x77, 0x03, 0x6e, 0x69, 0x6c, 0x77, 0x02, 0x6f, 0x70, 0x61, 0x0b, 0x77, 0x01, 0x64, 0x77,
+    0x03, 0x6e, 0x69, 0x6c,
+};
+
+typedef struct {
+    const char* name;
+    const char* json;
+    const uint8_t* etf;
+    size_t etf_len;
+} recorded_payload_t;
+
+#define RECORDED(name) { #name, json_ ##name, etf_ ##name, sizeof(etf_ ##name) }
+
+static const recorded_payload_t traffic[] = {
+    RECORDED(ready),
+    RECORDED(message),
+    RECORDED(reaction),
+    RECORDED(voice_state),
+    RECORDED(heartbeat_ack),
+};
+
+static uint8_t buffer[1024 + 1]; // decoder needs one spare byte after the payload
+
+static discord_payload_t* decode_etf(const uint8_t* etf, size_t len) {
+    memcpy(buffer, etf, len);
+    return discord_etf_read_payload(buffer, len, NULL);
+}
+
+/**
+ * @brief Reference decoder
+ */
+static discord_payload_t* decode_json(const char* json) {
+    return discord_json_deserialize_(payload, json, strlen(json));
+}
+
+/**
+ * @brief Decoder which gateway uses for JSON
+ */
+static discord_payload_t* read_json(const char* json) {
+    size_t len = strlen(json);
+    memcpy(buffer, json, len + 1);
+
+    return discord_json_read_payload((char*) buffer, len, NULL);
+}
+
+static discord_json_stream_t etf_stream(size_t size) {
+    discord_json_stream_t stream = {
+        .buffer = (char*) buffer,
+        .size = size,
+        .prune_keys = discord_json_stream_default_prune_keys,
+        .etf = true
+    };
+
+    discord_json_stream_reset(&stream);
+    return stream;
+}
+
+/**
+ * @brief Feed the payload in fragments of given length
+ */
+static esp_err_t etf_stream_feed(discord_json_stream_t* stream, const uint8_t* etf, size_t len, size_t fragment) {
+    for(size_t i = 0; i < len; i += fragment) {
+        esp_err_t err = discord_json_stream_feed(stream, (const char*) etf + i, len - i < fragment ? len - i : fragment);
+
+        if(err != ESP_OK) {
+            return err;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static void assert_users_equal(discord_user_t* expected, discord_user_t* actual) {
+    TEST_ASSERT_NOT_NULL(actual);
+    TEST_ASSERT_EQUAL_STRING(expected->id, actual->id);
+    TEST_ASSERT_EQUAL_STRING(expected->username, actual->username);
+    TEST_ASSERT_EQUAL_STRING(expected->discriminator, actual->discriminator);
+    TEST_ASSERT_EQUAL(expected->bot, actual->bot);
+}
+
+static void assert_members_equal(discord_member_t* expected, discord_member_t* actual) {
+    TEST_ASSERT_NOT_NULL(actual);
+    TEST_ASSERT_EQUAL_STRING(expected->nick, actual->nick);
+    TEST_ASSERT_EQUAL(expected->_roles_len, actual->_roles_len);
+
+    for(int i = 0; i < expected->_roles_len; i++) {
+        TEST_ASSERT_EQUAL_STRING(expected->roles[i], actual->roles[i]);
+    }
+}
+
+TEST_CASE("etf payloads decode into the same models as json", "[gateway]")
+{
+    for(int i = 0; i < sizeof(traffic) / sizeof(traffic[0]); i++) {
+        discord_payload_t* expected = decode_json(traffic[i].json);
+        discord_payload_t* actual = decode_etf(traffic[i].etf, traffic[i].etf_len);
+
+        TEST_ASSERT_NOT_NULL(expected);
+        TEST_ASSERT_NOT_NULL(actual);
+        TEST_ASSERT_EQUAL(expected->op, actual->op);
+        TEST_ASSERT_EQUAL(expected->s, actual->s);
+
+        if(expected->op == DISCORD_OP_DISPATCH) { // reference decoder sets the event of dispatches only
+            TEST_ASSERT_EQUAL(expected->t, actual->t);
+            TEST_ASSERT_NOT_NULL(actual->d);
+        }
+
+        switch(expected->op == DISCORD_OP_DISPATCH ? expected->t : DISCORD_EVENT_UNKNOWN) {
+            case DISCORD_EVENT_READY: {
+                    discord_session_t* e = expected->d;
+                    discord_session_t* a = actual->d;
+                    TEST_ASSERT_EQUAL_STRING(e->session_id, a->session_id);
+                    TEST_ASSERT_EQUAL_STRING(e->resume_gateway_url, a->resume_gateway_url);
+                    assert_users_equal(e->user, a->user);
+                }
+                break;
+
+            case DISCORD_EVENT_MESSAGE_RECEIVED: {
+                    discord_message_t* e = expected->d;
+                    discord_message_t* a = actual->d;
+                    TEST_ASSERT_EQUAL_STRING(e->id, a->id);
+                    TEST_ASSERT_EQUAL(e->type, a->type);
+                    TEST_ASSERT_EQUAL_STRING(e->content, a->content);
+                    TEST_ASSERT_EQUAL_STRING(e->channel_id, a->channel_id);
+                    TEST_ASSERT_EQUAL_STRING(e->guild_id, a->guild_id);
+                    TEST_ASSERT_EQUAL(e->_attachments_len, a->_attachments_len);
+                    assert_users_equal(e->author, a->author);
+                    assert_members_equal(e->member, a->member);
+                }
+                break;
+
+            case DISCORD_EVENT_MESSAGE_REACTION_ADDED: {
+                    discord_message_reaction_t* e = expected->d;
+                    discord_message_reaction_t* a = actual->d;
+                    TEST_ASSERT_EQUAL_STRING(e->user_id, a->user_id);
+                    TEST_ASSERT_EQUAL_STRING(e->message_id, a->message_id);
+                    TEST_ASSERT_EQUAL_STRING(e->channel_id, a->channel_id);
+                    TEST_ASSERT_EQUAL_STRING(e->guild_id, a->guild_id);
+                    TEST_ASSERT_NOT_NULL(a->emoji);
+                    TEST_ASSERT_EQUAL_STRING(e->emoji->name, a->emoji->name);
+                }
+                break;
+
+            case DISCORD_EVENT_VOICE_STATE_UPDATED: {
+                    discord_voice_state_t* e = expected->d;
+                    discord_voice_state_t* a = actual->d;
+                    TEST_ASSERT_EQUAL_STRING(e->guild_id, a->guild_id);
+                    TEST_ASSERT_EQUAL_STRING(e->channel_id, a->channel_id);
+                    TEST_ASSERT_EQUAL_STRING(e->user_id, a->user_id);
+                    TEST_ASSERT_EQUAL(e->deaf, a->deaf);
+                    TEST_ASSERT_EQUAL(e->mute, a->mute);
+                    TEST_ASSERT_EQUAL(e->self_deaf, a->self_deaf);
+                    TEST_ASSERT_EQUAL(e->self_mute, a->self_mute);
+                    assert_members_equal(e->member, a->member);
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        discord_payload_free(expected);
+        discord_payload_free(actual);
+    }
+}
+
+TEST_CASE("etf payloads are pruned while streaming", "[gateway]")
+{
+    const size_t fragments[] = { sizeof(etf_ready), 7, 1 };
+
+    for(int i = 0; i < sizeof(fragments) / sizeof(fragments[0]); i++) {
+        // payload does not fit into the buffer, only the retained part does
+        discord_json_stream_t stream = etf_stream(sizeof(etf_ready) - 40);
+        TEST_ASSERT_EQUAL(ESP_OK, etf_stream_feed(&stream, etf_ready, sizeof(etf_ready), fragments[i]));
+        TEST_ASSERT_TRUE(discord_json_stream_is_done(&stream));
+        TEST_ASSERT_EQUAL_STRING("READY", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_T));
+        TEST_ASSERT_EQUAL(1, discord_json_stream_get_int_field(&stream, DISCORD_JSON_STREAM_FIELD_S, -1));
+        TEST_ASSERT_EQUAL(DISCORD_OP_DISPATCH, discord_json_stream_get_int_field(&stream, DISCORD_JSON_STREAM_FIELD_OP, -1));
+
+        // guilds and application are gone and the map is still valid term
+        cJSON* cjson = discord_etf_to_cjson(buffer, stream.len);
+        cJSON* d = cJSON_GetObjectItem(cjson, "d");
+        TEST_ASSERT_NOT_NULL(d);
+        TEST_ASSERT_NULL(cJSON_GetObjectItem(d, "guilds"));
+        TEST_ASSERT_NULL(cJSON_GetObjectItem(d, "application"));
+        TEST_ASSERT_EQUAL(5, cJSON_GetArraySize(d));
+        cJSON_Delete(cjson);
+
+        discord_payload_t* payload = discord_etf_read_payload(buffer, stream.len, NULL);
+        TEST_ASSERT_NOT_NULL(payload);
+        TEST_ASSERT_EQUAL(DISCORD_EVENT_READY, (int) payload->t);
+        discord_session_t* session = payload->d;
+        TEST_ASSERT_EQUAL_STRING("3f1c2e9bd5a84d6e9e0f4c27a1b3d5e7", session->session_id);
+        TEST_ASSERT_EQUAL_STRING("1110502089848782858", session->user->id);
+        TEST_ASSERT_TRUE(session->user->bot);
+        discord_payload_free(payload);
+    }
+
+    // routing fields of other payloads
+    discord_json_stream_t stream = etf_stream(sizeof(buffer) - 1);
+    TEST_ASSERT_EQUAL(ESP_OK, etf_stream_feed(&stream, etf_message, sizeof(etf_message), 5));
+    TEST_ASSERT_TRUE(discord_json_stream_is_done(&stream));
+    TEST_ASSERT_EQUAL_STRING("MESSAGE_CREATE", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_T));
+    TEST_ASSERT_EQUAL(0, discord_json_stream_get_int_field(&stream, DISCORD_JSON_STREAM_FIELD_TYPE, -1));
+    TEST_ASSERT_EQUAL_STRING("1049316126681444372", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_CHANNEL_ID));
+    TEST_ASSERT_EQUAL_STRING("462290384412901376", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_AUTHOR_ID));
+    TEST_ASSERT_LESS_THAN(sizeof(etf_message), stream.len);
+
+    stream = etf_stream(sizeof(buffer) - 1);
+    TEST_ASSERT_EQUAL(ESP_OK, etf_stream_feed(&stream, etf_heartbeat_ack, sizeof(etf_heartbeat_ack), 3));
+    TEST_ASSERT_TRUE(discord_json_stream_is_done(&stream));
+    TEST_ASSERT_EQUAL(DISCORD_OP_HEARTBEAT_ACK, discord_json_stream_get_int_field(&stream, DISCORD_JSON_STREAM_FIELD_OP, -1));
+    TEST_ASSERT_NULL(discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_S));
+    TEST_ASSERT_NULL(discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_T));
+    TEST_ASSERT_EQUAL(sizeof(etf_heartbeat_ack), stream.len);
+
+    // retained data which does not fit
+    stream = etf_stream(60);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, etf_stream_feed(&stream, etf_message, sizeof(etf_message), 16));
+}
+
+typedef struct {
+    discord_member_record_t members[2];
+    int len;
+} scanned_members_t;
+
+static void collect_member(void* arg, const discord_member_record_t* member) {
+    scanned_members_t* scanned = arg;
+
+    if(scanned->len < 2) {
+        scanned->members[scanned->len++] = *member;
+    }
+}
+
+/**
+ * @brief Write dispatch with d.members the way Discord does. Erlang sorts keys of small maps, so "d" comes first and "t" last
+ */
+static int write_members_dispatch(uint8_t* etf, size_t size, const char* event) {
+    discord_etf_writer_t w;
+    discord_etf_writer_init(&w, etf, size);
+    discord_etf_write_map(&w, 4);
+    discord_etf_write_atom(&w, "d");
+    discord_etf_write_map(&w, 2);
+    discord_etf_write_atom(&w, "guild_id");
+    discord_etf_write_int(&w, 1049316126236839946LL);
+    discord_etf_write_atom(&w, "members");
+    discord_etf_write_list(&w, 2);
+    discord_etf_write_map(&w, 3);
+    discord_etf_write_atom(&w, "nick");
+    discord_etf_write_binary(&w, "door \\ \"key\"");
+    discord_etf_write_atom(&w, "roles");
+    discord_etf_write_list(&w, 2);
+    discord_etf_write_int(&w, 1049317394820878437LL);
+    discord_etf_write_binary(&w, "1049317470620307556");
+    discord_etf_write_list_end(&w);
+    discord_etf_write_atom(&w, "user");
+    discord_etf_write_map(&w, 1);
+    discord_etf_write_atom(&w, "id");
+    discord_etf_write_int(&w, 462290384412901376LL);
+    discord_etf_write_map(&w, 3);
+    discord_etf_write_atom(&w, "nick");
+    discord_etf_write_nil(&w);
+    discord_etf_write_atom(&w, "roles");
+    discord_etf_write_list_end(&w);
+    discord_etf_write_atom(&w, "user");
+    discord_etf_write_map(&w, 1);
+    discord_etf_write_atom(&w, "id");
+    discord_etf_write_int(&w, 1110502089848782858LL);
+    discord_etf_write_list_end(&w);
+    discord_etf_write_atom(&w, "op");
+    discord_etf_write_int(&w, DISCORD_OP_DISPATCH);
+    discord_etf_write_atom(&w, "s");
+    discord_etf_write_int(&w, 4);
+    discord_etf_write_atom(&w, "t");
+    discord_etf_write_atom(&w, event);
+
+    return discord_etf_writer_result(&w);
+}
+
+TEST_CASE("etf members chunk is scanned while it is pruned", "[gateway]")
+{
+    uint8_t chunk[256];
+    int len = write_members_dispatch(chunk, sizeof(chunk), "GUILD_MEMBERS_CHUNK");
+    TEST_ASSERT_GREATER_THAN(0, len);
+
+    scanned_members_t scanned = { 0 };
+    discord_member_record_t* members = scanned.members;
+    discord_json_stream_t stream = etf_stream(96); // members do not fit
+    stream.member_handler = collect_member;
+    stream.member_handler_arg = &scanned;
+    TEST_ASSERT_EQUAL(ESP_OK, etf_stream_feed(&stream, chunk, len, 3));
+    TEST_ASSERT_TRUE(discord_json_stream_is_done(&stream));
+    TEST_ASSERT_EQUAL(2, scanned.len);
+
+    TEST_ASSERT_EQUAL_UINT64(462290384412901376ULL, members[0].user_id);
+    TEST_ASSERT_EQUAL(2, members[0].roles_len);
+    TEST_ASSERT_EQUAL_UINT64(1049317394820878437ULL, members[0].roles[0]);
+    TEST_ASSERT_EQUAL_UINT64(1049317470620307556ULL, members[0].roles[1]);
+    TEST_ASSERT_TRUE(members[0].has_nick);
+    TEST_ASSERT_EQUAL_STRING("door \\ \"key\"", members[0].nick); // text is not escaped in ETF
+    TEST_ASSERT_EQUAL_UINT64(1110502089848782858ULL, members[1].user_id);
+    TEST_ASSERT_EQUAL(0, members[1].roles_len);
+    TEST_ASSERT_FALSE(members[1].has_nick);
+
+    // members are not retained
+    cJSON* cjson = discord_etf_to_cjson(buffer, stream.len);
+    cJSON* d = cJSON_GetObjectItem(cjson, "d");
+    TEST_ASSERT_EQUAL(1, cJSON_GetArraySize(d));
+    TEST_ASSERT_EQUAL_STRING("1049316126236839946", cJSON_GetObjectItem(d, "guild_id")->valuestring);
+    cJSON_Delete(cjson);
+    TEST_ASSERT_EQUAL_STRING("GUILD_MEMBERS_CHUNK", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_T));
+
+    // members of other event are scanned as well, event is known only once the payload is done
+    len = write_members_dispatch(chunk, sizeof(chunk), "GUILD_CREATE");
+    scanned.len = 0;
+    discord_json_stream_reset(&stream);
+    TEST_ASSERT_EQUAL(ESP_OK, etf_stream_feed(&stream, chunk, len, 3));
+    TEST_ASSERT_TRUE(discord_json_stream_is_done(&stream));
+    TEST_ASSERT_EQUAL(2, scanned.len);
+    TEST_ASSERT_EQUAL_STRING("GUILD_CREATE", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_T));
+}
+
+TEST_CASE("etf writer produces frames which decode back", "[gateway]")
+{
+    int len = discord_etf_write_heartbeat(buffer, sizeof(buffer) - 1, DISCORD_NULL_SEQUENCE_NUMBER);
+    TEST_ASSERT_GREATER_THAN(0, len);
+    cJSON* cjson = discord_etf_to_cjson(buffer, len);
+    TEST_ASSERT_EQUAL(DISCORD_OP_HEARTBEAT, cJSON_GetObjectItem(cjson, "op")->valueint);
+    TEST_ASSERT_TRUE(cJSON_IsNull(cJSON_GetObjectItem(cjson, "d")));
+    cJSON_Delete(cjson);
+
+    len = discord_etf_write_heartbeat(buffer, sizeof(buffer) - 1, 70000);
+    cjson = discord_etf_to_cjson(buffer, len);
+    TEST_ASSERT_EQUAL(70000, cJSON_GetObjectItem(cjson, "d")->valueint);
+    cJSON_Delete(cjson);
+
+    discord_identify_t identify = { .token = "token.part.signature", .intents = 33281 };
+    len = discord_etf_write_identify(buffer, sizeof(buffer) - 1, &identify);
+    TEST_ASSERT_GREATER_THAN(0, len);
+    cjson = discord_etf_to_cjson(buffer, len);
+    cJSON* d = cJSON_GetObjectItem(cjson, "d");
+    TEST_ASSERT_EQUAL(DISCORD_OP_IDENTIFY, cJSON_GetObjectItem(cjson, "op")->valueint);
+    TEST_ASSERT_EQUAL_STRING("token.part.signature", cJSON_GetObjectItem(d, "token")->valuestring);
+    TEST_ASSERT_EQUAL(33281, cJSON_GetObjectItem(d, "intents")->valueint);
+    TEST_ASSERT_EQUAL_STRING(CONFIG_IDF_TARGET, cJSON_GetObjectItem(cJSON_GetObjectItem(d, "properties"), "device")->valuestring);
+    TEST_ASSERT_EQUAL(3, cJSON_GetArraySize(d)); // optional fields are not sent
+    cJSON_Delete(cjson);
+
+    len = discord_etf_write_resume(buffer, sizeof(buffer) - 1, "token", "3f1c2e9bd5a84d6e9e0f4c27a1b3d5e7", 300);
+    cjson = discord_etf_to_cjson(buffer, len);
+    d = cJSON_GetObjectItem(cjson, "d");
+    TEST_ASSERT_EQUAL(DISCORD_OP_RESUME, cJSON_GetObjectItem(cjson, "op")->valueint);
+    TEST_ASSERT_EQUAL_STRING("3f1c2e9bd5a84d6e9e0f4c27a1b3d5e7", cJSON_GetObjectItem(d, "session_id")->valuestring);
+    TEST_ASSERT_EQUAL(300, cJSON_GetObjectItem(d, "seq")->valueint);
+    cJSON_Delete(cjson);
+
+    discord_activity_t activity = { .name = "Custom Status", .type = DISCORD_ACTIVITY_CUSTOM, .state = "Key is here" };
+    discord_presence_t presence = { .status = DISCORD_PRESENCE_IDLE, .activity = &activity };
+    len = discord_etf_write_presence(buffer, sizeof(buffer) - 1, &presence);
+    cjson = discord_etf_to_cjson(buffer, len);
+    d = cJSON_GetObjectItem(cjson, "d");
+    cJSON* activities = cJSON_GetObjectItem(d, "activities");
+    TEST_ASSERT_EQUAL(DISCORD_OP_PRESENCE_UPDATE, cJSON_GetObjectItem(cjson, "op")->valueint);
+    TEST_ASSERT_EQUAL_STRING("idle", cJSON_GetObjectItem(d, "status")->valuestring);
+    TEST_ASSERT_TRUE(cJSON_IsFalse(cJSON_GetObjectItem(d, "afk")));
+    TEST_ASSERT_EQUAL(1, cJSON_GetArraySize(activities));
+    TEST_ASSERT_EQUAL_STRING("Key is here", cJSON_GetObjectItem(cJSON_GetArrayItem(activities, 0), "state")->valuestring);
+    cJSON_Delete(cjson);
+
+    // frame which does not fit
+    TEST_ASSERT_EQUAL(-1, discord_etf_write_identify(buffer, 32, &identify));
+}
+
+TEST_CASE("identify options are written the same way by etf and json writers", "[gateway]")
+{
+    discord_activity_t activity = { .name = "\"Keys\" \\ locks\n", .type = DISCORD_ACTIVITY_WATCHING };
+    discord_presence_t presence = { .status = DISCORD_PRESENCE_DND, .activity = &activity, .afk = true };
+    discord_identify_t identify = {
+        .token = "token.part.signature",
+        .intents = 513,
+        .large_threshold = 50,
+        .compress = true,
+        .presence = &presence,
+        .shard_id = 1,
+        .shard_count = 4
+    };
+
+    cJSON* frames[2];
+
+    int len = discord_etf_write_identify(buffer, sizeof(buffer) - 1, &identify);
+    TEST_ASSERT_GREATER_THAN(0, len);
+    frames[0] = discord_etf_to_cjson(buffer, len);
+
+    len = discord_json_write_identify((char*) buffer, sizeof(buffer), &identify);
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_EQUAL(strlen((char*) buffer), len);
+    frames[1] = cJSON_Parse((char*) buffer);
+
+    for(int i = 0; i < 2; i++) {
+        TEST_ASSERT_NOT_NULL(frames[i]);
+        cJSON* d = cJSON_GetObjectItem(frames[i], "d");
+        TEST_ASSERT_EQUAL(DISCORD_OP_IDENTIFY, cJSON_GetObjectItem(frames[i], "op")->valueint);
+        TEST_ASSERT_EQUAL(513, cJSON_GetObjectItem(d, "intents")->valueint);
+        TEST_ASSERT_EQUAL(50, cJSON_GetObjectItem(d, "large_threshold")->valueint);
+        TEST_ASSERT_TRUE(cJSON_IsTrue(cJSON_GetObjectItem(d, "compress")));
+
+        cJSON* shard = cJSON_GetObjectItem(d, "shard");
+        TEST_ASSERT_EQUAL(2, cJSON_GetArraySize(shard));
+        TEST_ASSERT_EQUAL(1, cJSON_GetArrayItem(shard, 0)->valueint);
+        TEST_ASSERT_EQUAL(4, cJSON_GetArrayItem(shard, 1)->valueint);
+
+        cJSON* p = cJSON_GetObjectItem(d, "presence");
+        cJSON* a = cJSON_GetArrayItem(cJSON_GetObjectItem(p, "activities"), 0);
+        TEST_ASSERT_TRUE(cJSON_IsNull(cJSON_GetObjectItem(p, "since")));
+        TEST_ASSERT_EQUAL_STRING("dnd", cJSON_GetObjectItem(p, "status")->valuestring);
+        TEST_ASSERT_TRUE(cJSON_IsTrue(cJSON_GetObjectItem(p, "afk")));
+        TEST_ASSERT_EQUAL_STRING(activity.name, cJSON_GetObjectItem(a, "name")->valuestring);
+        TEST_ASSERT_EQUAL(DISCORD_ACTIVITY_WATCHING, cJSON_GetObjectItem(a, "type")->valueint);
+        TEST_ASSERT_NULL(cJSON_GetObjectItem(a, "state"));
+        cJSON_Delete(frames[i]);
+    }
+
+    // presence makes the frame too long, fields before it still fit
+    TEST_ASSERT_EQUAL(-1, discord_json_write_identify((char*) buffer, len - 8, &identify));
+    identify.presence = NULL;
+    TEST_ASSERT_GREATER_THAN(0, discord_json_write_identify((char*) buffer, len - 8, &identify));
+}
+
+TEST_CASE("etf decoder rejects truncated and malformed terms", "[gateway]")
+{
+    for(size_t len = 0; len < sizeof(etf_message); len++) {
+        memcpy(buffer, etf_message, len);
+        TEST_ASSERT_NULL(discord_etf_to_cjson(buffer, len));
+        memcpy(buffer, etf_message, len);
+        TEST_ASSERT_NULL(discord_etf_read_payload(buffer, len, NULL));
+
+        discord_json_stream_t stream = etf_stream(sizeof(buffer) - 1);
+        esp_err_t err = etf_stream_feed(&stream, etf_message, len, 16);
+        TEST_ASSERT_TRUE(err != ESP_OK || !discord_json_stream_is_done(&stream));
+    }
+
+    // unknown tag
+    discord_json_stream_t stream = etf_stream(sizeof(buffer) - 1);
+    const uint8_t unknown[] = { DISCORD_ETF_VERSION, 120, 0 };
+    TEST_ASSERT_EQUAL(ESP_FAIL, etf_stream_feed(&stream, unknown, sizeof(unknown), 1));
+    memcpy(buffer, unknown, sizeof(unknown));
+    TEST_ASSERT_NULL(discord_etf_read_payload(buffer, sizeof(unknown), NULL));
+
+    // nesting deeper than the limit
+    size_t len = 0;
+    buffer[len++] = DISCORD_ETF_VERSION;
+
+    for(int i = 0; i <= DISCORD_ETF_MAX_DEPTH; i++) {
+        const uint8_t list[] = { 108, 0, 0, 0, 1 };
+        memcpy(buffer + len, list, sizeof(list));
+        len += sizeof(list);
+    }
+
+    buffer[len++] = 106;
+    TEST_ASSERT_NULL(discord_etf_to_cjson(buffer, len));
+    TEST_ASSERT_NULL(discord_etf_read_payload(buffer, len, NULL));
+}
+
+TEST_CASE("etf and json decoding of the same traffic", "[gateway][benchmark]")
+{
+    const int rounds = 100;
+
+    for(int i = 0; i < sizeof(traffic) / sizeof(traffic[0]); i++) {
+        int64_t t = esp_timer_get_time();
+
+        for(int r = 0; r < rounds; r++) {
+            discord_payload_t* payload = read_json(traffic[i].json);
+            TEST_ASSERT_NOT_NULL(payload);
+            discord_payload_free(payload);
+        }
+
+        int64_t json_us = esp_timer_get_time() - t;
+        t = esp_timer_get_time();
+
+        for(int r = 0; r < rounds; r++) {
+            discord_payload_t* payload = decode_etf(traffic[i].etf, traffic[i].etf_len);
+            TEST_ASSERT_NOT_NULL(payload);
+            discord_payload_free(payload);
+        }
+
+        int64_t etf_us = esp_timer_get_time() - t;
+
+        printf("%s: json %d B, %lld us | etf %d B, %lld us (per payload)\n", traffic[i].name,
+            strlen(traffic[i].json), json_us / rounds, traffic[i].etf_len, etf_us / rounds);
+    }
+}
\ No newline at end of file
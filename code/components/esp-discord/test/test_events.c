@@ -0,0 +1,81 @@
+#include "unity.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_events.h"
+
+static void handler_a(void* arg, esp_event_base_t base, int32_t event_id, void* event_data) { }
+static void handler_b(void* arg, esp_event_base_t base, int32_t event_id, void* event_data) { }
+
+TEST_CASE("events filters select handlers and intents", "[events]")
+{
+    struct discord client = { 0 };
+    client.events_lock = xSemaphoreCreateRecursiveMutex();
+    TEST_ASSERT_NOT_NULL(client.events_lock);
+
+    TEST_ASSERT_EQUAL(0, dcev_required_intents(&client));
+
+    const char* channels[] = { "1049316126681444372", NULL };
+    discord_event_filter_t filter = {
+        .channel_ids = channels,
+        .author = DISCORD_EVENT_FILTER_AUTHOR_NOT_BOT
+    };
+
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_register(&client, DISCORD_EVENT_CONNECTED, NULL, handler_a, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_register(&client, DISCORD_EVENT_MESSAGE_RECEIVED, &filter, handler_a, NULL));
+    channels[0] = "overwritten"; // filter is copied
+
+    TEST_ASSERT_EQUAL(DISCORD_INTENT_GUILD_MESSAGES | DISCORD_INTENT_MESSAGE_CONTENT, dcev_required_intents(&client));
+
+    discord_event_attrs_t user_msg = { .scoped = true, .channel_id = "1049316126681444372", .guild_id = "1", .author_bot = 0 };
+    discord_event_attrs_t bot_msg = { .scoped = true, .channel_id = "1049316126681444372", .guild_id = "1", .author_bot = 1 };
+    discord_event_attrs_t other_channel = { .scoped = true, .channel_id = "1049316126681444373", .guild_id = "1", .author_bot = 0 };
+    discord_event_attrs_t unscoped = { .author_bot = -1 };
+
+    TEST_ASSERT_TRUE(dcev_is_wanted(&client, DISCORD_EVENT_MESSAGE_RECEIVED, &user_msg));
+    TEST_ASSERT_FALSE(dcev_is_wanted(&client, DISCORD_EVENT_MESSAGE_RECEIVED, &bot_msg));
+    TEST_ASSERT_FALSE(dcev_is_wanted(&client, DISCORD_EVENT_MESSAGE_RECEIVED, &other_channel));
+    TEST_ASSERT_FALSE(dcev_is_wanted(&client, DISCORD_EVENT_MESSAGE_REACTION_ADDED, &user_msg));
+    TEST_ASSERT_TRUE(dcev_is_wanted(&client, DISCORD_EVENT_CONNECTED, &unscoped));
+
+    // unfiltered handler for any event receives everything
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_register(&client, DISCORD_EVENT_ANY, NULL, handler_b, NULL));
+    TEST_ASSERT_TRUE(dcev_is_wanted(&client, DISCORD_EVENT_MESSAGE_RECEIVED, &other_channel));
+    TEST_ASSERT_TRUE(dcev_required_intents(&client) & DISCORD_INTENT_GUILD_MESSAGE_REACTIONS);
+
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_unregister(&client, DISCORD_EVENT_ANY, handler_b));
+    TEST_ASSERT_FALSE(dcev_is_wanted(&client, DISCORD_EVENT_MESSAGE_RECEIVED, &other_channel));
+
+    dcev_destroy(&client);
+    TEST_ASSERT_NULL(client.events_lock);
+}
+
+TEST_CASE("events filters ask for direct messages only when they can match", "[events]")
+{
+    struct discord client = { 0 };
+    client.events_lock = xSemaphoreCreateRecursiveMutex();
+    TEST_ASSERT_NOT_NULL(client.events_lock);
+
+    const char* channels[] = { "1049316126681444372", NULL };
+    const char* guilds[] = { "1049316126236839946", NULL };
+    discord_event_filter_t channel_filter = { .channel_ids = channels };
+    discord_event_filter_t guild_filter = { .guild_ids = guilds };
+    discord_event_filter_t dm_filter = { .channel_ids = channels, .direct_messages = true };
+
+    // channels are assumed to be guild channels
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_register(&client, DISCORD_EVENT_MESSAGE_RECEIVED, &channel_filter, handler_a, NULL));
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_register(&client, DISCORD_EVENT_MESSAGE_REACTION_ADDED, &guild_filter, handler_a, NULL));
+    TEST_ASSERT_EQUAL(DISCORD_INTENT_GUILD_MESSAGES | DISCORD_INTENT_MESSAGE_CONTENT | DISCORD_INTENT_GUILD_MESSAGE_REACTIONS,
+        dcev_required_intents(&client));
+
+    // explicit opt-in for DM channels
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_register(&client, DISCORD_EVENT_MESSAGE_DELETED, &dm_filter, handler_b, NULL));
+    TEST_ASSERT_TRUE(dcev_required_intents(&client) & DISCORD_INTENT_DIRECT_MESSAGES);
+    TEST_ASSERT_FALSE(dcev_required_intents(&client) & DISCORD_INTENT_DIRECT_MESSAGE_REACTIONS);
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_unregister(&client, DISCORD_EVENT_MESSAGE_DELETED, handler_b));
+    TEST_ASSERT_FALSE(dcev_required_intents(&client) & DISCORD_INTENT_DIRECT_MESSAGES);
+
+    // unfiltered registration receives direct messages as well
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_register(&client, DISCORD_EVENT_MESSAGE_REACTION_REMOVED, NULL, handler_b, NULL));
+    TEST_ASSERT_EQUAL(DISCORD_INTENT_DIRECT_MESSAGE_REACTIONS, dcev_required_intents(&client) & (DISCORD_INTENT_DIRECT_MESSAGES | DISCORD_INTENT_DIRECT_MESSAGE_REACTIONS));
+
+    dcev_destroy(&client);
+}
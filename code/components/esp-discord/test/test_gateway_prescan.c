@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_json.h"
+#include "discord/private/_json_stream.h"
+#include "discord/private/_events.h"
+#include "discord/private/_gateway.h"
+
+DISCORD_LOG_DEFINE_BASE();
+
+// Recorded payloads which the gateway never decodes for the bot below (ids are anonymized).
+// Bot user id is 1110502089848782858
+
+static const char* corpus[] = {
+    // own message
+    "{\"t\":\"MESSAGE_CREATE\",\"s\":4,\"op\":0,\"d\":{\"type\":0,\"tts\":false,\"timestamp\":\"2023-05-24T10:12:42.102000+00:00\","
+    "\"referenced_message\":null,\"pinned\":false,\"nonce\":null,\"mentions\":[],\"mention_roles\":[],\"mention_everyone\":false,"
+    "\"id\":\"1110841228590846012\",\"flags\":0,\"embeds\":[],\"edited_timestamp\":null,"
+    "\"content\":\"\\u270a knocking... if anyone's there, I'll get their attention\",\"components\":[],"
+    "\"channel_id\":\"1049316126681444372\","
+    "\"author\":{\"username\":\"key-bot\",\"public_flags\":0,\"id\":\"1110502089848782858\",\"discriminator\":\"4215\",\"bot\":true,\"avatar\":null},"
+    "\"attachments\":[],\"guild_id\":\"1049316126236839946\"}}",
+    // pin notification (non-default message type)
+    "{\"t\":\"MESSAGE_CREATE\",\"s\":5,\"op\":0,\"d\":{\"type\":6,\"tts\":false,\"timestamp\":\"2023-05-24T10:14:02.311000+00:00\","
+    "\"pinned\":false,\"mentions\":[],\"mention_roles\":[],\"mention_everyone\":false,"
+    "\"id\":\"1110841564307030066\",\"flags\":0,\"embeds\":[],\"edited_timestamp\":null,\"content\":\"\",\"components\":[],"
+    "\"channel_id\":\"1049316126681444372\","
+    "\"author\":{\"username\":\"user\",\"public_flags\":0,\"id\":\"462290384412901376\",\"discriminator\":\"0\",\"avatar\":null},"
+    "\"attachments\":[],\"guild_id\":\"1049316126236839946\"}}",
+    // events which are not supported by the library
+    "{\"t\":\"TYPING_START\",\"s\":6,\"op\":0,\"d\":{\"user_id\":\"462290384412901376\",\"timestamp\":1684923301,"
+    "\"member\":{\"user\":{\"username\":\"user\",\"public_flags\":0,\"id\":\"462290384412901376\",\"discriminator\":\"0\",\"avatar\":null},"
+    "\"roles\":[\"1049317394820878437\"],\"nick\":null,\"joined_at\":\"2022-12-05T19:57:02.115000+00:00\",\"deaf\":false,\"mute\":false},"
+    "\"channel_id\":\"1049316126681444372\",\"guild_id\":\"1049316126236839946\"}}",
+    "{\"t\":\"CHANNEL_PINS_UPDATE\",\"s\":7,\"op\":0,\"d\":{\"last_pin_timestamp\":\"2023-05-24T10:14:02.311000+00:00\","
+    "\"guild_id\":\"1049316126236839946\",\"channel_id\":\"1049316126681444372\"}}",
+    // guild state event while the guild cache is disabled
+    "{\"t\":\"CHANNEL_UPDATE\",\"s\":8,\"op\":0,\"d\":{\"type\":0,\"topic\":null,\"rate_limit_per_user\":0,\"position\":0,"
+    "\"permission_overwrites\":[],\"parent_id\":\"1049316126681444370\",\"nsfw\":false,\"name\":\"key\","
+    "\"last_message_id\":\"1110841564307030066\",\"id\":\"1049316126681444372\",\"guild_id\":\"1049316126236839946\",\"flags\":0}}",
+};
+
+static const char user_message[] =
+    "{\"t\":\"MESSAGE_CREATE\",\"s\":9,\"op\":0,\"d\":{\"type\":0,\"id\":\"1110841564307030067\",\"content\":\"knock\","
+    "\"channel_id\":\"1049316126681444372\","
+    "\"author\":{\"username\":\"user\",\"id\":\"462290384412901376\",\"discriminator\":\"0\"},\"guild_id\":\"1049316126236839946\"}}";
+
+static void message_handler(void* arg, esp_event_base_t base, int32_t event_id, void* event_data) { }
+
+/**
+ * @brief Connected client of the bot with a message handler, guild and member caches are disabled
+ */
+static void client_init(struct discord* client, discord_session_t* session) {
+    *client = (struct discord) {
+        .state = DISCORD_STATE_CONNECTED,
+        .session = session,
+        .events_lock = xSemaphoreCreateRecursiveMutex()
+    };
+
+    TEST_ASSERT_NOT_NULL(client->events_lock);
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_register(client, DISCORD_EVENT_MESSAGE_RECEIVED, NULL, message_handler, NULL));
+}
+
+static void stream_payload(discord_json_stream_t* stream, const char* json) {
+    discord_json_stream_reset(stream);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_json_stream_feed(stream, json, strlen(json)));
+    TEST_ASSERT_TRUE(discord_json_stream_is_done(stream));
+}
+
+TEST_CASE("gateway filter decodes only payloads which can be handled", "[gateway]")
+{
+    discord_user_t bot = { .id = "1110502089848782858" };
+    discord_session_t session = { .user = &bot };
+    struct discord client;
+    client_init(&client, &session);
+
+    char buffer[2048 + 1];
+    discord_json_stream_t stream = {
+        .buffer = buffer,
+        .size = sizeof(buffer) - 1,
+        .prune_keys = discord_json_stream_default_prune_keys
+    };
+
+    for(int i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        stream_payload(&stream, corpus[i]);
+        TEST_ASSERT_FALSE_MESSAGE(dcgw_whether_payload_should_be_decoded(&client, &stream), corpus[i]);
+    }
+
+    stream_payload(&stream, user_message);
+    TEST_ASSERT_TRUE(dcgw_whether_payload_should_be_decoded(&client, &stream));
+
+    // nobody handles the message
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_unregister(&client, DISCORD_EVENT_MESSAGE_RECEIVED, message_handler));
+    TEST_ASSERT_FALSE(dcgw_whether_payload_should_be_decoded(&client, &stream));
+
+    // nothing but READY is decoded until the client is connected
+    TEST_ASSERT_EQUAL(ESP_OK, dcev_register(&client, DISCORD_EVENT_MESSAGE_RECEIVED, NULL, message_handler, NULL));
+    client.state = DISCORD_STATE_CONNECTING;
+    TEST_ASSERT_FALSE(dcgw_whether_payload_should_be_decoded(&client, &stream));
+
+    dcev_destroy(&client);
+}
+
+#define BENCHMARK_RUNS (100)
+
+typedef struct {
+    size_t bytes;
+    size_t blocks;
+} heap_usage_t;
+
+static heap_usage_t heap_usage() {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+
+    return (heap_usage_t) {
+        .bytes = info.total_allocated_bytes,
+        .blocks = info.allocated_blocks
+    };
+}
+
+static void prescan(struct discord* client, discord_json_stream_t* stream, const char* json, size_t len) {
+    discord_json_stream_reset(stream);
+    discord_json_stream_feed(stream, json, len);
+    TEST_ASSERT_FALSE(dcgw_whether_payload_should_be_decoded(client, stream));
+}
+
+/**
+ * @brief Path of every payload before the filter: cJSON tree is built and decoded into the model, which is then dropped
+ * @param peak If not NULL, heap usage is measured while both the tree and the model are allocated
+ */
+static void decode(discord_json_stream_t* stream, const char* json, size_t len, heap_usage_t* peak) {
+    discord_json_stream_reset(stream);
+    discord_json_stream_feed(stream, json, len);
+
+    cJSON* cjson = cJSON_ParseWithLength(stream->buffer, stream->len);
+    TEST_ASSERT_NOT_NULL(cjson);
+    discord_payload_t* payload = discord_payload_from_cjson(cjson);
+    TEST_ASSERT_NOT_NULL(payload);
+
+    if(peak) {
+        *peak = heap_usage();
+    }
+
+    cJSON_Delete(cjson);
+    discord_payload_free(payload);
+}
+
+TEST_CASE("ignored payloads are rejected without allocation", "[gateway][benchmark]")
+{
+    discord_user_t bot = { .id = "1110502089848782858" };
+    discord_session_t session = { .user = &bot };
+    struct discord client;
+    client_init(&client, &session);
+
+    char buffer[2048 + 1];
+    discord_json_stream_t stream = {
+        .buffer = buffer,
+        .size = sizeof(buffer) - 1,
+        .prune_keys = discord_json_stream_default_prune_keys
+    };
+
+    for(int i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        size_t len = strlen(corpus[i]);
+
+        // heap is measured in a separate pass, because heap_caps_get_info walks the whole heap
+        heap_usage_t before = heap_usage();
+        prescan(&client, &stream, corpus[i], len);
+        heap_usage_t after = heap_usage();
+        TEST_ASSERT_EQUAL(before.bytes, after.bytes);
+        TEST_ASSERT_EQUAL(before.blocks, after.blocks);
+
+        heap_usage_t peak;
+        decode(&stream, corpus[i], len, &peak);
+        after = heap_usage();
+        TEST_ASSERT_EQUAL(before.bytes, after.bytes);
+
+        int64_t t = esp_timer_get_time();
+        for(int run = 0; run < BENCHMARK_RUNS; run++) {
+            prescan(&client, &stream, corpus[i], len);
+        }
+        int64_t prescan_ns = (esp_timer_get_time() - t) * 1000 / BENCHMARK_RUNS;
+
+        t = esp_timer_get_time();
+        for(int run = 0; run < BENCHMARK_RUNS; run++) {
+            decode(&stream, corpus[i], len, NULL);
+        }
+        int64_t decode_ns = (esp_timer_get_time() - t) * 1000 / BENCHMARK_RUNS;
+
+        printf("payload %d (len=%d): pre-scan %lld ns, 0 B in 0 blocks | cJSON decode %lld ns, peak %d B in %d blocks\n",
+            i, len, prescan_ns, decode_ns, peak.bytes - before.bytes, peak.blocks - before.blocks);
+    }
+
+    dcev_destroy(&client);
+}
\ No newline at end of file
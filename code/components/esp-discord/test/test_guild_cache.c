@@ -0,0 +1,174 @@
+#include <string.h>
+#include "unity.h"
+#include "cutils.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_guild_cache.h"
+#include "discord/private/_json.h"
+
+DISCORD_LOG_DEFINE_BASE();
+
+static const char guild_create[] =
+    "{\"t\":\"GUILD_CREATE\",\"s\":2,\"op\":0,\"d\":{\"id\":\"613425648685547541\",\"name\":\"Keybot\","
+    "\"roles\":["
+        "{\"id\":\"613425648685547541\",\"name\":\"@everyone\",\"position\":0,\"permissions\":\"104324673\"},"
+        "{\"id\":\"613430047285968897\",\"name\":\"Keyholder\",\"position\":2,\"permissions\":\"8\"}"
+    "],"
+    "\"channels\":["
+        "{\"id\":\"613425648685547543\",\"type\":0,\"name\":\"general\"},"
+        "{\"id\":\"613430191569862668\",\"type\":0,\"name\":\"firmware\"},"
+        "{\"id\":\"613425648685547545\",\"type\":2,\"name\":\"General\"}"
+    "]}}";
+
+static const char role_update[] =
+    "{\"t\":\"GUILD_ROLE_UPDATE\",\"s\":3,\"op\":0,\"d\":{\"guild_id\":\"613425648685547541\","
+    "\"role\":{\"id\":\"613430047285968897\",\"name\":\"Doorman\",\"position\":1,\"permissions\":\"268435456\"}}}";
+
+static const char role_delete[] =
+    "{\"t\":\"GUILD_ROLE_DELETE\",\"s\":4,\"op\":0,\"d\":{\"guild_id\":\"613425648685547541\",\"role_id\":\"613425648685547541\"}}";
+
+static const char channel_create[] =
+    "{\"t\":\"CHANNEL_CREATE\",\"s\":5,\"op\":0,\"d\":{\"id\":\"613430191569862670\",\"type\":0,\"name\":\"log\",\"guild_id\":\"613425648685547541\"}}";
+
+static const char channel_delete[] =
+    "{\"t\":\"CHANNEL_DELETE\",\"s\":6,\"op\":0,\"d\":{\"id\":\"613430191569862668\",\"type\":0,\"name\":\"firmware\",\"guild_id\":\"613425648685547541\"}}";
+
+static discord_guild_state_t* decode(const char* json, discord_payload_t** out_payload) {
+    *out_payload = discord_json_deserialize_(payload, json, strlen(json));
+    return *out_payload ? (discord_guild_state_t*) (*out_payload)->d : NULL;
+}
+
+static void put_guild(discord_guild_cache_t* cache, const char* guild_id, const char* channel_name) {
+    discord_channel_t channel = { .id = "1", .type = DISCORD_CHANNEL_GUILD_TEXT, .name = (char*) channel_name };
+    discord_channel_t* channels[] = { &channel };
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_set_channels(cache, guild_id, channels, 1));
+}
+
+TEST_CASE("guild cache is filled by GUILD_CREATE and kept current by role and channel events", "[guild_cache]")
+{
+    discord_guild_cache_t cache;
+    discord_guild_cache_init(&cache, 4 * 1024);
+
+    discord_payload_t* payload = NULL;
+    discord_guild_state_t* state = decode(guild_create, &payload);
+    TEST_ASSERT_NOT_NULL(state);
+    TEST_ASSERT_EQUAL(DISCORD_EVENT_GUILD_CREATED, (int) payload->t);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_set_roles(&cache, state->guild_id, state->roles, state->roles_len));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_set_channels(&cache, state->guild_id, state->channels, state->channels_len));
+    discord_payload_free(payload);
+
+    discord_role_t** roles = NULL;
+    discord_role_len_t roles_len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_get_roles(&cache, "613425648685547541", &roles, &roles_len));
+    TEST_ASSERT_EQUAL(2, roles_len);
+    TEST_ASSERT_EQUAL_STRING("613430047285968897", roles[1]->id);
+    TEST_ASSERT_EQUAL_STRING("Keyholder", roles[1]->name);
+    TEST_ASSERT_EQUAL_STRING("8", roles[1]->permissions);
+    TEST_ASSERT_EQUAL(2, roles[1]->position);
+    cu_list_tfreex(roles, discord_role_len_t, roles_len, discord_role_free);
+
+    state = decode(role_update, &payload);
+    TEST_ASSERT_NOT_NULL(state);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_put_role(&cache, state->guild_id, state->roles[0]));
+    discord_payload_free(payload);
+
+    state = decode(role_delete, &payload);
+    TEST_ASSERT_NOT_NULL(state);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_remove_role(&cache, state->guild_id, state->id));
+    discord_payload_free(payload);
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_get_roles(&cache, "613425648685547541", &roles, &roles_len));
+    TEST_ASSERT_EQUAL(1, roles_len);
+    TEST_ASSERT_EQUAL_STRING("Doorman", roles[0]->name);
+    TEST_ASSERT_EQUAL_STRING("268435456", roles[0]->permissions);
+    cu_list_tfreex(roles, discord_role_len_t, roles_len, discord_role_free);
+
+    state = decode(channel_create, &payload);
+    TEST_ASSERT_NOT_NULL(state);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_put_channel(&cache, state->guild_id, state->channels[0]));
+    discord_payload_free(payload);
+
+    state = decode(channel_delete, &payload);
+    TEST_ASSERT_NOT_NULL(state);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_remove_channel(&cache, state->guild_id, state->id));
+    discord_payload_free(payload);
+
+    discord_channel_t** channels = NULL;
+    int channels_len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_get_channels(&cache, "613425648685547541", &channels, &channels_len));
+    TEST_ASSERT_EQUAL(3, channels_len);
+    TEST_ASSERT_NULL(discord_channel_get_from_array_by_name(channels, channels_len, "firmware"));
+    discord_channel_t* log = discord_channel_get_from_array_by_name(channels, channels_len, "log");
+    TEST_ASSERT_NOT_NULL(log);
+    TEST_ASSERT_EQUAL_STRING("613430191569862670", log->id);
+    cu_list_freex(channels, channels_len, discord_channel_free);
+
+    TEST_ASSERT_EQUAL(3, cache.hits);
+    TEST_ASSERT_EQUAL(0, cache.misses);
+
+    discord_guild_cache_clear(&cache);
+    TEST_ASSERT_EQUAL(0, cache.size);
+}
+
+TEST_CASE("guild cache misses guilds and data it does not have", "[guild_cache]")
+{
+    discord_guild_cache_t cache;
+    discord_guild_cache_init(&cache, 1024);
+
+    put_guild(&cache, "100", "general");
+
+    discord_role_t** roles = NULL;
+    discord_role_len_t roles_len = 0;
+    discord_channel_t** channels = NULL;
+    int channels_len = 0;
+
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_guild_cache_get_channels(&cache, "200", &channels, &channels_len));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_guild_cache_get_roles(&cache, "100", &roles, &roles_len)); // only channels are cached
+    TEST_ASSERT_NULL(roles);
+
+    discord_role_t role = { .id = "300", .name = "new", .permissions = "0" };
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_guild_cache_put_role(&cache, "100", &role)); // partial role list is never cached
+    TEST_ASSERT_EQUAL(2, cache.misses);
+
+    discord_guild_cache_remove_guild(&cache, "100");
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_guild_cache_get_channels(&cache, "100", &channels, &channels_len));
+    TEST_ASSERT_EQUAL(0, cache.size);
+}
+
+TEST_CASE("guild cache evicts least recently used guild when over the limit", "[guild_cache]")
+{
+    discord_guild_cache_t cache;
+    discord_guild_cache_init(&cache, 1024);
+
+    put_guild(&cache, "100", "general");
+    size_t guild_size = cache.guilds->size;
+    discord_guild_cache_clear(&cache);
+
+    discord_guild_cache_init(&cache, 2 * guild_size);
+
+    put_guild(&cache, "100", "general");
+    put_guild(&cache, "200", "general");
+
+    discord_channel_t** channels = NULL;
+    int channels_len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_get_channels(&cache, "100", &channels, &channels_len)); // 200 is the least recently used now
+    cu_list_freex(channels, channels_len, discord_channel_free);
+
+    put_guild(&cache, "300", "general");
+    TEST_ASSERT_EQUAL(1, cache.evictions);
+    TEST_ASSERT_LESS_OR_EQUAL(cache.limit, cache.size);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_guild_cache_get_channels(&cache, "200", &channels, &channels_len));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_get_channels(&cache, "100", &channels, &channels_len));
+    cu_list_freex(channels, channels_len, discord_channel_free);
+
+    // guild which alone does not fit is not cached at all
+    discord_channel_t channel = { .id = "1", .type = DISCORD_CHANNEL_GUILD_TEXT, .name = "a name much longer than the whole cache limit allows to keep in memory" };
+    discord_channel_t* long_channels[] = { &channel, &channel, &channel, &channel };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, discord_guild_cache_set_channels(&cache, "400", long_channels, 4));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_guild_cache_get_channels(&cache, "400", &channels, &channels_len));
+    TEST_ASSERT_EQUAL(1, cache.evictions); // other guilds stay
+    TEST_ASSERT_EQUAL(ESP_OK, discord_guild_cache_get_channels(&cache, "300", &channels, &channels_len));
+    cu_list_freex(channels, channels_len, discord_channel_free);
+
+    discord_guild_cache_clear(&cache);
+}
\ No newline at end of file
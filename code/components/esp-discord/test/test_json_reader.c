@@ -0,0 +1,214 @@
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_json_reader.h"
+#include "discord/private/_json.h"
+
+DISCORD_LOG_DEFINE_BASE();
+
+static const char frame_message[] =
+    "{\"t\":\"MESSAGE_CREATE\",\"s\":3,\"op\":0,\"d\":{\"type\":0,\"tts\":false,\"timestamp\":\"2023-05-24T10:12:41.503000+00:00\","
+    "\"referenced_message\":null,\"pinned\":false,\"nonce\":\"1110841224735440896\","
+    "\"mentions\":[{\"username\":\"key-bot\",\"id\":\"1110502089848782858\",\"discriminator\":\"4215\",\"bot\":true}],"
+    "\"member\":{\"roles\":[\"1049317394820878437\",\"1049317470620307556\"],\"nick\":null,\"joined_at\":\"2022-12-05T19:57:02.115000+00:00\",\"deaf\":false},"
+    "\"id\":\"1110841226081644624\",\"flags\":0,\"embeds\":[{\"title\":\"t\",\"fields\":[{\"name\":\"n\",\"value\":\"v\"}]}],"
+    "\"content\":\"knock \\\"please\\\" \\u00e9 \\ud83d\\udc4b\",\"components\":[],"
+    "\"channel_id\":\"1049316126681444372\","
+    "\"author\":{\"username\":\"user\",\"public_flags\":0,\"id\":\"462290384412901376\",\"discriminator\":\"0\",\"avatar\":null},"
+    "\"attachments\":[{\"id\":\"1110841225612312345\",\"filename\":\"log.txt\",\"size\":1234,\"url\":\"https://cdn.discordapp.com/log.txt\",\"content_type\":\"text/plain\"},"
+                     "{\"id\":\"1110841225612312346\",\"filename\":\"a.png\",\"size\":5,\"url\":\"https://cdn.discordapp.com/a.png\"}],"
+    "\"guild_id\":\"1049316126236839946\"}}";
+
+static char* copy(const char* json) {
+    return strdup(json); // reader modifies the input
+}
+
+static void assert_message(discord_message_t* msg) {
+    TEST_ASSERT_NOT_NULL(msg);
+    TEST_ASSERT_EQUAL_STRING("1110841226081644624", msg->id);
+    TEST_ASSERT_EQUAL(DISCORD_MESSAGE_DEFAULT, msg->type);
+    TEST_ASSERT_EQUAL_STRING("knock \"please\" \xc3\xa9 \xf0\x9f\x91\x8b", msg->content);
+    TEST_ASSERT_EQUAL_STRING("1049316126681444372", msg->channel_id);
+    TEST_ASSERT_EQUAL_STRING("1049316126236839946", msg->guild_id);
+    TEST_ASSERT_EQUAL_STRING("462290384412901376", msg->author->id);
+    TEST_ASSERT_EQUAL_STRING("user", msg->author->username);
+    TEST_ASSERT_FALSE(msg->author->bot);
+    TEST_ASSERT_NULL(msg->member->nick);
+    TEST_ASSERT_EQUAL(2, msg->member->_roles_len);
+    TEST_ASSERT_EQUAL_STRING("1049317470620307556", msg->member->roles[1]);
+    TEST_ASSERT_EQUAL(2, msg->_attachments_len);
+    TEST_ASSERT_EQUAL_STRING("log.txt", msg->attachments[0]->filename);
+    TEST_ASSERT_EQUAL_STRING("text/plain", msg->attachments[0]->content_type);
+    TEST_ASSERT_EQUAL(1234, msg->attachments[0]->size);
+    TEST_ASSERT_NULL(msg->attachments[1]->content_type);
+    TEST_ASSERT_EQUAL(0, msg->_embeds_len);
+}
+
+static void walk(discord_json_reader_t* reader) {
+    const char* key;
+
+    switch(discord_json_reader_peek(reader)) {
+        case DISCORD_JSON_OBJECT:
+            discord_json_reader_object(reader);
+            while(discord_json_reader_next_key(reader, &key)) { walk(reader); }
+            break;
+
+        case DISCORD_JSON_ARRAY:
+            discord_json_reader_array(reader);
+            while(discord_json_reader_next_item(reader)) { walk(reader); }
+            break;
+
+        case DISCORD_JSON_STRING:
+            discord_json_reader_string(reader, NULL);
+            break;
+
+        default:
+            discord_json_reader_skip(reader);
+            break;
+    }
+}
+
+TEST_CASE("json reader walks values in place", "[json_reader]")
+{
+    char* json = copy("{\"a\" : [1, -2.5e3, true, null, {\"x\":[[]]}], \"k\\u00e9y\":\"v\\n\", \"n\":{}}");
+    discord_json_reader_t reader;
+    const char* key;
+
+    discord_json_reader_init(&reader, json, strlen(json));
+    TEST_ASSERT_TRUE(discord_json_reader_object(&reader));
+
+    TEST_ASSERT_TRUE(discord_json_reader_next_key(&reader, &key));
+    TEST_ASSERT_EQUAL_STRING("a", key);
+    TEST_ASSERT_EQUAL(5, discord_json_reader_count(&reader));
+    TEST_ASSERT_TRUE(discord_json_reader_array(&reader));
+    TEST_ASSERT_TRUE(discord_json_reader_next_item(&reader));
+    TEST_ASSERT_EQUAL(1, discord_json_reader_int(&reader, 0));
+    TEST_ASSERT_TRUE(discord_json_reader_next_item(&reader));
+    TEST_ASSERT_EQUAL(-2, discord_json_reader_int(&reader, 0));
+    TEST_ASSERT_TRUE(discord_json_reader_next_item(&reader));
+    TEST_ASSERT_TRUE(discord_json_reader_bool(&reader));
+    TEST_ASSERT_TRUE(discord_json_reader_next_item(&reader));
+    TEST_ASSERT_NULL(discord_json_reader_string(&reader, NULL));
+    TEST_ASSERT_TRUE(discord_json_reader_next_item(&reader));
+    TEST_ASSERT_EQUAL(DISCORD_JSON_OBJECT, discord_json_reader_peek(&reader));
+    discord_json_reader_skip(&reader);
+    TEST_ASSERT_FALSE(discord_json_reader_next_item(&reader));
+
+    TEST_ASSERT_TRUE(discord_json_reader_next_key(&reader, &key));
+    TEST_ASSERT_EQUAL_STRING("k\xc3\xa9y", key);
+    size_t len = 0;
+    TEST_ASSERT_EQUAL_STRING("v\n", discord_json_reader_string(&reader, &len));
+    TEST_ASSERT_EQUAL(2, len);
+
+    TEST_ASSERT_TRUE(discord_json_reader_next_key(&reader, &key));
+    TEST_ASSERT_EQUAL_STRING("n", key);
+    TEST_ASSERT_TRUE(discord_json_reader_object(&reader));
+    TEST_ASSERT_FALSE(discord_json_reader_next_key(&reader, &key));
+
+    TEST_ASSERT_FALSE(discord_json_reader_next_key(&reader, &key));
+    TEST_ASSERT_FALSE(reader.error);
+    free(json);
+
+    json = copy("[\"a\\\"]\", 1]"); // escaped quote does not end skipped string
+    discord_json_reader_init(&reader, json, strlen(json));
+    TEST_ASSERT_TRUE(discord_json_reader_array(&reader));
+    TEST_ASSERT_TRUE(discord_json_reader_next_item(&reader));
+    discord_json_reader_skip(&reader);
+    TEST_ASSERT_TRUE(discord_json_reader_next_item(&reader));
+    TEST_ASSERT_EQUAL(1, discord_json_reader_int(&reader, 0));
+    TEST_ASSERT_FALSE(discord_json_reader_next_item(&reader));
+    TEST_ASSERT_FALSE(reader.error);
+    free(json);
+
+    const char* invalid[] = { "{\"a\":1,}", "{\"a\" 1}", "[1 2]", "{\"a\":\"\\x\"}", "{\"a\":\"\\ud83d\"}", "{\"a\":[1,{\"b\":2}" };
+
+    for(int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        json = copy(invalid[i]);
+        discord_json_reader_init(&reader, json, strlen(json));
+        walk(&reader);
+        TEST_ASSERT_TRUE_MESSAGE(reader.error, invalid[i]);
+        free(json);
+    }
+}
+
+TEST_CASE("json reader decodes message payload like cJSON decoder", "[json_reader]")
+{
+    char* json = copy(frame_message);
+    discord_payload_t* payload = discord_json_read_payload(json, strlen(json), NULL);
+    free(json);
+
+    TEST_ASSERT_NOT_NULL(payload);
+    TEST_ASSERT_EQUAL(DISCORD_OP_DISPATCH, payload->op);
+    TEST_ASSERT_EQUAL(3, payload->s);
+    TEST_ASSERT_EQUAL(DISCORD_EVENT_MESSAGE_RECEIVED, (int) payload->t);
+    assert_message((discord_message_t*) payload->d);
+    discord_payload_free(payload);
+
+    payload = discord_json_deserialize_(payload, frame_message, strlen(frame_message));
+    assert_message((discord_message_t*) payload->d);
+    discord_payload_free(payload);
+
+    // message returned by REST API
+    const char* d = strstr(frame_message, "\"d\":") + 4;
+    json = strndup(d, strlen(d) - 1);
+    discord_message_t* msg = discord_json_read_message(json, strlen(json));
+    free(json);
+    assert_message(msg);
+    discord_message_free(msg);
+}
+
+TEST_CASE("json reader decodes control payloads in any member order", "[json_reader]")
+{
+    const char* frames[] = {
+        "{\"t\":null,\"s\":null,\"op\":10,\"d\":{\"heartbeat_interval\":41250,\"_trace\":[\"gw\"]}}",
+        "{\"d\":{\"heartbeat_interval\":41250},\"op\":10}",
+        "{\"op\":9,\"d\":true}",
+        "{\"d\":{\"user_id\":\"1\",\"message_id\":\"2\",\"channel_id\":\"3\",\"emoji\":{\"id\":null,\"name\":\"\\ud83d\\udc4d\"}},\"op\":0,\"s\":7,\"t\":\"MESSAGE_REACTION_ADD\"}",
+        "{\"t\":\"GUILD_ROLE_DELETE\",\"s\":8,\"op\":0,\"d\":{\"guild_id\":\"100\",\"role_id\":\"200\"}}",
+        "{\"t\":\"MESSAGE_CREATE\",\"s\":9,\"op\":0,\"d\":{\"id\":\"1\",\"content\":\"trunc",
+    };
+
+    char* json = copy(frames[0]);
+    discord_payload_t* payload = discord_json_read_payload(json, strlen(json), NULL);
+    TEST_ASSERT_EQUAL(DISCORD_OP_HELLO, payload->op);
+    TEST_ASSERT_EQUAL(DISCORD_NULL_SEQUENCE_NUMBER, payload->s);
+    TEST_ASSERT_EQUAL(41250, ((discord_hello_t*) payload->d)->heartbeat_interval);
+    discord_payload_free(payload);
+    free(json);
+
+    json = copy(frames[1]); // data before op is decoded afterwards
+    payload = discord_json_read_payload(json, strlen(json), NULL);
+    TEST_ASSERT_EQUAL(41250, ((discord_hello_t*) payload->d)->heartbeat_interval);
+    discord_payload_free(payload);
+    free(json);
+
+    json = copy(frames[2]);
+    payload = discord_json_read_payload(json, strlen(json), NULL);
+    TEST_ASSERT_TRUE(((discord_invalid_session_t*) payload->d)->resumable);
+    discord_payload_free(payload);
+    free(json);
+
+    json = copy(frames[3]);
+    payload = discord_json_read_payload(json, strlen(json), NULL);
+    TEST_ASSERT_EQUAL(DISCORD_EVENT_MESSAGE_REACTION_ADDED, (int) payload->t);
+    TEST_ASSERT_EQUAL(7, payload->s);
+    discord_message_reaction_t* reaction = (discord_message_reaction_t*) payload->d;
+    TEST_ASSERT_EQUAL_STRING("2", reaction->message_id);
+    TEST_ASSERT_NULL(reaction->guild_id);
+    TEST_ASSERT_EQUAL_STRING("\xf0\x9f\x91\x8d", reaction->emoji->name);
+    discord_payload_free(payload);
+    free(json);
+
+    json = copy(frames[4]); // guild state data goes through cJSON decoder
+    payload = discord_json_read_payload(json, strlen(json), NULL);
+    TEST_ASSERT_EQUAL(DISCORD_EVENT_GUILD_ROLE_DELETED, (int) payload->t);
+    TEST_ASSERT_EQUAL_STRING("100", ((discord_guild_state_t*) payload->d)->guild_id);
+    TEST_ASSERT_EQUAL_STRING("200", ((discord_guild_state_t*) payload->d)->id);
+    discord_payload_free(payload);
+    free(json);
+
+    json = copy(frames[5]);
+    TEST_ASSERT_NULL(discord_json_read_payload(json, strlen(json), NULL));
+    free(json);
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "discord/private/_json_stream.h"
+
+// Frames recorded from the gateway (ids, tokens and names are anonymized)
+
+static const char* frame_hello =
+    "{\"t\":null,\"s\":null,\"op\":10,\"d\":{\"heartbeat_interval\":41250,\"_trace\":[\"[\\\"gateway-prd-us-east1-b-0568\\\",{\\\"micros\\\":0.0}]\"]}}";
+
+static const char* frame_hello_pruned =
+    "{\"t\":null,\"s\":null,\"op\":10,\"d\":{\"heartbeat_interval\":41250}}";
+
+static const char* frame_ready =
+    "{\"t\":\"READY\",\"s\":1,\"op\":0,\"d\":{\"v\":10,"
+    "\"user_settings\":{},"
+    "\"user\":{\"verified\":true,\"username\":\"key-bot\",\"mfa_enabled\":false,\"id\":\"1110502089848782858\",\"flags\":0,\"email\":null,\"discriminator\":\"4215\",\"bot\":true,\"avatar\":null},"
+    "\"session_type\":\"normal\","
+    "\"session_id\":\"3f1c2e9bd5a84d6e9e0f4c27a1b3d5e7\","
+    "\"resume_gateway_url\":\"wss://gateway-us-east1-b.discord.gg\","
+    "\"relationships\":[],"
+    "\"private_channels\":[],"
+    "\"presences\":[],"
+    "\"guilds\":[{\"unavailable\":true,\"id\":\"1049316126236839946\"},{\"unavailable\":true,\"id\":\"1049316126236839947\"}],"
+    "\"guild_join_requests\":[],"
+    "\"geo_ordered_rtc_regions\":[\"frankfurt\",\"milan\",\"rotterdam\",\"stockholm\",\"bucharest\"],"
+    "\"application\":{\"id\":\"1110502089848782858\",\"flags\":565248},"
+    "\"_trace\":[\"[\\\"gateway-prd-us-east1-b-0568\\\",{\\\"micros\\\":132470}]\"]}}";
+
+static const char* frame_ready_pruned =
+    "{\"t\":\"READY\",\"s\":1,\"op\":0,\"d\":{\"v\":10,"
+    "\"user\":{\"verified\":true,\"username\":\"key-bot\",\"mfa_enabled\":false,\"id\":\"1110502089848782858\",\"flags\":0,\"email\":null,\"discriminator\":\"4215\",\"bot\":true,\"avatar\":null},"
+    "\"session_type\":\"normal\","
+    "\"session_id\":\"3f1c2e9bd5a84d6e9e0f4c27a1b3d5e7\","
+    "\"resume_gateway_url\":\"wss://gateway-us-east1-b.discord.gg\"}}";
+
+static const char* frame_message =
+    "{\"t\":\"MESSAGE_CREATE\",\"s\":3,\"op\":0,\"d\":{\"type\":0,\"tts\":false,\"timestamp\":\"2023-05-24T10:12:41.503000+00:00\","
+    "\"referenced_message\":null,\"pinned\":false,\"nonce\":\"1110841224735440896\","
+    "\"mentions\":[{\"username\":\"key-bot\",\"id\":\"1110502089848782858\",\"discriminator\":\"4215\",\"bot\":true}],"
+    "\"mention_roles\":[],\"mention_everyone\":false,"
+    "\"member\":{\"roles\":[\"1049317394820878437\",\"1049317470620307556\"],\"nick\":null,\"joined_at\":\"2022-12-05T19:57:02.115000+00:00\",\"deaf\":false},"
+    "\"id\":\"1110841226081644624\",\"flags\":0,\"embeds\":[],\"edited_timestamp\":null,"
+    "\"content\":\"knock \\\"please\\\" \\u00e9 <@1110502089848782858>\",\"components\":[],"
+    "\"channel_id\":\"1049316126681444372\","
+    "\"author\":{\"username\":\"user\",\"public_flags\":0,\"id\":\"462290384412901376\",\"discriminator\":\"0\",\"avatar\":null},"
+    "\"attachments\":[],\"guild_id\":\"1049316126236839946\"}}";
+
+static const char* frame_message_pruned =
+    "{\"t\":\"MESSAGE_CREATE\",\"s\":3,\"op\":0,\"d\":{\"type\":0,\"tts\":false,\"timestamp\":\"2023-05-24T10:12:41.503000+00:00\","
+    "\"pinned\":false,\"nonce\":\"1110841224735440896\","
+    "\"mention_everyone\":false,"
+    "\"member\":{\"roles\":[\"1049317394820878437\",\"1049317470620307556\"],\"nick\":null,\"joined_at\":\"2022-12-05T19:57:02.115000+00:00\",\"deaf\":false},"
+    "\"id\":\"1110841226081644624\",\"flags\":0,\"edited_timestamp\":null,"
+    "\"content\":\"knock \\\"please\\\" \\u00e9 <@1110502089848782858>\","
+    "\"channel_id\":\"1049316126681444372\","
+    "\"author\":{\"username\":\"user\",\"public_flags\":0,\"id\":\"462290384412901376\",\"discriminator\":\"0\",\"avatar\":null},"
+    "\"attachments\":[],\"guild_id\":\"1049316126236839946\"}}";
+
+static const char* frame_message_own =
+    "{\"t\":\"MESSAGE_CREATE\",\"s\":4,\"op\":0,\"d\":{\"type\":0,\"content\":\"knocking...\",\"channel_id\":\"1049316126681444372\","
+    "\"author\":{\"username\":\"key-bot\",\"id\":\"1110502089848782858\",\"discriminator\":\"4215\",\"bot\":true},"
+    "\"guild_id\":\"1049316126236839946\"}}";
+
+static const char* frame_ack = "{\"t\":null,\"s\":null,\"op\":11,\"d\":null}";
+
+static esp_err_t stream_whole(discord_json_stream_t* stream, const char* frame) {
+    discord_json_stream_reset(stream);
+    return discord_json_stream_feed(stream, frame, strlen(frame));
+}
+
+static esp_err_t stream_split(discord_json_stream_t* stream, const char* frame) {
+    size_t len = strlen(frame);
+    size_t offset = 0;
+
+    discord_json_stream_reset(stream);
+
+    while(offset < len) {
+        size_t chunk = 1 + rand() % 64;
+
+        if(chunk > len - offset) {
+            chunk = len - offset;
+        }
+
+        esp_err_t err = discord_json_stream_feed(stream, frame + offset, chunk);
+
+        if(err != ESP_OK) {
+            return err;
+        }
+
+        offset += chunk;
+    }
+
+    return ESP_OK;
+}
+
+static void assert_pruned(discord_json_stream_t* stream, const char* expected) {
+    TEST_ASSERT_TRUE(discord_json_stream_is_done(stream));
+    TEST_ASSERT_EQUAL(strlen(expected), stream->len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, stream->buffer, stream->len);
+}
+
+TEST_CASE("stream retains only decoded members of whole frames", "[gateway]")
+{
+    char buffer[1024 + 1];
+    discord_json_stream_t stream = {
+        .buffer = buffer,
+        .size = sizeof(buffer) - 1,
+        .prune_keys = discord_json_stream_default_prune_keys
+    };
+
+    TEST_ASSERT_EQUAL(ESP_OK, stream_whole(&stream, frame_hello));
+    assert_pruned(&stream, frame_hello_pruned);
+
+    TEST_ASSERT_EQUAL(ESP_OK, stream_whole(&stream, frame_ready));
+    assert_pruned(&stream, frame_ready_pruned);
+
+    TEST_ASSERT_EQUAL(ESP_OK, stream_whole(&stream, frame_message));
+    assert_pruned(&stream, frame_message_pruned);
+
+    TEST_ASSERT_EQUAL(ESP_OK, stream_whole(&stream, frame_ack));
+    assert_pruned(&stream, frame_ack);
+}
+
+TEST_CASE("stream produces same output for frames split at random offsets", "[gateway]")
+{
+    const char* frames[] = { frame_hello, frame_ready, frame_message, frame_ack };
+    const char* pruned[] = { frame_hello_pruned, frame_ready_pruned, frame_message_pruned, frame_ack };
+    char buffer[1024 + 1];
+    discord_json_stream_t stream = {
+        .buffer = buffer,
+        .size = sizeof(buffer) - 1,
+        .prune_keys = discord_json_stream_default_prune_keys
+    };
+
+    srand(2023);
+
+    for(int i = 0; i < 500; i++) {
+        int f = i % (sizeof(frames) / sizeof(frames[0]));
+        TEST_ASSERT_EQUAL(ESP_OK, stream_split(&stream, frames[f]));
+        assert_pruned(&stream, pruned[f]);
+    }
+}
+
+TEST_CASE("stream memory is bounded by retained data", "[gateway]")
+{
+    size_t retained = strlen(frame_ready_pruned);
+    char* buffer = malloc(retained + 1);
+    TEST_ASSERT_NOT_NULL(buffer);
+
+    discord_json_stream_t stream = {
+        .buffer = buffer,
+        .size = retained,
+        .prune_keys = discord_json_stream_default_prune_keys
+    };
+
+    // whole frame is larger than the buffer, but retained data fits
+    TEST_ASSERT_GREATER_THAN(retained, strlen(frame_ready));
+    TEST_ASSERT_EQUAL(ESP_OK, stream_split(&stream, frame_ready));
+    assert_pruned(&stream, frame_ready_pruned);
+
+    // one byte less and retained data does not fit anymore
+    stream.size = retained - 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, stream_split(&stream, frame_ready));
+    TEST_ASSERT_FALSE(discord_json_stream_is_done(&stream));
+    TEST_ASSERT_EQUAL(ESP_FAIL, discord_json_stream_feed(&stream, "}", 1)); // rest of the dropped payload
+
+    free(buffer);
+}
+
+TEST_CASE("stream rejects malformed frames", "[gateway]")
+{
+    char buffer[64 + 1];
+    discord_json_stream_t stream = {
+        .buffer = buffer,
+        .size = sizeof(buffer) - 1,
+        .prune_keys = discord_json_stream_default_prune_keys
+    };
+
+    TEST_ASSERT_EQUAL(ESP_FAIL, stream_whole(&stream, "{\"op\":11,}"));
+    TEST_ASSERT_EQUAL(ESP_FAIL, stream_whole(&stream, "{\"op\" 11}"));
+    TEST_ASSERT_EQUAL(ESP_FAIL, stream_whole(&stream, "{\"d\":[1,2}"));
+    TEST_ASSERT_EQUAL(ESP_OK, stream_whole(&stream, "{\"op\":11,\"d\":"));
+    TEST_ASSERT_FALSE(discord_json_stream_is_done(&stream));
+}
+
+TEST_CASE("stream captures routing fields", "[gateway]")
+{
+    char buffer[1024 + 1];
+    discord_json_stream_t stream = {
+        .buffer = buffer,
+        .size = sizeof(buffer) - 1,
+        .prune_keys = discord_json_stream_default_prune_keys
+    };
+
+    TEST_ASSERT_EQUAL(ESP_OK, stream_split(&stream, frame_message));
+    TEST_ASSERT_TRUE(discord_json_stream_is_done(&stream));
+    TEST_ASSERT_EQUAL(0, discord_json_stream_get_int_field(&stream, DISCORD_JSON_STREAM_FIELD_OP, -1));
+    TEST_ASSERT_EQUAL(3, discord_json_stream_get_int_field(&stream, DISCORD_JSON_STREAM_FIELD_S, -1));
+    TEST_ASSERT_EQUAL(0, discord_json_stream_get_int_field(&stream, DISCORD_JSON_STREAM_FIELD_TYPE, -1));
+    TEST_ASSERT_EQUAL_STRING("MESSAGE_CREATE", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_T));
+    TEST_ASSERT_EQUAL_STRING("1049316126681444372", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_CHANNEL_ID));
+    TEST_ASSERT_EQUAL_STRING("1049316126236839946", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_GUILD_ID));
+    TEST_ASSERT_EQUAL_STRING("462290384412901376", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_AUTHOR_ID));
+    TEST_ASSERT_NULL(discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_USER_ID));
+    TEST_ASSERT_NULL(discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_AUTHOR_BOT));
+
+    TEST_ASSERT_EQUAL(ESP_OK, stream_split(&stream, frame_message_own));
+    TEST_ASSERT_EQUAL_STRING("true", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_AUTHOR_BOT));
+
+    // nested ids (mentions, member) and ids of pruned members are not captured
+    TEST_ASSERT_EQUAL(ESP_OK, stream_split(&stream, frame_ready));
+    TEST_ASSERT_EQUAL_STRING("READY", discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_T));
+    TEST_ASSERT_NULL(discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_AUTHOR_ID));
+    TEST_ASSERT_NULL(discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_GUILD_ID));
+
+    TEST_ASSERT_EQUAL(ESP_OK, stream_whole(&stream, frame_ack));
+    TEST_ASSERT_TRUE(discord_json_stream_is_done(&stream));
+    TEST_ASSERT_EQUAL(11, discord_json_stream_get_int_field(&stream, DISCORD_JSON_STREAM_FIELD_OP, -1));
+    TEST_ASSERT_EQUAL(-1, discord_json_stream_get_int_field(&stream, DISCORD_JSON_STREAM_FIELD_S, -1));
+    TEST_ASSERT_NULL(discord_json_stream_get_field(&stream, DISCORD_JSON_STREAM_FIELD_T));
+}
\ No newline at end of file
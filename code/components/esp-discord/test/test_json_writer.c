@@ -0,0 +1,134 @@
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_json.h"
+#include "discord/private/_json_reader.h"
+
+DISCORD_LOG_DEFINE_BASE();
+
+static char buffer[1024];
+
+static void write_values(discord_json_writer_t* w, const char* str) {
+    discord_json_write_object(w);
+    discord_json_write_key(w, "s");
+    discord_json_write_string(w, str);
+    discord_json_write_key(w, "a");
+    discord_json_write_array(w);
+    discord_json_write_int(w, INT64_MIN);
+    discord_json_write_int(w, 0);
+    discord_json_write_bool(w, false);
+    discord_json_write_null(w);
+    discord_json_write_object(w);
+    discord_json_write_object_end(w);
+    discord_json_write_array(w);
+    discord_json_write_array_end(w);
+    discord_json_write_array_end(w);
+    discord_json_write_object_end(w);
+}
+
+TEST_CASE("json writer escapes strings and measures exact length", "[json_writer]")
+{
+    // escapes at every position of the word
+    const char* str = "plain text\"\\\n\t\x01 a\"bc\x1f\xc3\xa9 \xf0\x9f\x91\x8b";
+    const char* expected = "{\"s\":\"plain text\\\"\\\\\\n\\t\\u0001 a\\\"bc\\u001f\xc3\xa9 \xf0\x9f\x91\x8b\","
+        "\"a\":[-9223372036854775808,0,false,null,{},[]]}";
+
+    discord_json_writer_t w;
+    discord_json_writer_init(&w, NULL, 0);
+    write_values(&w, str);
+    TEST_ASSERT_EQUAL(strlen(expected), w.len);
+    TEST_ASSERT_EQUAL(-1, discord_json_writer_result(&w));
+
+    discord_json_writer_init(&w, buffer, sizeof(buffer));
+    write_values(&w, str);
+    TEST_ASSERT_EQUAL(strlen(expected), discord_json_writer_result(&w));
+    TEST_ASSERT_EQUAL_STRING(expected, buffer);
+
+    for(size_t i = 1; i < 16; i++) {
+        char shifted[32] = "0123456789abcdef";
+        shifted[i] = '"';
+        discord_json_writer_init(&w, buffer, sizeof(buffer));
+        discord_json_write_string(&w, shifted);
+        TEST_ASSERT_EQUAL(strlen(shifted) + 3, discord_json_writer_result(&w));
+        TEST_ASSERT_EQUAL(0, strncmp("\\\"", buffer + i + 1, 2));
+    }
+
+    // text and terminator must fit
+    discord_json_writer_init(&w, buffer, strlen(expected));
+    write_values(&w, str);
+    TEST_ASSERT_EQUAL(-1, discord_json_writer_result(&w));
+}
+
+TEST_CASE("json writer writes message with embeds in one allocation", "[json_writer]")
+{
+    discord_embed_field_t field = { .name = "Door", .value = "Open \"now\"", .is_inline = true };
+    discord_embed_field_t* fields[] = { &field, &field };
+    discord_embed_image_t image = { .url = "https://example.com/key.png" };
+    discord_embed_t embed = {
+        .title = "Key\tbot",
+        .color = 0x2ecc71,
+        .image = &image,
+        .fields = fields,
+        ._fields_len = 2
+    };
+    discord_embed_t* embeds[] = { &embed };
+    discord_attachment_t attachment = { .id = "0", .filename = "log.txt" };
+    discord_attachment_t* attachments[] = { &attachment };
+    discord_message_t message = {
+        .content = "Who's there? \xf0\x9f\x94\x91\n",
+        .channel_id = "1049316126681444372",
+        .attachments = attachments,
+        ._attachments_len = 1,
+        .embeds = embeds,
+        ._embeds_len = 1
+    };
+
+    char* json = discord_json_write_alloc(discord_json_write_message, &message);
+    TEST_ASSERT_NOT_NULL(json);
+
+    cJSON* root = cJSON_Parse(json);
+    TEST_ASSERT_NOT_NULL(root);
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(root, "id"));
+    TEST_ASSERT_EQUAL_STRING(message.content, cJSON_GetObjectItem(root, "content")->valuestring);
+    TEST_ASSERT_EQUAL_STRING("log.txt", cJSON_GetObjectItem(cJSON_GetArrayItem(cJSON_GetObjectItem(root, "attachments"), 0), "filename")->valuestring);
+    cJSON* e = cJSON_GetArrayItem(cJSON_GetObjectItem(root, "embeds"), 0);
+    TEST_ASSERT_EQUAL_STRING("Key\tbot", cJSON_GetObjectItem(e, "title")->valuestring);
+    TEST_ASSERT_EQUAL(0x2ecc71, cJSON_GetObjectItem(e, "color")->valueint);
+    TEST_ASSERT_EQUAL_STRING(image.url, cJSON_GetObjectItem(cJSON_GetObjectItem(e, "image"), "url")->valuestring);
+    TEST_ASSERT_NULL(cJSON_GetObjectItem(e, "thumbnail"));
+    cJSON* f = cJSON_GetObjectItem(e, "fields");
+    TEST_ASSERT_EQUAL(2, cJSON_GetArraySize(f));
+    TEST_ASSERT_EQUAL_STRING("Open \"now\"", cJSON_GetObjectItem(cJSON_GetArrayItem(f, 1), "value")->valuestring);
+    TEST_ASSERT_TRUE(cJSON_IsTrue(cJSON_GetObjectItem(cJSON_GetArrayItem(f, 1), "inline")));
+    cJSON_Delete(root);
+
+    discord_message_t* decoded = discord_json_read_message(json, strlen(json));
+    TEST_ASSERT_NOT_NULL(decoded);
+    TEST_ASSERT_EQUAL_STRING(message.content, decoded->content);
+    TEST_ASSERT_EQUAL_STRING(message.channel_id, decoded->channel_id);
+    discord_message_free(decoded);
+    free(json);
+}
+
+TEST_CASE("json writer writes gateway frames into the buffer", "[json_writer]")
+{
+    discord_activity_t activity = { .name = "Custom Status", .type = DISCORD_ACTIVITY_CUSTOM, .state = "Key is \"here\"" };
+    discord_presence_t presence = { .status = DISCORD_PRESENCE_IDLE, .activity = &activity };
+
+    int len = discord_json_write_presence(buffer, sizeof(buffer), &presence);
+    TEST_ASSERT_EQUAL_STRING("{\"op\":3,\"d\":{\"since\":null,\"activities\":[{\"name\":\"Custom Status\",\"type\":4,"
+        "\"state\":\"Key is \\\"here\\\"\"}],\"status\":\"idle\",\"afk\":false}}", buffer);
+    TEST_ASSERT_EQUAL(strlen(buffer), len);
+    TEST_ASSERT_EQUAL(-1, discord_json_write_presence(buffer, len, &presence));
+
+    len = discord_json_write_request_guild_members(buffer, sizeof(buffer), "1049316126236839946");
+    TEST_ASSERT_EQUAL_STRING("{\"op\":8,\"d\":{\"guild_id\":\"1049316126236839946\",\"query\":\"\",\"limit\":0}}", buffer);
+    TEST_ASSERT_EQUAL(strlen(buffer), len);
+
+    len = discord_json_write_heartbeat(buffer, sizeof(buffer), DISCORD_NULL_SEQUENCE_NUMBER);
+    TEST_ASSERT_EQUAL_STRING("{\"op\":1,\"d\":null}", buffer);
+    len = discord_json_write_resume(buffer, sizeof(buffer), "token", "session", 42);
+    TEST_ASSERT_EQUAL_STRING("{\"op\":6,\"d\":{\"token\":\"token\",\"session_id\":\"session\",\"seq\":42}}", buffer);
+    TEST_ASSERT_EQUAL(strlen(buffer), len);
+}
\ No newline at end of file
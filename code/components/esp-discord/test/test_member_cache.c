@@ -0,0 +1,223 @@
+#include <string.h>
+#include "unity.h"
+#include "cutils.h"
+#include "discord/private/_discord.h"
+#include "discord/private/_member_cache.h"
+#include "discord/private/_json_stream.h"
+#include "discord/private/_json.h"
+
+DISCORD_LOG_DEFINE_BASE();
+
+#define GUILD_ID "1049316126236839946"
+
+static const char members_chunk[] =
+    "{\"t\":\"GUILD_MEMBERS_CHUNK\",\"s\":4,\"op\":0,\"d\":{"
+    "\"members\":["
+        "{\"user\":{\"username\":\"user\",\"id\":\"462290384412901376\",\"avatar\":null,\"avatar_decoration_data\":{\"sku_id\":\"1\"}},"
+        "\"roles\":[\"1049317394820878437\",\"1049317470620307556\"],\"nick\":\"Doorman\",\"joined_at\":\"2022-12-05T19:57:02.115000+00:00\"},"
+        "{\"roles\":[],\"nick\":null,\"user\":{\"id\":\"1110502089848782858\",\"bot\":true}},"
+        "{\"user\":{\"id\":\"462290384412901377\"},\"roles\":[],\"nick\":\"\\\"quoted\\\"\"}" // escaped nick is not cached
+    "],"
+    "\"guild_id\":\"" GUILD_ID "\",\"chunk_index\":0,\"chunk_count\":2}}";
+
+static const char member_update[] =
+    "{\"t\":\"GUILD_MEMBER_UPDATE\",\"s\":5,\"op\":0,\"d\":{\"guild_id\":\"" GUILD_ID "\","
+    "\"user\":{\"username\":\"user\",\"id\":\"462290384412901376\"},\"roles\":[\"1049317394820878437\"],\"nick\":null}}";
+
+static const char member_remove[] =
+    "{\"t\":\"GUILD_MEMBER_REMOVE\",\"s\":6,\"op\":0,\"d\":{\"guild_id\":\"" GUILD_ID "\",\"user\":{\"id\":\"1110502089848782858\"}}}";
+
+static void put_scanned_member(void* arg, const discord_member_record_t* member) {
+    discord_member_cache_put((discord_member_cache_t*) arg, GUILD_ID, member);
+}
+
+static void put_member(discord_member_cache_t* cache, const char* guild_id, uint64_t user_id) {
+    discord_member_record_t record = { .user_id = user_id, .roles = { 1, 2 }, .roles_len = 2 };
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_put(cache, guild_id, &record));
+}
+
+TEST_CASE("members of GUILD_MEMBERS_CHUNK are cached while the chunk is streamed", "[member_cache]")
+{
+    discord_member_cache_t cache;
+    discord_member_cache_init(&cache, 4 * 1024);
+
+    char buffer[128 + 1];
+    discord_json_stream_t stream = {
+        .buffer = buffer,
+        .size = sizeof(buffer) - 1, // whole chunk does not fit, only fields around members are retained
+        .prune_keys = discord_json_stream_default_prune_keys,
+        .member_handler = put_scanned_member,
+        .member_handler_arg = &cache
+    };
+    discord_json_stream_reset(&stream);
+
+    for(size_t i = 0; i < sizeof(members_chunk) - 1; i += 7) { // split at odd offsets
+        size_t len = sizeof(members_chunk) - 1 - i;
+        TEST_ASSERT_EQUAL(ESP_OK, discord_json_stream_feed(&stream, members_chunk + i, len < 7 ? len : 7));
+    }
+
+    TEST_ASSERT_TRUE(discord_json_stream_is_done(&stream));
+    buffer[stream.len] = '\0';
+    TEST_ASSERT_NULL(strstr(buffer, "members"));
+
+    discord_payload_t* payload = discord_json_deserialize_(payload, buffer, stream.len);
+    TEST_ASSERT_NOT_NULL(payload);
+    TEST_ASSERT_EQUAL(DISCORD_EVENT_GUILD_MEMBERS_CHUNK, (int) payload->t);
+    discord_guild_state_t* state = (discord_guild_state_t*) payload->d;
+    TEST_ASSERT_EQUAL_STRING(GUILD_ID, state->guild_id);
+    TEST_ASSERT_EQUAL(0, state->chunk_index);
+    TEST_ASSERT_EQUAL(2, state->chunk_count);
+    TEST_ASSERT_EQUAL(0, state->members_len);
+    discord_payload_free(payload);
+
+    discord_member_t* member = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_get(&cache, GUILD_ID, "462290384412901376", &member));
+    TEST_ASSERT_EQUAL_STRING("Doorman", member->nick);
+    TEST_ASSERT_EQUAL(2, member->_roles_len);
+    TEST_ASSERT_EQUAL_STRING("1049317394820878437", member->roles[0]);
+    TEST_ASSERT_EQUAL_STRING("1049317470620307556", member->roles[1]);
+    discord_member_free(member);
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_get(&cache, GUILD_ID, "1110502089848782858", &member));
+    TEST_ASSERT_NULL(member->nick);
+    TEST_ASSERT_EQUAL(0, member->_roles_len);
+    discord_member_free(member);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_member_cache_get(&cache, GUILD_ID, "462290384412901377", &member));
+    TEST_ASSERT_EQUAL(2, cache.hits);
+    TEST_ASSERT_EQUAL(1, cache.misses);
+
+    discord_member_cache_clear(&cache);
+    TEST_ASSERT_EQUAL(0, cache.size);
+}
+
+TEST_CASE("member cache is kept current by member events", "[member_cache]")
+{
+    discord_member_cache_t cache;
+    discord_member_cache_init(&cache, 4 * 1024);
+
+    put_member(&cache, GUILD_ID, 462290384412901376ULL);
+    put_member(&cache, GUILD_ID, 1110502089848782858ULL);
+
+    discord_payload_t* payload = discord_json_deserialize_(payload, member_update, strlen(member_update));
+    TEST_ASSERT_NOT_NULL(payload);
+    discord_guild_state_t* state = (discord_guild_state_t*) payload->d;
+    TEST_ASSERT_EQUAL(1, state->members_len);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_put(&cache, state->guild_id, &state->members[0]));
+    discord_payload_free(payload);
+
+    payload = discord_json_deserialize_(payload, member_remove, strlen(member_remove));
+    TEST_ASSERT_NOT_NULL(payload);
+    state = (discord_guild_state_t*) payload->d;
+    TEST_ASSERT_EQUAL(0, state->members_len);
+    TEST_ASSERT_EQUAL_STRING("1110502089848782858", state->id);
+    discord_member_cache_remove(&cache, state->guild_id, state->id);
+    discord_payload_free(payload);
+
+    discord_member_t* member = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_get(&cache, GUILD_ID, "462290384412901376", &member));
+    TEST_ASSERT_EQUAL(1, member->_roles_len);
+    TEST_ASSERT_EQUAL_STRING("1049317394820878437", member->roles[0]);
+    discord_member_free(member);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_member_cache_get(&cache, GUILD_ID, "1110502089848782858", &member));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_member_cache_get(&cache, "200", "462290384412901376", &member)); // other guild
+
+    discord_member_cache_clear(&cache);
+}
+
+TEST_CASE("member cache evicts least recently used members when over the limit", "[member_cache]")
+{
+    discord_member_cache_t cache;
+    discord_member_cache_init(&cache, 1024);
+
+    put_member(&cache, "100", 1);
+    size_t member_size = cache.size;
+    discord_member_cache_clear(&cache);
+
+    discord_member_cache_init(&cache, 2 * member_size);
+
+    put_member(&cache, "100", 1);
+    put_member(&cache, "100", 2);
+
+    discord_member_t* member = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_get(&cache, "100", "1", &member)); // 2 is the least recently used now
+    discord_member_free(member);
+
+    put_member(&cache, "100", 3);
+    TEST_ASSERT_EQUAL(1, cache.evictions);
+    TEST_ASSERT_LESS_OR_EQUAL(cache.limit, cache.size);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_member_cache_get(&cache, "100", "2", &member));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_get(&cache, "100", "1", &member));
+    discord_member_free(member);
+
+    // member which alone does not fit is not cached at all
+    discord_member_record_t record = { .user_id = 4, .roles_len = DISCORD_MEMBER_CACHE_ROLES_MAX, .has_nick = true };
+    memset(record.nick, 'n', DISCORD_MEMBER_CACHE_NICK_MAX);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, discord_member_cache_put(&cache, "100", &record));
+    TEST_ASSERT_EQUAL(1, cache.evictions); // other members stay
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_get(&cache, "100", "3", &member));
+    discord_member_free(member);
+
+    discord_member_cache_clear(&cache);
+}
+
+TEST_CASE("staged members are cached only when committed", "[member_cache]")
+{
+    discord_member_cache_t cache;
+    discord_member_cache_init(&cache, 4 * 1024);
+    discord_member_record_t record = { .user_id = 1, .roles = { 10 }, .roles_len = 1 };
+
+    put_member(&cache, GUILD_ID, 1);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_stage(&cache, &record));
+    record.user_id = 2;
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_stage(&cache, &record));
+
+    // payload was not a members chunk
+    discord_member_cache_drop_staged(&cache);
+    TEST_ASSERT_NULL(cache.staged);
+    discord_member_t* member = NULL;
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_member_cache_get(&cache, GUILD_ID, "2", &member));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_get(&cache, GUILD_ID, "1", &member));
+    TEST_ASSERT_EQUAL(2, member->_roles_len);
+    discord_member_free(member);
+
+    // staged member replaces the cached one
+    record.user_id = 1;
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_stage(&cache, &record));
+    record.user_id = 2;
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_stage(&cache, &record));
+    size_t size = cache.size;
+    discord_member_cache_commit(&cache, GUILD_ID);
+    TEST_ASSERT_NULL(cache.staged);
+    TEST_ASSERT_EQUAL(0, cache.staged_size);
+    TEST_ASSERT_GREATER_THAN(size, cache.size);
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_get(&cache, GUILD_ID, "1", &member));
+    TEST_ASSERT_EQUAL(1, member->_roles_len);
+    TEST_ASSERT_EQUAL_STRING("10", member->roles[0]);
+    discord_member_free(member);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_get(&cache, GUILD_ID, "2", &member));
+    discord_member_free(member);
+
+    // staged members are bounded by the limit, the oldest are dropped
+    discord_member_cache_clear(&cache);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_stage(&cache, &record));
+    size_t member_size = cache.staged_size;
+    discord_member_cache_clear(&cache);
+    discord_member_cache_init(&cache, 2 * member_size);
+
+    for(record.user_id = 1; record.user_id <= 4; record.user_id++) {
+        TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_stage(&cache, &record));
+    }
+
+    TEST_ASSERT_EQUAL(2 * member_size, cache.staged_size);
+    TEST_ASSERT_EQUAL(2, cache.evictions);
+    discord_member_cache_commit(&cache, GUILD_ID);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_member_cache_get(&cache, GUILD_ID, "4", &member));
+    discord_member_free(member);
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_member_cache_get(&cache, GUILD_ID, "1", &member));
+
+    discord_member_cache_clear(&cache);
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "discord/private/_outbox.h"
+
+enum { PRIO_HEARTBEAT, PRIO_SESSION, PRIO_REQUEST };
+enum { OP_IDENTIFY = 2, OP_PRESENCE_UPDATE = 3, OP_REQUEST_GUILD_MEMBERS = 8 };
+
+/**
+ * @brief Outbound frame, id tells frames of the same op apart
+ */
+typedef struct {
+    int op;
+    int id;
+} frame_t;
+
+static int dropped; // frames dropped by the outbox instead of being sent
+
+static void frame_drop(void* frame) {
+    dropped++;
+    free(frame);
+}
+
+static frame_t* frame(int op, int id) {
+    frame_t* f = malloc(sizeof(frame_t));
+    *f = (frame_t) { .op = op, .id = id };
+    return f;
+}
+
+/**
+ * @return Id of the sent frame or -1 if nothing can be sent
+ */
+static int send_next(discord_outbox_t* outbox, uint64_t now) {
+    frame_t* f = discord_outbox_next(outbox, now);
+
+    if(!f) {
+        return -1;
+    }
+
+    int id = f->id;
+    free(f);
+    return id;
+}
+
+TEST_CASE("outbox limits rate and keeps reserve for heartbeats", "[outbox]")
+{
+    discord_outbox_t outbox;
+
+    // 4 sends per 2 seconds (one token per 500 ms), last token is reserved
+    TEST_ASSERT_EQUAL(ESP_OK, discord_outbox_init(&outbox, 4, 2000, 1, PRIO_REQUEST, 8, frame_drop));
+    discord_outbox_reset(&outbox, 1000);
+
+    TEST_ASSERT_TRUE(discord_outbox_take_token(&outbox, PRIO_REQUEST, 1000));
+    TEST_ASSERT_TRUE(discord_outbox_take_token(&outbox, PRIO_REQUEST, 1000));
+    TEST_ASSERT_TRUE(discord_outbox_take_token(&outbox, PRIO_REQUEST, 1000));
+    TEST_ASSERT_FALSE(discord_outbox_take_token(&outbox, PRIO_REQUEST, 1000));
+    TEST_ASSERT_TRUE(discord_outbox_take_token(&outbox, PRIO_HEARTBEAT, 1000));
+    TEST_ASSERT_FALSE(discord_outbox_take_token(&outbox, PRIO_HEARTBEAT, 1000));
+
+    TEST_ASSERT_EQUAL(UINT32_MAX, discord_outbox_wait_ms(&outbox, 1000));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_outbox_defer(&outbox, frame(OP_REQUEST_GUILD_MEMBERS, 1), PRIO_REQUEST, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_outbox_defer(&outbox, frame(OP_IDENTIFY, 2), PRIO_SESSION, 0));
+
+    // session goes first and needs a single token
+    TEST_ASSERT_EQUAL(400, discord_outbox_wait_ms(&outbox, 1100));
+    TEST_ASSERT_EQUAL(-1, send_next(&outbox, 1499));
+    TEST_ASSERT_EQUAL(2, send_next(&outbox, 1500));
+
+    // request waits until there is a token above the reserve
+    TEST_ASSERT_EQUAL(1000, discord_outbox_wait_ms(&outbox, 1500));
+    TEST_ASSERT_EQUAL(-1, send_next(&outbox, 2000));
+    TEST_ASSERT_FALSE(discord_outbox_take_token(&outbox, PRIO_REQUEST, 2400)); // does not overtake the waiting one
+    TEST_ASSERT_EQUAL(1, send_next(&outbox, 2500));
+
+    // bucket is refilled up to the capacity only
+    TEST_ASSERT_EQUAL(ESP_OK, discord_outbox_defer(&outbox, frame(OP_REQUEST_GUILD_MEMBERS, 3), PRIO_REQUEST, 0));
+    TEST_ASSERT_EQUAL(3, send_next(&outbox, 60000));
+    TEST_ASSERT_EQUAL(3, outbox.tokens);
+    TEST_ASSERT_EQUAL(3, outbox.deferred);
+
+    discord_outbox_destroy(&outbox);
+}
+
+TEST_CASE("outbox replaces superseded items", "[outbox]")
+{
+    discord_outbox_t outbox;
+    dropped = 0;
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_outbox_init(&outbox, 2, 1000, 0, PRIO_REQUEST, 2, frame_drop));
+    discord_outbox_reset(&outbox, 0);
+    outbox.tokens = 0;
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_outbox_defer(&outbox, frame(OP_PRESENCE_UPDATE, 1), PRIO_REQUEST, OP_PRESENCE_UPDATE));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_outbox_defer(&outbox, frame(OP_PRESENCE_UPDATE, 2), PRIO_REQUEST, OP_PRESENCE_UPDATE));
+    TEST_ASSERT_EQUAL(1, dropped);
+    TEST_ASSERT_EQUAL(1, outbox.coalesced);
+    TEST_ASSERT_EQUAL(ESP_OK, discord_outbox_defer(&outbox, frame(OP_REQUEST_GUILD_MEMBERS, 3), PRIO_REQUEST, 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, discord_outbox_defer(&outbox, frame(OP_REQUEST_GUILD_MEMBERS, 4), PRIO_REQUEST, 0));
+    TEST_ASSERT_EQUAL(2, dropped);
+
+    TEST_ASSERT_EQUAL(2, send_next(&outbox, 500));
+    TEST_ASSERT_EQUAL(3, send_next(&outbox, 1000));
+
+    discord_outbox_reset(&outbox, 1000);
+    TEST_ASSERT_EQUAL(2, outbox.tokens);
+    discord_outbox_destroy(&outbox);
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include "unity.h"
+#include "discord/private/_payload_ring.h"
+
+static int freed;
+
+static void item_free(void* item) {
+    freed++;
+    free(item);
+}
+
+static int* item(int value) {
+    int* it = malloc(sizeof(int));
+    *it = value;
+    return it;
+}
+
+static int pop_value(discord_payload_ring_t* ring) {
+    int* it = discord_payload_ring_pop(ring);
+
+    if(!it) {
+        return -1;
+    }
+
+    int value = *it;
+    free(it);
+    return value;
+}
+
+TEST_CASE("payload ring drops oldest or newest when full", "[payload_ring]")
+{
+    discord_payload_ring_t ring;
+    freed = 0;
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_init(&ring, 2, DISCORD_QUEUE_POLICY_DROP_OLDEST, 0, item_free));
+    TEST_ASSERT_NULL(discord_payload_ring_pop(&ring));
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(1), 0));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(2), 0));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(3), 0));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(4), 0));
+    TEST_ASSERT_EQUAL(2, discord_payload_ring_depth(&ring));
+
+    // consumer drops the oldest items the producer had no room for
+    TEST_ASSERT_EQUAL(3, pop_value(&ring));
+    TEST_ASSERT_EQUAL(4, pop_value(&ring));
+    TEST_ASSERT_EQUAL(-1, pop_value(&ring));
+    TEST_ASSERT_EQUAL(2, freed);
+    TEST_ASSERT_EQUAL(2, ring.drops);
+    TEST_ASSERT_EQUAL(2, ring.max_depth);
+
+    // consumer did not run at all, ring is physically full
+    for(int i = 0; i < 5; i++) {
+        discord_payload_ring_push(&ring, item(10 + i), 0);
+    }
+    TEST_ASSERT_EQUAL(12, pop_value(&ring));
+    TEST_ASSERT_EQUAL(13, pop_value(&ring));
+    discord_payload_ring_destroy(&ring);
+
+    freed = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_init(&ring, 2, DISCORD_QUEUE_POLICY_DROP_NEWEST, 0, item_free));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(1), 0));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(2), 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, discord_payload_ring_push(&ring, item(3), 0));
+    TEST_ASSERT_EQUAL(1, freed);
+    TEST_ASSERT_EQUAL(1, pop_value(&ring));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(4), 0));
+    TEST_ASSERT_EQUAL(2, pop_value(&ring));
+    TEST_ASSERT_EQUAL(4, pop_value(&ring));
+    discord_payload_ring_destroy(&ring);
+
+    // with zero timeout blocking policy gives up immediately
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_init(&ring, 1, DISCORD_QUEUE_POLICY_BLOCK, 0, item_free));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(1), 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, discord_payload_ring_push(&ring, item(2), 0));
+    TEST_ASSERT_EQUAL(1, pop_value(&ring));
+    discord_payload_ring_destroy(&ring);
+}
+
+TEST_CASE("payload ring coalesces items with the same key", "[payload_ring]")
+{
+    discord_payload_ring_t ring;
+    freed = 0;
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_init(&ring, 3, DISCORD_QUEUE_POLICY_COALESCE, 0, item_free));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(1), 100));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(2), 0));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(3), 100)); // replaces 1 in place
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(4), 200));
+    TEST_ASSERT_EQUAL(3, discord_payload_ring_depth(&ring));
+    TEST_ASSERT_EQUAL(1, ring.coalesced);
+    TEST_ASSERT_EQUAL(0, ring.drops);
+
+    TEST_ASSERT_EQUAL(3, pop_value(&ring));
+    TEST_ASSERT_EQUAL(2, pop_value(&ring));
+
+    // taken item is not replaced anymore
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(5), 100));
+    TEST_ASSERT_EQUAL(4, pop_value(&ring));
+    TEST_ASSERT_EQUAL(5, pop_value(&ring));
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_payload_ring_push(&ring, item(6), 0));
+    discord_payload_ring_flush(&ring);
+    TEST_ASSERT_EQUAL(0, discord_payload_ring_depth(&ring));
+    TEST_ASSERT_EQUAL(2, freed);
+    discord_payload_ring_destroy(&ring);
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "discord/private/_recorder.h"
+#include "esp_websocket_client.h"
+#include "esp_transport_ws.h"
+
+/**
+ * @brief Copy first len bytes of the log into a new file
+ */
+static FILE* copy_log(FILE* file, long len) {
+    FILE* copy = tmpfile();
+    char* log = malloc(len);
+
+    rewind(file);
+
+    if(copy && log && fread(log, 1, len, file) == len && fwrite(log, 1, len, copy) == len) {
+        rewind(copy);
+    } else if(copy) {
+        fclose(copy);
+        copy = NULL;
+    }
+
+    free(log);
+
+    return copy;
+}
+
+static const char* chunks[] = {
+    "{\"op\":10,\"d\":{\"heartbeat_interval\":41250}}",
+    "{\"t\":\"MESSAGE_CREATE\",\"s\":3,\"op\":0,\"d\":{\"content\":\"kn",
+    "ock\"}}",
+};
+
+TEST_CASE("recorder writes frames which are read back", "[gateway]")
+{
+    FILE* file = tmpfile();
+
+    if(!file) {
+        TEST_IGNORE_MESSAGE("Temporary file cannot be created (no filesystem)");
+    }
+
+    discord_recorder_t recorder;
+    discord_recorder_header_t header = { .encoding = DISCORD_GATEWAY_ENCODING_ETF, .compress = true };
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_recorder_init_writer(&recorder, file, &header));
+
+    discord_recorder_frame_t connected = { .event_id = WEBSOCKET_EVENT_CONNECTED };
+    TEST_ASSERT_EQUAL(ESP_OK, discord_recorder_write(&recorder, &connected, NULL));
+
+    size_t split_len = strlen(chunks[1]) + strlen(chunks[2]);
+    discord_recorder_frame_t frames[] = {
+        { .event_id = WEBSOCKET_EVENT_DATA, .op_code = WS_TRANSPORT_OPCODES_TEXT, .payload_len = strlen(chunks[0]), .payload_offset = 0, .data_len = strlen(chunks[0]) },
+        { .event_id = WEBSOCKET_EVENT_DATA, .op_code = WS_TRANSPORT_OPCODES_TEXT, .payload_len = split_len, .payload_offset = 0, .data_len = strlen(chunks[1]) },
+        { .event_id = WEBSOCKET_EVENT_DATA, .op_code = WS_TRANSPORT_OPCODES_TEXT, .payload_len = split_len, .payload_offset = strlen(chunks[1]), .data_len = strlen(chunks[2]) },
+    };
+
+    for(int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, discord_recorder_write(&recorder, &frames[i], chunks[i]));
+    }
+
+    rewind(file);
+
+    discord_recorder_header_t read_header;
+    discord_recorder_frame_t frame;
+    char data[64];
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_recorder_init_reader(&recorder, file, &read_header));
+    TEST_ASSERT_EQUAL(DISCORD_GATEWAY_ENCODING_ETF, read_header.encoding);
+    TEST_ASSERT_TRUE(read_header.compress);
+    TEST_ASSERT_FALSE(read_header.payload_compress);
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_recorder_read_frame(&recorder, &frame));
+    TEST_ASSERT_EQUAL(WEBSOCKET_EVENT_CONNECTED, frame.event_id);
+    TEST_ASSERT_EQUAL(0, frame.data_len);
+    uint64_t time_us = frame.time_us;
+
+    for(int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, discord_recorder_read_frame(&recorder, &frame));
+        TEST_ASSERT_EQUAL(frames[i].event_id, frame.event_id);
+        TEST_ASSERT_EQUAL(frames[i].op_code, frame.op_code);
+        TEST_ASSERT_EQUAL(frames[i].payload_len, frame.payload_len);
+        TEST_ASSERT_EQUAL(frames[i].payload_offset, frame.payload_offset);
+        TEST_ASSERT_EQUAL(frames[i].data_len, frame.data_len);
+        TEST_ASSERT_GREATER_OR_EQUAL(time_us, frame.time_us);
+        time_us = frame.time_us;
+
+        if(i == 1) {
+            continue; // unread data is skipped
+        }
+
+        TEST_ASSERT_EQUAL(ESP_OK, discord_recorder_read_data(&recorder, data));
+        TEST_ASSERT_EQUAL_MEMORY(chunks[i], data, frame.data_len);
+    }
+
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, discord_recorder_read_frame(&recorder, &frame));
+    discord_recorder_close(&recorder);
+}
+
+TEST_CASE("recorder rejects foreign and truncated logs", "[gateway]")
+{
+    FILE* file = tmpfile();
+
+    if(!file) {
+        TEST_IGNORE_MESSAGE("Temporary file cannot be created (no filesystem)");
+    }
+
+    discord_recorder_t recorder;
+    discord_recorder_header_t header = { .encoding = DISCORD_GATEWAY_ENCODING_JSON };
+    discord_recorder_frame_t frame = { .event_id = WEBSOCKET_EVENT_DATA, .op_code = WS_TRANSPORT_OPCODES_TEXT, .payload_len = 300, .data_len = 300 };
+    char data[300] = { 0 };
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_recorder_init_writer(&recorder, file, &header));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_recorder_write(&recorder, &frame, data));
+    long len = ftell(file);
+
+    // every cut inside the record is reported, cut between records is the end of the log
+    for(long cut = 8; cut < len; cut++) {
+        FILE* truncated = copy_log(file, cut);
+        discord_recorder_t reader;
+
+        TEST_ASSERT_NOT_NULL(truncated);
+        TEST_ASSERT_EQUAL(ESP_OK, discord_recorder_init_reader(&reader, truncated, &header));
+
+        esp_err_t err = discord_recorder_read_frame(&reader, &frame);
+
+        if(cut == 8) {
+            TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, err);
+        } else if(err == ESP_OK) {
+            TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, discord_recorder_read_data(&reader, data));
+        } else {
+            TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, err);
+        }
+
+        discord_recorder_close(&reader);
+    }
+
+    discord_recorder_close(&recorder);
+
+    FILE* foreign = tmpfile();
+    TEST_ASSERT_NOT_NULL(foreign);
+    fputs("{\"op\":10}", foreign);
+    rewind(foreign);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_VERSION, discord_recorder_init_reader(&recorder, foreign, &header));
+    discord_recorder_close(&recorder);
+}
\ No newline at end of file
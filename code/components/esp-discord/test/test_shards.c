@@ -0,0 +1,36 @@
+#include <stdint.h>
+#include "unity.h"
+#include "discord/private/_shards.h"
+
+TEST_CASE("identify limiter spaces identifies of one bucket", "[shards]")
+{
+    discord_identify_limiter_t limiter;
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, discord_identify_limiter_init(&limiter, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_identify_limiter_init(&limiter, 2));
+
+    // shards 0 and 2 share bucket 0, shards 1 and 3 share bucket 1
+    TEST_ASSERT_EQUAL(0, discord_identify_limiter_take(&limiter, 0, 1000));
+    TEST_ASSERT_EQUAL(0, discord_identify_limiter_take(&limiter, 1, 1000));
+    TEST_ASSERT_EQUAL(DISCORD_SHARD_IDENTIFY_INTERVAL_MS, discord_identify_limiter_take(&limiter, 2, 1000));
+    TEST_ASSERT_EQUAL(DISCORD_SHARD_IDENTIFY_INTERVAL_MS - 500, discord_identify_limiter_take(&limiter, 3, 1500));
+
+    // slots are reserved, next identify of bucket 0 waits for both
+    TEST_ASSERT_EQUAL(2 * DISCORD_SHARD_IDENTIFY_INTERVAL_MS, discord_identify_limiter_take(&limiter, 0, 1000));
+
+    // bucket which has been idle long enough identifies right away
+    TEST_ASSERT_EQUAL(0, discord_identify_limiter_take(&limiter, 1, 1000 + 3 * DISCORD_SHARD_IDENTIFY_INTERVAL_MS));
+
+    discord_identify_limiter_destroy(&limiter);
+    TEST_ASSERT_EQUAL(0, discord_identify_limiter_take(&limiter, 0, 1000)); // destroyed limiter does not limit
+}
+
+TEST_CASE("guild is assigned to shard by its id", "[shards]")
+{
+    // 1049316126236839946 >> 22 = 250176459845
+    TEST_ASSERT_EQUAL(0, discord_shard_of_guild("1049316126236839946", 1));
+    TEST_ASSERT_EQUAL(1, discord_shard_of_guild("1049316126236839946", 2));
+    TEST_ASSERT_EQUAL(4, discord_shard_of_guild("1049316126236839946", 7));
+    TEST_ASSERT_EQUAL(0, discord_shard_of_guild("1049316126236839946", 0));
+    TEST_ASSERT_EQUAL(0, discord_shard_of_guild(NULL, 4));
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include <string.h>
+#include "unity.h"
+#include "discord/private/_zlib_stream.h"
+#include "discord/private/_json_stream.h"
+
+// Three consecutive messages of one zlib-stream connection (HELLO, HEARTBEAT_ACK, HEARTBEAT_ACK).
+// The last one is only a back-reference to the previous one, so it can be inflated only with the shared context
+
+static const unsigned char message_hello[] =
+    "\x78\x9c\x34\xc9\x41\x0a\x83\x30\x10\x05\xd0\xbb\xfc\x75\x22\x49\xa9\xa5\xcc\x55\x8c\xc8\xa8\x43\x2b\xa4\x2a\xc9"
+    "\xd8\x52\x42\xee\x6e\x37\xdd\x3d\x78\x05\x0a\x5a\x8f\x18\x0d\xf2\x1f\xdb\x0e\xf2\xce\x60\x06\x15\x3c\x85\x93\x8e"
+    "\xc2\x3a\x2c\xab\x4a\x7a\x73\x04\x5d\xfd\xa5\xfd\xfd\xa0\x89\x27\x01\x75\xe8\x02\x1e\xac\xf2\xe1\xaf\xdd\xd3\x6c"
+    "\x8f\x6c\x85\xb3\x7a\x3b\x5a\xd7\xde\xee\x01\xa6\x04\xbc\x96\x29\x6d\x39\x80\x5c\xe3\x6a\x8f\xbe\xd6\x13\x00\x00"
+    "\xff\xff";
+
+static const unsigned char message_ack[] =
+    "\xaa\xc6\x65\xb7\x21\xd8\x6e\x90\x40\x2d\x00\x00\x00\xff\xff";
+
+static const unsigned char message_ack_again[] =
+    "\x22\x46\x0d\x00\x00\x00\xff\xff";
+
+// Messages compressed one by one (identify compress), each is a whole zlib stream
+
+static const unsigned char payload_hello[] =
+    "\x78\xda\x35\xc9\x41\x0a\x83\x30\x10\x05\xd0\xbb\xfc\x75\x22\x49\xa9\xa5\xcc\x55\x8c\xc8\xa8\x43\x2b\xa4\x2a\xc9"
+    "\xd8\x52\x42\xee\x6e\x37\xdd\x3d\x78\x05\x0a\x5a\x8f\x18\x0d\xf2\x1f\xdb\x0e\xf2\xce\x60\x06\x15\x3c\x85\x93\x8e"
+    "\xc2\x3a\x2c\xab\x4a\x7a\x73\x04\x5d\xfd\xa5\xfd\xfd\xa0\x89\x27\x01\x75\xe8\x02\x1e\xac\xf2\xe1\xaf\xdd\xd3\x6c"
+    "\x8f\x6c\x85\xb3\x7a\x3b\x5a\xd7\xde\xee\x01\xa6\x04\xbc\x96\x29\x6d\x39\x80\x5c\xe3\x6a\x8f\xbe\xd6\x13\xa6\xed"
+    "\x27\xad";
+
+static const unsigned char payload_ack[] =
+    "\x78\xda\xab\x56\x2a\x51\xb2\xca\x2b\xcd\xc9\xd1\x51\x2a\x86\x31\xf2\x0b\x94\xac\x0c\x0d\x75\x94\x52\x20\x02\xb5"
+    "\x00\xce\x64\x0b\x32";
+
+// HEARTBEAT_ACK with 32 KB of data between the two copies of the same word, so the second one is a back-reference
+// 32016 bytes far. Stream declares 32 KB window (CINFO 7) in its header
+
+static const unsigned char message_far_reference[] =
+    "\x78\xda\xec\xdd\xb9\x15\x40\x40\x14\x00\xc0\x5e\x7e\x2c\xb0\x6e\xdb\x0d\x96\x94\xdc\xd3\xbb\x44\xa4\x86\x99\x46"
+    "\xe6\x8e\xf3\x8a\x9c\x52\x15\x25\x72\xd4\xa9\x69\xbb\x7e\x18\xa7\x79\x59\xb7\xb2\x1f\x0b\x00\x00\x00\x00\x00\x00"
+    "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xc0\xe7\xff\xa1"
+    "\xc7\xf3\x02\x00\x00\xff\xff";
+
+static const char* message_hello_pruned = "{\"t\":null,\"s\":null,\"op\":10,\"d\":{\"heartbeat_interval\":41250}}";
+static const char* message_ack_pruned = "{\"t\":null,\"s\":null,\"op\":11,\"d\":null}";
+
+static void stream_sink(void* arg, const char* data, size_t len) {
+    discord_json_stream_feed((discord_json_stream_t*) arg, data, len);
+}
+
+static void assert_message(discord_zlib_stream_t* zlib, discord_json_stream_t* json, const unsigned char* message, size_t len, size_t chunk, const char* expected) {
+    discord_json_stream_reset(json);
+
+    for(size_t offset = 0; offset < len; offset += chunk) {
+        TEST_ASSERT_FALSE(discord_zlib_stream_is_flushed(zlib) && offset > 0);
+        TEST_ASSERT_EQUAL(ESP_OK, discord_zlib_stream_feed(zlib, message + offset, chunk < len - offset ? chunk : len - offset, stream_sink, json));
+    }
+
+    TEST_ASSERT_TRUE(discord_zlib_stream_is_flushed(zlib));
+    TEST_ASSERT_TRUE(discord_json_stream_is_done(json));
+    TEST_ASSERT_EQUAL(strlen(expected), json->len);
+    TEST_ASSERT_EQUAL_MEMORY(expected, json->buffer, json->len);
+}
+
+TEST_CASE("zlib stream inflates consecutive messages with shared context", "[gateway]")
+{
+    char buffer[256 + 1];
+    discord_json_stream_t json = {
+        .buffer = buffer,
+        .size = sizeof(buffer) - 1,
+        .prune_keys = discord_json_stream_default_prune_keys
+    };
+    discord_zlib_stream_t zlib = { 0 };
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_zlib_stream_init(&zlib));
+
+    for(size_t chunk = 1; chunk <= sizeof(message_hello); chunk *= 3) {
+        discord_zlib_stream_reset(&zlib);
+        assert_message(&zlib, &json, message_hello, sizeof(message_hello) - 1, chunk, message_hello_pruned);
+        assert_message(&zlib, &json, message_ack, sizeof(message_ack) - 1, chunk, message_ack_pruned);
+        assert_message(&zlib, &json, message_ack_again, sizeof(message_ack_again) - 1, chunk, message_ack_pruned);
+    }
+
+    discord_zlib_stream_destroy(&zlib);
+}
+
+TEST_CASE("zlib stream inflates messages compressed one by one", "[gateway]")
+{
+    char buffer[256 + 1];
+    discord_json_stream_t json = {
+        .buffer = buffer,
+        .size = sizeof(buffer) - 1,
+        .prune_keys = discord_json_stream_default_prune_keys
+    };
+    discord_zlib_stream_t zlib = { 0 };
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_zlib_stream_init(&zlib));
+    zlib.per_message = true;
+
+    for(size_t chunk = 1; chunk <= sizeof(payload_hello); chunk *= 3) {
+        assert_message(&zlib, &json, payload_ack, sizeof(payload_ack) - 1, chunk, message_ack_pruned);
+        assert_message(&zlib, &json, payload_hello, sizeof(payload_hello) - 1, chunk, message_hello_pruned);
+        assert_message(&zlib, &json, payload_ack, sizeof(payload_ack) - 1, chunk, message_ack_pruned);
+    }
+
+    // data after the end of the stream
+    discord_json_stream_reset(&json);
+    unsigned char twice[2 * sizeof(payload_ack)];
+    memcpy(twice, payload_ack, sizeof(payload_ack) - 1);
+    memcpy(twice + sizeof(payload_ack) - 1, payload_ack, sizeof(payload_ack) - 1);
+    TEST_ASSERT_EQUAL(ESP_FAIL, discord_zlib_stream_feed(&zlib, twice, 2 * (sizeof(payload_ack) - 1), stream_sink, &json));
+
+    discord_zlib_stream_destroy(&zlib);
+}
+
+TEST_CASE("zlib stream rejects corrupted input", "[gateway]")
+{
+    discord_zlib_stream_t zlib = { 0 };
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_zlib_stream_init(&zlib));
+    TEST_ASSERT_EQUAL(ESP_FAIL, discord_zlib_stream_feed(&zlib, "\x00\x01\x02\x03\x04\x05\x06\x07", 8, NULL, NULL));
+
+    discord_zlib_stream_destroy(&zlib);
+}
+
+static void tail_sink(void* arg, const char* data, size_t len) {
+    char* tail = (char*) arg; // last 16 bytes of the output
+    size_t keep = len < 16 ? 16 - len : 0;
+
+    memmove(tail, tail + 16 - keep, keep);
+    memcpy(tail + keep, data + len - (16 - keep), 16 - keep);
+}
+
+TEST_CASE("zlib stream resolves back-references across the whole window", "[gateway]")
+{
+    char tail[16 + 1] = { 0 };
+    discord_zlib_stream_t zlib = { 0 };
+
+    TEST_ASSERT_EQUAL(ESP_OK, discord_zlib_stream_init(&zlib));
+    TEST_ASSERT_EQUAL(ESP_OK, discord_zlib_stream_feed(&zlib, message_far_reference, sizeof(message_far_reference) - 1, tail_sink, tail));
+    TEST_ASSERT_TRUE(discord_zlib_stream_is_flushed(&zlib));
+    TEST_ASSERT_EQUAL_STRING("23456789abcdef\"}", tail);
+
+    // header which declares 64 KB window (CINFO 8) is rejected by tinfl
+    unsigned char too_big_window[sizeof(message_far_reference)];
+    memcpy(too_big_window, message_far_reference, sizeof(message_far_reference));
+    too_big_window[0] = 0x88;
+    too_big_window[1] = 0xd6; // FCHECK of the new header
+
+    discord_zlib_stream_reset(&zlib);
+    TEST_ASSERT_EQUAL(ESP_FAIL, discord_zlib_stream_feed(&zlib, too_big_window, sizeof(too_big_window) - 1, NULL, NULL));
+    discord_zlib_stream_destroy(&zlib);
+}
\ No newline at end of file
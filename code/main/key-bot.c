@@ -25,6 +25,7 @@
 #include "discord.h"
 #include "discord/session.h"
 #include "discord/message.h"
+#include "discord/presence.h"
 #include "estr.h"
 
 static const char *TAG = "key-bot";
@@ -36,6 +37,8 @@ static const char *TAG = "key-bot";
 
 //// DISCORD
 #define DISCORD_CHANNEL_ID CONFIG_DISCORD_CHANNEL_ID
+// average heartbeat RTT above which the link to Discord is reported as slow
+#define DISCORD_LATENCY_THRESHOLD_MS 1000
 
 static discord_handle_t bot;
 
@@ -45,6 +48,8 @@ static void bot_notifcation_random_message(bool key_state);
 
 static void bot_send_message(const char *message_content);
 
+static void bot_publish_key_state(bool key_state);
+
 //// WIFI
 /*set the ssid and password via "idf.py menuconfig"*/
 #define DEFAULT_SSID CONFIG_EXAMPLE_WIFI_SSID
@@ -164,8 +169,10 @@ void app_main(void)
     time_t visibility_led_on_time = 0;
 
     //// DISCORD SETUP
+    // intents are calculated from the registered events
     discord_config_t cfg = {
-        .intents = DISCORD_INTENT_GUILD_MESSAGES | DISCORD_INTENT_MESSAGE_CONTENT};
+        .gateway_compress = true,
+        .gateway_latency_threshold_ms = DISCORD_LATENCY_THRESHOLD_MS};
 
     // struct for passing arguments to the event handler
     typedef struct
@@ -179,7 +186,18 @@ void app_main(void)
         .key_state = &key_state};
 
     bot = discord_create(&cfg);
-    ESP_ERROR_CHECK(discord_register_events(bot, DISCORD_EVENT_ANY, bot_event_handler, &args));
+    // only messages from the key channel are delivered (and decoded)
+    const char *key_channel_ids[] = {DISCORD_CHANNEL_ID, NULL};
+    discord_event_filter_t key_channel_filter = {
+        .channel_ids = key_channel_ids};
+
+    ESP_ERROR_CHECK(discord_register_events(bot, DISCORD_EVENT_CONNECTED, bot_event_handler, &args));
+    ESP_ERROR_CHECK(discord_register_events(bot, DISCORD_EVENT_RESUMED, bot_event_handler, &args));
+    ESP_ERROR_CHECK(discord_register_events(bot, DISCORD_EVENT_DISCONNECTED, bot_event_handler, &args));
+    ESP_ERROR_CHECK(discord_register_events(bot, DISCORD_EVENT_GATEWAY_LATENCY, bot_event_handler, &args));
+    ESP_ERROR_CHECK(discord_register_events_filtered(bot, DISCORD_EVENT_MESSAGE_RECEIVED, &key_channel_filter, bot_event_handler, &args));
+    // presence is kept by the library and sent as soon as the session is ready
+    bot_publish_key_state(key_state);
     ESP_ERROR_CHECK(discord_login(bot));
 
     // EVENT LOOP
@@ -248,6 +266,8 @@ void app_main(void)
                         bot_notification_random_message(key_state);
                     }
 
+                    // Show key state as bot presence
+                    bot_publish_key_state(key_state);
                     // Log current time | key state
                     ESP_LOGI(TAG, "%s | Key: %s", strftime_buf, key_state ? "present" : "not present");
                     // Reset time_above_threshold_ms and time_below_threshold_ms
@@ -511,6 +531,27 @@ static void bot_event_handler(void *handler_arg, esp_event_base_t base, int32_t
         break;
     }
 
+    case DISCORD_EVENT_RESUMED:
+    {
+        ESP_LOGI(TAG, "Bot session resumed");
+        break;
+    }
+
+    case DISCORD_EVENT_GATEWAY_LATENCY:
+    {
+        discord_gateway_latency_t *latency = (discord_gateway_latency_t *)data->ptr;
+
+        if (latency->above_threshold)
+        {
+            ESP_LOGW(TAG, "Slow link to Discord (avg=%lu ms, p95=%lu ms)", (unsigned long)latency->avg_ms, (unsigned long)latency->p95_ms);
+        }
+        else
+        {
+            ESP_LOGI(TAG, "Link to Discord recovered (avg=%lu ms)", (unsigned long)latency->avg_ms);
+        }
+        break;
+    }
+
     case DISCORD_EVENT_DISCONNECTED:
     {
         ESP_LOGW(TAG, "Bot logged out");
@@ -629,6 +670,24 @@ static void bot_send_message(const char *message_content)
     vTaskDelay(1000 / portTICK_PERIOD_MS);
 }
 
+// Publish key state as bot presence, it costs one small frame on the already open gateway connection
+static void bot_publish_key_state(bool key_state)
+{
+    discord_activity_t activity = {
+        .name = "Custom Status",
+        .type = DISCORD_ACTIVITY_CUSTOM,
+        .state = key_state ? "Key is here" : "Key is gone"};
+
+    discord_presence_t presence = {
+        .status = key_state ? DISCORD_PRESENCE_ONLINE : DISCORD_PRESENCE_IDLE,
+        .activity = &activity};
+
+    if (discord_presence_update(bot, &presence) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to update presence");
+    }
+}
+
 //// LED
 // Blink LED strip 2 times at specified RGB color, used for key state change and knock command
 static void blink_led(led_strip_t *strip, uint8_t red, uint8_t green, uint8_t blue)